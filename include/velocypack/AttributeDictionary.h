@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef VELOCYPACK_ATTRIBUTEDICTIONARY_H
+#define VELOCYPACK_ATTRIBUTEDICTIONARY_H 1
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/AttributeTranslator.h"
+#include "velocypack/Builder.h"
+#include "velocypack/Slice.h"
+#include "velocypack/StringRef.h"
+
+namespace arangodb {
+namespace velocypack {
+
+// persistence for the keys of an AttributeTranslator. a dictionary is a
+// VPack Object of the form
+//
+//   {
+//     "type": "velocypack-dictionary",
+//     "version": 1,
+//     "keys": { <attribute name>: <id>, ... }
+//   }
+//
+// dictionaries with a higher version than the one supported are rejected
+struct AttributeDictionary {
+  static constexpr uint64_t currentVersion = 1;
+
+  // appends the dictionary for the translator's keys to the Builder
+  static void save(AttributeTranslator const& translator, Builder& builder);
+
+  static Builder save(AttributeTranslator const& translator) {
+    Builder builder;
+    save(translator, builder);
+    return builder;
+  }
+
+  // creates a sealed translator from a dictionary
+  static std::unique_ptr<AttributeTranslator> load(Slice dictionary);
+};
+
+// learns the most frequent attribute names from a stream of values, for
+// building an AttributeTranslator. counting uses the space-saving
+// algorithm: at most capacity names are tracked, and when a new name is
+// seen while all slots are in use, it replaces the least frequent name.
+// the counts of the most frequent names are thus approximate (they may be
+// overestimated by at most the count of the replaced name), but memory
+// usage does not depend on the number of distinct names in the input
+class AttributeDictionaryTrainer {
+ public:
+  explicit AttributeDictionaryTrainer(std::size_t capacity = 4096);
+
+  AttributeDictionaryTrainer(AttributeDictionaryTrainer const&) = delete;
+  AttributeDictionaryTrainer& operator=(AttributeDictionaryTrainer const&) = delete;
+
+  // maximum number of tracked names
+  std::size_t capacity() const noexcept { return _capacity; }
+
+  // number of currently tracked names
+  std::size_t size() const noexcept { return _heap.size(); }
+
+  // number of names observed so far
+  uint64_t observed() const noexcept { return _observed; }
+
+  // counts the names of all Objects contained in the value, recursively.
+  // integer keys are ignored, as they are already translated
+  void observe(Slice value);
+
+  // counts a single name
+  void observeKey(StringRef const& key);
+
+  // returns up to k of the most frequent names with their (estimated)
+  // counts, most frequent first
+  std::vector<std::pair<std::string, uint64_t>> top(std::size_t k) const;
+
+  // creates a sealed translator for up to maxKeys of the most frequent
+  // names that occurred at least minCount times and have at least
+  // minLength bytes. the most frequent names get the smallest ids. if a
+  // base translator is given, all its names are kept with their ids, and
+  // new names get ids above the base translator's ids
+  std::unique_ptr<AttributeTranslator> train(
+      std::size_t maxKeys, uint64_t minCount = 2, std::size_t minLength = 2,
+      AttributeTranslator const* base = nullptr) const;
+
+ private:
+  struct Entry {
+    std::string key;
+    uint64_t count;
+    // position of the entry in _heap
+    std::size_t position;
+  };
+
+  void siftUp(std::size_t position);
+
+  void siftDown(std::size_t position);
+
+ private:
+  std::size_t const _capacity;
+  uint64_t _observed;
+  // entries, never reallocated, so that the keys in _index stay valid
+  std::vector<Entry> _entries;
+  // min-heap of indexes into _entries, ordered by count
+  std::vector<std::size_t> _heap;
+  std::unordered_map<StringRef, std::size_t> _index;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
@@ -26,9 +26,11 @@
 #define VELOCYPACK_ATTRIBUTETRANSLATOR_H 1
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "velocypack/velocypack-common.h"
 #include "velocypack/StringRef.h"
@@ -37,6 +39,11 @@ namespace arangodb {
 namespace velocypack {
 class Builder;
 
+// maps attribute names to small integer ids and back. after all keys have
+// been added, seal() builds the lookup structures: a minimal perfect hash
+// table for key to id lookups, which needs exactly one hash computation
+// and one key comparison per lookup, and a dense vector for id to key
+// lookups. lookups never allocate memory
 class AttributeTranslator {
  public:
   AttributeTranslator(AttributeTranslator const&) = delete;
@@ -56,13 +63,26 @@ class AttributeTranslator {
   
   // translate from string to id
   uint8_t const* translate(StringRef const& key) const noexcept {
-    auto it = _keyToId.find(key);
+    if (_slots.empty()) {
+      return nullptr;
+    }
 
-    if (it == _keyToId.end()) {
+    uint64_t const h = VELOCYPACK_HASH(key.data(), key.size(), _seed);
+    uint32_t const displacement =
+        _displacements[reduce(static_cast<uint32_t>(h), _displacements.size())];
+    Slot const& slot =
+        _slots[reduce(mix(h >> 32, displacement), _slots.size())];
+
+    // every slot is occupied, so the key must be compared to rule out
+    // keys that were never added
+    if (slot.length != key.size() || slot.prefix != prefix(key) ||
+        (key.size() > sizeof(uint64_t) &&
+         std::memcmp(slot.key + sizeof(uint64_t), key.data() + sizeof(uint64_t),
+                     key.size() - sizeof(uint64_t)) != 0)) {
       return nullptr;
     }
 
-    return (*it).second;
+    return slot.id;
   }
 
   // translate from string to id
@@ -77,19 +97,70 @@ class AttributeTranslator {
 
   // translate from id to string
   uint8_t const* translate(uint64_t id) const noexcept {
-    auto it = _idToKey.find(id);
+    if (id < _idToKey.size()) {
+      return _idToKey[static_cast<std::size_t>(id)];
+    }
+    if (_sparseIdToKey.empty()) {
+      return nullptr;
+    }
+
+    auto it = _sparseIdToKey.find(id);
 
-    if (it == _idToKey.end()) {
+    if (it == _sparseIdToKey.end()) {
       return nullptr;
     }
 
     return (*it).second;
   }
 
+ private:
+  // an entry of the perfect hash table
+  struct Slot {
+    // the first 8 bytes of the key, zero-padded
+    uint64_t prefix;
+    std::size_t length;
+    // start of the key's characters
+    char const* key;
+    // start of the id's VPack value
+    uint8_t const* id;
+  };
+
+  // maps a 32 bit value into the range [0, n) without a division
+  static inline uint32_t reduce(uint32_t value, std::size_t n) noexcept {
+    return static_cast<uint32_t>((static_cast<uint64_t>(value) * n) >> 32);
+  }
+
+  // derives the slot hash from the key's hash and the displacement of the
+  // key's bucket
+  static inline uint32_t mix(uint64_t h, uint32_t displacement) noexcept {
+    uint64_t x = h ^ (static_cast<uint64_t>(displacement) * 0x9e3779b97f4a7c15ULL);
+    x ^= x >> 29;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 32;
+    return static_cast<uint32_t>(x);
+  }
+
+  static inline uint64_t prefix(StringRef const& key) noexcept {
+    uint64_t result = 0;
+    std::memcpy(&result, key.data(),
+                key.size() < sizeof(uint64_t) ? key.size() : sizeof(uint64_t));
+    return result;
+  }
+
+  // builds the perfect hash table with the specified seed. returns false
+  // if no displacements could be found for all buckets
+  bool buildPerfectHash(std::vector<Slot> const& entries, uint64_t seed);
+
  private:
   std::unique_ptr<Builder> _builder;
-  std::unordered_map<StringRef, uint8_t const*> _keyToId;
-  std::unordered_map<uint64_t, uint8_t const*> _idToKey;
+  // perfect hash table for key to id lookups
+  std::vector<Slot> _slots;
+  std::vector<uint32_t> _displacements;
+  uint64_t _seed;
+  // id to key lookups. ids that are too large for the dense vector are
+  // kept in the map
+  std::vector<uint8_t const*> _idToKey;
+  std::unordered_map<uint64_t, uint8_t const*> _sparseIdToKey;
   std::size_t _count;
 };
 
@@ -108,6 +179,30 @@ class AttributeTranslatorScope {
   AttributeTranslator* _old;
 };
 
+// binds a translator to the calling thread. while the scope is active,
+// Slice lookups on integer keys in this thread use the bound translator
+// instead of Options::Defaults.attributeTranslator. in contrast to
+// AttributeTranslatorScope, no global state is modified, so different
+// threads can use different translators at the same time. scopes can be
+// nested
+class AttributeTranslatorThreadScope {
+ private:
+  AttributeTranslatorThreadScope(AttributeTranslatorThreadScope const&) = delete;
+  AttributeTranslatorThreadScope& operator= (AttributeTranslatorThreadScope const&) = delete;
+
+ public:
+  explicit AttributeTranslatorThreadScope(AttributeTranslator const* translator) noexcept;
+  ~AttributeTranslatorThreadScope();
+
+  void revert() noexcept;
+
+  // the translator bound to the calling thread, or nullptr
+  static AttributeTranslator const* current() noexcept;
+
+ private:
+  AttributeTranslator const* _old;
+};
+
 }  // namespace arangodb::velocypack
 }  // namespace arangodb
 
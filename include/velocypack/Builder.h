@@ -181,6 +181,16 @@ class Builder {
     _start = _bufferPtr->data();
   }
 
+  // Reserves room in the index of the currently open Array or Object
+  // for n more members, for when the number of members is known up front
+  void reserveMembers(ValueLength n) {
+    if (VELOCYPACK_UNLIKELY(_stack.empty())) {
+      throw Exception(Exception::BuilderNeedOpenCompound);
+    }
+    std::vector<ValueLength>& index = _index[_stack.size() - 1];
+    index.reserve(index.size() + static_cast<std::size_t>(n));
+  }
+
   // Clear and start from scratch:
   void clear() noexcept {
     _pos = 0;
@@ -466,6 +476,29 @@ class Builder {
     return addInternal<Serializable>(tag, sub._sable);
   }
 
+  // Add a packed array of numbers (int64_t, double or float) to an array,
+  // copying all values with a single memcpy. see PackedArrayView.h
+  template <typename T>
+  uint8_t* addPacked(T const* values, std::size_t n) {
+    return addPackedInternal<T>(nullptr, values, n);
+  }
+
+  template <typename T>
+  uint8_t* addPacked(std::vector<T> const& values) {
+    return addPackedInternal<T>(nullptr, values.data(), values.size());
+  }
+
+  // Add a packed array of numbers to an object
+  template <typename T>
+  uint8_t* addPacked(StringRef const& attrName, T const* values, std::size_t n) {
+    return addPackedInternal<T>(&attrName, values, n);
+  }
+
+  template <typename T>
+  uint8_t* addPacked(StringRef const& attrName, std::vector<T> const& values) {
+    return addPackedInternal<T>(&attrName, values.data(), values.size());
+  }
+
   // Add an External slice to an array
   uint8_t* addExternal(uint8_t const* sub) {
     if (options->disallowExternals) {
@@ -565,6 +598,31 @@ class Builder {
   }
 
  private:
+  template <typename T>
+  uint8_t* addPackedInternal(StringRef const* attrName, T const* values,
+                             std::size_t n) {
+    uint64_t const tag = PackedArrayTraits<T>::tag;
+    std::size_t const length = n * sizeof(T);
+    uint8_t const* data = reinterpret_cast<uint8_t const*>(values);
+#ifdef VELOCYPACK_PACKED_ARRAY_SWAP
+    // the format is little-endian
+    std::vector<uint8_t> swapped(length);
+    for (std::size_t i = 0; i < length; i += sizeof(T)) {
+      std::reverse_copy(data + i, data + i + sizeof(T), swapped.data() + i);
+    }
+    data = swapped.data();
+#endif
+    if (n == 0) {
+      // values may be a nullptr
+      data = reinterpret_cast<uint8_t const*>("");
+    }
+    ValuePair pair(data, length, ValueType::Binary);
+    if (attrName == nullptr) {
+      return addTagged(tag, pair);
+    }
+    return addTagged(*attrName, tag, pair);
+  }
+
   void sortObjectIndexShort(uint8_t* objBase,
                             std::vector<ValueLength>& offsets) const;
 
@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VELOCYPACK_CBOR_H
+#define VELOCYPACK_CBOR_H 1
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Builder.h"
+#include "velocypack/Exception.h"
+#include "velocypack/Options.h"
+#include "velocypack/Sink.h"
+#include "velocypack/Slice.h"
+
+namespace arangodb {
+namespace velocypack {
+
+// writes VPack values as CBOR (RFC 8949) into a Sink, without going
+// through JSON. Objects become maps, Binary values byte strings, tags
+// CBOR tags, UTCDates epoch-based dates (tag 1) and Doubles float 64.
+// all items use definite lengths. packed Arrays and shaped Objects are
+// written like the Arrays and Objects they stand for, and External
+// values are followed. the remaining types have no CBOR equivalent and
+// are handled according to options->unsupportedTypeBehavior
+class CborDumper {
+ public:
+  Options const* options;
+
+  CborDumper(CborDumper const&) = delete;
+  CborDumper& operator=(CborDumper const&) = delete;
+
+  explicit CborDumper(Sink* sink, Options const* options = &Options::Defaults)
+      : options(options), _sink(sink) {
+    if (VELOCYPACK_UNLIKELY(sink == nullptr)) {
+      throw Exception(Exception::InternalError, "Sink cannot be a nullptr");
+    }
+    if (VELOCYPACK_UNLIKELY(options == nullptr)) {
+      throw Exception(Exception::InternalError, "Options cannot be a nullptr");
+    }
+  }
+
+  Sink* sink() const { return _sink; }
+
+  void dump(Slice const& slice) { dumpValue(slice); }
+
+  static void dump(Slice const& slice, Sink* sink,
+                   Options const* options = &Options::Defaults) {
+    CborDumper dumper(sink, options);
+    dumper.dump(slice);
+  }
+
+  static std::string toString(Slice const& slice,
+                              Options const* options = &Options::Defaults) {
+    std::string buffer;
+    StringSink sink(&buffer);
+    dump(slice, &sink, options);
+    return buffer;
+  }
+
+ private:
+  void dumpValue(Slice const& slice);
+
+  void dumpInt(int64_t value);
+
+  void dumpDouble(double value);
+
+  void dumpUTCDate(int64_t value);
+
+  void dumpPackedArray(Slice const& slice);
+
+  void dumpShapedObject(Slice const& slice, ShapeRegistry const* registry);
+
+  // writes the initial byte of an item with the given major type, and
+  // the argument in the smallest encoding that can hold it
+  void dumpHeader(uint8_t majorType, uint64_t value);
+
+  void handleUnsupportedType(Slice const& slice);
+
+ private:
+  Sink* _sink;
+};
+
+// builds VPack from CBOR (RFC 8949), without going through JSON. maps
+// become Objects, byte strings Binary values, and tags are kept as VPack
+// tags, except for epoch-based dates (tag 1), which become UTCDates with
+// millisecond precision. the member counts of definite-length arrays and
+// maps are known up front, so the Builder's index for them is reserved in
+// one go. indefinite-length items are supported as well. map keys must
+// be text strings, undefined becomes null, and half, single and double
+// precision floats all become Doubles. tag 0 (date/time strings) is
+// dropped, as VPack has no tag 0. all other tags, including the RFC 8746
+// typed array tags, are kept, so packed Arrays written by CborDumper
+// without Options::packedArrays are read back unchanged
+class CborParser {
+ public:
+  Options const* options;
+
+  CborParser(CborParser const&) = delete;
+  CborParser& operator=(CborParser const&) = delete;
+
+  explicit CborParser(Builder& builder, Options const* options = &Options::Defaults)
+      : options(options),
+        _builder(&builder),
+        _start(nullptr),
+        _size(0),
+        _pos(0),
+        _key(nullptr),
+        _keyLength(0),
+        _tag(0),
+        _haveTag(false) {
+    if (VELOCYPACK_UNLIKELY(options == nullptr)) {
+      throw Exception(Exception::InternalError, "Options cannot be a nullptr");
+    }
+  }
+
+  Builder const& builder() const { return *_builder; }
+
+  // adds the CBOR item at the start of the data to the Builder, and
+  // returns the number of bytes it occupies. the data may continue after
+  // the item, so that sequences of items can be parsed
+  ValueLength parse(uint8_t const* start, std::size_t size);
+
+  ValueLength parse(char const* start, std::size_t size) {
+    return parse(reinterpret_cast<uint8_t const*>(start), size);
+  }
+
+  ValueLength parse(std::string const& data) {
+    return parse(data.data(), data.size());
+  }
+
+  static std::shared_ptr<Builder> fromCbor(uint8_t const* start, std::size_t size,
+                                           Options const* options = &Options::Defaults) {
+    auto builder = std::make_shared<Builder>(options);
+    CborParser parser(*builder, options);
+    parser.parse(start, size);
+    return builder;
+  }
+
+  static std::shared_ptr<Builder> fromCbor(std::string const& data,
+                                           Options const* options = &Options::Defaults) {
+    return fromCbor(reinterpret_cast<uint8_t const*>(data.data()), data.size(), options);
+  }
+
+  // Returns the position at the time when the just reported error
+  // occurred, only use when handling an exception.
+  std::size_t errorPos() const { return _pos; }
+
+ private:
+  void parseValue();
+
+  void parseArray(uint8_t info, uint64_t length);
+
+  void parseMap(uint8_t info, uint64_t length);
+
+  // the next item in a map must be a text string, which becomes the key
+  // of the item after it
+  void parseKey();
+
+  void parseString(uint8_t majorType, uint8_t info, uint64_t length);
+
+  // concatenates the chunks of an indefinite-length string into out
+  void readChunks(uint8_t majorType, std::string& out);
+
+  void parseTag(std::size_t start, uint64_t tag);
+
+  void parseDate();
+
+  void parseSimple(uint8_t info, uint64_t value);
+
+  // adds a value to the Builder, under the pending map key and with the
+  // pending tag, if there are any
+  template <typename T>
+  void add(T const& value);
+
+  // reads the argument of an item with the given additional information
+  uint64_t readArgument(uint8_t info);
+
+  uint8_t const* consume(ValueLength length);
+
+  // consumes the break stop code if it comes next
+  bool consumeBreak();
+
+ private:
+  Builder* _builder;
+  uint8_t const* _start;
+  std::size_t _size;
+  std::size_t _pos;
+  // the key for the next value, if it is a member of a map
+  char const* _key;
+  ValueLength _keyLength;
+  std::string _keyBuffer;
+  // the tag for the next value
+  uint64_t _tag;
+  bool _haveTag;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
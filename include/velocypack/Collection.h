@@ -25,16 +25,25 @@
 #ifndef VELOCYPACK_COLLECTION_H
 #define VELOCYPACK_COLLECTION_H 1
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <set>
 #include <string>
+#include <type_traits>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "velocypack/velocypack-common.h"
 #include "velocypack/Builder.h"
+#include "velocypack/Exception.h"
 #include "velocypack/Iterator.h"
 #include "velocypack/Slice.h"
+#include "velocypack/ThreadPool.h"
+#include "velocypack/TrustedSlice.h"
+#include "velocypack/Value.h"
+#include "velocypack/ValueType.h"
 
 namespace arangodb {
 namespace velocypack {
@@ -54,28 +63,88 @@ class Collection {
 
   static Builder& appendArray(Builder& builder, Slice const& left);
 
-  static void forEach(Slice const& slice, Predicate const& predicate);
+  // the predicates of forEach(), filter(), find(), contains(), all() and
+  // any() can be any callable with the signature of Predicate. they are
+  // inlined into the iteration, so lambdas and function objects do not
+  // pay for the indirect call of a std::function
+  template<typename F>
+  static void forEach(Slice const& slice, F&& predicate) {
+    ArrayIterator it(slice);
+    ValueLength index = 0;
 
-  static void forEach(Slice const* slice, Predicate const& predicate) {
-    return forEach(*slice, predicate);
+    while (it.valid()) {
+      if (!predicate(it.value(), index)) {
+        // abort
+        return;
+      }
+      it.next();
+      ++index;
+    }
+  }
+
+  template<typename F>
+  static void forEach(Slice const* slice, F&& predicate) {
+    return forEach(*slice, std::forward<F>(predicate));
   }
 
-  static Builder filter(Slice const& slice, Predicate const& predicate);
+  template<typename F>
+  static Builder filter(Slice const& slice, F&& predicate) {
+    // construct a new Array
+    Builder b;
+    b.add(Value(ValueType::Array));
 
-  static Builder filter(Slice const* slice, Predicate const& predicate) {
-    return filter(*slice, predicate);
+    ArrayIterator it(slice);
+    ValueLength index = 0;
+
+    while (it.valid()) {
+      Slice s = it.value();
+      if (predicate(s, index)) {
+        b.add(s);
+      }
+      it.next();
+      ++index;
+    }
+    b.close();
+    return b;
   }
 
-  static Slice find(Slice const& slice, Predicate const& predicate);
+  template<typename F>
+  static Builder filter(Slice const* slice, F&& predicate) {
+    return filter(*slice, std::forward<F>(predicate));
+  }
+
+  template<typename F>
+  static Slice find(Slice const& slice, F&& predicate) {
+    ArrayIterator it(slice);
+    ValueLength index = 0;
+
+    while (it.valid()) {
+      Slice s = it.value();
+      if (predicate(s, index)) {
+        return s;
+      }
+      it.next();
+      ++index;
+    }
 
-  static Slice find(Slice const* slice, Predicate const& predicate) {
-    return find(*slice, predicate);
+    return Slice();
   }
 
-  static bool contains(Slice const& slice, Predicate const& predicate);
+  template<typename F>
+  static Slice find(Slice const* slice, F&& predicate) {
+    return find(*slice, std::forward<F>(predicate));
+  }
 
-  static bool contains(Slice const* slice, Predicate const& predicate) {
-    return contains(*slice, predicate);
+  template<typename F, typename std::enable_if<
+                           !std::is_convertible<F, Slice const&>::value, int>::type = 0>
+  static bool contains(Slice const& slice, F&& predicate) {
+    return !find(slice, std::forward<F>(predicate)).isNone();
+  }
+
+  template<typename F, typename std::enable_if<
+                           !std::is_convertible<F, Slice const&>::value, int>::type = 0>
+  static bool contains(Slice const* slice, F&& predicate) {
+    return contains(*slice, std::forward<F>(predicate));
   }
 
   static bool contains(Slice const& slice, Slice const& other);
@@ -90,18 +159,153 @@ class Collection {
     return indexOf(*slice, other);
   }
 
-  static bool all(Slice const& slice, Predicate const& predicate);
+  template<typename F>
+  static bool all(Slice const& slice, F&& predicate) {
+    ArrayIterator it(slice);
+    ValueLength index = 0;
+
+    while (it.valid()) {
+      if (!predicate(it.value(), index)) {
+        return false;
+      }
+      it.next();
+      ++index;
+    }
+
+    return true;
+  }
+
+  template<typename F>
+  static bool all(Slice const* slice, F&& predicate) {
+    return all(*slice, std::forward<F>(predicate));
+  }
+
+  template<typename F>
+  static bool any(Slice const& slice, F&& predicate) {
+    ArrayIterator it(slice);
+    ValueLength index = 0;
+
+    while (it.valid()) {
+      if (predicate(it.value(), index)) {
+        return true;
+      }
+      it.next();
+      ++index;
+    }
 
-  static bool all(Slice const* slice, Predicate const& predicate) {
-    return all(*slice, predicate);
+    return false;
   }
 
-  static bool any(Slice const& slice, Predicate const& predicate);
+  template<typename F>
+  static bool any(Slice const* slice, F&& predicate) {
+    return any(*slice, std::forward<F>(predicate));
+  }
 
-  static bool any(Slice const* slice, Predicate const& predicate) {
-    return any(*slice, predicate);
+  // parallel variants of forEach(), filter() and any(). the members of the
+  // Array are split into up to numThreads ranges of consecutive members,
+  // which are processed concurrently, so the predicate must be safe to
+  // call from several threads at once. each range has at least
+  // minMembersPerThread members, so small Arrays are processed on the
+  // calling thread only. the first exception thrown by a predicate is
+  // rethrown after all ranges have finished. the variants taking a
+  // ThreadPool run the ranges on its threads, and use up to pool.size()
+  // ranges
+
+  // the order in which the members are visited is unspecified. once the
+  // predicate returns false, no further members are visited
+  template<typename F>
+  static void forEachParallel(Slice const& slice, std::size_t numThreads,
+                              F&& predicate) {
+    ThreadPool pool(numThreads);
+    forEachParallel(slice, pool, std::forward<F>(predicate));
   }
 
+  template<typename F>
+  static void forEachParallel(Slice const& slice, ThreadPool& pool,
+                              F&& predicate) {
+    std::atomic<bool> done(false);
+    runParallel(slice, pool, [&](Slice first, ValueLength start,
+                                       ValueLength stop, std::size_t) {
+      Slice s = first;
+      for (ValueLength index = start; index < stop; ++index) {
+        if (done.load(std::memory_order_relaxed)) {
+          return;
+        }
+        if (!predicate(s, index)) {
+          done.store(true, std::memory_order_relaxed);
+          return;
+        }
+        s = Slice(s.start() + s.byteSize());
+      }
+    });
+  }
+
+  // the members of the result are in the same order as in the input
+  template<typename F>
+  static Builder filterParallel(Slice const& slice, std::size_t numThreads,
+                                F&& predicate) {
+    ThreadPool pool(numThreads);
+    return filterParallel(slice, pool, std::forward<F>(predicate));
+  }
+
+  template<typename F>
+  static Builder filterParallel(Slice const& slice, ThreadPool& pool,
+                                F&& predicate) {
+    std::vector<std::vector<Slice>> matches(pool.size());
+    runParallel(slice, pool, [&](Slice first, ValueLength start,
+                                       ValueLength stop, std::size_t chunk) {
+      Slice s = first;
+      for (ValueLength index = start; index < stop; ++index) {
+        if (predicate(s, index)) {
+          matches[chunk].push_back(s);
+        }
+        s = Slice(s.start() + s.byteSize());
+      }
+    });
+
+    Builder b;
+    b.add(Value(ValueType::Array));
+    for (auto const& it : matches) {
+      for (auto const& s : it) {
+        b.add(s);
+      }
+    }
+    b.close();
+    return b;
+  }
+
+  // all ranges stop as soon as a match has been found in any of them
+  template<typename F>
+  static bool anyParallel(Slice const& slice, std::size_t numThreads,
+                          F&& predicate) {
+    ThreadPool pool(numThreads);
+    return anyParallel(slice, pool, std::forward<F>(predicate));
+  }
+
+  template<typename F>
+  static bool anyParallel(Slice const& slice, ThreadPool& pool,
+                          F&& predicate) {
+    std::atomic<bool> found(false);
+    runParallel(slice, pool, [&](Slice first, ValueLength start,
+                                       ValueLength stop, std::size_t) {
+      Slice s = first;
+      for (ValueLength index = start; index < stop; ++index) {
+        if (found.load(std::memory_order_relaxed)) {
+          return;
+        }
+        if (predicate(s, index)) {
+          found.store(true, std::memory_order_relaxed);
+          return;
+        }
+        s = Slice(s.start() + s.byteSize());
+      }
+    });
+    return found.load();
+  }
+
+  // minimum number of members per range for the parallel variants
+  static ValueLength const minMembersPerThread;
+
   static std::vector<std::string> keys(Slice const& slice);
 
   static std::vector<std::string> keys(Slice const* slice) {
@@ -206,19 +410,192 @@ class Collection {
   }
   static Builder& merge(Builder& builder, Slice const& left, Slice const& right, bool mergeValues, bool nullMeansRemove = false);
 
-  static void visitRecursive(
-      Slice const& slice, VisitationOrder order,
-      std::function<bool(Slice const&, Slice const&)> const& func);
+  // calls func(key, value) for all members of an Object or Array and of
+  // all the Objects and Arrays nested in it. key is None for Array members.
+  // with PreOrder, the members of a nested value are visited before the
+  // nested value itself, with PostOrder after it. once func returns false,
+  // the visitation stops. the nesting is tracked on an explicit stack, so
+  // deeply nested values cannot overflow the call stack
+  template<typename F>
+  static void visitRecursive(Slice const& slice, VisitationOrder order,
+                             F&& func) {
+    if (VELOCYPACK_UNLIKELY(!slice.isObject() && !slice.isArray())) {
+      throw Exception(Exception::InvalidValueType,
+                      "Expecting type Object or Array");
+    }
+    if (order == Collection::PreOrder) {
+      visit<Collection::PreOrder>(slice, func);
+    } else {
+      visit<Collection::PostOrder>(slice, func);
+    }
+  }
+
+  template<typename F>
+  static void visitRecursive(Slice const* slice, VisitationOrder order,
+                             F&& func) {
+    visitRecursive(*slice, order, std::forward<F>(func));
+  }
+
+  template<typename F>
+  static Builder sort(Slice const& array, F&& lessthan) {
+    if (!array.isArray()) {
+      throw Exception(Exception::InvalidValueType, "Expecting type Array");
+    }
+    ArrayIterator it(array);
+    std::vector<Slice> subValues;
+    subValues.reserve(checkOverflow(it.size()));
+    while (it.valid()) {
+      subValues.push_back(it.value());
+      it.next();
+    }
+    std::sort(subValues.begin(), subValues.end(),
+              [&lessthan](Slice const& lhs, Slice const& rhs) {
+                return lessthan(lhs, rhs);
+              });
+    Builder b;
+    b.openArray();
+    for (auto const& s : subValues) {
+      b.add(s);
+    }
+    b.close();
+    return b;
+  }
+
+  // result of aggregateNumbers()
+  struct NumberAggregate {
+    // number of numeric members
+    uint64_t count;
+    double sum;
+    // +/- infinity if there are no numeric members
+    double min;
+    double max;
+  };
+
+  // aggregates the numeric members of an Array or a packed array (see
+  // PackedArrayView.h, only if enabled in the Options) in a single pass.
+  // members of other types are
+  // ignored, NaN values are ignored by min and max. runs of doubles and of
+  // integers with the same byte width are decoded in bulk, using SIMD
+  // where available. doubles are summed up in several partial sums, so
+  // the sum may differ from a sequential summation in the last bits
+  static NumberAggregate aggregateNumbers(Slice const& slice,
+                                          Options const* options = &Options::Defaults);
+
+  static double sumNumbers(Slice const& slice,
+                           Options const* options = &Options::Defaults) {
+    return aggregateNumbers(slice, options).sum;
+  }
+
+  // determines the minimum and maximum of the numeric members of an Array.
+  // returns false if there are no numeric members
+  static bool minMax(Slice const& slice, double& min, double& max,
+                     Options const* options = &Options::Defaults);
+
+  // counts the numeric members of an Array in the range [min, max],
+  // divided into the given number of equally sized buckets. the value max
+  // itself is counted in the last bucket. other values are ignored
+  static std::vector<uint64_t> histogram(Slice const& slice, double min,
+                                         double max, std::size_t buckets,
+                                         Options const* options = &Options::Defaults);
+
+ private:
+  // one Object or Array on the visitation stack of visitRecursive(). the
+  // type of the value has been checked when it was pushed, so the
+  // iteration itself does not need to check anything
+  class VisitFrame {
+   public:
+    explicit VisitFrame(Slice const& slice)
+        : _isObject(slice.isObject()),
+          _array(_isObject ? Slice::emptyArraySlice() : slice),
+          _object(_isObject ? slice : Slice::emptyObjectSlice()) {}
+
+    bool valid() const noexcept {
+      return _isObject ? _object.valid() : _array.valid();
+    }
+
+    // returns the value of the current member and stores its key, which
+    // is None for Array members
+    Slice current(Slice& key) const {
+      if (_isObject) {
+        auto pair = *_object;
+        key = pair.key;
+        return pair.value;
+      }
+      key = Slice();
+      return *_array;
+    }
+
+    void next() {
+      if (_isObject) {
+        _object.next();
+      } else {
+        _array.next();
+      }
+    }
 
-  static void visitRecursive(
-      Slice const* slice, VisitationOrder order,
-      std::function<bool(Slice const&, Slice const&)> const& func) {
-    visitRecursive(*slice, order, func);
+   private:
+    bool _isObject;
+    TrustedArrayIterator _array;
+    TrustedObjectIterator _object;
+  };
+
+  template<VisitationOrder order, typename F>
+  static void visit(Slice const& slice, F& func) {
+    std::vector<VisitFrame> stack;
+    // enough for most documents without growing
+    stack.reserve(16);
+    stack.emplace_back(slice);
+
+    while (!stack.empty()) {
+      VisitFrame& frame = stack.back();
+      Slice key;
+
+      if (!frame.valid()) {
+        stack.pop_back();
+        if (order == Collection::PreOrder && !stack.empty()) {
+          // all members of the nested value have been visited, now visit
+          // the member of the enclosing value that contains it
+          VisitFrame& parent = stack.back();
+          Slice value = parent.current(key);
+          if (!func(key, value)) {
+            return;
+          }
+          parent.next();
+        }
+        continue;
+      }
+
+      Slice value = frame.current(key);
+      bool const isCompound = (value.isObject() || value.isArray());
+
+      if (order == Collection::PreOrder) {
+        if (isCompound) {
+          // the member itself is visited once its members are done
+          stack.emplace_back(value);
+          continue;
+        }
+        if (!func(key, value)) {
+          return;
+        }
+        frame.next();
+      } else {
+        if (!func(key, value)) {
+          return;
+        }
+        frame.next();
+        if (isCompound) {
+          stack.emplace_back(value);
+        }
+      }
+    }
   }
 
-  static Builder sort(
-      Slice const& array,
-      std::function<bool (Slice const&, Slice const&)> lessthan);
+  // splits the members of an Array into up to pool.size() ranges and
+  // calls cb(first member, index of first member, end index, range number)
+  // for each of them on the threads of pool
+  static void runParallel(
+      Slice const& slice, ThreadPool& pool,
+      std::function<void(Slice, ValueLength, ValueLength, std::size_t)> const& cb);
 };
 
 struct IsEqualPredicate {
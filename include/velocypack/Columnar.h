@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VELOCYPACK_COLUMNAR_H
+#define VELOCYPACK_COLUMNAR_H 1
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Builder.h"
+#include "velocypack/Slice.h"
+#include "velocypack/StringRef.h"
+
+namespace arangodb {
+namespace velocypack {
+
+class ColumnarView;
+
+// converts Arrays of Objects ("rows") into a columnar form and back. the
+// columnar form is a regular VPack Object:
+//
+//   {
+//     "length": <number of rows>,
+//     "keys": [<attribute name>, ...],
+//     "columns": [[<value of 1st attribute in row 0>, ...], ...]
+//   }
+//
+// every attribute name is stored only once, and the values of each
+// attribute are stored in one Array, so scanning a single attribute
+// touches only its column. "keys" contains all attribute names that occur
+// in any row, in order of first occurrence. rows that do not have an
+// attribute have an Illegal value in the attribute's column
+struct Columnar {
+  // appends the columnar form of the Array of Objects to the Builder
+  static void fromRows(Slice rows, Builder& builder);
+
+  static Builder fromRows(Slice rows) {
+    Builder builder;
+    fromRows(rows, builder);
+    return builder;
+  }
+
+  // appends the Array of Objects represented by the columnar value to
+  // the Builder
+  static void toRows(Slice columnar, Builder& builder);
+
+  static Builder toRows(Slice columnar) {
+    Builder builder;
+    toRows(columnar, builder);
+    return builder;
+  }
+};
+
+// a single row of a columnar value. resolves attributes through the
+// ColumnarView, which must outlive the row
+class ColumnarRow {
+ public:
+  ColumnarRow(ColumnarView const* view, ValueLength index) noexcept
+      : _view(view), _index(index) {}
+
+  // index of the row
+  ValueLength index() const noexcept { return _index; }
+
+  // returns the value of the attribute in this row, or a None Slice if
+  // the row does not have the attribute
+  Slice get(StringRef const& attribute) const;
+
+  Slice get(std::string const& attribute) const {
+    return get(StringRef(attribute));
+  }
+
+  Slice get(char const* attribute) const {
+    return get(StringRef(attribute));
+  }
+
+  template<typename T>
+  bool hasKey(T const& attribute) const {
+    return !get(attribute).isNone();
+  }
+
+  // returns the value of the nth column in this row, or a None Slice if
+  // the row does not have the column's attribute
+  Slice valueAt(ValueLength column) const;
+
+  // appends the row as an Object to the Builder
+  void toObject(Builder& builder) const;
+
+ private:
+  ColumnarView const* _view;
+  ValueLength _index;
+};
+
+// random access to the rows and columns of a columnar value, as produced
+// by Columnar::fromRows(). the view refers to the value's memory, which
+// must stay valid while the view is in use
+class ColumnarView {
+ public:
+  explicit ColumnarView(Slice columnar);
+
+  ColumnarView(ColumnarView const&) = delete;
+  ColumnarView& operator=(ColumnarView const&) = delete;
+
+  Slice slice() const noexcept { return _slice; }
+
+  // number of rows
+  ValueLength length() const noexcept { return _length; }
+
+  // number of columns
+  ValueLength numColumns() const noexcept { return _columns.size(); }
+
+  // name of the nth column
+  Slice keyAt(ValueLength column) const {
+    return _keys.at(column);
+  }
+
+  // the Array of values of the nth column
+  Slice column(ValueLength column) const {
+    if (VELOCYPACK_UNLIKELY(column >= _columns.size())) {
+      throw Exception(Exception::IndexOutOfBounds);
+    }
+    return _columns[static_cast<std::size_t>(column)];
+  }
+
+  // the Array of values of the attribute, or a None Slice if no row
+  // has the attribute
+  Slice column(StringRef const& attribute) const {
+    auto it = _index.find(attribute);
+    if (it == _index.end()) {
+      return Slice();
+    }
+    return _columns[(*it).second];
+  }
+
+  // index of the attribute's column, or -1 if no row has the attribute
+  int64_t columnIndex(StringRef const& attribute) const {
+    auto it = _index.find(attribute);
+    if (it == _index.end()) {
+      return -1;
+    }
+    return static_cast<int64_t>((*it).second);
+  }
+
+  int64_t columnIndex(char const* attribute) const {
+    return columnIndex(StringRef(attribute));
+  }
+
+  ColumnarRow row(ValueLength index) const {
+    if (VELOCYPACK_UNLIKELY(index >= _length)) {
+      throw Exception(Exception::IndexOutOfBounds);
+    }
+    return ColumnarRow(this, index);
+  }
+
+  ColumnarRow operator[](ValueLength index) const { return row(index); }
+
+ private:
+  Slice _slice;
+  Slice _keys;
+  ValueLength _length;
+  std::vector<Slice> _columns;
+  std::unordered_map<StringRef, std::size_t> _index;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
@@ -0,0 +1,144 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VELOCYPACK_COMPACT_INDEX_H
+#define VELOCYPACK_COMPACT_INDEX_H 1
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Exception.h"
+#include "velocypack/Slice.h"
+#include "velocypack/StringRef.h"
+
+namespace arangodb {
+namespace velocypack {
+
+// a side index for random access into compact Arrays (0x13) and compact
+// Objects (0x14), which do not carry an index table of their own. Slice::at()
+// and friends have to walk such values from the start on every call, whereas
+// the index is built in a single pass and afterwards provides O(1) access by
+// position and O(log n) access by attribute name.
+// the index can also be built for non-compact Arrays and Objects. in this
+// case it only stores a sorted attribute index for unsorted Objects and
+// delegates everything else to the Slice.
+// the index refers to the Slice's memory, which must neither be modified
+// nor freed while the index is in use. the index is immutable after
+// construction, so it can be shared between threads
+class CompactIndex {
+ public:
+  explicit CompactIndex(Slice slice);
+
+  CompactIndex(CompactIndex const&) = default;
+  CompactIndex& operator=(CompactIndex const&) = default;
+  CompactIndex(CompactIndex&&) = default;
+  CompactIndex& operator=(CompactIndex&&) = default;
+
+  // the Slice the index was built for
+  Slice slice() const noexcept { return _slice; }
+
+  // number of members of the Array or Object
+  ValueLength length() const noexcept { return _length; }
+
+  // whether or not the index stores the members' offsets
+  bool hasOffsets() const noexcept { return !_offsets.empty(); }
+
+  // get the offset for the nth member, same as Slice::getNthOffset()
+  ValueLength getNthOffset(ValueLength index) const {
+    if (_offsets.empty()) {
+      return _slice.getNthOffset(index);
+    }
+    if (VELOCYPACK_UNLIKELY(index >= _length)) {
+      throw Exception(Exception::IndexOutOfBounds);
+    }
+    return _offsets[static_cast<std::size_t>(index)];
+  }
+
+  // same as Slice::at()
+  Slice at(ValueLength index) const {
+    if (VELOCYPACK_UNLIKELY(!_slice.isArray())) {
+      throw Exception(Exception::InvalidValueType, "Expecting type Array");
+    }
+    return Slice(_slice.start() + getNthOffset(index));
+  }
+
+  Slice operator[](ValueLength index) const { return at(index); }
+
+  // same as Slice::keyAt()
+  Slice keyAt(ValueLength index, bool translate = true) const {
+    if (VELOCYPACK_UNLIKELY(!_slice.isObject())) {
+      throw Exception(Exception::InvalidValueType, "Expecting type Object");
+    }
+    Slice key(_slice.start() + getNthOffset(index));
+    return translate ? key.makeKey() : key;
+  }
+
+  // same as Slice::valueAt()
+  Slice valueAt(ValueLength index) const {
+    Slice key = keyAt(index, false);
+    return Slice(key.start() + key.byteSize());
+  }
+
+  // same as Slice::get(), but using a binary search for compact and
+  // unsorted Objects
+  Slice get(StringRef const& attribute) const;
+
+  Slice get(std::string const& attribute) const {
+    return get(StringRef(attribute));
+  }
+
+  Slice get(char const* attribute) const { return get(StringRef(attribute)); }
+
+  Slice get(char const* attribute, std::size_t length) const {
+    return get(StringRef(attribute, length));
+  }
+
+  // whether or not the Object has the attribute, same as Slice::hasKey()
+  bool hasKey(StringRef const& attribute) const {
+    return !get(attribute).isNone();
+  }
+
+  // approximate number of bytes of heap memory used by the index
+  std::size_t memoryUsage() const noexcept {
+    return _offsets.capacity() * sizeof(ValueLength) +
+           _sorted.capacity() * sizeof(ValueLength);
+  }
+
+ private:
+  Slice _slice;
+  ValueLength _length;
+  // offsets of all members, relative to the start of the Slice. only
+  // populated for compact Arrays and Objects
+  std::vector<ValueLength> _offsets;
+  // offsets of all Object members, sorted by attribute name. only populated
+  // for Objects that are not sorted already
+  std::vector<ValueLength> _sorted;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
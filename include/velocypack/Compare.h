@@ -25,6 +25,8 @@
 #ifndef VELOCYPACK_COMPARE_H
 #define VELOCYPACK_COMPARE_H 1
 
+#include <string>
+
 #include "velocypack/velocypack-common.h"
 
 namespace arangodb {
@@ -63,9 +65,29 @@ static bool equalsNumbers(Slice lhs, Slice rhs);
 // function to compare two string values
 static bool equalsStrings(Slice lhs, Slice rhs);
 
-// function to compare two arbitrary Slices
+// function to compare two arbitrary Slices.
+// Arrays and Objects with identical byte representations are compared by
+// walking the members of one side only
 static bool equals(Slice lhs, Slice rhs);
 
+// function to compare two numeric values, returning a value < 0 if lhs
+// sorts before rhs, 0 if both are equal and a value > 0 otherwise.
+// Int, UInt and SmallInt values are compared exactly with each other and
+// with Double values. NaN sorts before all other numbers, and -0.0 is
+// equal to 0.0
+static int compareNumbers(Slice lhs, Slice rhs);
+
+// function to compare two string values bytewise
+static int compareStrings(Slice lhs, Slice rhs);
+
+// function to compare two arbitrary Slices, establishing a total order:
+// MinKey < None < Illegal < Null < Bool < numbers < UTCDate < String <
+// Binary < Array < Object < MaxKey.
+// Arrays are compared element-wise, Objects are compared as sequences of
+// key/value pairs in ascending key order. Externals are resolved and tags
+// are ignored. Comparing BCD or Custom values throws.
+static int compare(Slice lhs, Slice rhs);
+
 struct Hash {
   size_t operator()(arangodb::velocypack::Slice const&) const;
 };
@@ -81,6 +103,26 @@ struct Equal {
                   arangodb::velocypack::Slice const&) const;
 };
 
+// less-than functor, suitable for Collection::sort and ordered containers
+struct Less {
+  bool operator()(arangodb::velocypack::Slice const&,
+                  arangodb::velocypack::Slice const&) const;
+};
+
+};
+
+// helper struct for turning Slices into binary keys which, compared with
+// memcmp, sort in the same order as NormalizedCompare::compare. 
+// Two keys are bytewise identical if and only if the two Slices compare 
+// as equal. The keys cannot be decoded back into Slices.
+struct SortKey {
+
+// appends the sort key for the Slice to the output string
+static void append(Slice slice, std::string& out);
+
+// returns the sort key for the Slice
+static std::string encode(Slice slice);
+
 };
   
 }
@@ -0,0 +1,258 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef VELOCYPACK_COMPRESSION_H
+#define VELOCYPACK_COMPRESSION_H 1
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Buffer.h"
+#include "velocypack/Exception.h"
+#include "velocypack/Sink.h"
+#include "velocypack/Slice.h"
+#include "velocypack/ThreadPool.h"
+
+#if __cplusplus >= 201703L
+#include "velocypack/SharedSlice.h"
+#endif
+
+namespace arangodb {
+namespace velocypack {
+
+// a small LZ77 codec for blocks of up to 4 GB. the compressed data is a
+// sequence of (literals, match) pairs, each starting with a token byte
+// whose upper 4 bits hold the number of literals and whose lower 4 bits
+// hold the match length minus 4. a nibble value of 15 is followed by
+// extension bytes, which are added to it until a byte below 255 is read.
+// the literals are followed by the 2 byte little endian distance of the
+// match, which must be in the range 1 to 65535. the last pair consists of
+// literals only.
+// decompress() checks all lengths and distances and throws on corrupt data
+struct LZCodec {
+  // maximum length of the compressed data for an input of the given length
+  static std::size_t maxCompressedLength(std::size_t length) noexcept {
+    return length + length / 255 + 16;
+  }
+
+  // maximum length of the data that compressed data of the given length
+  // can decompress to. a match can produce at most 255 bytes per byte of
+  // its length encoding, and a literal one byte per byte
+  static std::size_t maxDecompressedLength(std::size_t length) noexcept {
+    return length * 255;
+  }
+
+  // compresses length bytes from src into dst, which must provide
+  // maxCompressedLength(length) bytes. returns the compressed length
+  static std::size_t compress(uint8_t const* src, std::size_t length,
+                              uint8_t* dst);
+
+  // decompresses length bytes from src into dst, which must provide
+  // exactly dstLength bytes. throws if the data is corrupt or does not
+  // decompress to exactly dstLength bytes
+  static void decompress(uint8_t const* src, std::size_t length,
+                         uint8_t* dst, std::size_t dstLength);
+};
+
+// a sequence of VelocyPack values, split into blocks that are compressed
+// independently of each other:
+//
+//   <header> <block>* <index> <footer>
+//
+//   header: "VPKZ" <format version: 1 byte> <reserved: 3 bytes>
+//   block:  <method: 1 byte, 0 = stored, 1 = LZCodec>
+//           <compressed length: 4 bytes> <uncompressed length: 4 bytes>
+//           <number of values: 4 bytes> <Adler-32 of uncompressed data: 4 bytes>
+//           <compressed data>
+//   index:  (<offset of block: 8 bytes> <number of first value: 8 bytes>)*
+//   footer: <offset of index: 8 bytes> <number of blocks: 4 bytes> "VPKI"
+//
+// all integers are stored little endian. the uncompressed data of a block
+// is the concatenation of its values, so values never span blocks. the
+// index at the end allows locating the block of any value without
+// reading the blocks before it
+struct CompressedFormat {
+  static constexpr uint8_t version = 1;
+  static constexpr std::size_t headerLength = 8;
+  static constexpr std::size_t blockHeaderLength = 17;
+  static constexpr std::size_t indexEntryLength = 16;
+  static constexpr std::size_t footerLength = 16;
+
+  enum Method : uint8_t { Stored = 0, LZ = 1 };
+};
+
+// writes VelocyPack values into a compressed container, which is appended
+// to a Sink. values are collected until the block size is reached, so a
+// block holds at least one value and is only larger than the block size
+// if a single value is. finish() must be called after the last value to
+// write the index
+class CompressedWriter {
+ public:
+  static constexpr std::size_t defaultBlockSize = 256 * 1024;
+
+  CompressedWriter(CompressedWriter const&) = delete;
+  CompressedWriter& operator=(CompressedWriter const&) = delete;
+
+  explicit CompressedWriter(Sink* sink, std::size_t blockSize = defaultBlockSize);
+  ~CompressedWriter() = default;
+
+  // appends the value
+  void add(Slice value);
+
+  // writes the values added so far as a block, even if it is not full.
+  // this bounds the number of values lost if the container is cut off
+  void flush();
+
+  // writes the last block and the index. no values can be added afterwards
+  void finish();
+
+  // number of values added
+  uint64_t values() const noexcept { return _values; }
+
+  // number of blocks written
+  std::size_t blocks() const noexcept { return _index.size(); }
+
+  // number of bytes written to the Sink
+  uint64_t bytesWritten() const noexcept { return _offset; }
+
+ private:
+  void write(uint8_t const* data, std::size_t length);
+
+ private:
+  Sink* _sink;
+  std::size_t const _blockSize;
+  // uncompressed values of the current block
+  Buffer<uint8_t> _pending;
+  uint32_t _pendingValues;
+  Buffer<uint8_t> _compressed;
+  // offset and number of first value of all blocks written
+  std::vector<std::pair<uint64_t, uint64_t>> _index;
+  uint64_t _offset;
+  uint64_t _values;
+  bool _finished;
+};
+
+// the decompressed values of one block. the values share ownership of the
+// block's memory, so the block can be passed on and kept independently of
+// the CompressedReader
+class CompressedBlock {
+  friend class CompressedReader;
+
+ public:
+  CompressedBlock() : _length(0), _firstValue(0) {}
+
+  // number of values in the block
+  std::size_t size() const noexcept { return _offsets.size(); }
+
+  // number of the block's first value in the container
+  uint64_t firstValue() const noexcept { return _firstValue; }
+
+  // the nth value of the block
+  Slice at(std::size_t position) const {
+    if (position >= _offsets.size()) {
+      throw Exception(Exception::IndexOutOfBounds);
+    }
+    return Slice(_data.get() + _offsets[position]);
+  }
+
+  Slice operator[](std::size_t position) const { return at(position); }
+
+  // the uncompressed data of the block
+  std::shared_ptr<uint8_t const> const& data() const noexcept { return _data; }
+
+  // length of the uncompressed data
+  std::size_t length() const noexcept { return _length; }
+
+#if __cplusplus >= 201703L
+  // the nth value of the block, sharing ownership of the block's memory
+  SharedSlice sharedAt(std::size_t position) const {
+    return SharedSlice(SharedSlice(_data), at(position));
+  }
+#endif
+
+ private:
+  std::shared_ptr<uint8_t const> _data;
+  std::size_t _length;
+  uint64_t _firstValue;
+  std::vector<std::size_t> _offsets;
+};
+
+// reads a compressed container from memory. the constructor reads the
+// index, blocks are decompressed on demand. the data must stay valid
+// while the CompressedReader is in use, and all methods are const and
+// can be called concurrently
+class CompressedReader {
+ public:
+  // throws if the header, index or footer are corrupt
+  CompressedReader(uint8_t const* data, std::size_t length);
+
+  CompressedReader(char const* data, std::size_t length)
+      : CompressedReader(reinterpret_cast<uint8_t const*>(data), length) {}
+
+  // number of blocks
+  std::size_t blocks() const noexcept { return _index.size(); }
+
+  // number of values
+  uint64_t values() const noexcept { return _values; }
+
+  // number of the block which contains the nth value
+  std::size_t findBlock(uint64_t value) const;
+
+  // decompresses the nth block. throws if the block is corrupt
+  CompressedBlock block(std::size_t index) const;
+
+  // decompresses all blocks, using up to numThreads threads
+  std::vector<CompressedBlock> decompress(std::size_t numThreads = 1) const;
+
+  // decompresses all blocks on the threads of pool
+  std::vector<CompressedBlock> decompress(ThreadPool& pool) const;
+
+#if __cplusplus >= 201703L
+  // the nth value. decompresses the block containing it
+  SharedSlice get(uint64_t value) const;
+#endif
+
+ public:
+  // if true, all decompressed values are checked with the Validator.
+  // otherwise only the checksum of each block and the value lengths are
+  // checked, which detects accidental corruption, but is not sufficient
+  // for data from untrusted sources
+  bool validate;
+
+ private:
+  uint8_t const* _data;
+  std::size_t _length;
+  // offset and number of first value of all blocks
+  std::vector<std::pair<uint64_t, uint64_t>> _index;
+  uint64_t _values;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
@@ -26,26 +26,36 @@
 #define VELOCYPACK_DUMPER_H 1
 
 #include <string>
+#include <vector>
 
 #include "velocypack/velocypack-common.h"
+#include "velocypack/Buffer.h"
 #include "velocypack/Exception.h"
+#include "velocypack/Iterator.h"
 #include "velocypack/Options.h"
 #include "velocypack/Sink.h"
 #include "velocypack/Slice.h"
+#include "velocypack/ThreadPool.h"
 
 namespace arangodb {
 namespace velocypack {
 
 // Dumps VPack into a JSON output string
 class Dumper {
+  friend class StreamingDumper;
+
  public:
   Options const* options;
 
   Dumper(Dumper const&) = delete;
   Dumper& operator=(Dumper const&) = delete;
 
+  // minimum number of members that dumpParallel() hands to each thread.
+  // Arrays and Objects with fewer members are dumped on a single thread
+  ValueLength minMembersPerThread;
+
   explicit Dumper(Sink* sink, Options const* options = &Options::Defaults)
-      : options(options), _sink(sink), _indentation(0) {
+      : options(options), minMembersPerThread(1000), _sink(sink), _indentation(0) {
     if (VELOCYPACK_UNLIKELY(sink == nullptr)) {
       throw Exception(Exception::InternalError, "Sink cannot be a nullptr");
     }
@@ -66,6 +76,17 @@ class Dumper {
 
   void dump(Slice const* slice) { dump(*slice); }
 
+  // dumps the value like dump(), but if it is an Array or Object, its
+  // members are split into ranges that are dumped by up to numThreads
+  // threads, each into its own buffer. the buffers are appended to the
+  // Sink in order, so the output is the same as dump()'s. a custom type
+  // handler set in the options must be safe to call from several threads
+  void dumpParallel(Slice const& slice, std::size_t numThreads);
+
+  // dumps the value like dumpParallel(), but on the threads of pool,
+  // which can be reused for many values
+  void dumpParallel(Slice const& slice, ThreadPool& pool);
+
   static void dump(Slice const& slice, Sink* sink,
                    Options const* options = &Options::Defaults) {
     Dumper dumper(sink, options);
@@ -77,6 +98,14 @@ class Dumper {
     dump(*slice, sink, options);
   }
 
+  // returns the length of the JSON that dump() produces for the value
+  // with the given options, without producing it. the result is exact,
+  // except that finite Doubles are counted with the maximum length of
+  // their representation (24 bytes), so it is a tight upper bound for
+  // values containing Doubles. throws where dump() would throw
+  static ValueLength maxOutputSize(Slice const& slice,
+                                   Options const* options = &Options::Defaults);
+
   static std::string toString(Slice const& slice,
                               Options const* options = &Options::Defaults) {
     std::string buffer;
@@ -121,12 +150,48 @@ class Dumper {
 
   void dumpString(char const*, ValueLength);
 
+  void dumpDouble(double, Slice const*);
+
+  void dumpPackedArray(Slice const*);
+
+  template <typename T>
+  void dumpPackedValues(Slice const*);
+
+  void dumpPackedValue(int64_t, Slice const*);
+
+  void dumpPackedValue(double, Slice const*);
+
+  void dumpPackedValue(float, Slice const*);
+
+  // whether the value is dumped as a shaped object. without a shape
+  // registry, shaped objects are dumped like other tagged values
+  bool dumpsAsPackedArray(Slice const*) const;
+
+  bool dumpsAsShapedObject(Slice const*) const;
+
+  void dumpShapedObject(Slice const*, ShapeRegistry const*);
+
   inline void dumpValue(Slice const& slice, Slice const* base = nullptr) {
     dumpValue(&slice, base);
   }
 
   void dumpValue(Slice const*, Slice const* = nullptr);
 
+  // dumps a member of an Array (key == nullptr) or Object, preceded by the
+  // separator from the previous member unless it is the first one
+  void dumpMember(bool first, Slice const* key, Slice const& value, Slice const* base);
+  void dumpMember(bool first, ArrayIterator const& it, Slice const& base);
+  void dumpMember(bool first, ObjectIterator const& it, Slice const& base);
+
+  template <typename T>
+  void dumpMembersParallel(Slice const& slice, T it, ThreadPool& pool, std::size_t numChunks);
+
+  ValueLength sizeOfValue(Slice const*, Slice const*);
+
+  ValueLength sizeOfString(char const*, ValueLength) const;
+
+  ValueLength sizeOfUnsupportedType(Slice const*) const;
+
   void indent() {
     std::size_t n = _indentation;
     _sink->reserve(2 * n);
@@ -153,6 +218,69 @@ class Dumper {
   int _indentation;
 };
 
+// produces the JSON for a value in pieces of bounded size, on demand.
+// Dumper writes the entire JSON into its Sink in one call, whereas the
+// output of StreamingDumper is pulled via produce(), so a large value can
+// be sent out while it is being dumped, at the pace of the receiver.
+// Arrays and Objects are traversed with an explicit stack, and long
+// strings are escaped piecewise, so apart from the stack only the JSON of
+// a single scalar value or key is buffered. the output is the same as
+// Dumper's for the same options.
+// after an exception was thrown, the StreamingDumper must not be used
+// any further
+class StreamingDumper {
+ public:
+  StreamingDumper(StreamingDumper const&) = delete;
+  StreamingDumper& operator=(StreamingDumper const&) = delete;
+
+  explicit StreamingDumper(Slice slice, Options const* options = &Options::Defaults);
+
+  // writes the next at most maxBytes bytes of the JSON into buffer and
+  // returns the number of bytes written. fewer than maxBytes bytes are
+  // only written once the end of the JSON is reached
+  std::size_t produce(char* buffer, std::size_t maxBytes);
+
+  // whether the entire JSON has been produced
+  bool done() const noexcept {
+    return _pendingOffset == _pending.size() && !_haveNext && !_inString &&
+           _stack.empty();
+  }
+
+  // starts over with another value
+  void reset(Slice slice);
+
+ private:
+  // an open Array or Object. the iterators are kept in _arrays and _objects
+  struct Frame {
+    Slice value;
+    bool isObject;
+    bool first;
+  };
+
+  bool step();
+  void beginValue(Slice slice, Slice base);
+  void continueString();
+
+ private:
+  // strings longer than this are escaped in pieces of this size
+  static constexpr ValueLength stringPieceLength = 4096;
+
+  Buffer<char> _pending;
+  std::size_t _pendingOffset;
+  CharBufferSink _sink;
+  Dumper _dumper;
+  std::vector<Frame> _stack;
+  std::vector<ArrayIterator> _arrays;
+  std::vector<ObjectIterator> _objects;
+  // the top-level value, until dumping it has started
+  Slice _next;
+  bool _haveNext;
+  // the string currently being escaped
+  Slice _string;
+  ValueLength _stringOffset;
+  bool _inString;
+};
+
 }  // namespace arangodb::velocypack
 }  // namespace arangodb
 
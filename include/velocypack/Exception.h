@@ -53,6 +53,9 @@ class Exception : public virtual std::exception {
     NeedAttributeTranslator = 20,
     CannotTranslateKey = 21,
     KeyNotFound = 22, // not used anymore
+    NeedShapeRegistry = 23,
+    UnknownShape = 24,
+    CorruptCompressedData = 25,
 
     BuilderNotSealed = 30,
     BuilderNeedOpenObject = 31,
@@ -126,6 +129,12 @@ class Exception : public virtual std::exception {
         return "Cannot translate key";
       case KeyNotFound:
         return "Key not found";
+      case NeedShapeRegistry:
+        return "Cannot execute operation without shape registry";
+      case UnknownShape:
+        return "Unknown shape";
+      case CorruptCompressedData:
+        return "Corrupt compressed data";
       case BuilderNotSealed:
         return "Builder value not yet sealed";
       case BuilderNeedOpenObject:
@@ -165,6 +174,33 @@ class Exception : public virtual std::exception {
   }
 };
 
+// the outcome of an operation that reports its errors without throwing,
+// such as Parser::tryParse() and Validator::tryValidate()
+struct Status {
+  Status() noexcept
+      : code(Exception::UnknownError), message(nullptr), position(0) {}
+
+  Status(Exception::ExceptionType code, char const* message,
+         std::size_t position) noexcept
+      : code(code), message(message), position(position) {}
+
+  bool ok() const noexcept { return message == nullptr; }
+
+  // throws the error as an Exception, if there is one
+  void raise() const {
+    if (!ok()) {
+      throw Exception(code, message);
+    }
+  }
+
+  // only meaningful if the operation failed
+  Exception::ExceptionType code;
+  // nullptr if the operation succeeded
+  char const* message;
+  // the offset into the input at which the error was detected
+  std::size_t position;
+};
+
 }  // namespace arangodb::velocypack
 }  // namespace arangodb
 
@@ -288,6 +288,21 @@ class ObjectIterator : public std::iterator<std::forward_iterator_tag, ObjectIte
   inline bool isFirst() const noexcept { return (_position == 0); }
 
   inline bool isLast() const noexcept { return (_position + 1 >= _size); }
+
+  inline void forward(ValueLength count) {
+    if (_position + count >= _size) {
+      // beyond end of data
+      _current = nullptr;
+      _position = _size;
+    } else if (_current != nullptr) {
+      // sequential iteration
+      while (count-- > 0) {
+        operator++();
+      }
+    } else {
+      _position += count;
+    }
+  }
   
   inline void reset() {
     _position = 0;
@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VELOCYPACK_MESSAGEPACK_H
+#define VELOCYPACK_MESSAGEPACK_H 1
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Builder.h"
+#include "velocypack/Exception.h"
+#include "velocypack/Options.h"
+#include "velocypack/Sink.h"
+#include "velocypack/Slice.h"
+
+namespace arangodb {
+namespace velocypack {
+
+// writes VPack values as MessagePack into a Sink, without going through
+// JSON. Objects become maps, Binary values bin, UTCDates timestamps
+// (extension type -1) and Doubles float 64. Integers use the smallest
+// encoding that fits. packed Arrays and shaped Objects are written like
+// the Arrays and Objects they stand for, all other tags are dropped and
+// External values are followed. the remaining types have no MessagePack
+// equivalent and are handled according to options->unsupportedTypeBehavior
+class MessagePackDumper {
+ public:
+  Options const* options;
+
+  MessagePackDumper(MessagePackDumper const&) = delete;
+  MessagePackDumper& operator=(MessagePackDumper const&) = delete;
+
+  explicit MessagePackDumper(Sink* sink, Options const* options = &Options::Defaults)
+      : options(options), _sink(sink) {
+    if (VELOCYPACK_UNLIKELY(sink == nullptr)) {
+      throw Exception(Exception::InternalError, "Sink cannot be a nullptr");
+    }
+    if (VELOCYPACK_UNLIKELY(options == nullptr)) {
+      throw Exception(Exception::InternalError, "Options cannot be a nullptr");
+    }
+  }
+
+  Sink* sink() const { return _sink; }
+
+  void dump(Slice const& slice) { dumpValue(slice); }
+
+  static void dump(Slice const& slice, Sink* sink,
+                   Options const* options = &Options::Defaults) {
+    MessagePackDumper dumper(sink, options);
+    dumper.dump(slice);
+  }
+
+  static std::string toString(Slice const& slice,
+                              Options const* options = &Options::Defaults) {
+    std::string buffer;
+    StringSink sink(&buffer);
+    dump(slice, &sink, options);
+    return buffer;
+  }
+
+ private:
+  void dumpValue(Slice const& slice);
+
+  void dumpInt(int64_t value);
+
+  void dumpUInt(uint64_t value);
+
+  void dumpDouble(double value);
+
+  void dumpString(char const* p, ValueLength length);
+
+  void dumpUTCDate(int64_t value);
+
+  void dumpPackedArray(Slice const& slice);
+
+  void dumpShapedObject(Slice const& slice, ShapeRegistry const* registry);
+
+  // writes the lowest bytes of the value in big-endian byte order
+  void dumpBigEndian(uint64_t value, int bytes);
+
+  // writes a type byte followed by a big-endian length or value of the
+  // given number of bytes
+  void dumpHeader(uint8_t type, uint64_t value, int bytes);
+
+  // writes the header of an array, map, string or binary, choosing the
+  // smallest variant that can hold the length. lengths below fixLimit are
+  // stored in the type byte itself. type8 is 0 if there is no variant
+  // with an 8 bit length
+  void dumpLength(ValueLength length, uint8_t fixType, ValueLength fixLimit,
+                  uint8_t type8, uint8_t type16, uint8_t type32);
+
+  void handleUnsupportedType(Slice const& slice);
+
+ private:
+  Sink* _sink;
+};
+
+// builds VPack from MessagePack, without going through JSON. maps
+// become Objects, bin and str become Binary and String values, and
+// timestamps (extension type -1) become UTCDates, truncated to
+// milliseconds. the member counts of arrays and maps are known up front,
+// so the Builder's index for them is reserved in one go. map keys must be
+// strings. other extension types have no VPack equivalent and are rejected
+class MessagePackParser {
+ public:
+  Options const* options;
+
+  MessagePackParser(MessagePackParser const&) = delete;
+  MessagePackParser& operator=(MessagePackParser const&) = delete;
+
+  explicit MessagePackParser(Builder& builder,
+                             Options const* options = &Options::Defaults)
+      : options(options),
+        _builder(&builder),
+        _start(nullptr),
+        _size(0),
+        _pos(0),
+        _key(nullptr),
+        _keyLength(0) {
+    if (VELOCYPACK_UNLIKELY(options == nullptr)) {
+      throw Exception(Exception::InternalError, "Options cannot be a nullptr");
+    }
+  }
+
+  Builder const& builder() const { return *_builder; }
+
+  // adds the MessagePack value at the start of the data to the Builder,
+  // and returns the number of bytes it occupies. the data may continue
+  // after the value, so that sequences of values can be parsed
+  ValueLength parse(uint8_t const* start, std::size_t size);
+
+  ValueLength parse(char const* start, std::size_t size) {
+    return parse(reinterpret_cast<uint8_t const*>(start), size);
+  }
+
+  ValueLength parse(std::string const& data) {
+    return parse(data.data(), data.size());
+  }
+
+  static std::shared_ptr<Builder> fromMessagePack(
+      uint8_t const* start, std::size_t size,
+      Options const* options = &Options::Defaults) {
+    auto builder = std::make_shared<Builder>(options);
+    MessagePackParser parser(*builder, options);
+    parser.parse(start, size);
+    return builder;
+  }
+
+  static std::shared_ptr<Builder> fromMessagePack(
+      std::string const& data, Options const* options = &Options::Defaults) {
+    return fromMessagePack(reinterpret_cast<uint8_t const*>(data.data()),
+                           data.size(), options);
+  }
+
+  // Returns the position at the time when the just reported error
+  // occurred, only use when handling an exception.
+  std::size_t errorPos() const { return _pos; }
+
+ private:
+  void parseValue();
+
+  // adds a value to the Builder, under the pending map key if there is one
+  template <typename T>
+  void add(T const& value);
+
+  void addInt(int64_t value);
+
+  void parseArray(ValueLength length);
+
+  void parseMap(ValueLength length);
+
+  void parseString(ValueLength length);
+
+  void parseBinary(ValueLength length);
+
+  void parseExtension(ValueLength length);
+
+  // reads a big-endian unsigned integer of the given number of bytes
+  uint64_t readUInt(int bytes);
+
+  uint8_t const* consume(ValueLength length);
+
+ private:
+  Builder* _builder;
+  uint8_t const* _start;
+  std::size_t _size;
+  std::size_t _pos;
+  // the key for the next value, if it is a member of a map
+  char const* _key;
+  ValueLength _keyLength;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
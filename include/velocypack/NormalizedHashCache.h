@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef VELOCYPACK_NORMALIZED_HASH_CACHE_H
+#define VELOCYPACK_NORMALIZED_HASH_CACHE_H 1
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Slice.h"
+
+namespace arangodb {
+namespace velocypack {
+
+// memoizes the results of Slice::normalizedHash() for Slices that are
+// hashed over and over again, e.g. the build and probe keys of a hash join.
+// entries are keyed by the start address of the Slice's memory, so the
+// memory must neither be modified nor freed while it is cached. the cache
+// is not thread-safe
+class NormalizedHashCache {
+ public:
+  explicit NormalizedHashCache(uint64_t seed = Slice::defaultSeed64)
+      : _seed(seed) {}
+
+  NormalizedHashCache(NormalizedHashCache const&) = delete;
+  NormalizedHashCache& operator=(NormalizedHashCache const&) = delete;
+  NormalizedHashCache(NormalizedHashCache&&) = default;
+  NormalizedHashCache& operator=(NormalizedHashCache&&) = default;
+
+  // returns the normalized hash of the Slice, computing and storing it
+  // on first access
+  uint64_t normalizedHash(Slice slice);
+
+  // computes the normalized hashes of n Slices, writing them into hashes
+  void normalizedHashMany(Slice const* slices, std::size_t n, uint64_t* hashes);
+
+  // stores an externally computed hash value for the Slice.
+  // note: the hash is *not* validated. it is the caller's responsibility
+  // to ensure the hash value is correct
+  void store(Slice slice, uint64_t hash) { _hashes[slice.start()] = hash; }
+
+  // whether or not a hash value is stored for the Slice
+  bool contains(Slice slice) const {
+    return _hashes.find(slice.start()) != _hashes.end();
+  }
+
+  // removes the hash value stored for the Slice, if any. must be called
+  // before the Slice's memory is modified or reused
+  void invalidate(Slice slice) { _hashes.erase(slice.start()); }
+
+  // removes all stored hash values
+  void clear() noexcept { _hashes.clear(); }
+
+  std::size_t size() const noexcept { return _hashes.size(); }
+
+  bool empty() const noexcept { return _hashes.empty(); }
+
+  uint64_t seed() const noexcept { return _seed; }
+
+ private:
+  uint64_t _seed;
+  std::unordered_map<uint8_t const*, uint64_t> _hashes;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
@@ -32,6 +32,7 @@
 namespace arangodb {
 namespace velocypack {
 class AttributeTranslator;
+class ShapeRegistry;
 class Dumper;
 struct Options;
 class Slice;
@@ -81,6 +82,9 @@ struct Options {
   // custom attribute translator for integer keys
   AttributeTranslator* attributeTranslator = nullptr;
 
+  // shape registry for resolving attributes of shaped objects
+  ShapeRegistry* shapeRegistry = nullptr;
+
   // custom type handler used for processing custom types by Dumper and Slicer
   CustomTypeHandler* customTypeHandler = nullptr;
 
@@ -131,6 +135,12 @@ struct Options {
   // render dates as integers
   bool datesAsIntegers = false;
 
+  // recognize packed arrays (Binary values with tags 0x40 to 0x42, as built
+  // by Builder::addPacked()) in Slice::isPackedArray(), the Collection
+  // number aggregates and the dumpers, which dump them as arrays of
+  // numbers. when false, these tags are handled like any other tag
+  bool packedArrays = false;
+
   // disallow using type External (to prevent injection of arbitrary pointer
   // values as a security precaution), validated when object-building via
   // Builder and VelocyPack validation using Validator objects
@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VELOCYPACK_PACKED_ARRAY_VIEW_H
+#define VELOCYPACK_PACKED_ARRAY_VIEW_H 1
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Exception.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define VELOCYPACK_PACKED_ARRAY_SWAP 1
+#endif
+
+namespace arangodb {
+namespace velocypack {
+
+// packed arrays store homogeneous numeric vectors (embeddings, time series,
+// coordinates) as a Tagged Binary value. the Binary payload contains the
+// numbers back to back in little-endian byte order, without the per-member
+// head bytes and index table of a regular Array. the tag identifies the
+// element type:
+//
+//   0xee 0x40 <Binary>   int64_t values, 8 bytes each
+//   0xee 0x41 <Binary>   double values, 8 bytes each
+//   0xee 0x42 <Binary>   float values, 4 bytes each
+//
+// use Builder::addPacked() to build them and Slice::getPackedArray<T>(),
+// with packed arrays enabled in the Options,
+// to access them
+template <typename T>
+struct PackedArrayTraits;
+
+template <>
+struct PackedArrayTraits<int64_t> {
+  enum : uint64_t { tag = 0x40 };
+};
+
+template <>
+struct PackedArrayTraits<double> {
+  static_assert(sizeof(double) == 8, "unexpected size of double");
+  enum : uint64_t { tag = 0x41 };
+};
+
+template <>
+struct PackedArrayTraits<float> {
+  static_assert(sizeof(float) == 4, "unexpected size of float");
+  enum : uint64_t { tag = 0x42 };
+};
+
+namespace detail {
+
+template <typename T>
+inline T readPackedValue(uint8_t const* p) noexcept {
+  T value;
+#ifdef VELOCYPACK_PACKED_ARRAY_SWAP
+  uint8_t bytes[sizeof(T)];
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    bytes[i] = p[sizeof(T) - 1 - i];
+  }
+  std::memcpy(&value, &bytes[0], sizeof(T));
+#else
+  std::memcpy(&value, p, sizeof(T));
+#endif
+  return value;
+}
+
+}  // namespace detail
+
+// read-only view of the values of a packed array. values are read with
+// memcpy, so the view works regardless of the alignment of the underlying
+// memory. the memory must stay valid while the view is in use
+template <typename T>
+class PackedArrayView {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T const*;
+    using reference = T;
+
+    explicit iterator(uint8_t const* p) noexcept : _p(p) {}
+
+    T operator*() const noexcept { return detail::readPackedValue<T>(_p); }
+
+    iterator& operator++() noexcept {
+      _p += sizeof(T);
+      return *this;
+    }
+
+    iterator operator++(int) noexcept {
+      iterator result(*this);
+      _p += sizeof(T);
+      return result;
+    }
+
+    difference_type operator-(iterator const& other) const noexcept {
+      return (_p - other._p) / static_cast<difference_type>(sizeof(T));
+    }
+
+    bool operator==(iterator const& other) const noexcept {
+      return _p == other._p;
+    }
+
+    bool operator!=(iterator const& other) const noexcept {
+      return _p != other._p;
+    }
+
+   private:
+    uint8_t const* _p;
+  };
+
+  PackedArrayView() noexcept : _data(nullptr), _size(0) {}
+
+  PackedArrayView(uint8_t const* data, std::size_t size) noexcept
+      : _data(data), _size(size) {}
+
+  // number of values
+  std::size_t size() const noexcept { return _size; }
+
+  bool empty() const noexcept { return _size == 0; }
+
+  // the raw little-endian bytes of the values
+  uint8_t const* data() const noexcept { return _data; }
+
+  std::size_t byteSize() const noexcept { return _size * sizeof(T); }
+
+  T operator[](std::size_t index) const noexcept {
+    return detail::readPackedValue<T>(_data + index * sizeof(T));
+  }
+
+  T at(std::size_t index) const {
+    if (VELOCYPACK_UNLIKELY(index >= _size)) {
+      throw Exception(Exception::IndexOutOfBounds);
+    }
+    return (*this)[index];
+  }
+
+  // returns a typed pointer to the values if they can be accessed in
+  // place, i.e. the memory is suitably aligned for T and the host is
+  // little-endian. returns a nullptr otherwise, in which case the values
+  // must be accessed via operator[] or copyTo()
+  T const* pointer() const noexcept {
+#ifdef VELOCYPACK_PACKED_ARRAY_SWAP
+    return nullptr;
+#else
+    if (reinterpret_cast<uintptr_t>(_data) % alignof(T) != 0) {
+      return nullptr;
+    }
+    return reinterpret_cast<T const*>(_data);
+#endif
+  }
+
+  // copies all values into the target, which must have room for size()
+  // values
+  void copyTo(T* target) const noexcept {
+#ifdef VELOCYPACK_PACKED_ARRAY_SWAP
+    for (std::size_t i = 0; i < _size; ++i) {
+      target[i] = (*this)[i];
+    }
+#else
+    if (_size > 0) {
+      std::memcpy(target, _data, byteSize());
+    }
+#endif
+  }
+
+  iterator begin() const noexcept { return iterator(_data); }
+
+  iterator end() const noexcept { return iterator(_data + byteSize()); }
+
+ private:
+  uint8_t const* _data;
+  std::size_t _size;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
@@ -27,30 +27,92 @@
 
 #include <string>
 #include <cmath>
+#include <vector>
 
 #include "velocypack/velocypack-common.h"
 #include "velocypack/Builder.h"
 #include "velocypack/Exception.h"
 #include "velocypack/Options.h"
+#include "velocypack/StringRef.h"
 
 namespace arangodb {
 namespace velocypack {
 
+// receives the values of a JSON document from Parser::parse() one by
+// one, in document order, instead of having them built into VPack.
+// the StringRefs passed to key() and stringValue() hold the unescaped
+// strings and are only valid during the call.
+// returning false from startArray(), startObject() or key() skips the
+// Array, the Object or the value of the member, respectively, which is
+// much faster than parsing it. skipped values are only checked for
+// being terminated, not for being valid JSON, and no events are
+// reported for them, not even the endArray() or endObject() of a
+// skipped Array or Object
+class JsonHandler {
+ public:
+  virtual ~JsonHandler() = default;
+
+  virtual void nullValue() {}
+  virtual void boolValue(bool) {}
+  virtual void intValue(int64_t) {}
+  virtual void uintValue(uint64_t) {}
+  virtual void doubleValue(double) {}
+  virtual void stringValue(StringRef) {}
+
+  virtual bool startArray() { return true; }
+  virtual void endArray() {}
+
+  virtual bool startObject() { return true; }
+  virtual bool key(StringRef) { return true; }
+  virtual void endObject() {}
+};
+
+// a set of attribute paths, for parsing only the members at these paths
+// of a JSON Object with Parser::parse()
+class JsonProjection {
+  friend class Parser;
+
+ public:
+  JsonProjection() : _nodes(1) {}
+
+  // adds the path of attribute names, such as {"a", "b"} for the member
+  // "b" of the Object in the member "a". the member is selected with its
+  // entire value, so adding an empty path selects the entire document
+  void add(std::vector<std::string> const& path);
+
+ private:
+  struct Node {
+    Node() : selected(false) {}
+
+    std::vector<std::pair<std::string, uint32_t>> children;
+    bool selected;
+  };
+
+  // returns the child of the node for the key, or 0 if there is none
+  uint32_t find(uint32_t node, StringRef key) const noexcept;
+
+  // node 0 is the root and thus never a child
+  std::vector<Node> _nodes;
+};
+
 class Parser {
   // This class can parse JSON very rapidly, but only from contiguous
-  // blocks of memory. It builds the result using the Builder.
+  // blocks of memory. It builds the result using the Builder, or reports
+  // the values to a JsonHandler. Both are handlers of the same scanner,
+  // which is instantiated for each of them.
 
   struct ParsedNumber {
     ParsedNumber() : intValue(0), doubleValue(0.0), isInteger(true) {}
 
-    void addDigit(int i) {
+    // returns false if the number gets out of range
+    bool addDigit(int i) {
       if (isInteger) {
         // check if adding another digit to the int will make it overflow
         if (intValue < 1844674407370955161ULL ||
             (intValue == 1844674407370955161ULL && (i - '0') <= 5)) {
           // int won't overflow
           intValue = intValue * 10 + (i - '0');
-          return;
+          return true;
         }
         // int would overflow
         doubleValue = static_cast<double>(intValue);
@@ -58,9 +120,7 @@ class Parser {
       }
 
       doubleValue = doubleValue * 10.0 + (i - '0');
-      if (std::isnan(doubleValue) || !std::isfinite(doubleValue)) {
-        throw Exception(Exception::NumberOutOfRange);
-      }
+      return !std::isnan(doubleValue) && std::isfinite(doubleValue);
     }
 
     double asDouble() const {
@@ -81,6 +141,11 @@ class Parser {
   std::size_t _size;
   std::size_t _pos;
   int _nesting;
+  // the first error of the current parse. the scanner records it here and
+  // unwinds by returning instead of throwing, so that tryParse() can
+  // reject invalid input without the cost of an exception
+  Exception::ExceptionType _errorCode;
+  char const* _errorMessage;
 
  public:
   Options const* options;
@@ -96,6 +161,8 @@ class Parser {
         _size(0), 
         _pos(0), 
         _nesting(0), 
+        _errorCode(Exception::UnknownError),
+        _errorMessage(nullptr),
         options(&Options::Defaults) {
     _builder.reset(new Builder());
     _builderPtr = _builder.get();
@@ -107,6 +174,8 @@ class Parser {
         _size(0), 
         _pos(0), 
         _nesting(0), 
+        _errorCode(Exception::UnknownError),
+        _errorMessage(nullptr),
         options(options) {
     if (VELOCYPACK_UNLIKELY(options == nullptr)) {
       throw Exception(Exception::InternalError, "Options cannot be a nullptr");
@@ -124,6 +193,8 @@ class Parser {
         _size(0), 
         _pos(0), 
         _nesting(0),
+        _errorCode(Exception::UnknownError),
+        _errorMessage(nullptr),
          options(options) {
     if (VELOCYPACK_UNLIKELY(options == nullptr)) {
       throw Exception(Exception::InternalError, "Options cannot be a nullptr");
@@ -137,6 +208,8 @@ class Parser {
         _size(0), 
         _pos(0), 
         _nesting(0),
+        _errorCode(Exception::UnknownError),
+        _errorMessage(nullptr),
          options(options) {
     if (VELOCYPACK_UNLIKELY(options == nullptr)) {
       throw Exception(Exception::InternalError, "Options cannot be a nullptr");
@@ -180,16 +253,60 @@ class Parser {
     return parse(reinterpret_cast<uint8_t const*>(start), size, multi);
   }
 
-  ValueLength parse(uint8_t const* start, std::size_t size, bool multi = false) {
-    _start = start;
-    _size = size;
-    _pos = 0;
-    if (options->clearBuilderBeforeParse) {
-      _builder->clear();
-    }
-    return parseInternal(multi);
+  ValueLength parse(uint8_t const* start, std::size_t size, bool multi = false);
+
+  // like parse(), but reports invalid JSON by returning the error instead
+  // of throwing it, which makes rejecting malformed input much cheaper.
+  // errors raised by the Builder, such as duplicate attribute names with
+  // Options::checkAttributeUniqueness, are caught and returned as well.
+  // the Builder's contents after an error are the same as with parse()
+  Status tryParse(std::string const& json, bool multi = false) {
+    return tryParse(reinterpret_cast<uint8_t const*>(json.data()), json.size(),
+                    multi);
+  }
+
+  Status tryParse(char const* start, std::size_t size, bool multi = false) {
+    return tryParse(reinterpret_cast<uint8_t const*>(start), size, multi);
+  }
+
+  Status tryParse(uint8_t const* start, std::size_t size, bool multi = false);
+
+  // reports the values of the JSON to the handler instead of building
+  // VPack from them. the Builder is not touched
+  ValueLength parse(std::string const& json, JsonHandler& handler,
+                    bool multi = false) {
+    return parse(reinterpret_cast<uint8_t const*>(json.data()), json.size(),
+                 handler, multi);
+  }
+
+  ValueLength parse(char const* start, std::size_t size, JsonHandler& handler,
+                    bool multi = false) {
+    return parse(reinterpret_cast<uint8_t const*>(start), size, handler, multi);
+  }
+
+  ValueLength parse(uint8_t const* start, std::size_t size,
+                    JsonHandler& handler, bool multi = false);
+
+  // builds an Object holding only the members at the paths of the
+  // projection, along with the Objects leading to them. all other values
+  // are skipped, and thus only checked for being terminated. Objects on a
+  // path that hold none of its members are built empty, and a top-level
+  // value that is not an Object results in an empty Object
+  ValueLength parse(std::string const& json, JsonProjection const& projection,
+                    bool multi = false) {
+    return parse(reinterpret_cast<uint8_t const*>(json.data()), json.size(),
+                 projection, multi);
   }
 
+  ValueLength parse(char const* start, std::size_t size,
+                    JsonProjection const& projection, bool multi = false) {
+    return parse(reinterpret_cast<uint8_t const*>(start), size, projection,
+                 multi);
+  }
+
+  ValueLength parse(uint8_t const* start, std::size_t size,
+                    JsonProjection const& projection, bool multi = false);
+
   // We probably want a parse from stream at some stage...
   // Not with this high-performance two-pass approach. :-(
 
@@ -206,7 +323,7 @@ class Parser {
   uint8_t const* start() { return _builderPtr->start(); }
 
   // Returns the position at the time when the just reported error
-  // occurred, only use when handling an exception.
+  // occurred, only use when handling an exception or a failed tryParse().
   std::size_t errorPos() const { return _pos > 0 ? _pos - 1 : _pos; }
 
   void clear() { _builderPtr->clear(); }
@@ -230,52 +347,100 @@ class Parser {
 
   inline void reset() { _pos = 0; }
 
-  ValueLength parseInternal(bool multi);
+  // prepares the state for parsing the input
+  inline void begin(uint8_t const* start, std::size_t size) noexcept {
+    _start = start;
+    _size = size;
+    _pos = 0;
+    _nesting = 0;
+    _errorMessage = nullptr;
+  }
+
+  // records the error, unless there is one already. the caller then
+  // returns, and so does every caller up to the entry point
+  inline void fail(Exception::ExceptionType code, char const* message) noexcept {
+    if (_errorMessage == nullptr) {
+      _errorCode = code;
+      _errorMessage = message;
+    }
+  }
+
+  inline void fail(Exception::ExceptionType code) noexcept {
+    fail(code, Exception::message(code));
+  }
+
+  inline bool failed() const noexcept { return _errorMessage != nullptr; }
+
+  // throws the error of the current parse, if any
+  inline void throwIfFailed() const {
+    if (VELOCYPACK_UNLIKELY(failed())) {
+      throw Exception(_errorCode, _errorMessage);
+    }
+  }
+
+  // receivers of the scanner's events, defined in Parser.cpp
+  struct BuilderHandler;
+  struct BuilderStringTarget;
+  struct SaxHandler;
+  struct ProjectionHandler;
+
+  template<typename Handler>
+  ValueLength parseInternal(Handler& handler, bool multi);
 
   inline bool isWhiteSpace(uint8_t i) const noexcept {
     return (i == ' ' || i == '\t' || i == '\n' || i == '\r');
   }
 
   // skips over all following whitespace tokens but does not consume the
-  // byte following the whitespace
+  // byte following the whitespace. fails with the message and returns -1
+  // at the end of the input
   int skipWhiteSpace(char const*);
 
-  void parseTrue() {
+  template<typename Handler>
+  void parseTrue(Handler& handler) {
     // Called, when main mode has just seen a 't', need to see "rue" next
     if (consume() != 'r' || consume() != 'u' || consume() != 'e') {
-      throw Exception(Exception::ParseError, "Expecting 'true'");
+      fail(Exception::ParseError, "Expecting 'true'");
+      return;
     }
-    _builderPtr->addTrue();
+    handler.addBool(true);
   }
 
-  void parseFalse() {
+  template<typename Handler>
+  void parseFalse(Handler& handler) {
     // Called, when main mode has just seen a 'f', need to see "alse" next
     if (consume() != 'a' || consume() != 'l' || consume() != 's' ||
         consume() != 'e') {
-      throw Exception(Exception::ParseError, "Expecting 'false'");
+      fail(Exception::ParseError, "Expecting 'false'");
+      return;
     }
-    _builderPtr->addFalse();
+    handler.addBool(false);
   }
 
-  void parseNull() {
+  template<typename Handler>
+  void parseNull(Handler& handler) {
     // Called, when main mode has just seen a 'n', need to see "ull" next
     if (consume() != 'u' || consume() != 'l' || consume() != 'l') {
-      throw Exception(Exception::ParseError, "Expecting 'null'");
+      fail(Exception::ParseError, "Expecting 'null'");
+      return;
     }
-    _builderPtr->addNull();
+    handler.addNull();
   }
 
-  void scanDigits(ParsedNumber& value) {
+  // returns false if the number gets out of range
+  bool scanDigits(ParsedNumber& value) {
     while (true) {
       int i = consume();
       if (i < 0) {
-        return;
+        return true;
       }
       if (i < '0' || i > '9') {
         unconsume();
-        return;
+        return true;
+      }
+      if (VELOCYPACK_UNLIKELY(!value.addDigit(i))) {
+        return false;
       }
-      value.addDigit(i);
     }
   }
 
@@ -296,10 +461,12 @@ class Parser {
     }
   }
 
-  inline int getOneOrThrow(char const* msg) {
+  // consumes the next byte, or fails with the message at the end of the
+  // input and returns -1
+  inline int getOneOrFail(char const* msg) {
     int i = consume();
-    if (i < 0) {
-      throw Exception(Exception::ParseError, msg);
+    if (VELOCYPACK_UNLIKELY(i < 0)) {
+      fail(Exception::ParseError, msg);
     }
     return i;
   }
@@ -308,15 +475,26 @@ class Parser {
 
   inline void decreaseNesting() { --_nesting; }
 
-  void parseNumber();
+  template<typename Handler>
+  void parseNumber(Handler& handler);
+
+  template<typename Target>
+  void parseString(Target& target);
 
-  void parseString();
+  template<typename Handler>
+  void parseArray(Handler& handler);
 
-  void parseArray();
+  template<typename Handler>
+  void parseObject(Handler& handler);
 
-  void parseObject();
+  template<typename Handler>
+  void parseJson(Handler& handler);
 
-  void parseJson();
+  // skip over the rest of a string, Array or Object whose first byte
+  // has already been consumed, or over an entire value
+  void skipString();
+  void skipCompound();
+  void skipValue();
 };
 
 }  // namespace arangodb::velocypack
@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef VELOCYPACK_SHAPEREGISTRY_H
+#define VELOCYPACK_SHAPEREGISTRY_H 1
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Builder.h"
+#include "velocypack/Slice.h"
+#include "velocypack/StringRef.h"
+
+namespace arangodb {
+namespace velocypack {
+
+// a shape is the set of attribute names of an Object. the ShapeRegistry
+// assigns ids to shapes, and Objects with a registered shape can be
+// encoded as "shaped objects", which store the shape id and the values
+// but no attribute names:
+//
+//   0xee 0x43 <Array [<shape id>, <value 0>, <value 1>, ...]>
+//
+// the values are stored in the order of the shape's attribute names,
+// which are sorted bytewise. Slice::get() resolves attributes of shaped
+// objects through the shape registry of the Options it is given or the one
+// set in Options::Defaults, with one hash lookup to find the position of
+// the value and one index table access to find the value itself. without
+// a shape registry, shaped objects are handled like other tagged values.
+//
+// shapes can be registered explicitly via add(), or inferred from sample
+// data via observe() and infer(). the registry must not be modified while
+// it is in use by other threads
+class ShapeRegistry {
+ public:
+  // must be kept in sync with Slice::isShapedObject()
+  enum : uint64_t { tag = 0x43 };
+
+  // id returned by find() for Objects without a registered shape
+  static constexpr uint64_t NotFound = UINT64_MAX;
+
+  // the registry that resolves shaped objects: the one in the Options,
+  // or the one in Options::Defaults. returns a nullptr if neither is set,
+  // in which case shaped objects are treated like other tagged values
+  static ShapeRegistry const* resolve(Options const* options) noexcept;
+
+  class Shape {
+    friend class ShapeRegistry;
+
+   public:
+    // number of attributes
+    std::size_t size() const noexcept { return _names.size(); }
+
+    // the nth attribute name, as a String Slice
+    Slice keyAt(std::size_t position) const {
+      return _keys.slice().at(position);
+    }
+
+    // the attribute names, as an Array of Strings
+    Slice keys() const { return _keys.slice(); }
+
+    // position of the attribute in the shape, or -1 if the shape does
+    // not contain the attribute
+    int64_t position(StringRef const& attribute) const {
+      if (_names.size() <= linearSearchThreshold) {
+        // for small shapes, comparing the lengths first and then the
+        // bytes is cheaper than hashing the attribute name
+        std::size_t const length = attribute.size();
+        for (std::size_t i = 0; i < _names.size(); ++i) {
+          if (_names[i].size() == length &&
+              std::memcmp(_names[i].data(), attribute.data(), length) == 0) {
+            return static_cast<int64_t>(i);
+          }
+        }
+        return -1;
+      }
+      auto it = _positions.find(attribute);
+      if (it == _positions.end()) {
+        return -1;
+      }
+      return static_cast<int64_t>((*it).second);
+    }
+
+   private:
+    static constexpr std::size_t linearSearchThreshold = 16;
+
+    Builder _keys;
+    // the attribute names, referring to the memory of _keys
+    std::vector<StringRef> _names;
+    std::unordered_map<StringRef, std::size_t> _positions;
+  };
+
+  ShapeRegistry(ShapeRegistry const&) = delete;
+  ShapeRegistry& operator=(ShapeRegistry const&) = delete;
+
+  ShapeRegistry();
+  ~ShapeRegistry();
+
+  // number of registered shapes
+  std::size_t count() const noexcept { return _shapes.size(); }
+
+  // registers the shape with the specified attribute names, and returns
+  // its id. registering the same set of names again returns the same id
+  uint64_t add(std::vector<std::string> const& keys);
+
+  // registers the shape of the Object, and returns its id
+  uint64_t add(Slice object);
+
+  // returns the shape with the specified id, or a nullptr
+  Shape const* shape(uint64_t id) const noexcept {
+    if (id >= _shapes.size()) {
+      return nullptr;
+    }
+    return _shapes[static_cast<std::size_t>(id)].get();
+  }
+
+  // returns the id of the Object's shape, or NotFound
+  uint64_t find(Slice object) const;
+
+  // counts the shapes of all Objects contained in the value, recursively.
+  // the counts are used by infer()
+  void observe(Slice value);
+
+  // registers all observed shapes that occurred at least minOccurrences
+  // times and resets the counts. returns the number of new shapes
+  std::size_t infer(uint64_t minOccurrences = 2);
+
+  // appends the value to the Builder, replacing all Objects with a
+  // registered shape by shaped objects, recursively
+  void encode(Slice value, Builder& builder) const;
+
+  Builder encode(Slice value) const {
+    Builder builder;
+    encode(value, builder);
+    return builder;
+  }
+
+  // appends the value to the Builder, replacing all shaped objects by
+  // regular Objects, recursively
+  void decode(Slice value, Builder& builder) const;
+
+  Builder decode(Slice value) const {
+    Builder builder;
+    decode(value, builder);
+    return builder;
+  }
+
+  // returns the value of the attribute in the shaped object, or a None
+  // Slice if the object's shape does not contain the attribute
+  Slice get(Slice shaped, StringRef const& attribute) const;
+
+ private:
+  // builds the canonical signature of a set of attribute names
+  static std::string signature(std::vector<StringRef>& keys);
+
+  uint64_t add(std::vector<StringRef>& keys);
+
+  uint64_t find(Slice object, std::vector<StringRef>& keys) const;
+
+ private:
+  std::vector<std::unique_ptr<Shape>> _shapes;
+  std::unordered_map<std::string, uint64_t> _ids;
+  std::unordered_map<std::string, uint64_t> _observed;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
@@ -25,11 +25,13 @@
 #ifndef VELOCYPACK_SLICE_H
 #define VELOCYPACK_SLICE_H 1
 
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <string>
 #include <vector>
 #include <iosfwd>
+#include <limits>
 #include <algorithm>
 #include <functional>
 #include <type_traits>
@@ -42,6 +44,7 @@
 #include "velocypack/velocypack-common.h"
 #include "velocypack/Exception.h"
 #include "velocypack/Options.h"
+#include "velocypack/PackedArrayView.h"
 #include "velocypack/SliceStaticData.h"
 #include "velocypack/StringRef.h"
 #include "velocypack/Value.h"
@@ -60,6 +63,9 @@ class Slice {
   friend class ArrayIterator;
   friend class ObjectIterator;
   friend class ValueSlice;
+  friend class TrustedSlice;
+  friend class TrustedArrayIterator;
+  friend class TrustedObjectIterator;
 
   // _start is the pointer to the first byte of the value. It should always be
   // accessed through the start() method as that allows subclasses to adjust
@@ -254,6 +260,12 @@ class Slice {
     return VELOCYPACK_HASH32(start(), size, seed);
   }
 
+  // hashes the binary representations of n Slices and writes them into hashes.
+  // produces the same values as calling hash() on each Slice, but prefetches
+  // the memory of upcoming Slices while hashing the current one
+  static void hashMany(Slice const* slices, std::size_t n, uint64_t* hashes,
+                       uint64_t seed = defaultSeed64);
+
   // hashes the binary representation of a value, not using precalculated hash values
   // this is mainly here for testing purposes
   inline uint64_t hashSlow(uint64_t seed = defaultSeed64) const {
@@ -271,6 +283,12 @@ class Slice {
   // hash values than the binary hash32() function
   uint32_t normalizedHash32(uint32_t seed = defaultSeed32) const;
 
+  // computes the normalized hashes of n Slices and writes them into hashes.
+  // produces the same values as calling normalizedHash() on each Slice,
+  // prefetching the memory of upcoming Slices like hashMany()
+  static void normalizedHashMany(Slice const* slices, std::size_t n,
+                                 uint64_t* hashes, uint64_t seed = defaultSeed64);
+
   // hashes the binary representation of a String slice. No check
   // is done if the Slice value is actually of type String
   inline uint64_t hashString(uint64_t seed = defaultSeed64) const noexcept {
@@ -558,7 +576,8 @@ class Slice {
         last = last.resolveExternal();
       }
 
-      if (last.isNone() || (i + 1 < n && !last.isObject())) {
+      if (last.isNone() ||
+          (i + 1 < n && !last.isObject() && !last.isShapedObject())) {
         return Slice();
       }
     }
@@ -566,9 +585,29 @@ class Slice {
     return last;
   }
   
-  // look for the specified attribute inside an Object
+  // look for the specified attribute inside an Object or a shaped object
+  // returns a Slice(ValueType::None) if not found
+  Slice get(StringRef const& attribute) const {
+    return get(attribute, static_cast<AttributeTranslator const*>(nullptr));
+  }
+
+  // look for the specified attribute inside an Object, translating
+  // integer keys with the specified translator. if the translator is a
+  // nullptr, the translator bound to the calling thread via
+  // AttributeTranslatorThreadScope is used, or the one in Options::Defaults
   // returns a Slice(ValueType::None) if not found
-  Slice get(StringRef const& attribute) const;
+  Slice get(StringRef const& attribute, AttributeTranslator const* translator) const;
+
+  // look for the specified attribute inside an Object, translating
+  // integer keys with the translator of the specified Options. attributes
+  // of shaped objects are resolved with the shape registry of the Options,
+  // or the one in Options::Defaults
+  Slice get(StringRef const& attribute, Options const* options) const;
+
+  // disambiguates get(attribute, nullptr). uses the default translator
+  Slice get(StringRef const& attribute, std::nullptr_t) const {
+    return get(attribute, static_cast<AttributeTranslator const*>(nullptr));
+  }
 
   Slice get(std::string const& attribute) const {
     return get(StringRef(attribute.data(), attribute.size()));
@@ -595,6 +634,18 @@ class Slice {
     return !get(attribute).isNone();
   }
 
+  bool hasKey(StringRef const& attribute, AttributeTranslator const* translator) const {
+    return !get(attribute, translator).isNone();
+  }
+
+  bool hasKey(StringRef const& attribute, Options const* options) const {
+    return !get(attribute, options).isNone();
+  }
+
+  bool hasKey(StringRef const& attribute, std::nullptr_t) const {
+    return !get(attribute, nullptr).isNone();
+  }
+
   bool hasKey(std::string const& attribute) const {
     return hasKey(StringRef(attribute));
   }
@@ -650,7 +701,14 @@ class Slice {
   }
 
   // translates an integer key into a string
-  Slice translate() const;
+  Slice translate() const {
+    return translate(nullptr);
+  }
+
+  // translates an integer key into a string, using the specified
+  // translator. if the translator is a nullptr, the translator bound to
+  // the calling thread or the one in Options::Defaults is used
+  Slice translate(AttributeTranslator const* translator) const;
  
   // return the value for an Int object
   int64_t getInt() const;
@@ -868,6 +926,63 @@ class Slice {
     return out;
   }
 
+  // check if the slice is a shaped object. see ShapeRegistry.h for
+  // the format. 0x43 is ShapeRegistry::tag. as applications may use the
+  // same tag for their own purposes, only values with a non-empty Array
+  // payload that starts with an unsigned integer count as shaped objects
+  bool isShapedObject() const noexcept {
+    if (!isTagged() || getFirstTag() != 0x43) {
+      return false;
+    }
+    Slice v(_start + (*_start == 0xee ? 2 : 9));
+    uint8_t const h = v.head();
+    if (!v.isArray() || h == 0x01) {
+      return false;
+    }
+    Slice id(v.start() + (h == 0x13 ? v.getStartOffsetFromCompact()
+                                     : v.findDataOffset(h)));
+    uint8_t const idHead = id.head();
+    // UInt or SmallInt >= 0
+    return (idHead >= 0x28 && idHead <= 0x39);
+  }
+
+  // check if the slice is a packed array of numbers of type T (int64_t,
+  // double or float). see PackedArrayView.h for the format. always false
+  // unless packed arrays are enabled in the Options
+  template <typename T>
+  bool isPackedArray(Options const* options = &Options::Defaults) const noexcept {
+    if (!options->packedArrays || !isTagged() ||
+        getFirstTag() != PackedArrayTraits<T>::tag) {
+      return false;
+    }
+    Slice v(_start + (*_start == 0xee ? 2 : 9));
+    if (!v.isBinary()) {
+      return false;
+    }
+    uint8_t const h = v.head();
+    return readIntegerNonEmpty<ValueLength>(v.start() + 1, h - 0xbf) %
+               sizeof(T) == 0;
+  }
+
+  // check if the slice is a packed array of numbers of any type
+  bool isPackedArray(Options const* options = &Options::Defaults) const noexcept {
+    return isPackedArray<int64_t>(options) || isPackedArray<double>(options) ||
+           isPackedArray<float>(options);
+  }
+
+  // return a typed view on the values of a packed array of numbers
+  template <typename T>
+  PackedArrayView<T> getPackedArray(Options const* options = &Options::Defaults) const {
+    if (!isPackedArray<T>(options)) {
+      throw Exception(Exception::InvalidValueType,
+                      "Expecting packed array of matching type");
+    }
+    ValueLength length;
+    uint8_t const* data =
+        Slice(_start + (*_start == 0xee ? 2 : 9)).getBinary(length);
+    return PackedArrayView<T>(data, static_cast<std::size_t>(length / sizeof(T)));
+  }
+
   // get the total byte size for the slice, including the head byte, including tags
   ValueLength byteSize() const {
     return byteSize(start());
@@ -903,7 +1018,13 @@ class Slice {
   // get the offset for the nth member from an Array type
   ValueLength getNthOffset(ValueLength index) const;
 
-  Slice makeKey() const;
+  Slice makeKey() const {
+    return makeKey(nullptr);
+  }
+
+  // returns the key as a String Slice, translating integer keys with the
+  // specified translator (see translate())
+  Slice makeKey(AttributeTranslator const* translator) const;
 
   int compareString(StringRef const& value) const;
   
@@ -1092,9 +1213,21 @@ class Slice {
   }
   
   // translates an integer key into a string, without checks
-  Slice translateUnchecked() const;
+  Slice translateUnchecked(AttributeTranslator const* translator) const;
+
+  // look for the specified attribute inside a Slice that is known to be
+  // an Object
+  Slice searchObject(StringRef const& attribute,
+                     AttributeTranslator const* translator) const;
+
+  // look for the specified attribute inside a value that is not an
+  // Object. only shaped objects have attributes, and only if there is a
+  // shape registry in the Options (which may be a nullptr) or the defaults
+  Slice getFromNonObject(StringRef const& attribute,
+                         Options const* options) const;
 
-  Slice getFromCompactObject(StringRef const& attribute) const;
+  Slice getFromCompactObject(StringRef const& attribute,
+                             AttributeTranslator const* translator) const;
 
   // extract the nth member from an Array
   Slice getNth(ValueLength index) const;
@@ -1128,11 +1261,13 @@ class Slice {
 
   // perform a linear search for the specified attribute inside an Object
   Slice searchObjectKeyLinear(StringRef const& attribute, ValueLength ieBase,
-                              ValueLength offsetSize, ValueLength n) const;
+                              ValueLength offsetSize, ValueLength n,
+                              AttributeTranslator const* translator) const;
 
   // perform a binary search for the specified attribute inside an Object
   template<ValueLength offsetSize>
-  Slice searchObjectKeyBinary(StringRef const& attribute, ValueLength ieBase, ValueLength n) const;
+  Slice searchObjectKeyBinary(StringRef const& attribute, ValueLength ieBase, ValueLength n,
+                              AttributeTranslator const* translator) const;
 
   // extracts a pointer from the slice and converts it into a
   // built-in pointer type
@@ -606,6 +606,136 @@ struct SliceStaticData {
     /* 0xfa */ 0x0000000000000000,    /* 0xfb */ 0x0000000000000000,    
     /* 0xfc */ 0x0000000000000000,    /* 0xfd */ 0x0000000000000000,    
     /* 0xfe */ 0x0000000000000000,    /* 0xff */ 0x0000000000000000 
+#endif
+#ifdef VELOCYPACK_XXH3
+    /* 0x00 */ 0x737a2f80a0ca2b8e,    /* 0x01 */ 0x1dd4c4cb65c42d1c,
+    /* 0x02 */ 0x0000000000000000,    /* 0x03 */ 0x0000000000000000,
+    /* 0x04 */ 0x0000000000000000,    /* 0x05 */ 0x0000000000000000,
+    /* 0x06 */ 0x0000000000000000,    /* 0x07 */ 0x0000000000000000,
+    /* 0x08 */ 0x0000000000000000,    /* 0x09 */ 0x0000000000000000,
+    /* 0x0a */ 0x62af5d7dcecae60b,    /* 0x0b */ 0x0000000000000000,
+    /* 0x0c */ 0x0000000000000000,    /* 0x0d */ 0x0000000000000000,
+    /* 0x0e */ 0x0000000000000000,    /* 0x0f */ 0x0000000000000000,
+    /* 0x10 */ 0x0000000000000000,    /* 0x11 */ 0x0000000000000000,
+    /* 0x12 */ 0x0000000000000000,    /* 0x13 */ 0x0000000000000000,
+    /* 0x14 */ 0x0000000000000000,    /* 0x15 */ 0x0000000000000000,
+    /* 0x16 */ 0x0000000000000000,    /* 0x17 */ 0x49572ec8e2306df2,
+    /* 0x18 */ 0x5243c219a4b89def,    /* 0x19 */ 0xbbfd11ef7e92f0f9,
+    /* 0x1a */ 0xd85be8a72b86a8c1,    /* 0x1b */ 0x0000000000000000,
+    /* 0x1c */ 0x0000000000000000,    /* 0x1d */ 0x0000000000000000,
+    /* 0x1e */ 0x20df353102e08df2,    /* 0x1f */ 0xc6285beee1d3683c,
+    /* 0x20 */ 0x0000000000000000,    /* 0x21 */ 0x0000000000000000,
+    /* 0x22 */ 0x0000000000000000,    /* 0x23 */ 0x0000000000000000,
+    /* 0x24 */ 0x0000000000000000,    /* 0x25 */ 0x0000000000000000,
+    /* 0x26 */ 0x0000000000000000,    /* 0x27 */ 0x0000000000000000,
+    /* 0x28 */ 0x0000000000000000,    /* 0x29 */ 0x0000000000000000,
+    /* 0x2a */ 0x0000000000000000,    /* 0x2b */ 0x0000000000000000,
+    /* 0x2c */ 0x0000000000000000,    /* 0x2d */ 0x0000000000000000,
+    /* 0x2e */ 0x0000000000000000,    /* 0x2f */ 0x0000000000000000,
+    /* 0x30 */ 0x2119e849f9ce631b,    /* 0x31 */ 0xc505854ca2315927,
+    /* 0x32 */ 0x3b07ef9c6c372d75,    /* 0x33 */ 0x749385d4967e0d37,
+    /* 0x34 */ 0xb67db024dff35d83,    /* 0x35 */ 0x850c4b0d5f468284,
+    /* 0x36 */ 0xc8bcd183baf7f454,    /* 0x37 */ 0xa26e411d20bfc313,
+    /* 0x38 */ 0xe48dfb36cf2c940c,    /* 0x39 */ 0x3bffc34f454744ec,
+    /* 0x3a */ 0x239035fd4d4cca0c,    /* 0x3b */ 0x8a2459c18c8e4b2a,
+    /* 0x3c */ 0xb6093a2729c11f78,    /* 0x3d */ 0x1db66dd50173d9d4,
+    /* 0x3e */ 0x16d76895a3fb09ba,    /* 0x3f */ 0xae19e89c3717b99a,
+    /* 0x40 */ 0xf81844b741e55073,    /* 0x41 */ 0x0000000000000000,
+    /* 0x42 */ 0x0000000000000000,    /* 0x43 */ 0x0000000000000000,
+    /* 0x44 */ 0x0000000000000000,    /* 0x45 */ 0x0000000000000000,
+    /* 0x46 */ 0x0000000000000000,    /* 0x47 */ 0x0000000000000000,
+    /* 0x48 */ 0x0000000000000000,    /* 0x49 */ 0x0000000000000000,
+    /* 0x4a */ 0x0000000000000000,    /* 0x4b */ 0x0000000000000000,
+    /* 0x4c */ 0x0000000000000000,    /* 0x4d */ 0x0000000000000000,
+    /* 0x4e */ 0x0000000000000000,    /* 0x4f */ 0x0000000000000000,
+    /* 0x50 */ 0x0000000000000000,    /* 0x51 */ 0x0000000000000000,
+    /* 0x52 */ 0x0000000000000000,    /* 0x53 */ 0x0000000000000000,
+    /* 0x54 */ 0x0000000000000000,    /* 0x55 */ 0x0000000000000000,
+    /* 0x56 */ 0x0000000000000000,    /* 0x57 */ 0x0000000000000000,
+    /* 0x58 */ 0x0000000000000000,    /* 0x59 */ 0x0000000000000000,
+    /* 0x5a */ 0x0000000000000000,    /* 0x5b */ 0x0000000000000000,
+    /* 0x5c */ 0x0000000000000000,    /* 0x5d */ 0x0000000000000000,
+    /* 0x5e */ 0x0000000000000000,    /* 0x5f */ 0x0000000000000000,
+    /* 0x60 */ 0x0000000000000000,    /* 0x61 */ 0x0000000000000000,
+    /* 0x62 */ 0x0000000000000000,    /* 0x63 */ 0x0000000000000000,
+    /* 0x64 */ 0x0000000000000000,    /* 0x65 */ 0x0000000000000000,
+    /* 0x66 */ 0x0000000000000000,    /* 0x67 */ 0x0000000000000000,
+    /* 0x68 */ 0x0000000000000000,    /* 0x69 */ 0x0000000000000000,
+    /* 0x6a */ 0x0000000000000000,    /* 0x6b */ 0x0000000000000000,
+    /* 0x6c */ 0x0000000000000000,    /* 0x6d */ 0x0000000000000000,
+    /* 0x6e */ 0x0000000000000000,    /* 0x6f */ 0x0000000000000000,
+    /* 0x70 */ 0x0000000000000000,    /* 0x71 */ 0x0000000000000000,
+    /* 0x72 */ 0x0000000000000000,    /* 0x73 */ 0x0000000000000000,
+    /* 0x74 */ 0x0000000000000000,    /* 0x75 */ 0x0000000000000000,
+    /* 0x76 */ 0x0000000000000000,    /* 0x77 */ 0x0000000000000000,
+    /* 0x78 */ 0x0000000000000000,    /* 0x79 */ 0x0000000000000000,
+    /* 0x7a */ 0x0000000000000000,    /* 0x7b */ 0x0000000000000000,
+    /* 0x7c */ 0x0000000000000000,    /* 0x7d */ 0x0000000000000000,
+    /* 0x7e */ 0x0000000000000000,    /* 0x7f */ 0x0000000000000000,
+    /* 0x80 */ 0x0000000000000000,    /* 0x81 */ 0x0000000000000000,
+    /* 0x82 */ 0x0000000000000000,    /* 0x83 */ 0x0000000000000000,
+    /* 0x84 */ 0x0000000000000000,    /* 0x85 */ 0x0000000000000000,
+    /* 0x86 */ 0x0000000000000000,    /* 0x87 */ 0x0000000000000000,
+    /* 0x88 */ 0x0000000000000000,    /* 0x89 */ 0x0000000000000000,
+    /* 0x8a */ 0x0000000000000000,    /* 0x8b */ 0x0000000000000000,
+    /* 0x8c */ 0x0000000000000000,    /* 0x8d */ 0x0000000000000000,
+    /* 0x8e */ 0x0000000000000000,    /* 0x8f */ 0x0000000000000000,
+    /* 0x90 */ 0x0000000000000000,    /* 0x91 */ 0x0000000000000000,
+    /* 0x92 */ 0x0000000000000000,    /* 0x93 */ 0x0000000000000000,
+    /* 0x94 */ 0x0000000000000000,    /* 0x95 */ 0x0000000000000000,
+    /* 0x96 */ 0x0000000000000000,    /* 0x97 */ 0x0000000000000000,
+    /* 0x98 */ 0x0000000000000000,    /* 0x99 */ 0x0000000000000000,
+    /* 0x9a */ 0x0000000000000000,    /* 0x9b */ 0x0000000000000000,
+    /* 0x9c */ 0x0000000000000000,    /* 0x9d */ 0x0000000000000000,
+    /* 0x9e */ 0x0000000000000000,    /* 0x9f */ 0x0000000000000000,
+    /* 0xa0 */ 0x0000000000000000,    /* 0xa1 */ 0x0000000000000000,
+    /* 0xa2 */ 0x0000000000000000,    /* 0xa3 */ 0x0000000000000000,
+    /* 0xa4 */ 0x0000000000000000,    /* 0xa5 */ 0x0000000000000000,
+    /* 0xa6 */ 0x0000000000000000,    /* 0xa7 */ 0x0000000000000000,
+    /* 0xa8 */ 0x0000000000000000,    /* 0xa9 */ 0x0000000000000000,
+    /* 0xaa */ 0x0000000000000000,    /* 0xab */ 0x0000000000000000,
+    /* 0xac */ 0x0000000000000000,    /* 0xad */ 0x0000000000000000,
+    /* 0xae */ 0x0000000000000000,    /* 0xaf */ 0x0000000000000000,
+    /* 0xb0 */ 0x0000000000000000,    /* 0xb1 */ 0x0000000000000000,
+    /* 0xb2 */ 0x0000000000000000,    /* 0xb3 */ 0x0000000000000000,
+    /* 0xb4 */ 0x0000000000000000,    /* 0xb5 */ 0x0000000000000000,
+    /* 0xb6 */ 0x0000000000000000,    /* 0xb7 */ 0x0000000000000000,
+    /* 0xb8 */ 0x0000000000000000,    /* 0xb9 */ 0x0000000000000000,
+    /* 0xba */ 0x0000000000000000,    /* 0xbb */ 0x0000000000000000,
+    /* 0xbc */ 0x0000000000000000,    /* 0xbd */ 0x0000000000000000,
+    /* 0xbe */ 0x0000000000000000,    /* 0xbf */ 0x0000000000000000,
+    /* 0xc0 */ 0x0000000000000000,    /* 0xc1 */ 0x0000000000000000,
+    /* 0xc2 */ 0x0000000000000000,    /* 0xc3 */ 0x0000000000000000,
+    /* 0xc4 */ 0x0000000000000000,    /* 0xc5 */ 0x0000000000000000,
+    /* 0xc6 */ 0x0000000000000000,    /* 0xc7 */ 0x0000000000000000,
+    /* 0xc8 */ 0x0000000000000000,    /* 0xc9 */ 0x0000000000000000,
+    /* 0xca */ 0x0000000000000000,    /* 0xcb */ 0x0000000000000000,
+    /* 0xcc */ 0x0000000000000000,    /* 0xcd */ 0x0000000000000000,
+    /* 0xce */ 0x0000000000000000,    /* 0xcf */ 0x0000000000000000,
+    /* 0xd0 */ 0x0000000000000000,    /* 0xd1 */ 0x0000000000000000,
+    /* 0xd2 */ 0x0000000000000000,    /* 0xd3 */ 0x0000000000000000,
+    /* 0xd4 */ 0x0000000000000000,    /* 0xd5 */ 0x0000000000000000,
+    /* 0xd6 */ 0x0000000000000000,    /* 0xd7 */ 0x0000000000000000,
+    /* 0xd8 */ 0x0000000000000000,    /* 0xd9 */ 0x0000000000000000,
+    /* 0xda */ 0x0000000000000000,    /* 0xdb */ 0x0000000000000000,
+    /* 0xdc */ 0x0000000000000000,    /* 0xdd */ 0x0000000000000000,
+    /* 0xde */ 0x0000000000000000,    /* 0xdf */ 0x0000000000000000,
+    /* 0xe0 */ 0x0000000000000000,    /* 0xe1 */ 0x0000000000000000,
+    /* 0xe2 */ 0x0000000000000000,    /* 0xe3 */ 0x0000000000000000,
+    /* 0xe4 */ 0x0000000000000000,    /* 0xe5 */ 0x0000000000000000,
+    /* 0xe6 */ 0x0000000000000000,    /* 0xe7 */ 0x0000000000000000,
+    /* 0xe8 */ 0x0000000000000000,    /* 0xe9 */ 0x0000000000000000,
+    /* 0xea */ 0x0000000000000000,    /* 0xeb */ 0x0000000000000000,
+    /* 0xec */ 0x0000000000000000,    /* 0xed */ 0x0000000000000000,
+    /* 0xee */ 0x0000000000000000,    /* 0xef */ 0x0000000000000000,
+    /* 0xf0 */ 0x0000000000000000,    /* 0xf1 */ 0x0000000000000000,
+    /* 0xf2 */ 0x0000000000000000,    /* 0xf3 */ 0x0000000000000000,
+    /* 0xf4 */ 0x0000000000000000,    /* 0xf5 */ 0x0000000000000000,
+    /* 0xf6 */ 0x0000000000000000,    /* 0xf7 */ 0x0000000000000000,
+    /* 0xf8 */ 0x0000000000000000,    /* 0xf9 */ 0x0000000000000000,
+    /* 0xfa */ 0x0000000000000000,    /* 0xfb */ 0x0000000000000000,
+    /* 0xfc */ 0x0000000000000000,    /* 0xfd */ 0x0000000000000000,
+    /* 0xfe */ 0x0000000000000000,    /* 0xff */ 0x0000000000000000
 #endif
   };
 };
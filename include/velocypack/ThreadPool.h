@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VELOCYPACK_THREADPOOL_H
+#define VELOCYPACK_THREADPOOL_H 1
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "velocypack/velocypack-common.h"
+
+namespace arangodb {
+namespace velocypack {
+
+// a pool of worker threads for the parallel variants of Validator,
+// StreamValidator, Dumper, CompressedReader and Collection. the threads
+// are started when the pool is first given more than one task, and are
+// kept until the pool is destroyed, so a pool that is used for many
+// calls pays for starting its threads only once.
+// a pool runs one batch of tasks at a time. concurrent calls to run()
+// wait for each other, and calls from within a task of the same pool
+// execute their tasks on the calling thread
+class ThreadPool {
+ public:
+  // a pool that runs up to numThreads tasks at the same time. the thread
+  // calling run() takes part, so numThreads - 1 worker threads are used
+  explicit ThreadPool(std::size_t numThreads);
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  // maximum number of tasks that run at the same time
+  std::size_t size() const noexcept { return _size; }
+
+  // calls cb(task) for each task in [0, numTasks) and waits until all of
+  // them are done. returns the exception thrown by each task, if any
+  std::vector<std::exception_ptr> run(std::size_t numTasks,
+                                      std::function<void(std::size_t)> const& cb);
+
+ private:
+  struct Batch;
+
+  void startWorkers();
+  void workerLoop();
+  void work(Batch& batch);
+
+  std::size_t const _size;
+  // serializes calls to run()
+  std::mutex _runMutex;
+  // protects the members below
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _done;
+  std::vector<std::thread> _workers;
+  Batch* _batch;
+  uint64_t _generation;
+  bool _stop;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
@@ -0,0 +1,459 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VELOCYPACK_TRUSTED_SLICE_H
+#define VELOCYPACK_TRUSTED_SLICE_H 1
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Iterator.h"
+#include "velocypack/Slice.h"
+#include "velocypack/StringRef.h"
+#include "velocypack/ValueType.h"
+
+namespace arangodb {
+namespace velocypack {
+class AttributeTranslator;
+
+// a read-only view over VelocyPack data that is known to be valid, e.g.
+// because it was produced by our own Builder or has passed the Validator.
+// the accessors provide the same results as their Slice counterparts, but
+// perform no type checks and no bounds checks, and have no throwing
+// branches of their own. calling an accessor on a value of the wrong type
+// or with an index beyond the end of a compound value has undefined
+// behavior. the only errors left are configuration errors, e.g. translating
+// integer keys without an AttributeTranslator.
+//
+// use TrustedSlice, TrustedArrayIterator and TrustedObjectIterator in hot
+// loops over trusted data, and Slice everywhere else
+class TrustedSlice {
+  friend class TrustedArrayIterator;
+  friend class TrustedObjectIterator;
+
+ public:
+  constexpr TrustedSlice() noexcept : _slice() {}
+
+  constexpr explicit TrustedSlice(Slice slice) noexcept : _slice(slice) {}
+
+  constexpr explicit TrustedSlice(uint8_t const* start) noexcept
+      : _slice(start) {}
+
+  // the underlying (checked) Slice
+  constexpr Slice slice() const noexcept { return _slice; }
+
+  uint8_t const* start() const noexcept { return _slice.start(); }
+
+  uint8_t head() const noexcept { return _slice.head(); }
+
+  ValueType type() const noexcept { return _slice.type(); }
+
+  bool isNone() const noexcept { return _slice.isNone(); }
+  bool isNull() const noexcept { return _slice.isNull(); }
+  bool isBool() const noexcept { return _slice.isBool(); }
+  bool isArray() const noexcept { return _slice.isArray(); }
+  bool isObject() const noexcept { return _slice.isObject(); }
+  bool isDouble() const noexcept { return _slice.isDouble(); }
+  bool isInt() const noexcept { return _slice.isInt(); }
+  bool isUInt() const noexcept { return _slice.isUInt(); }
+  bool isSmallInt() const noexcept { return _slice.isSmallInt(); }
+  bool isNumber() const noexcept { return _slice.isNumber(); }
+  bool isString() const noexcept { return _slice.isString(); }
+
+  ValueLength byteSize() const { return _slice.byteSize(); }
+
+  // return the value for a Bool object
+  bool getBool() const noexcept { return head() == 0x1a; }
+
+  // return the value for a Double object
+  double getDouble() const noexcept {
+    union {
+      uint64_t dv;
+      double d;
+    } v;
+    v.dv = readIntegerFixed<uint64_t, 8>(start() + 1);
+    return v.d;
+  }
+
+  // return the value for an Int, UInt or SmallInt object. UInt values
+  // beyond the range of int64_t wrap around
+  int64_t getInt() const noexcept {
+    uint8_t const h = head();
+    if (h >= 0x28 && h <= 0x2f) {
+      return static_cast<int64_t>(_slice.getUIntUnchecked());
+    }
+    return _slice.getIntUnchecked();
+  }
+
+  // return the value for a UInt, Int or SmallInt object. negative values
+  // wrap around
+  uint64_t getUInt() const noexcept {
+    uint8_t const h = head();
+    if (h >= 0x28 && h <= 0x2f) {
+      return _slice.getUIntUnchecked();
+    }
+    return static_cast<uint64_t>(_slice.getIntUnchecked());
+  }
+
+  // return the value for a SmallInt object
+  int64_t getSmallInt() const noexcept {
+    return _slice.getSmallIntUnchecked();
+  }
+
+  // return the value of any numeric object, converted to T without range
+  // checks
+  template <typename T>
+  T getNumber() const noexcept {
+    static_assert(std::is_arithmetic<T>::value, "expecting numeric type");
+    uint8_t const h = head();
+    if (h == 0x1b) {
+      return static_cast<T>(getDouble());
+    }
+    if (h >= 0x28 && h <= 0x2f) {
+      return static_cast<T>(_slice.getUIntUnchecked());
+    }
+    return static_cast<T>(_slice.getIntUnchecked());
+  }
+
+  // return the value for a String object
+  char const* getString(ValueLength& length) const noexcept {
+    return _slice.getStringUnchecked(length);
+  }
+
+  // return the length of the String slice
+  ValueLength getStringLength() const noexcept {
+    uint8_t const h = head();
+    if (h == 0xbf) {
+      return readIntegerFixed<ValueLength, 8>(start() + 1);
+    }
+    return h - 0x40;
+  }
+
+  StringRef stringRef() const noexcept {
+    ValueLength length;
+    char const* p = _slice.getStringUnchecked(length);
+    return StringRef(p, static_cast<std::size_t>(length));
+  }
+
+  std::string copyString() const {
+    ValueLength length;
+    char const* p = _slice.getStringUnchecked(length);
+    return std::string(p, static_cast<std::size_t>(length));
+  }
+
+  // return the number of members for an Array or Object object
+  ValueLength length() const {
+    uint8_t const h = head();
+    if (h == 0x01 || h == 0x0a) {
+      // empty Array or Object
+      return 0;
+    }
+
+    if (h == 0x13 || h == 0x14) {
+      // compact Array or Object
+      ValueLength end = readVariableValueLength<false>(start() + 1);
+      return readVariableValueLength<true>(start() + end - 1);
+    }
+
+    ValueLength const offsetSize = _slice.indexEntrySize(h);
+    ValueLength end = readIntegerNonEmpty<ValueLength>(start() + 1, offsetSize);
+
+    if (h <= 0x05) {
+      // no index table and no length, all members have the same byte size
+      ValueLength const dataOffset = _slice.findDataOffset(h);
+      return (end - dataOffset) / Slice(start() + dataOffset).byteSize();
+    }
+    if (offsetSize < 8) {
+      return readIntegerNonEmpty<ValueLength>(start() + offsetSize + 1, offsetSize);
+    }
+    return readIntegerNonEmpty<ValueLength>(start() + end - offsetSize, offsetSize);
+  }
+
+  // extract the array value at the specified index
+  TrustedSlice at(ValueLength index) const {
+    return TrustedSlice(start() + nthOffset(index));
+  }
+
+  TrustedSlice operator[](ValueLength index) const {
+    return at(index);
+  }
+
+  // extract a key from an Object at the specified index. integer keys
+  // are translated if translate is true
+  TrustedSlice keyAt(ValueLength index, bool translate = true) const {
+    return TrustedSlice(start() + nthOffset(index)).makeKey(translate);
+  }
+
+  // extract a value from an Object at the specified index
+  TrustedSlice valueAt(ValueLength index) const {
+    uint8_t const* key = start() + nthOffset(index);
+    return TrustedSlice(key + Slice(key).byteSize());
+  }
+
+  // look for the specified attribute inside an Object
+  // returns a TrustedSlice(ValueType::None) if not found. unlike Slice::get(),
+  // this does not resolve attributes of shaped objects
+  TrustedSlice get(StringRef const& attribute,
+                   AttributeTranslator const* translator = nullptr) const {
+    return TrustedSlice(_slice.searchObject(attribute, translator));
+  }
+
+  TrustedSlice get(std::string const& attribute) const {
+    return get(StringRef(attribute.data(), attribute.size()));
+  }
+
+  TrustedSlice get(char const* attribute) const {
+    return get(StringRef(attribute));
+  }
+
+ private:
+  // the key itself if it is a String, or its translation if it is an
+  // integer and translate is true
+  TrustedSlice makeKey(bool translate) const {
+    if (!translate || isString()) {
+      return *this;
+    }
+    return TrustedSlice(_slice.makeKey());
+  }
+
+  // get the offset for the nth member of a non-empty Array or Object
+  ValueLength nthOffset(ValueLength index) const {
+    uint8_t const h = head();
+
+    if (h == 0x13 || h == 0x14) {
+      // compact Array or Object, need to skip over the preceding members
+      ValueLength offset = _slice.getStartOffsetFromCompact();
+      while (index-- > 0) {
+        offset += Slice(start() + offset).byteSize();
+        if (h == 0x14) {
+          offset += Slice(start() + offset).byteSize();
+        }
+      }
+      return offset;
+    }
+
+    ValueLength const dataOffset = _slice.findDataOffset(h);
+    if (h <= 0x05) {
+      // no index table, all members have the same byte size
+      return dataOffset + index * Slice(start() + dataOffset).byteSize();
+    }
+
+    ValueLength const offsetSize = _slice.indexEntrySize(h);
+    ValueLength end = readIntegerNonEmpty<ValueLength>(start() + 1, offsetSize);
+    ValueLength n;
+    if (offsetSize < 8) {
+      n = readIntegerNonEmpty<ValueLength>(start() + 1 + offsetSize, offsetSize);
+    } else {
+      n = readIntegerNonEmpty<ValueLength>(start() + end - offsetSize, offsetSize);
+    }
+    if (n == 1) {
+      // a single member, there is no index table
+      return dataOffset;
+    }
+
+    ValueLength const ieBase =
+        end - n * offsetSize + index * offsetSize - (offsetSize == 8 ? 8 : 0);
+    return readIntegerNonEmpty<ValueLength>(start() + ieBase, offsetSize);
+  }
+
+  Slice _slice;
+};
+
+// iterates over the members of an Array that is known to be valid. there
+// are no checks on construction or access: the Slice must be an Array,
+// and value() must only be called while valid() is true
+class TrustedArrayIterator {
+ public:
+  TrustedArrayIterator() = delete;
+
+  explicit TrustedArrayIterator(TrustedSlice slice)
+      : _size(slice.length()), _position(0), _current(nullptr) {
+    if (_size > 0) {
+      uint8_t const h = slice.head();
+      if (h == 0x13) {
+        _current = slice.start() + slice._slice.getStartOffsetFromCompact();
+      } else {
+        _current = slice.start() + slice._slice.findDataOffset(h);
+      }
+    }
+  }
+
+  explicit TrustedArrayIterator(Slice slice)
+      : TrustedArrayIterator(TrustedSlice(slice)) {}
+
+  // prefix ++
+  TrustedArrayIterator& operator++() {
+    _current += Slice(_current).byteSize();
+    ++_position;
+    return *this;
+  }
+
+  bool operator==(TrustedArrayIterator const& other) const noexcept {
+    return _position == other._position;
+  }
+  bool operator!=(TrustedArrayIterator const& other) const noexcept {
+    return !operator==(other);
+  }
+
+  Slice operator*() const noexcept { return Slice(_current); }
+
+  TrustedArrayIterator begin() const noexcept { return *this; }
+
+  TrustedArrayIterator end() const noexcept {
+    auto it = TrustedArrayIterator(*this);
+    it._position = it._size;
+    return it;
+  }
+
+  inline bool valid() const noexcept { return (_position < _size); }
+
+  inline Slice value() const noexcept { return Slice(_current); }
+
+  inline void next() { operator++(); }
+
+  inline ValueLength index() const noexcept { return _position; }
+
+  inline ValueLength size() const noexcept { return _size; }
+
+  inline bool isFirst() const noexcept { return (_position == 0); }
+
+  inline bool isLast() const noexcept { return (_position + 1 >= _size); }
+
+ private:
+  ValueLength _size;
+  ValueLength _position;
+  uint8_t const* _current;
+};
+
+// iterates over the members of an Object that is known to be valid. there
+// are no checks on construction or access: the Slice must be an Object,
+// and key() and value() must only be called while valid() is true.
+// as with ObjectIterator, useSequentialIteration determines whether the
+// members are visited in storage order or in index table order
+class TrustedObjectIterator {
+ public:
+  using ObjectPair = ObjectIteratorPair;
+
+  TrustedObjectIterator() = delete;
+
+  explicit TrustedObjectIterator(TrustedSlice slice,
+                                 bool useSequentialIteration = false)
+      : _start(slice.start()), _size(slice.length()), _position(0),
+        _current(nullptr), _indexTable(nullptr), _offsetSize(0) {
+    if (_size > 0) {
+      uint8_t const h = slice.head();
+      if (h == 0x14) {
+        _current = _start + slice._slice.getStartOffsetFromCompact();
+      } else if (useSequentialIteration || _size == 1) {
+        _current = _start + slice._slice.findDataOffset(h);
+      } else {
+        _offsetSize = slice._slice.indexEntrySize(h);
+        ValueLength end = readIntegerNonEmpty<ValueLength>(_start + 1, _offsetSize);
+        _indexTable = _start + end - _size * _offsetSize -
+                      (_offsetSize == 8 ? 8 : 0);
+      }
+    }
+  }
+
+  explicit TrustedObjectIterator(Slice slice,
+                                 bool useSequentialIteration = false)
+      : TrustedObjectIterator(TrustedSlice(slice), useSequentialIteration) {}
+
+  // prefix ++
+  TrustedObjectIterator& operator++() {
+    ++_position;
+    if (_indexTable == nullptr) {
+      // skip over key and value
+      _current += Slice(_current).byteSize();
+      _current += Slice(_current).byteSize();
+    }
+    return *this;
+  }
+
+  bool operator==(TrustedObjectIterator const& other) const noexcept {
+    return _position == other._position;
+  }
+  bool operator!=(TrustedObjectIterator const& other) const noexcept {
+    return !operator==(other);
+  }
+
+  ObjectPair operator*() const {
+    uint8_t const* key = keyStart();
+    return ObjectPair(TrustedSlice(key).makeKey(true).slice(),
+                      Slice(key + Slice(key).byteSize()));
+  }
+
+  TrustedObjectIterator begin() const noexcept { return *this; }
+
+  TrustedObjectIterator end() const noexcept {
+    auto it = TrustedObjectIterator(*this);
+    it._position = it._size;
+    return it;
+  }
+
+  inline bool valid() const noexcept { return (_position < _size); }
+
+  inline Slice key(bool translate = true) const {
+    return TrustedSlice(keyStart()).makeKey(translate).slice();
+  }
+
+  inline Slice value() const {
+    uint8_t const* key = keyStart();
+    return Slice(key + Slice(key).byteSize());
+  }
+
+  inline void next() { operator++(); }
+
+  inline ValueLength index() const noexcept { return _position; }
+
+  inline ValueLength size() const noexcept { return _size; }
+
+  inline bool isFirst() const noexcept { return (_position == 0); }
+
+  inline bool isLast() const noexcept { return (_position + 1 >= _size); }
+
+ private:
+  uint8_t const* keyStart() const noexcept {
+    if (_indexTable == nullptr) {
+      return _current;
+    }
+    return _start + readIntegerNonEmpty<ValueLength>(
+                        _indexTable + _position * _offsetSize, _offsetSize);
+  }
+
+  uint8_t const* _start;
+  ValueLength _size;
+  ValueLength _position;
+  uint8_t const* _current;
+  // start of the index table, if the iteration uses it
+  uint8_t const* _indexTable;
+  ValueLength _offsetSize;
+};
+
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
@@ -26,7 +26,10 @@
 #define VELOCYPACK_VALIDATOR_H 1
 
 #include "velocypack/velocypack-common.h"
+#include "velocypack/Buffer.h"
+#include "velocypack/Exception.h"
 #include "velocypack/Options.h"
+#include "velocypack/ThreadPool.h"
 
 namespace arangodb {
 namespace velocypack {
@@ -49,24 +52,207 @@ class Validator {
   // validates a VelocyPack Slice value starting at ptr, with length bytes length
   // throws if the data is invalid
   bool validate(uint8_t const* ptr, std::size_t length, bool isSubPart = false);
+  
+  // validates a VelocyPack Slice value like validate(), but if the value is
+  // an Array or Object with an index table, its members are split into 
+  // ranges that are validated by up to numThreads threads. If the data is
+  // invalid, throws the same exception as validate() would
+  bool validateParallel(char const* ptr, std::size_t length, std::size_t numThreads, 
+                        bool isSubPart = false) {
+    return validateParallel(reinterpret_cast<uint8_t const*>(ptr), length, numThreads, isSubPart);
+  }
+  
+  // validates a VelocyPack Slice value like validate(), but if the value is
+  // an Array or Object with an index table, its members are split into 
+  // ranges that are validated by up to numThreads threads. If the data is
+  // invalid, throws the same exception as validate() would
+  bool validateParallel(uint8_t const* ptr, std::size_t length, std::size_t numThreads, 
+                        bool isSubPart = false);
+
+  // validates like validateParallel(), but runs the ranges on the threads
+  // of pool, which can be reused for many values
+  bool validateParallel(char const* ptr, std::size_t length, ThreadPool& pool, 
+                        bool isSubPart = false) {
+    return validateParallel(reinterpret_cast<uint8_t const*>(ptr), length, pool, isSubPart);
+  }
+
+  bool validateParallel(uint8_t const* ptr, std::size_t length, ThreadPool& pool, 
+                        bool isSubPart = false);
+
+  // validates like validate(), but reports invalid data by returning the
+  // error instead of throwing it, which makes rejecting it much cheaper.
+  // the position of the error is the offset of the offending value from ptr
+  Status tryValidate(char const* ptr, std::size_t length, bool isSubPart = false) {
+    return tryValidate(reinterpret_cast<uint8_t const*>(ptr), length, isSubPart);
+  }
+
+  Status tryValidate(uint8_t const* ptr, std::size_t length, bool isSubPart = false);
+
+  // validates like validateParallel(), but returns the error like
+  // tryValidate()
+  Status tryValidateParallel(char const* ptr, std::size_t length, std::size_t numThreads,
+                             bool isSubPart = false) {
+    return tryValidateParallel(reinterpret_cast<uint8_t const*>(ptr), length, numThreads, isSubPart);
+  }
+
+  Status tryValidateParallel(uint8_t const* ptr, std::size_t length, std::size_t numThreads,
+                             bool isSubPart = false);
+
+  Status tryValidateParallel(char const* ptr, std::size_t length, ThreadPool& pool,
+                             bool isSubPart = false) {
+    return tryValidateParallel(reinterpret_cast<uint8_t const*>(ptr), length, pool, isSubPart);
+  }
+
+  Status tryValidateParallel(uint8_t const* ptr, std::size_t length, ThreadPool& pool,
+                             bool isSubPart = false);
 
  private:
+  // layout of an Array or Object with index table
+  struct IndexedLayout {
+    uint8_t const* indexTable;
+    uint8_t const* firstMember;
+    ValueLength byteSizeLength;
+    ValueLength nrItems;
+  };
+
+  // the checks record the first error with fail() and return right
+  // away, as does every caller up to the entry point. the entry points
+  // then either throw or return the error
+  void begin(uint8_t const* ptr) noexcept {
+    _base = ptr;
+    _errorMessage = nullptr;
+  }
+
+  void fail(uint8_t const* ptr, Exception::ExceptionType code, char const* message) noexcept {
+    if (_errorMessage == nullptr) {
+      _errorCode = code;
+      _errorMessage = message;
+      _errorPtr = ptr;
+    }
+  }
+
+  void fail(uint8_t const* ptr, Exception::ExceptionType code) noexcept {
+    fail(ptr, code, Exception::message(code));
+  }
+
+  // takes over the error of a validator of a range of members
+  void adoptError(Validator const& other) noexcept {
+    fail(other._errorPtr, other._errorCode, other._errorMessage);
+  }
+
+  bool failed() const noexcept { return _errorMessage != nullptr; }
+
+  void throwIfFailed() const {
+    if (VELOCYPACK_UNLIKELY(failed())) {
+      throw Exception(_errorCode, _errorMessage);
+    }
+  }
+
+  Status status() const noexcept {
+    if (!failed()) {
+      return Status();
+    }
+    return Status(_errorCode, _errorMessage, static_cast<std::size_t>(_errorPtr - _base));
+  }
+
+  void validateValue(uint8_t const* ptr, std::size_t length, bool isSubPart);
+  void validateValueParallel(uint8_t const* ptr, std::size_t length, ThreadPool& pool,
+                             bool isSubPart);
   void validateArray(uint8_t const* ptr, std::size_t length);
   void validateCompactArray(uint8_t const* ptr, std::size_t length);
   void validateUnindexedArray(uint8_t const* ptr, std::size_t length);
   void validateIndexedArray(uint8_t const* ptr, std::size_t length);
+  IndexedLayout validateIndexedArrayLayout(uint8_t const* ptr, std::size_t length);
+  uint8_t const* validateIndexedArrayMembers(uint8_t const* ptr, IndexedLayout const& layout,
+                                             uint8_t const* member, ValueLength position,
+                                             ValueLength stopAt, bool isLast);
+  void validateIndexedArrayParallel(uint8_t const* ptr, std::size_t length, ThreadPool& pool);
   void validateObject(uint8_t const* ptr, std::size_t length);
   void validateCompactObject(uint8_t const* ptr, std::size_t length);
   void validateIndexedObject(uint8_t const* ptr, std::size_t length);
-  void validateBufferLength(std::size_t expected, std::size_t actual, bool isSubPart);
-  void validateSliceLength(uint8_t const* ptr, std::size_t length, bool isSubPart);
+  IndexedLayout validateIndexedObjectLayout(uint8_t const* ptr, std::size_t length);
+  uint8_t const* validateObjectMember(uint8_t const* member, uint8_t const* indexTable);
+  uint8_t const* validateIndexedObjectMembers(uint8_t const* ptr, IndexedLayout const& layout,
+                                              ValueLength const* offsets, uint8_t const* member, 
+                                              ValueLength position, ValueLength stopAt, 
+                                              bool isLast, bool& offsetsMatch);
+  void validateIndexedObjectParallel(uint8_t const* ptr, std::size_t length, ThreadPool& pool);
+  bool validateBufferLength(uint8_t const* ptr, std::size_t expected, std::size_t actual,
+                            bool isSubPart);
+  bool validateSliceLength(uint8_t const* ptr, std::size_t length, bool isSubPart);
   ValueLength readByteSize(uint8_t const*& ptr, uint8_t const* end);
 
  public:
   Options const* options;
 
+  // minimum number of members that validateParallel() hands to each
+  // thread. values with fewer members are validated on a single thread
+  ValueLength minMembersPerThread;
+
  private:
   int _level;
+  // start of the value validated by the entry point
+  uint8_t const* _base;
+  Exception::ExceptionType _errorCode;
+  char const* _errorMessage;
+  // the value at which the error was detected
+  uint8_t const* _errorPtr;
+};
+
+// validates a stream of consecutive VelocyPack values which arrives in
+// arbitrarily sized pieces, e.g. from a network connection or a file.
+// values that are entirely contained in a piece are validated in place,
+// only the bytes of a value which spans several pieces are buffered, so 
+// the memory usage is bounded by maxValueSize.
+// after an exception was thrown, the StreamValidator must not be fed again
+class StreamValidator {
+ public:
+  // values are validated with validateParallel() on a pool of numThreads
+  // threads, which is kept for the lifetime of the StreamValidator
+  explicit StreamValidator(Options const* options = &Options::Defaults,
+                           std::size_t numThreads = 1);
+
+  StreamValidator(StreamValidator const&) = delete;
+  StreamValidator& operator=(StreamValidator const&) = delete;
+
+  // feeds the next piece of the stream, validating all values that are
+  // completed by it. returns the number of values completed.
+  // throws if the data is invalid
+  std::size_t feed(char const* data, std::size_t length) {
+    return feed(reinterpret_cast<uint8_t const*>(data), length);
+  }
+  
+  // feeds the next piece of the stream, validating all values that are
+  // completed by it. returns the number of values completed.
+  // throws if the data is invalid
+  std::size_t feed(uint8_t const* data, std::size_t length);
+
+  // must be called at the end of the stream. throws if the stream
+  // ended in the middle of a value
+  void finish() const;
+
+  // number of values validated so far
+  uint64_t values() const noexcept { return _values; }
+  
+  // number of bytes validated so far
+  uint64_t bytes() const noexcept { return _bytes; }
+
+ private:
+  void validateValue(uint8_t const* ptr, ValueLength length);
+  void checkValueSize(ValueLength size) const;
+
+ public:
+  // maximum byte size of a single value. feeding a larger value throws
+  ValueLength maxValueSize;
+
+ private:
+  Validator _validator;
+  // reused for all values, so the threads are started only once
+  ThreadPool _pool;
+  Buffer<uint8_t> _pending;
+  ValueLength _pendingSize;
+  uint64_t _values;
+  uint64_t _bytes;
 };
 
 }  // namespace arangodb::velocypack
@@ -47,6 +47,65 @@ using VPackObjectIterator = arangodb::velocypack::ObjectIterator;
 #endif
 #endif
 
+#ifdef VELOCYPACK_NORMALIZED_HASH_CACHE_H
+#ifndef VELOCYPACK_ALIAS_NORMALIZED_HASH_CACHE
+#define VELOCYPACK_ALIAS_NORMALIZED_HASH_CACHE
+using VPackNormalizedHashCache = arangodb::velocypack::NormalizedHashCache;
+#endif
+#endif
+
+#ifdef VELOCYPACK_COLUMNAR_H
+#ifndef VELOCYPACK_ALIAS_COLUMNAR
+#define VELOCYPACK_ALIAS_COLUMNAR
+using VPackColumnar = arangodb::velocypack::Columnar;
+using VPackColumnarRow = arangodb::velocypack::ColumnarRow;
+using VPackColumnarView = arangodb::velocypack::ColumnarView;
+#endif
+#endif
+
+#ifdef VELOCYPACK_COMPACT_INDEX_H
+#ifndef VELOCYPACK_ALIAS_COMPACT_INDEX
+#define VELOCYPACK_ALIAS_COMPACT_INDEX
+using VPackCompactIndex = arangodb::velocypack::CompactIndex;
+#endif
+#endif
+
+#ifdef VELOCYPACK_COMPRESSION_H
+#ifndef VELOCYPACK_ALIAS_COMPRESSION
+#define VELOCYPACK_ALIAS_COMPRESSION
+using VPackLZCodec = arangodb::velocypack::LZCodec;
+using VPackCompressedWriter = arangodb::velocypack::CompressedWriter;
+using VPackCompressedReader = arangodb::velocypack::CompressedReader;
+using VPackCompressedBlock = arangodb::velocypack::CompressedBlock;
+#endif
+#endif
+
+#ifdef VELOCYPACK_CBOR_H
+#ifndef VELOCYPACK_ALIAS_CBOR
+#define VELOCYPACK_ALIAS_CBOR
+using VPackCborDumper = arangodb::velocypack::CborDumper;
+using VPackCborParser = arangodb::velocypack::CborParser;
+#endif
+#endif
+
+#ifdef VELOCYPACK_MESSAGEPACK_H
+#ifndef VELOCYPACK_ALIAS_MESSAGEPACK
+#define VELOCYPACK_ALIAS_MESSAGEPACK
+using VPackMessagePackDumper = arangodb::velocypack::MessagePackDumper;
+using VPackMessagePackParser = arangodb::velocypack::MessagePackParser;
+#endif
+#endif
+
+#ifdef VELOCYPACK_PACKED_ARRAY_VIEW_H
+#ifndef VELOCYPACK_ALIAS_PACKED_ARRAY_VIEW
+#define VELOCYPACK_ALIAS_PACKED_ARRAY_VIEW
+template <typename T>
+using VPackPackedArrayView = arangodb::velocypack::PackedArrayView<T>;
+template <typename T>
+using VPackPackedArrayTraits = arangodb::velocypack::PackedArrayTraits<T>;
+#endif
+#endif
+
 #ifdef VELOCYPACK_BUILDER_H
 #ifndef VELOCYPACK_ALIAS_BUILDER
 #define VELOCYPACK_ALIAS_BUILDER
@@ -91,6 +150,14 @@ using VPackCollection = arangodb::velocypack::Collection;
 #endif
 #endif
 
+#ifdef VELOCYPACK_ATTRIBUTEDICTIONARY_H
+#ifndef VELOCYPACK_ALIAS_ATTRIBUTEDICTIONARY
+#define VELOCYPACK_ALIAS_ATTRIBUTEDICTIONARY
+using VPackAttributeDictionary = arangodb::velocypack::AttributeDictionary;
+using VPackAttributeDictionaryTrainer = arangodb::velocypack::AttributeDictionaryTrainer;
+#endif
+#endif
+
 #ifdef VELOCYPACK_ATTRIBUTETRANSLATOR_H
 #ifndef VELOCYPACK_ALIAS_ATTRIBUTETRANSLATOR
 #define VELOCYPACK_ALIAS_ATTRIBUTETRANSLATOR
@@ -102,6 +169,7 @@ using VPackAttributeTranslator = arangodb::velocypack::AttributeTranslator;
 #ifndef VELOCYPACK_ALIAS_DUMPER
 #define VELOCYPACK_ALIAS_DUMPER
 using VPackDumper = arangodb::velocypack::Dumper;
+using VPackStreamingDumper = arangodb::velocypack::StreamingDumper;
 #endif
 #endif
 
@@ -109,6 +177,7 @@ using VPackDumper = arangodb::velocypack::Dumper;
 #ifndef VELOCYPACK_ALIAS_EXCEPTION
 #define VELOCYPACK_ALIAS_EXCEPTION
 using VPackException = arangodb::velocypack::Exception;
+using VPackStatus = arangodb::velocypack::Status;
 #endif
 #endif
 
@@ -138,6 +207,8 @@ using VPackCustomTypeHandler = arangodb::velocypack::CustomTypeHandler;
 #ifndef VELOCYPACK_ALIAS_PARSER
 #define VELOCYPACK_ALIAS_PARSER
 using VPackParser = arangodb::velocypack::Parser;
+using VPackJsonHandler = arangodb::velocypack::JsonHandler;
+using VPackJsonProjection = arangodb::velocypack::JsonProjection;
 #endif
 #endif
 
@@ -149,6 +220,13 @@ using VPackSerialize = arangodb::velocypack::Serialize;
 #endif
 #endif
 
+#ifdef VELOCYPACK_SHAPEREGISTRY_H
+#ifndef VELOCYPACK_ALIAS_SHAPEREGISTRY
+#define VELOCYPACK_ALIAS_SHAPEREGISTRY
+using VPackShapeRegistry = arangodb::velocypack::ShapeRegistry;
+#endif
+#endif
+
 #ifdef VELOCYPACK_SLICE_H
 #ifndef VELOCYPACK_ALIAS_SLICE
 #define VELOCYPACK_ALIAS_SLICE
@@ -170,6 +248,22 @@ using VPackStringRef = arangodb::velocypack::StringRef;
 #endif
 #endif
 
+#ifdef VELOCYPACK_THREADPOOL_H
+#ifndef VELOCYPACK_ALIAS_THREADPOOL
+#define VELOCYPACK_ALIAS_THREADPOOL
+using VPackThreadPool = arangodb::velocypack::ThreadPool;
+#endif
+#endif
+
+#ifdef VELOCYPACK_TRUSTED_SLICE_H
+#ifndef VELOCYPACK_ALIAS_TRUSTED_SLICE
+#define VELOCYPACK_ALIAS_TRUSTED_SLICE
+using VPackTrustedSlice = arangodb::velocypack::TrustedSlice;
+using VPackTrustedArrayIterator = arangodb::velocypack::TrustedArrayIterator;
+using VPackTrustedObjectIterator = arangodb::velocypack::TrustedObjectIterator;
+#endif
+#endif
+
 #ifdef VELOCYPACK_UTF8HELPER_H
 #ifndef VELOCYPACK_ALIAS_UTF8HELPER
 #define VELOCYPACK_ALIAS_UTF8HELPER
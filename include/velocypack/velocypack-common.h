@@ -38,6 +38,13 @@
 #define VELOCYPACK_UNLIKELY(v) v
 #endif
 
+// hint to the CPU that the memory at the address will be read soon
+#if defined(__GNUC__) || defined(__clang__)
+#define VELOCYPACK_PREFETCH(addr) __builtin_prefetch(addr, 0, 3)
+#else
+#define VELOCYPACK_PREFETCH(addr) 
+#endif
+
 // debug mode
 #ifndef NDEBUG
 #ifndef VELOCYPACK_DEBUG
@@ -85,10 +92,12 @@
 
 #ifndef VELOCYPACK_XXHASH
 #ifndef VELOCYPACK_FASTHASH
+#ifndef VELOCYPACK_XXH3
 // default to xxhash if no hash define is set
 #define VELOCYPACK_XXHASH
 #endif
 #endif
+#endif
 
 #include "velocypack/velocypack-memory.h"
 
@@ -101,6 +110,16 @@ extern "C" unsigned int XXH32(void const* input, std::size_t len, unsigned int s
 #define VELOCYPACK_HASH32(mem, size, seed) XXH32(mem, size, seed)
 #endif
 
+#ifdef VELOCYPACK_XXH3
+// forward for XXH functions declared elsewhere.
+// xxh3 has no 32 bit variant, so 32 bit hashes are still produced by XXH32
+extern "C" unsigned long long XXH3_64bits_withSeed(void const*, std::size_t, unsigned long long);
+extern "C" unsigned int XXH32(void const* input, std::size_t len, unsigned int seed);
+
+#define VELOCYPACK_HASH(mem, size, seed) XXH3_64bits_withSeed(mem, size, seed)
+#define VELOCYPACK_HASH32(mem, size, seed) XXH32(mem, size, seed)
+#endif
+
 #ifdef VELOCYPACK_FASTHASH
 // forward for fasthash functions declared elsewhere
 uint64_t fasthash64(void const*, std::size_t, uint64_t);
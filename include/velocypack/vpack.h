@@ -26,22 +26,33 @@
 #define VELOCYPACK_VPACK_H 1
 
 #include "velocypack/velocypack-common.h"
+#include "velocypack/AttributeDictionary.h"
 #include "velocypack/AttributeTranslator.h"
 #include "velocypack/Buffer.h"
 #include "velocypack/Builder.h"
+#include "velocypack/Cbor.h"
 #include "velocypack/Collection.h"
+#include "velocypack/Columnar.h"
+#include "velocypack/CompactIndex.h"
 #include "velocypack/Compare.h"
+#include "velocypack/Compression.h"
 #include "velocypack/Dumper.h"
 #include "velocypack/Exception.h"
 #include "velocypack/HexDump.h"
 #include "velocypack/Iterator.h"
+#include "velocypack/MessagePack.h"
+#include "velocypack/NormalizedHashCache.h"
 #include "velocypack/Options.h"
+#include "velocypack/PackedArrayView.h"
 #include "velocypack/Parser.h"
 #include "velocypack/Serializable.h"
+#include "velocypack/ShapeRegistry.h"
 #include "velocypack/Sink.h"
 #include "velocypack/Slice.h"
 #include "velocypack/SliceContainer.h"
 #include "velocypack/StringRef.h"
+#include "velocypack/ThreadPool.h"
+#include "velocypack/TrustedSlice.h"
 #include "velocypack/Utf8Helper.h"
 #include "velocypack/Validator.h"
 #include "velocypack/Value.h"
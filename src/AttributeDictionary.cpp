@@ -0,0 +1,234 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>
+
+#include "velocypack/AttributeDictionary.h"
+#include "velocypack/Iterator.h"
+#include "velocypack/Value.h"
+
+using namespace arangodb::velocypack;
+
+namespace {
+
+char const* const dictionaryType = "velocypack-dictionary";
+
+void throwInvalid(char const* message) {
+  throw Exception(Exception::InvalidValueType, message);
+}
+
+}  // namespace
+
+constexpr uint64_t AttributeDictionary::currentVersion;
+
+void AttributeDictionary::save(AttributeTranslator const& translator,
+                               Builder& builder) {
+  builder.openObject();
+  builder.add("type", Value(::dictionaryType));
+  builder.add("version", Value(currentVersion));
+  if (translator.builder() != nullptr && translator.builder()->isClosed()) {
+    builder.add("keys", translator.builder()->slice());
+  } else {
+    builder.add("keys", Slice::emptyObjectSlice());
+  }
+  builder.close();
+}
+
+std::unique_ptr<AttributeTranslator> AttributeDictionary::load(Slice dictionary) {
+  if (!dictionary.isObject() || !dictionary.get("type").isEqualString(StringRef(::dictionaryType))) {
+    ::throwInvalid("Expecting dictionary");
+  }
+  Slice version = dictionary.get("version");
+  if (!version.isNumber<uint64_t>()) {
+    ::throwInvalid("Expecting dictionary version");
+  }
+  if (version.getNumber<uint64_t>() > currentVersion) {
+    ::throwInvalid("Unsupported dictionary version");
+  }
+  Slice keys = dictionary.get("keys");
+  if (!keys.isObject()) {
+    ::throwInvalid("Expecting dictionary keys");
+  }
+
+  std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
+  ObjectIterator it(keys, true);
+  while (it.valid()) {
+    Slice key = it.key(false);
+    Slice id = it.value();
+    if (!key.isString() || !id.isNumber<uint64_t>()) {
+      ::throwInvalid("Expecting dictionary keys");
+    }
+    translator->add(key.copyString(), id.getNumber<uint64_t>());
+    it.next();
+  }
+  translator->seal();
+  return translator;
+}
+
+AttributeDictionaryTrainer::AttributeDictionaryTrainer(std::size_t capacity)
+    : _capacity((std::max)(capacity, std::size_t(1))), _observed(0) {
+  _entries.reserve(_capacity);
+  _heap.reserve(_capacity);
+}
+
+void AttributeDictionaryTrainer::observe(Slice value) {
+  if (value.isObject()) {
+    ObjectIterator it(value, true);
+    while (it.valid()) {
+      Slice key = it.key(false);
+      if (key.isString()) {
+        observeKey(key.stringRef());
+      }
+      observe(it.value());
+      it.next();
+    }
+  } else if (value.isArray()) {
+    for (auto member : ArrayIterator(value)) {
+      observe(member);
+    }
+  }
+}
+
+void AttributeDictionaryTrainer::observeKey(StringRef const& key) {
+  ++_observed;
+
+  auto it = _index.find(key);
+  if (it != _index.end()) {
+    Entry& entry = _entries[(*it).second];
+    ++entry.count;
+    siftDown(entry.position);
+    return;
+  }
+
+  if (_entries.size() < _capacity) {
+    // free slot
+    std::size_t index = _entries.size();
+    _entries.push_back(Entry{key.toString(), 1, _heap.size()});
+    _heap.push_back(index);
+    siftUp(_heap.size() - 1);
+    _index.emplace(StringRef(_entries[index].key), index);
+    return;
+  }
+
+  // replace the least frequent entry, inheriting its count
+  std::size_t index = _heap[0];
+  Entry& entry = _entries[index];
+  _index.erase(StringRef(entry.key));
+  entry.key.assign(key.data(), key.size());
+  ++entry.count;
+  _index.emplace(StringRef(entry.key), index);
+  siftDown(0);
+}
+
+void AttributeDictionaryTrainer::siftUp(std::size_t position) {
+  while (position > 0) {
+    std::size_t parent = (position - 1) / 2;
+    if (_entries[_heap[parent]].count <= _entries[_heap[position]].count) {
+      break;
+    }
+    std::swap(_heap[position], _heap[parent]);
+    _entries[_heap[position]].position = position;
+    _entries[_heap[parent]].position = parent;
+    position = parent;
+  }
+}
+
+void AttributeDictionaryTrainer::siftDown(std::size_t position) {
+  std::size_t const n = _heap.size();
+  while (true) {
+    std::size_t smallest = position;
+    std::size_t left = 2 * position + 1;
+    std::size_t right = left + 1;
+    if (left < n && _entries[_heap[left]].count < _entries[_heap[smallest]].count) {
+      smallest = left;
+    }
+    if (right < n && _entries[_heap[right]].count < _entries[_heap[smallest]].count) {
+      smallest = right;
+    }
+    if (smallest == position) {
+      break;
+    }
+    std::swap(_heap[position], _heap[smallest]);
+    _entries[_heap[position]].position = position;
+    _entries[_heap[smallest]].position = smallest;
+    position = smallest;
+  }
+}
+
+std::vector<std::pair<std::string, uint64_t>> AttributeDictionaryTrainer::top(
+    std::size_t k) const {
+  std::vector<std::pair<std::string, uint64_t>> result;
+  result.reserve(_entries.size());
+  for (auto const& entry : _entries) {
+    result.emplace_back(entry.key, entry.count);
+  }
+  // ties are broken by name, to make the result deterministic
+  std::sort(result.begin(), result.end(),
+            [](std::pair<std::string, uint64_t> const& lhs,
+               std::pair<std::string, uint64_t> const& rhs) {
+              if (lhs.second != rhs.second) {
+                return lhs.second > rhs.second;
+              }
+              return lhs.first < rhs.first;
+            });
+  if (result.size() > k) {
+    result.resize(k);
+  }
+  return result;
+}
+
+std::unique_ptr<AttributeTranslator> AttributeDictionaryTrainer::train(
+    std::size_t maxKeys, uint64_t minCount, std::size_t minLength,
+    AttributeTranslator const* base) const {
+  std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
+
+  uint64_t nextId = 1;
+  if (base != nullptr && base->builder() != nullptr &&
+      base->builder()->isClosed()) {
+    ObjectIterator it(base->builder()->slice(), true);
+    while (it.valid()) {
+      uint64_t id = it.value().getUInt();
+      translator->add(it.key(false).copyString(), id);
+      nextId = (std::max)(nextId, id + 1);
+      it.next();
+    }
+  }
+
+  std::size_t added = 0;
+  for (auto const& it : top(_entries.size())) {
+    if (added == maxKeys || it.second < minCount) {
+      break;
+    }
+    if (it.first.size() < minLength ||
+        (base != nullptr && base->translate(it.first) != nullptr)) {
+      continue;
+    }
+    translator->add(it.first, nextId++);
+    ++added;
+  }
+
+  translator->seal();
+  return translator;
+}
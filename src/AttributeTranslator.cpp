@@ -22,8 +22,12 @@
 /// @author Jan Steemann
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <unordered_set>
+
 #include "velocypack/AttributeTranslator.h"
 #include "velocypack/Builder.h"
+#include "velocypack/Exception.h"
 #include "velocypack/Iterator.h"
 #include "velocypack/Options.h"
 #include "velocypack/Slice.h"
@@ -31,8 +35,15 @@
 
 using namespace arangodb::velocypack;
 
+namespace {
+
+// translator bound to the current thread via AttributeTranslatorThreadScope
+thread_local AttributeTranslator const* threadTranslator = nullptr;
+
+}  // namespace
+
 AttributeTranslator::AttributeTranslator()
-    : _count(0) {}
+    : _seed(0), _count(0) {}
 
 AttributeTranslator::~AttributeTranslator() {}
 
@@ -55,18 +66,129 @@ void AttributeTranslator::seal() {
 
   Slice s(_builder->slice());
 
+  std::vector<Slot> entries;
+  std::vector<std::pair<uint64_t, uint8_t const*>> ids;
+  std::unordered_set<StringRef> seen;
+  entries.reserve(_count);
+  ids.reserve(_count);
+  uint64_t maxId = 0;
+
   ObjectIterator it(s);
 
   while (it.valid()) {
     Slice const key(it.key(false));
     VELOCYPACK_ASSERT(key.isString());
 
-    // insert into string and char lookup maps
-    _keyToId.emplace(key.stringRef(), it.value().begin());
-    // insert into id to slice lookup map
-    _idToKey.emplace(it.value().getUInt(), key.begin());
+    StringRef name = key.stringRef();
+    // the first occurrence of a key wins
+    if (seen.emplace(name).second) {
+      entries.push_back(Slot{prefix(name), name.size(), name.data(),
+                             it.value().begin()});
+    }
+    uint64_t id = it.value().getUInt();
+    ids.emplace_back(id, key.begin());
+    maxId = (std::max)(maxId, id);
     it.next();
   }
+
+  // ids are usually assigned consecutively, so a vector indexed by id
+  // is both smaller and faster than a map
+  if (!ids.empty() && maxId < 2 * ids.size() + 64) {
+    _idToKey.assign(static_cast<std::size_t>(maxId) + 1, nullptr);
+    for (auto const& entry : ids) {
+      if (_idToKey[static_cast<std::size_t>(entry.first)] == nullptr) {
+        _idToKey[static_cast<std::size_t>(entry.first)] = entry.second;
+      }
+    }
+  } else {
+    for (auto const& entry : ids) {
+      _sparseIdToKey.emplace(entry.first, entry.second);
+    }
+  }
+
+  if (entries.empty()) {
+    return;
+  }
+
+  // finding displacements for all buckets fails only with negligible
+  // probability, and then succeeds with another seed
+  uint64_t seed = 0xdeadbeef;
+  for (int attempt = 0; attempt < 64; ++attempt) {
+    if (buildPerfectHash(entries, seed)) {
+      return;
+    }
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+  throw Exception(Exception::InternalError,
+                  "Cannot build hash table for attribute translator");
+}
+
+// builds a minimal perfect hash table using hash and displace: keys are
+// distributed into buckets of about 4 keys, and for each bucket, largest
+// first, a displacement value is searched that maps all of the bucket's
+// keys into free slots
+bool AttributeTranslator::buildPerfectHash(std::vector<Slot> const& entries,
+                                           uint64_t seed) {
+  std::size_t const n = entries.size();
+  std::size_t const numBuckets = (n + 3) / 4;
+
+  std::vector<uint64_t> hashes(n);
+  std::vector<std::vector<uint32_t>> buckets(numBuckets);
+  for (std::size_t i = 0; i < n; ++i) {
+    hashes[i] = VELOCYPACK_HASH(entries[i].key, entries[i].length, seed);
+    buckets[reduce(static_cast<uint32_t>(hashes[i]), numBuckets)].push_back(
+        static_cast<uint32_t>(i));
+  }
+
+  std::vector<uint32_t> order(numBuckets);
+  for (std::size_t i = 0; i < numBuckets; ++i) {
+    order[i] = static_cast<uint32_t>(i);
+  }
+  std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t lhs, uint32_t rhs) {
+    return buckets[lhs].size() > buckets[rhs].size();
+  });
+
+  std::vector<uint32_t> displacements(numBuckets, 0);
+  std::vector<bool> taken(n, false);
+  std::vector<uint32_t> positions;
+  std::vector<Slot> slots(n);
+
+  for (uint32_t b : order) {
+    auto const& bucket = buckets[b];
+    if (bucket.empty()) {
+      break;
+    }
+
+    bool found = false;
+    for (uint32_t d = 0; d < (1U << 24); ++d) {
+      positions.clear();
+      for (uint32_t i : bucket) {
+        uint32_t p = reduce(mix(hashes[i] >> 32, d), n);
+        if (taken[p] ||
+            std::find(positions.begin(), positions.end(), p) != positions.end()) {
+          break;
+        }
+        positions.push_back(p);
+      }
+      if (positions.size() == bucket.size()) {
+        for (std::size_t i = 0; i < bucket.size(); ++i) {
+          taken[positions[i]] = true;
+          slots[positions[i]] = entries[bucket[i]];
+        }
+        displacements[b] = d;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      return false;
+    }
+  }
+
+  _slots = std::move(slots);
+  _displacements = std::move(displacements);
+  _seed = seed;
+  return true;
 }
   
 AttributeTranslatorScope::AttributeTranslatorScope(AttributeTranslator* translator)
@@ -82,3 +204,21 @@ AttributeTranslatorScope::~AttributeTranslatorScope() {
 void AttributeTranslatorScope::revert() noexcept {
   Options::Defaults.attributeTranslator = _old;
 }
+
+AttributeTranslatorThreadScope::AttributeTranslatorThreadScope(AttributeTranslator const* translator) noexcept
+      : _old(::threadTranslator) {
+  ::threadTranslator = translator;
+}
+
+AttributeTranslatorThreadScope::~AttributeTranslatorThreadScope() {
+  revert();
+}
+
+// prematurely revert the change
+void AttributeTranslatorThreadScope::revert() noexcept {
+  ::threadTranslator = _old;
+}
+
+AttributeTranslator const* AttributeTranslatorThreadScope::current() noexcept {
+  return ::threadTranslator;
+}
@@ -108,8 +108,10 @@ thread_local std::unique_ptr<std::unordered_set<StringRef>> duplicateKeys;
 // Find the actual bytes of the attribute name of the VPack value
 // at position base, also determine the length len of the attribute.
 // This takes into account the different possibilities for the format
-// of attribute names:
-uint8_t const* findAttrName(uint8_t const* base, uint64_t& len) {
+// of attribute names. integer attribute names are translated with the
+// specified translator:
+uint8_t const* findAttrName(uint8_t const* base, uint64_t& len,
+                            AttributeTranslator const* translator) {
   uint8_t const b = *base;
   if (b >= 0x40 && b <= 0xbe) {
     // short UTF-8 string
@@ -127,15 +129,17 @@ uint8_t const* findAttrName(uint8_t const* base, uint64_t& len) {
   }
 
   // translate attribute name
-  return findAttrName(arangodb::velocypack::Slice(base).makeKey().start(), len);
+  return findAttrName(arangodb::velocypack::Slice(base).makeKey(translator).start(),
+                      len, translator);
 }
 
-bool checkAttributeUniquenessUnsortedBrute(ObjectIterator& it) {
+bool checkAttributeUniquenessUnsortedBrute(ObjectIterator& it,
+                                           AttributeTranslator const* translator) {
   std::array<StringRef, LinearAttributeUniquenessCutoff> keys;
 
   do {
-    // key(true) guarantees a String as returned type
-    StringRef key = it.key(true).stringRef();
+    // makeKey() guarantees a String as returned type
+    StringRef key = it.key(false).makeKey(translator).stringRef();
 
     ValueLength index = it.index();
     // compare with all other already looked-at keys
@@ -152,7 +156,8 @@ bool checkAttributeUniquenessUnsortedBrute(ObjectIterator& it) {
   return true;
 }
 
-bool checkAttributeUniquenessUnsortedSet(ObjectIterator& it) {
+bool checkAttributeUniquenessUnsortedSet(ObjectIterator& it,
+                                         AttributeTranslator const* translator) {
 #ifndef VELOCYPACK_NO_THREADLOCALS
   std::unique_ptr<std::unordered_set<StringRef>>& tmp = ::duplicateKeys;
 
@@ -166,8 +171,8 @@ bool checkAttributeUniquenessUnsortedSet(ObjectIterator& it) {
 #endif
 
   do {
-    Slice const key = it.key(true);
-    // key(true) guarantees a String as returned type
+    Slice const key = it.key(false).makeKey(translator);
+    // makeKey() guarantees a String as returned type
     VELOCYPACK_ASSERT(key.isString());
     if (VELOCYPACK_UNLIKELY(!tmp->emplace(key).second)) {
       // identical key
@@ -346,8 +351,9 @@ std::string Builder::toJson() const {
   
 void Builder::sortObjectIndexShort(uint8_t* objBase,
                                    std::vector<ValueLength>& offsets) const {
-  std::sort(offsets.begin(), offsets.end(), [objBase](ValueLength const& a, 
-                                                      ValueLength const& b) {
+  AttributeTranslator const* translator = options->attributeTranslator;
+  std::sort(offsets.begin(), offsets.end(), [objBase, translator](ValueLength const& a,
+                                                                  ValueLength const& b) {
     uint8_t const* aa = objBase + a;
     uint8_t const* bb = objBase + b;
     if (*aa >= 0x40 && *aa <= 0xbe && *bb >= 0x40 && *bb <= 0xbe) {
@@ -358,8 +364,8 @@ void Builder::sortObjectIndexShort(uint8_t* objBase,
     } else {
       uint64_t lena;
       uint64_t lenb;
-      aa = findAttrName(aa, lena);
-      bb = findAttrName(bb, lenb);
+      aa = findAttrName(aa, lena, translator);
+      bb = findAttrName(bb, lenb, translator);
       uint64_t m = (std::min)(lena, lenb);
       int c = memcmp(aa, bb, checkOverflow(m));
       return (c < 0 || (c == 0 && lena < lenb));
@@ -389,7 +395,8 @@ void Builder::sortObjectIndexLong(uint8_t* objBase,
   for (std::size_t i = 0; i < n; i++) {
     SortEntry e;
     e.offset = offsets[i];
-    e.nameStart = ::findAttrName(objBase + e.offset, e.nameSize);
+    e.nameStart = ::findAttrName(objBase + e.offset, e.nameSize,
+                                 options->attributeTranslator);
     tmp->push_back(e);
   }
   VELOCYPACK_ASSERT(tmp->size() == n);
@@ -775,7 +782,7 @@ bool Builder::hasKey(std::string const& key) const {
   }
   for (std::size_t i = 0; i < index.size(); ++i) {
     Slice s(_start + tos + index[i]);
-    if (s.makeKey().isEqualString(key)) {
+    if (s.makeKey(options->attributeTranslator).isEqualString(key)) {
       return true;
     }
   }
@@ -797,7 +804,7 @@ Slice Builder::getKey(std::string const& key) const {
   }
   for (std::size_t i = 0; i < index.size(); ++i) {
     Slice s(_start + tos + index[i]);
-    if (s.makeKey().isEqualString(key)) {
+    if (s.makeKey(options->attributeTranslator).isEqualString(key)) {
       return Slice(s.start() + s.byteSize());
     }
   }
@@ -1194,10 +1201,11 @@ bool Builder::checkAttributeUniqueness(Slice obj) const {
 }
 
 bool Builder::checkAttributeUniquenessSorted(Slice obj) const {
+  AttributeTranslator const* translator = options->attributeTranslator;
   ObjectIterator it(obj, false);
 
   // fetch initial key
-  Slice previous = it.key(true);
+  Slice previous = it.key(false).makeKey(translator);
   ValueLength len;
   char const* p = previous.getString(len);
   
@@ -1205,7 +1213,7 @@ bool Builder::checkAttributeUniquenessSorted(Slice obj) const {
   it.next();
 
   do {
-    Slice const current = it.key(true);
+    Slice const current = it.key(false).makeKey(translator);
     VELOCYPACK_ASSERT(current.isString());
     
     ValueLength len2;
@@ -1235,9 +1243,9 @@ bool Builder::checkAttributeUniquenessUnsorted(Slice obj) const {
   ObjectIterator it(obj, true);
     
   if (it.size() <= ::LinearAttributeUniquenessCutoff) {
-    return ::checkAttributeUniquenessUnsortedBrute(it);
+    return ::checkAttributeUniquenessUnsortedBrute(it, options->attributeTranslator);
   }
-  return ::checkAttributeUniquenessUnsortedSet(it);
+  return ::checkAttributeUniquenessUnsortedSet(it, options->attributeTranslator);
 }
 
 // Add all subkeys and subvalues into an object from an ObjectIterator
@@ -0,0 +1,594 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/Cbor.h"
+#include "velocypack/Iterator.h"
+#include "velocypack/PackedArrayView.h"
+#include "velocypack/ShapeRegistry.h"
+#include "velocypack/StringRef.h"
+#include "velocypack/Utf8Helper.h"
+#include "velocypack/Value.h"
+#include "velocypack/ValueType.h"
+
+using namespace arangodb::velocypack;
+
+namespace {
+
+// major types
+constexpr uint8_t unsignedInteger = 0;
+constexpr uint8_t negativeInteger = 1;
+constexpr uint8_t byteString = 2;
+constexpr uint8_t textString = 3;
+constexpr uint8_t array = 4;
+constexpr uint8_t map = 5;
+constexpr uint8_t tag = 6;
+constexpr uint8_t simple = 7;
+
+// additional information for indefinite lengths and the break stop code
+constexpr uint8_t indefinite = 31;
+constexpr uint8_t breakCode = 0xff;
+
+// the tag of epoch-based dates
+constexpr uint64_t epochDateTag = 1;
+
+double halfToDouble(uint16_t half) {
+  int const exponent = (half >> 10) & 0x1f;
+  int const mantissa = half & 0x3ff;
+  double value;
+  if (exponent == 0) {
+    value = std::ldexp(mantissa, -24);
+  } else if (exponent != 31) {
+    value = std::ldexp(mantissa + 1024, exponent - 25);
+  } else {
+    value = (mantissa == 0) ? INFINITY : NAN;
+  }
+  return (half & 0x8000U) ? -value : value;
+}
+
+}  // namespace
+
+void CborDumper::dumpHeader(uint8_t majorType, uint64_t value) {
+  char buffer[9];
+  int bytes;
+  uint8_t info;
+  if (value < 24) {
+    _sink->push_back(static_cast<char>((majorType << 5) | value));
+    return;
+  } else if (value <= 0xffU) {
+    info = 24;
+    bytes = 1;
+  } else if (value <= 0xffffU) {
+    info = 25;
+    bytes = 2;
+  } else if (value <= 0xffffffffU) {
+    info = 26;
+    bytes = 4;
+  } else {
+    info = 27;
+    bytes = 8;
+  }
+  buffer[0] = static_cast<char>((majorType << 5) | info);
+  for (int i = bytes; i > 0; --i) {
+    buffer[i] = static_cast<char>(value & 0xffU);
+    value >>= 8;
+  }
+  _sink->append(&buffer[0], static_cast<ValueLength>(1 + bytes));
+}
+
+void CborDumper::dumpInt(int64_t value) {
+  if (value >= 0) {
+    dumpHeader(::unsignedInteger, static_cast<uint64_t>(value));
+  } else {
+    // -1 - value, without overflow for INT64_MIN
+    dumpHeader(::negativeInteger, ~static_cast<uint64_t>(value));
+  }
+}
+
+void CborDumper::dumpDouble(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  char buffer[9];
+  buffer[0] = static_cast<char>((::simple << 5) | 27);
+  for (int i = 8; i > 0; --i) {
+    buffer[i] = static_cast<char>(bits & 0xffU);
+    bits >>= 8;
+  }
+  _sink->append(&buffer[0], sizeof(buffer));
+}
+
+// UTCDates are written as integral seconds where possible, and as
+// fractional seconds otherwise
+void CborDumper::dumpUTCDate(int64_t value) {
+  dumpHeader(::tag, ::epochDateTag);
+  if (value % 1000 == 0) {
+    dumpInt(value / 1000);
+  } else {
+    dumpDouble(static_cast<double>(value) / 1000.0);
+  }
+}
+
+void CborDumper::dumpPackedArray(Slice const& slice) {
+  if (slice.isPackedArray<int64_t>(options)) {
+    PackedArrayView<int64_t> values = slice.getPackedArray<int64_t>(options);
+    dumpHeader(::array, values.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      dumpInt(values[i]);
+    }
+  } else if (slice.isPackedArray<double>(options)) {
+    PackedArrayView<double> values = slice.getPackedArray<double>(options);
+    dumpHeader(::array, values.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      dumpDouble(values[i]);
+    }
+  } else {
+    VELOCYPACK_ASSERT(slice.isPackedArray<float>(options));
+    PackedArrayView<float> values = slice.getPackedArray<float>(options);
+    dumpHeader(::array, values.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      dumpDouble(static_cast<double>(values[i]));
+    }
+  }
+}
+
+void CborDumper::dumpShapedObject(Slice const& slice, ShapeRegistry const* registry) {
+  VELOCYPACK_ASSERT(registry != nullptr);
+
+  Slice payload = slice.value();
+  if (!payload.isArray() || payload.isEmptyArray()) {
+    throw Exception(Exception::InvalidValueType, "Expecting shaped object");
+  }
+  ArrayIterator it(payload);
+  ShapeRegistry::Shape const* shape = registry->shape((*it).getUInt());
+  if (shape == nullptr || it.size() != shape->size() + 1) {
+    throw Exception(Exception::UnknownShape);
+  }
+  it.next();
+
+  dumpHeader(::map, shape->size());
+  std::size_t position = 0;
+  while (it.valid()) {
+    dumpValue(shape->keyAt(position));
+    dumpValue(*it);
+    ++position;
+    it.next();
+  }
+}
+
+void CborDumper::handleUnsupportedType(Slice const& slice) {
+  if (options->unsupportedTypeBehavior == Options::NullifyUnsupportedType) {
+    _sink->push_back(static_cast<char>(0xf6));
+    return;
+  } else if (options->unsupportedTypeBehavior == Options::ConvertUnsupportedType) {
+    std::string const value = std::string("(non-representable type ") + slice.typeName() + ")";
+    dumpHeader(::textString, value.size());
+    _sink->append(value);
+    return;
+  }
+
+  throw Exception(Exception::NoJsonEquivalent, "Type has no equivalent in CBOR");
+}
+
+void CborDumper::dumpValue(Slice const& slice) {
+  switch (slice.type()) {
+    case ValueType::Null: {
+      _sink->push_back(static_cast<char>(0xf6));
+      break;
+    }
+
+    case ValueType::Bool: {
+      _sink->push_back(static_cast<char>(slice.getBool() ? 0xf5 : 0xf4));
+      break;
+    }
+
+    case ValueType::Array: {
+      ArrayIterator it(slice);
+      dumpHeader(::array, it.size());
+      while (it.valid()) {
+        dumpValue(it.value());
+        it.next();
+      }
+      break;
+    }
+
+    case ValueType::Object: {
+      ObjectIterator it(slice, !options->dumpAttributesInIndexOrder);
+      dumpHeader(::map, it.size());
+      while (it.valid()) {
+        auto current = (*it);
+        dumpValue(current.key);
+        dumpValue(current.value);
+        it.next();
+      }
+      break;
+    }
+
+    case ValueType::Double: {
+      dumpDouble(slice.getDouble());
+      break;
+    }
+
+    case ValueType::UInt: {
+      dumpHeader(::unsignedInteger, slice.getUIntUnchecked());
+      break;
+    }
+
+    case ValueType::Int: {
+      dumpInt(slice.getIntUnchecked());
+      break;
+    }
+
+    case ValueType::SmallInt: {
+      dumpInt(slice.getSmallIntUnchecked());
+      break;
+    }
+
+    case ValueType::String: {
+      ValueLength length;
+      char const* p = slice.getString(length);
+      dumpHeader(::textString, length);
+      _sink->append(p, length);
+      break;
+    }
+
+    case ValueType::Binary: {
+      ValueLength length;
+      uint8_t const* p = slice.getBinary(length);
+      dumpHeader(::byteString, length);
+      _sink->append(reinterpret_cast<char const*>(p), length);
+      break;
+    }
+
+    case ValueType::UTCDate: {
+      dumpUTCDate(slice.getUTCDate());
+      break;
+    }
+
+    case ValueType::External: {
+      dumpValue(Slice(reinterpret_cast<uint8_t const*>(slice.getExternal())));
+      break;
+    }
+
+    case ValueType::Tagged: {
+      // without a shape registry, shaped objects are dumped like other
+      // tagged values
+      ShapeRegistry const* registry =
+          slice.isShapedObject() ? ShapeRegistry::resolve(options) : nullptr;
+      if (slice.isPackedArray(options)) {
+        dumpPackedArray(slice);
+      } else if (registry != nullptr) {
+        dumpShapedObject(slice, registry);
+      } else {
+        // value() skips all tags of the value, not just the first one
+        for (uint64_t tag : slice.getTags()) {
+          dumpHeader(::tag, tag);
+        }
+        dumpValue(slice.value());
+      }
+      break;
+    }
+
+    case ValueType::None:
+    case ValueType::Illegal:
+    case ValueType::MinKey:
+    case ValueType::MaxKey:
+    case ValueType::BCD:
+    case ValueType::Custom: {
+      handleUnsupportedType(slice);
+      break;
+    }
+  }
+}
+
+ValueLength CborParser::parse(uint8_t const* start, std::size_t size) {
+  _start = start;
+  _size = size;
+  _pos = 0;
+  _key = nullptr;
+  _haveTag = false;
+  if (options->clearBuilderBeforeParse) {
+    _builder->clear();
+  }
+  parseValue();
+  return _pos;
+}
+
+uint8_t const* CborParser::consume(ValueLength length) {
+  if (VELOCYPACK_UNLIKELY(length > _size - _pos)) {
+    throw Exception(Exception::ParseError, "Unexpected end of CBOR data");
+  }
+  uint8_t const* p = _start + _pos;
+  _pos += static_cast<std::size_t>(length);
+  return p;
+}
+
+bool CborParser::consumeBreak() {
+  if (_pos < _size && _start[_pos] == ::breakCode) {
+    ++_pos;
+    return true;
+  }
+  return false;
+}
+
+uint64_t CborParser::readArgument(uint8_t info) {
+  if (info < 24) {
+    return info;
+  }
+  if (info > 27) {
+    throw Exception(Exception::ParseError, "Invalid CBOR additional information");
+  }
+  int const bytes = 1 << (info - 24);
+  uint8_t const* p = consume(static_cast<ValueLength>(bytes));
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; ++i) {
+    value = (value << 8) | p[i];
+  }
+  return value;
+}
+
+template <typename T>
+void CborParser::add(T const& value) {
+  char const* key = _key;
+  _key = nullptr;
+  if (_haveTag) {
+    _haveTag = false;
+    if (key != nullptr) {
+      _builder->addTagged(StringRef(key, static_cast<std::size_t>(_keyLength)), _tag, value);
+    } else {
+      _builder->addTagged(_tag, value);
+    }
+  } else if (key != nullptr) {
+    _builder->add(StringRef(key, static_cast<std::size_t>(_keyLength)), value);
+  } else {
+    _builder->add(value);
+  }
+}
+
+void CborParser::parseArray(uint8_t info, uint64_t length) {
+  add(Value(ValueType::Array));
+  if (info == ::indefinite) {
+    while (!consumeBreak()) {
+      parseValue();
+    }
+  } else {
+    // every member takes at least one byte, so corrupt lengths cannot
+    // make the reservation arbitrarily large
+    _builder->reserveMembers((std::min)(length, static_cast<uint64_t>(_size - _pos)));
+    for (uint64_t i = 0; i < length; ++i) {
+      parseValue();
+    }
+  }
+  _builder->close();
+}
+
+void CborParser::parseMap(uint8_t info, uint64_t length) {
+  add(Value(ValueType::Object));
+  if (info == ::indefinite) {
+    while (!consumeBreak()) {
+      parseKey();
+      parseValue();
+    }
+  } else {
+    _builder->reserveMembers((std::min)(length, static_cast<uint64_t>(_size - _pos) / 2));
+    for (uint64_t i = 0; i < length; ++i) {
+      parseKey();
+      parseValue();
+    }
+  }
+  _builder->close();
+}
+
+void CborParser::parseKey() {
+  uint8_t const head = *consume(1);
+  uint8_t const info = head & 0x1fU;
+  if ((head >> 5) != ::textString) {
+    throw Exception(Exception::ParseError, "CBOR map keys must be text strings");
+  }
+  if (info == ::indefinite) {
+    _keyBuffer.clear();
+    readChunks(::textString, _keyBuffer);
+    _key = _keyBuffer.data();
+    _keyLength = _keyBuffer.size();
+  } else {
+    _keyLength = readArgument(info);
+    _key = reinterpret_cast<char const*>(consume(_keyLength));
+  }
+  if (options->validateUtf8Strings &&
+      !Utf8Helper::isValidUtf8(reinterpret_cast<uint8_t const*>(_key), _keyLength)) {
+    throw Exception(Exception::InvalidUtf8Sequence);
+  }
+}
+
+void CborParser::readChunks(uint8_t majorType, std::string& out) {
+  while (!consumeBreak()) {
+    uint8_t const head = *consume(1);
+    uint8_t const info = head & 0x1fU;
+    if ((head >> 5) != majorType || info == ::indefinite) {
+      throw Exception(Exception::ParseError, "Invalid chunk in indefinite-length CBOR string");
+    }
+    ValueLength const length = readArgument(info);
+    out.append(reinterpret_cast<char const*>(consume(length)), length);
+  }
+}
+
+void CborParser::parseString(uint8_t majorType, uint8_t info, uint64_t length) {
+  ValueType const type = (majorType == ::textString) ? ValueType::String : ValueType::Binary;
+  std::string chunks;
+  uint8_t const* p;
+  if (info == ::indefinite) {
+    readChunks(majorType, chunks);
+    p = reinterpret_cast<uint8_t const*>(chunks.data());
+    length = chunks.size();
+  } else {
+    p = consume(length);
+  }
+  if (type == ValueType::String && options->validateUtf8Strings &&
+      !Utf8Helper::isValidUtf8(p, length)) {
+    throw Exception(Exception::InvalidUtf8Sequence);
+  }
+  add(ValuePair(p, length, type));
+}
+
+void CborParser::parseDate() {
+  uint8_t const head = *consume(1);
+  uint8_t const info = head & 0x1fU;
+  uint8_t const majorType = head >> 5;
+  int64_t value;
+  if (majorType == ::unsignedInteger || majorType == ::negativeInteger) {
+    uint64_t const argument = readArgument(info);
+    if (argument > static_cast<uint64_t>(INT64_MAX / 1000)) {
+      throw Exception(Exception::NumberOutOfRange, "CBOR date out of range");
+    }
+    value = static_cast<int64_t>(argument) * 1000;
+    if (majorType == ::negativeInteger) {
+      value = -value - 1000;
+    }
+  } else if (majorType == ::simple && info >= 25 && info <= 27) {
+    uint64_t const argument = readArgument(info);
+    double seconds;
+    if (info == 25) {
+      seconds = ::halfToDouble(static_cast<uint16_t>(argument));
+    } else if (info == 26) {
+      float f;
+      uint32_t bits = static_cast<uint32_t>(argument);
+      memcpy(&f, &bits, sizeof(f));
+      seconds = f;
+    } else {
+      memcpy(&seconds, &argument, sizeof(seconds));
+    }
+    double const milliseconds = std::round(seconds * 1000.0);
+    if (!(milliseconds >= -9.2e18 && milliseconds <= 9.2e18)) {
+      throw Exception(Exception::NumberOutOfRange, "CBOR date out of range");
+    }
+    value = static_cast<int64_t>(milliseconds);
+  } else {
+    throw Exception(Exception::ParseError, "Expecting number for CBOR epoch-based date");
+  }
+  add(Value(value, ValueType::UTCDate));
+}
+
+void CborParser::parseTag(std::size_t start, uint64_t value) {
+  if (_haveTag) {
+    // the Builder adds one tag at a time, so a tagged item inside a tag
+    // is built separately and then added as a whole
+    Builder inner(_builder->options);
+    CborParser parser(inner, options);
+    _pos = start + static_cast<std::size_t>(parser.parse(_start + start, _size - start));
+    add(inner.slice());
+    return;
+  }
+  if (value == ::epochDateTag) {
+    parseDate();
+    return;
+  }
+  if (value == 0) {
+    // the Builder takes tag 0 to mean no tag
+    parseValue();
+    return;
+  }
+  _tag = value;
+  _haveTag = true;
+  parseValue();
+}
+
+void CborParser::parseSimple(uint8_t info, uint64_t value) {
+  switch (info) {
+    case 20:
+      add(Value(false));
+      break;
+    case 21:
+      add(Value(true));
+      break;
+    case 22:
+    case 23:
+      add(Value(ValueType::Null));
+      break;
+    case 25:
+      add(Value(::halfToDouble(static_cast<uint16_t>(value))));
+      break;
+    case 26: {
+      float f;
+      uint32_t bits = static_cast<uint32_t>(value);
+      memcpy(&f, &bits, sizeof(f));
+      add(Value(static_cast<double>(f)));
+      break;
+    }
+    case 27: {
+      double d;
+      memcpy(&d, &value, sizeof(d));
+      add(Value(d));
+      break;
+    }
+    case ::indefinite:
+      throw Exception(Exception::ParseError, "Unexpected CBOR break stop code");
+    default:
+      throw Exception(Exception::ParseError, "Unsupported CBOR simple value");
+  }
+}
+
+void CborParser::parseValue() {
+  std::size_t const start = _pos;
+  uint8_t const head = *consume(1);
+  uint8_t const majorType = head >> 5;
+  uint8_t const info = head & 0x1fU;
+
+  uint64_t argument = 0;
+  if (info != ::indefinite) {
+    argument = readArgument(info);
+  } else if (majorType < ::byteString || majorType == ::tag) {
+    throw Exception(Exception::ParseError, "Invalid CBOR additional information");
+  }
+
+  switch (majorType) {
+    case ::unsignedInteger:
+      add(Value(argument));
+      break;
+    case ::negativeInteger:
+      if (argument > static_cast<uint64_t>(INT64_MAX)) {
+        throw Exception(Exception::NumberOutOfRange, "CBOR negative integer out of range");
+      }
+      add(Value(-1 - static_cast<int64_t>(argument)));
+      break;
+    case ::byteString:
+    case ::textString:
+      parseString(majorType, info, argument);
+      break;
+    case ::array:
+      parseArray(info, argument);
+      break;
+    case ::map:
+      parseMap(info, argument);
+      break;
+    case ::tag:
+      parseTag(start, argument);
+      break;
+    default:
+      parseSimple(info, argument);
+      break;
+  }
+}
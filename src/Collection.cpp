@@ -22,8 +22,16 @@
 /// @author Jan Steemann
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <unordered_map>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "velocypack/velocypack-common.h"
 #include "velocypack/Collection.h"
 #include "velocypack/Iterator.h"
@@ -31,10 +39,14 @@
 #include "velocypack/Value.h"
 #include "velocypack/ValueType.h"
 
+#include "parallel.h"
+
 using namespace arangodb::velocypack;
 
 // indicator for "element not found" in indexOf() method
 ValueLength const Collection::NotFound = UINT64_MAX;
+
+ValueLength const Collection::minMembersPerThread = 1000;
   
 // fully append an array to the builder
 Builder& Collection::appendArray(Builder& builder, Slice const& slice) {
@@ -58,72 +70,6 @@ static inline std::unordered_set<std::string> makeSet(
   return s;
 }
 
-void Collection::forEach(Slice const& slice, Predicate const& predicate) {
-  ArrayIterator it(slice);
-  ValueLength index = 0;
-
-  while (it.valid()) {
-    if (!predicate(it.value(), index)) {
-      // abort
-      return;
-    }
-    it.next();
-    ++index;
-  }
-}
-
-Builder Collection::filter(Slice const& slice, Predicate const& predicate) {
-  // construct a new Array
-  Builder b;
-  b.add(Value(ValueType::Array));
-
-  ArrayIterator it(slice);
-  ValueLength index = 0;
-
-  while (it.valid()) {
-    Slice s = it.value();
-    if (predicate(s, index)) {
-      b.add(s);
-    }
-    it.next();
-    ++index;
-  }
-  b.close();
-  return b;
-}
-
-Slice Collection::find(Slice const& slice, Predicate const& predicate) {
-  ArrayIterator it(slice);
-  ValueLength index = 0;
-
-  while (it.valid()) {
-    Slice s = it.value();
-    if (predicate(s, index)) {
-      return s;
-    }
-    it.next();
-    ++index;
-  }
-
-  return Slice();
-}
-
-bool Collection::contains(Slice const& slice, Predicate const& predicate) {
-  ArrayIterator it(slice);
-  ValueLength index = 0;
-
-  while (it.valid()) {
-    Slice s = it.value();
-    if (predicate(s, index)) {
-      return true;
-    }
-    it.next();
-    ++index;
-  }
-
-  return false;
-}
-
 bool Collection::contains(Slice const& slice, Slice const& other) {
   ArrayIterator it(slice);
 
@@ -152,36 +98,38 @@ ValueLength Collection::indexOf(Slice const& slice, Slice const& other) {
   return Collection::NotFound;
 }
 
-bool Collection::all(Slice const& slice, Predicate const& predicate) {
-  ArrayIterator it(slice);
-  ValueLength index = 0;
+void Collection::runParallel(
+    Slice const& slice, ThreadPool& pool,
+    std::function<void(Slice, ValueLength, ValueLength, std::size_t)> const& cb) {
+  if (VELOCYPACK_UNLIKELY(!slice.isArray())) {
+    throw Exception(Exception::InvalidValueType, "Expecting type Array");
+  }
 
-  while (it.valid()) {
-    Slice s = it.value();
-    if (!predicate(s, index)) {
-      return false;
-    }
-    it.next();
-    ++index;
+  ValueLength const n = slice.length();
+  if (n == 0) {
+    return;
   }
 
-  return true;
-}
+  std::size_t const numChunks = parallel::numberOfChunks(n, pool.size(), minMembersPerThread);
+  if (numChunks <= 1) {
+    cb(slice.at(0), 0, n, 0);
+    return;
+  }
 
-bool Collection::any(Slice const& slice, Predicate const& predicate) {
+  // the first member of each range. a single pass finds them all, also
+  // for compact Arrays, which have no index table
+  std::vector<Slice> firsts;
+  firsts.reserve(numChunks);
   ArrayIterator it(slice);
-  ValueLength index = 0;
-
-  while (it.valid()) {
-    Slice s = it.value();
-    if (predicate(s, index)) {
-      return true;
-    }
-    it.next();
-    ++index;
+  for (std::size_t chunk = 0; chunk < numChunks; ++chunk) {
+    it.forward(parallel::chunkStart(n, numChunks, chunk) - it.index());
+    firsts.push_back(it.value());
   }
 
-  return false;
+  parallel::rethrowFirst(pool.run(numChunks, [&](std::size_t chunk) {
+    cb(firsts[chunk], parallel::chunkStart(n, numChunks, chunk),
+       parallel::chunkStart(n, numChunks, chunk + 1), chunk);
+  }));
 }
 
 std::vector<std::string> Collection::keys(Slice const& slice) {
@@ -415,121 +363,428 @@ Builder& Collection::merge(Builder& builder, Slice const& left, Slice const& rig
   return builder;
 }
 
-template <Collection::VisitationOrder order>
-static bool doVisit(
-    Slice const& slice,
-    std::function<bool(Slice const& key, Slice const& value)> const& func);
 
-template <Collection::VisitationOrder order>
-static bool visitObject(
-    Slice const& value,
-    std::function<bool(Slice const& key, Slice const& value)> const& func) {
-  ObjectIterator it(value);
+namespace {
 
-  while (it.valid()) {
-    auto current = (*it);
-    // sub-object?
-    Slice v = current.value;
-    bool const isCompound = (v.isObject() || v.isArray());
-
-    if (isCompound && order == Collection::PreOrder) {
-      if (!doVisit<order>(v, func)) {
-        return false;
-      }
-    }
+inline double readDouble(uint8_t const* p) noexcept {
+  uint64_t dv = readIntegerFixed<uint64_t, 8>(p);
+  double d;
+  memcpy(&d, &dv, sizeof(d));
+  return d;
+}
 
-    if (!func(current.key, v)) {
-      return false;
-    }
+inline int64_t smallIntValue(uint8_t h) noexcept {
+  VELOCYPACK_ASSERT(h >= 0x30 && h <= 0x3f);
+  return (h <= 0x39) ? static_cast<int64_t>(h - 0x30)
+                     : static_cast<int64_t>(h - 0x3a) - 6;
+}
 
-    if (isCompound && order == Collection::PostOrder) {
-      if (!doVisit<order>(v, func)) {
-        return false;
-      }
+template <std::size_t W, bool Signed>
+struct IntReader;
+
+template <std::size_t W>
+struct IntReader<W, true> {
+  typedef int64_t type;
+  static int64_t read(uint8_t const* p) noexcept {
+    uint64_t v = readIntegerFixed<uint64_t, W>(p);
+    if (W == 8) {
+      return toInt64(v);
+    }
+    uint64_t const signBit = uint64_t(1) << (8 * W - 1);
+    if (v & signBit) {
+      return static_cast<int64_t>(v) - static_cast<int64_t>(signBit << 1);
     }
+    return static_cast<int64_t>(v);
+  }
+};
+
+template <std::size_t W>
+struct IntReader<W, false> {
+  typedef uint64_t type;
+  static uint64_t read(uint8_t const* p) noexcept {
+    return readIntegerFixed<uint64_t, W>(p);
+  }
+};
+
+// generic kernel functions. each run function is called with a pointer to
+// the first member of a run and the number of remaining Array members. it
+// consumes members as long as they have the same type as the first one,
+// and returns the number of consumed members. Derived must implement
+// value(double), and can override the run functions with faster versions
+template <typename Derived>
+struct NumberKernel {
+  Derived& self() noexcept { return static_cast<Derived&>(*this); }
+
+  std::size_t doubles(uint8_t const* p, std::size_t n) {
+    std::size_t i = 0;
+    while (i < n && p[9 * i] == 0x1b) {
+      self().value(::readDouble(p + 9 * i + 1));
+      ++i;
+    }
+    return i;
+  }
 
-    it.next();
+  std::size_t smallInts(uint8_t const* p, std::size_t n) {
+    std::size_t i = 0;
+    while (i < n && (p[i] & 0xf0) == 0x30) {
+      self().value(static_cast<double>(::smallIntValue(p[i])));
+      ++i;
+    }
+    return i;
   }
-  return true;
-}
 
-template <Collection::VisitationOrder order>
-static bool visitArray(
-    Slice const& value,
-    std::function<bool(Slice const& key, Slice const& value)> const& func) {
-  ArrayIterator it(value);
+  template <std::size_t W, bool Signed>
+  std::size_t ints(uint8_t const* p, std::size_t n) {
+    uint8_t const h = *p;
+    std::size_t i = 0;
+    while (i < n && p[(W + 1) * i] == h) {
+      self().value(static_cast<double>(
+          IntReader<W, Signed>::read(p + (W + 1) * i + 1)));
+      ++i;
+    }
+    return i;
+  }
 
-  while (it.valid()) {
-    // sub-object?
-    Slice v = it.value();
-    bool const isCompound = (v.isObject() || v.isArray());
+  template <typename T>
+  void packed(PackedArrayView<T> const& values) {
+    for (auto v : values) {
+      self().value(static_cast<double>(v));
+    }
+  }
+};
+
+struct AggregateKernel : NumberKernel<AggregateKernel> {
+  AggregateKernel()
+      : count(0),
+        sum(0.0),
+        min(std::numeric_limits<double>::infinity()),
+        max(-std::numeric_limits<double>::infinity()) {}
+
+  void value(double v) noexcept {
+    ++count;
+    sum += v;
+    // comparisons with NaN are false, so NaNs are ignored here
+    if (v < min) {
+      min = v;
+    }
+    if (v > max) {
+      max = v;
+    }
+  }
 
-    if (isCompound && order == Collection::PreOrder) {
-      if (!doVisit<order>(v, func)) {
-        return false;
+  using NumberKernel<AggregateKernel>::packed;
+
+#ifdef __SSE2__
+  // folds the SIMD accumulators for n values into the scalar results
+  void fold(__m128d s, __m128d mn, __m128d mx, std::size_t n) noexcept {
+    double parts[2];
+    _mm_storeu_pd(&parts[0], s);
+    sum += parts[0] + parts[1];
+    _mm_storeu_pd(&parts[0], mn);
+    min = (std::min)(min, (std::min)(parts[0], parts[1]));
+    _mm_storeu_pd(&parts[0], mx);
+    max = (std::max)(max, (std::max)(parts[0], parts[1]));
+    count += n;
+  }
+
+  std::size_t doubles(uint8_t const* p, std::size_t n) {
+    std::size_t i = 0;
+    if (n >= 4) {
+      __m128d s0 = _mm_setzero_pd();
+      __m128d s1 = _mm_setzero_pd();
+      __m128d mn = _mm_set1_pd(std::numeric_limits<double>::infinity());
+      __m128d mx = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+      while (i + 4 <= n && p[9 * i] == 0x1b && p[9 * i + 9] == 0x1b &&
+             p[9 * i + 18] == 0x1b && p[9 * i + 27] == 0x1b) {
+        double d[4];
+        memcpy(&d[0], p + 9 * i + 1, 8);
+        memcpy(&d[1], p + 9 * i + 10, 8);
+        memcpy(&d[2], p + 9 * i + 19, 8);
+        memcpy(&d[3], p + 9 * i + 28, 8);
+        __m128d v0 = _mm_loadu_pd(&d[0]);
+        __m128d v1 = _mm_loadu_pd(&d[2]);
+        s0 = _mm_add_pd(s0, v0);
+        s1 = _mm_add_pd(s1, v1);
+        // minpd/maxpd return the second operand if either one is NaN
+        mn = _mm_min_pd(v0, mn);
+        mn = _mm_min_pd(v1, mn);
+        mx = _mm_max_pd(v0, mx);
+        mx = _mm_max_pd(v1, mx);
+        i += 4;
+      }
+      if (i > 0) {
+        fold(_mm_add_pd(s0, s1), mn, mx, i);
       }
     }
-
-    if (!func(Slice(), v)) {
-      return false;
+    return i + NumberKernel<AggregateKernel>::doubles(p + 9 * i, n - i);
+  }
+
+  std::size_t smallInts(uint8_t const* p, std::size_t n) {
+    // SmallInts are 0x30 - 0x39 (0 to 9) and 0x3a - 0x3f (-6 to -1).
+    // (h + 6) & 0x0f maps them monotonically to 0 - 15
+    std::size_t i = 0;
+    __m128i const bias = _mm_set1_epi8(6);
+    __m128i const lowNibble = _mm_set1_epi8(0x0f);
+    __m128i const highNibble = _mm_set1_epi8(static_cast<char>(0xf0));
+    __m128i const smallIntHigh = _mm_set1_epi8(0x30);
+    __m128i const zero = _mm_setzero_si128();
+    __m128i total = _mm_setzero_si128();
+    __m128i mn = _mm_set1_epi8(static_cast<char>(0xff));
+    __m128i mx = _mm_setzero_si128();
+    while (i + 16 <= n) {
+      __m128i h = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+      __m128i isSmallInt =
+          _mm_cmpeq_epi8(_mm_and_si128(h, highNibble), smallIntHigh);
+      if (_mm_movemask_epi8(isSmallInt) != 0xffff) {
+        break;
+      }
+      __m128i v = _mm_and_si128(_mm_add_epi8(h, bias), lowNibble);
+      total = _mm_add_epi64(total, _mm_sad_epu8(v, zero));
+      mn = _mm_min_epu8(mn, v);
+      mx = _mm_max_epu8(mx, v);
+      i += 16;
     }
-
-    if (isCompound && order == Collection::PostOrder) {
-      if (!doVisit<order>(v, func)) {
-        return false;
+    if (i > 0) {
+      uint64_t parts[2];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&parts[0]), total);
+      count += i;
+      sum += static_cast<double>(static_cast<int64_t>(parts[0] + parts[1]) -
+                                 6 * static_cast<int64_t>(i));
+      uint8_t bytes[16];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&bytes[0]), mn);
+      double const lo = static_cast<double>(
+          *std::min_element(&bytes[0], &bytes[16]) - 6);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&bytes[0]), mx);
+      double const hi = static_cast<double>(
+          *std::max_element(&bytes[0], &bytes[16]) - 6);
+      min = (std::min)(min, lo);
+      max = (std::max)(max, hi);
+    }
+    return i + NumberKernel<AggregateKernel>::smallInts(p + i, n - i);
+  }
+
+  void packed(PackedArrayView<double> const& values) {
+    uint8_t const* p = values.data();
+    std::size_t const n = values.size();
+    std::size_t i = 0;
+    if (n >= 4) {
+      __m128d s0 = _mm_setzero_pd();
+      __m128d s1 = _mm_setzero_pd();
+      __m128d mn = _mm_set1_pd(std::numeric_limits<double>::infinity());
+      __m128d mx = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+      for (; i + 4 <= n; i += 4) {
+        __m128d v0 = _mm_loadu_pd(reinterpret_cast<double const*>(p + 8 * i));
+        __m128d v1 = _mm_loadu_pd(reinterpret_cast<double const*>(p + 8 * i + 16));
+        s0 = _mm_add_pd(s0, v0);
+        s1 = _mm_add_pd(s1, v1);
+        mn = _mm_min_pd(v0, mn);
+        mn = _mm_min_pd(v1, mn);
+        mx = _mm_max_pd(v0, mx);
+        mx = _mm_max_pd(v1, mx);
       }
+      fold(_mm_add_pd(s0, s1), mn, mx, i);
+    }
+    for (; i < n; ++i) {
+      value(values[i]);
     }
-
-    it.next();
   }
 
-  return true;
-}
-
-template <Collection::VisitationOrder order>
-static bool doVisit(
-    Slice const& slice,
-    std::function<bool(Slice const& key, Slice const& value)> const& func) {
-  if (slice.isObject()) {
-    return visitObject<order>(slice, func);
+  void packed(PackedArrayView<float> const& values) {
+    uint8_t const* p = values.data();
+    std::size_t const n = values.size();
+    std::size_t i = 0;
+    if (n >= 4) {
+      __m128d s = _mm_setzero_pd();
+      __m128d mn = _mm_set1_pd(std::numeric_limits<double>::infinity());
+      __m128d mx = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+      for (; i + 4 <= n; i += 4) {
+        __m128 f = _mm_loadu_ps(reinterpret_cast<float const*>(p + 4 * i));
+        __m128d v0 = _mm_cvtps_pd(f);
+        __m128d v1 = _mm_cvtps_pd(_mm_movehl_ps(f, f));
+        s = _mm_add_pd(s, _mm_add_pd(v0, v1));
+        mn = _mm_min_pd(v0, mn);
+        mn = _mm_min_pd(v1, mn);
+        mx = _mm_max_pd(v0, mx);
+        mx = _mm_max_pd(v1, mx);
+      }
+      fold(s, mn, mx, i);
+    }
+    for (; i < n; ++i) {
+      value(static_cast<double>(values[i]));
+    }
   }
-  if (slice.isArray()) {
-    return visitArray<order>(slice, func);
+#endif
+
+  template <std::size_t W, bool Signed>
+  std::size_t ints(uint8_t const* p, std::size_t n) {
+    typedef typename IntReader<W, Signed>::type Int;
+    // narrow values are summed up in an integer, which cannot overflow
+    // for up to 2^30 values
+    std::size_t const limit = (W <= 4) ? (std::min)(n, std::size_t(1) << 30) : n;
+    uint8_t const h = *p;
+    Int isum = 0;
+    double dsum = 0.0;
+    Int lo = (std::numeric_limits<Int>::max)();
+    Int hi = (std::numeric_limits<Int>::min)();
+    std::size_t i = 0;
+    while (i < limit && p[(W + 1) * i] == h) {
+      Int v = IntReader<W, Signed>::read(p + (W + 1) * i + 1);
+      if (W <= 4) {
+        isum += v;
+      } else {
+        dsum += static_cast<double>(v);
+      }
+      lo = (std::min)(lo, v);
+      hi = (std::max)(hi, v);
+      ++i;
+    }
+    VELOCYPACK_ASSERT(i > 0);
+    count += i;
+    sum += static_cast<double>(isum) + dsum;
+    min = (std::min)(min, static_cast<double>(lo));
+    max = (std::max)(max, static_cast<double>(hi));
+    return i;
+  }
+
+  uint64_t count;
+  double sum;
+  double min;
+  double max;
+};
+
+struct HistogramKernel : NumberKernel<HistogramKernel> {
+  HistogramKernel(double min, double max, std::size_t buckets)
+      : min(min),
+        max(max),
+        factor(static_cast<double>(buckets) / (max - min)),
+        counts(buckets, 0) {}
+
+  void value(double v) noexcept {
+    if (!(v >= min && v <= max)) {
+      // out of range or NaN
+      return;
+    }
+    std::size_t bucket = static_cast<std::size_t>((v - min) * factor);
+    if (bucket >= counts.size()) {
+      // v == max, or rounding errors
+      bucket = counts.size() - 1;
+    }
+    ++counts[bucket];
+  }
+
+  double const min;
+  double const max;
+  double const factor;
+  std::vector<uint64_t> counts;
+};
+
+template <typename Kernel>
+std::size_t intRun(Kernel& kernel, uint8_t const* p, std::size_t n) {
+  switch (*p) {
+    case 0x20: return kernel.template ints<1, true>(p, n);
+    case 0x21: return kernel.template ints<2, true>(p, n);
+    case 0x22: return kernel.template ints<3, true>(p, n);
+    case 0x23: return kernel.template ints<4, true>(p, n);
+    case 0x24: return kernel.template ints<5, true>(p, n);
+    case 0x25: return kernel.template ints<6, true>(p, n);
+    case 0x26: return kernel.template ints<7, true>(p, n);
+    case 0x27: return kernel.template ints<8, true>(p, n);
+    case 0x28: return kernel.template ints<1, false>(p, n);
+    case 0x29: return kernel.template ints<2, false>(p, n);
+    case 0x2a: return kernel.template ints<3, false>(p, n);
+    case 0x2b: return kernel.template ints<4, false>(p, n);
+    case 0x2c: return kernel.template ints<5, false>(p, n);
+    case 0x2d: return kernel.template ints<6, false>(p, n);
+    case 0x2e: return kernel.template ints<7, false>(p, n);
+    default: {
+      VELOCYPACK_ASSERT(*p == 0x2f);
+      return kernel.template ints<8, false>(p, n);
+    }
   }
-
-  throw Exception(Exception::InvalidValueType,
-                  "Expecting type Object or Array");
 }
 
-void Collection::visitRecursive(
-    Slice const& slice, Collection::VisitationOrder order,
-    std::function<bool(Slice const&, Slice const&)> const& func) {
-  if (order == Collection::PreOrder) {
-    doVisit<Collection::PreOrder>(slice, func);
-  } else {
-    doVisit<Collection::PostOrder>(slice, func);
+// walks the members of an Array sequentially, handing runs of members
+// with the same type to the kernel
+template <typename Kernel>
+void aggregate(Slice const& slice, Options const* options, Kernel& kernel) {
+  if (slice.isTagged()) {
+    if (slice.isPackedArray<double>(options)) {
+      kernel.packed(slice.getPackedArray<double>(options));
+      return;
+    }
+    if (slice.isPackedArray<float>(options)) {
+      kernel.packed(slice.getPackedArray<float>(options));
+      return;
+    }
+    if (slice.isPackedArray<int64_t>(options)) {
+      kernel.packed(slice.getPackedArray<int64_t>(options));
+      return;
+    }
   }
-}
 
-Builder Collection::sort(
-      Slice const& array,
-      std::function<bool (Slice const&, Slice const&)> lessthan) {
-  if (!array.isArray()) {
+  if (!slice.isArray()) {
     throw Exception(Exception::InvalidValueType, "Expecting type Array");
   }
-  std::vector<Slice> subValues;
-  ValueLength len = array.length();
-  subValues.reserve(checkOverflow(len));
-  for (ValueLength i = 0; i < len; i++) {
-    subValues.push_back(array[i]);
-  }
-  std::sort(subValues.begin(), subValues.end(), lessthan);
-  Builder b;
-  b.openArray();
-  for (auto const&s : subValues) {
-    b.add(s);
+
+  ArrayIterator it(slice);
+  std::size_t remaining = static_cast<std::size_t>(it.size());
+  if (remaining == 0) {
+    return;
+  }
+
+  // members are stored back to back, in all Array layouts
+  uint8_t const* p = it.value().start();
+  while (remaining > 0) {
+    uint8_t const h = *p;
+    std::size_t consumed;
+    if (h == 0x1b) {
+      consumed = kernel.doubles(p, remaining);
+      p += 9 * consumed;
+    } else if (h >= 0x30 && h <= 0x3f) {
+      consumed = kernel.smallInts(p, remaining);
+      p += consumed;
+    } else if (h >= 0x20 && h <= 0x2f) {
+      consumed = ::intRun(kernel, p, remaining);
+      std::size_t const width = (h <= 0x27) ? (h - 0x1f) : (h - 0x27);
+      p += (width + 1) * consumed;
+    } else {
+      Slice s(p);
+      if (s.isNumber()) {
+        kernel.value(s.getNumber<double>());
+      }
+      consumed = 1;
+      p += s.byteSize();
+    }
+    VELOCYPACK_ASSERT(consumed > 0 && consumed <= remaining);
+    remaining -= consumed;
   }
-  b.close();
-  return b;
 }
 
+}  // namespace
+
+Collection::NumberAggregate Collection::aggregateNumbers(Slice const& slice,
+                                                        Options const* options) {
+  AggregateKernel kernel;
+  ::aggregate(slice, options, kernel);
+  return NumberAggregate{kernel.count, kernel.sum, kernel.min, kernel.max};
+}
+
+bool Collection::minMax(Slice const& slice, double& min, double& max,
+                        Options const* options) {
+  AggregateKernel kernel;
+  ::aggregate(slice, options, kernel);
+  min = kernel.min;
+  max = kernel.max;
+  return kernel.count > 0;
+}
+
+std::vector<uint64_t> Collection::histogram(Slice const& slice, double min,
+                                            double max, std::size_t buckets,
+                                            Options const* options) {
+  if (buckets == 0 || !(min < max) || std::isinf(max - min)) {
+    throw Exception(Exception::NumberOutOfRange, "Invalid histogram bounds");
+  }
+  HistogramKernel kernel(min, max, buckets);
+  ::aggregate(slice, options, kernel);
+  return std::move(kernel.counts);
+}
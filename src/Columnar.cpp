@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <string>
+
+#include "velocypack/Columnar.h"
+#include "velocypack/Iterator.h"
+#include "velocypack/Value.h"
+
+using namespace arangodb::velocypack;
+
+namespace {
+
+void throwInvalid() {
+  throw Exception(Exception::InvalidValueType, "Expecting columnar value");
+}
+
+}  // namespace
+
+void Columnar::fromRows(Slice rows, Builder& builder) {
+  if (!rows.isArray()) {
+    throw Exception(Exception::InvalidValueType, "Expecting type Array");
+  }
+
+  // first pass: collect the attribute names and the values of all cells.
+  // cells of attributes that a row does not have remain None
+  std::vector<StringRef> keys;
+  std::unordered_map<StringRef, std::size_t> index;
+  std::vector<std::vector<Slice>> cells;
+  std::size_t const n = static_cast<std::size_t>(rows.length());
+
+  std::size_t row = 0;
+  for (auto it : ArrayIterator(rows)) {
+    if (!it.isObject()) {
+      throw Exception(Exception::InvalidValueType, "Expecting type Object");
+    }
+    ObjectIterator oit(it, true);
+    while (oit.valid()) {
+      StringRef key = oit.key(true).stringRef();
+      auto found = index.find(key);
+      std::size_t column;
+      if (found == index.end()) {
+        column = keys.size();
+        index.emplace(key, column);
+        keys.push_back(key);
+        cells.emplace_back(n);
+      } else {
+        column = (*found).second;
+      }
+      Slice& cell = cells[column][row];
+      if (cell.isNone()) {
+        // first occurrence of the attribute wins
+        cell = oit.value();
+      }
+      oit.next();
+    }
+    ++row;
+  }
+
+  builder.openObject();
+  builder.add("length", Value(static_cast<uint64_t>(n)));
+  builder.add("keys", Value(ValueType::Array));
+  for (auto const& key : keys) {
+    builder.add(ValuePair(key.data(), key.size(), ValueType::String));
+  }
+  builder.close();
+  builder.add("columns", Value(ValueType::Array));
+  for (auto const& column : cells) {
+    builder.openArray();
+    for (auto const& cell : column) {
+      builder.add(cell.isNone() ? Slice::illegalSlice() : cell);
+    }
+    builder.close();
+  }
+  builder.close();
+  builder.close();
+}
+
+void Columnar::toRows(Slice columnar, Builder& builder) {
+  ColumnarView view(columnar);
+
+  std::vector<ArrayIterator> columns;
+  columns.reserve(static_cast<std::size_t>(view.numColumns()));
+  for (ValueLength i = 0; i < view.numColumns(); ++i) {
+    columns.emplace_back(view.column(i));
+  }
+
+  builder.openArray();
+  for (ValueLength row = 0; row < view.length(); ++row) {
+    builder.openObject();
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+      Slice value = columns[i].value();
+      if (!value.isIllegal()) {
+        builder.add(view.keyAt(i).stringRef(), value);
+      }
+      columns[i].next();
+    }
+    builder.close();
+  }
+  builder.close();
+}
+
+ColumnarView::ColumnarView(Slice columnar) : _slice(columnar), _length(0) {
+  if (!columnar.isObject()) {
+    ::throwInvalid();
+  }
+  Slice length = columnar.get("length");
+  _keys = columnar.get("keys");
+  Slice columns = columnar.get("columns");
+  if (!length.isInteger() || !_keys.isArray() || !columns.isArray() ||
+      _keys.length() != columns.length()) {
+    ::throwInvalid();
+  }
+  _length = length.getNumber<ValueLength>();
+
+  _columns.reserve(static_cast<std::size_t>(columns.length()));
+  for (auto it : ArrayIterator(columns)) {
+    if (!it.isArray() || it.length() != _length) {
+      ::throwInvalid();
+    }
+    _columns.push_back(it);
+  }
+
+  std::size_t i = 0;
+  for (auto it : ArrayIterator(_keys)) {
+    if (!it.isString()) {
+      ::throwInvalid();
+    }
+    _index.emplace(it.stringRef(), i++);
+  }
+}
+
+Slice ColumnarRow::get(StringRef const& attribute) const {
+  int64_t column = _view->columnIndex(attribute);
+  if (column < 0) {
+    return Slice();
+  }
+  return valueAt(static_cast<ValueLength>(column));
+}
+
+Slice ColumnarRow::valueAt(ValueLength column) const {
+  Slice value = _view->column(column).at(_index);
+  if (value.isIllegal()) {
+    return Slice();
+  }
+  return value;
+}
+
+void ColumnarRow::toObject(Builder& builder) const {
+  builder.openObject();
+  for (ValueLength i = 0; i < _view->numColumns(); ++i) {
+    Slice value = valueAt(i);
+    if (!value.isNone()) {
+      builder.add(_view->keyAt(i).stringRef(), value);
+    }
+  }
+  builder.close();
+}
@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include <utility>
+
+#include "velocypack/CompactIndex.h"
+#include "velocypack/Iterator.h"
+
+using namespace arangodb::velocypack;
+
+namespace {
+
+// returns the attribute name of an Object key, translating it if required.
+// returns false for keys of invalid types, which can never be found via get()
+bool keyName(Slice key, StringRef& name) {
+  if (key.isString()) {
+    name = key.stringRef();
+    return true;
+  }
+  if (key.isSmallInt() || key.isUInt()) {
+    // throws if there is no attribute translator
+    name = key.makeKey().stringRef();
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+CompactIndex::CompactIndex(Slice slice) : _slice(slice), _length(0) {
+  if (VELOCYPACK_UNLIKELY(!slice.isArray() && !slice.isObject())) {
+    throw Exception(Exception::InvalidValueType,
+                    "Expecting type Array or Object");
+  }
+
+  _length = slice.length();
+  uint8_t const h = slice.head();
+
+  if (h == 0x13) {
+    _offsets.reserve(static_cast<std::size_t>(_length));
+    for (auto it : ArrayIterator(slice)) {
+      _offsets.push_back(static_cast<ValueLength>(it.start() - slice.start()));
+    }
+    return;
+  }
+
+  if (h != 0x14 && (h < 0x0f || h > 0x12)) {
+    // indexed Array, sorted Object or empty value. nothing to do
+    return;
+  }
+
+  // compact or unsorted Object
+  std::vector<std::pair<StringRef, ValueLength>> keys;
+  keys.reserve(static_cast<std::size_t>(_length));
+  if (h == 0x14) {
+    _offsets.reserve(static_cast<std::size_t>(_length));
+  }
+
+  ObjectIterator it(slice, true);
+  while (it.valid()) {
+    Slice key = it.key(false);
+    ValueLength offset = static_cast<ValueLength>(key.start() - slice.start());
+    if (h == 0x14) {
+      _offsets.push_back(offset);
+    }
+    StringRef name;
+    if (::keyName(key, name)) {
+      keys.emplace_back(name, offset);
+    }
+    it.next();
+  }
+
+  // stable sort, so that get() returns the first of duplicate attributes,
+  // as the linear search in Slice::get() does
+  std::stable_sort(keys.begin(), keys.end(),
+                   [](std::pair<StringRef, ValueLength> const& lhs,
+                      std::pair<StringRef, ValueLength> const& rhs) {
+                     return lhs.first.compare(rhs.first) < 0;
+                   });
+
+  _sorted.reserve(keys.size());
+  for (auto const& key : keys) {
+    _sorted.push_back(key.second);
+  }
+}
+
+Slice CompactIndex::get(StringRef const& attribute) const {
+  if (VELOCYPACK_UNLIKELY(!_slice.isObject())) {
+    throw Exception(Exception::InvalidValueType, "Expecting Object");
+  }
+
+  uint8_t const h = _slice.head();
+  if (h != 0x14 && (h < 0x0f || h > 0x12)) {
+    // sorted Objects can be searched efficiently already
+    return _slice.get(attribute);
+  }
+
+  uint8_t const* start = _slice.start();
+  auto it = std::lower_bound(_sorted.begin(), _sorted.end(), attribute,
+                             [start](ValueLength offset, StringRef const& attribute) {
+                               StringRef name;
+                               ::keyName(Slice(start + offset), name);
+                               return name.compare(attribute) < 0;
+                             });
+
+  if (it != _sorted.end()) {
+    Slice key(start + (*it));
+    StringRef name;
+    ::keyName(key, name);
+    if (name.equals(attribute)) {
+      return Slice(key.start() + key.byteSize());
+    }
+  }
+
+  // not found
+  return Slice();
+}
@@ -30,10 +30,301 @@
 #include "velocypack/Slice.h"
 #include "velocypack/ValueType.h"
 
-#include <set>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
 
 using namespace arangodb::velocypack;
 
+namespace {
+
+// sort weights of the value types, used by compare and by the sort keys.
+// weight 0 is reserved as the terminator byte in sort keys
+enum class SortWeight : uint8_t {
+  Terminator = 0,
+  MinKey = 1,
+  None,
+  Illegal,
+  Null,
+  Bool,
+  Number,
+  UTCDate,
+  String,
+  Binary,
+  Array,
+  Object,
+  MaxKey
+};
+
+// resolves Externals and strips tags, so that only the actual value remains
+Slice normalize(Slice slice) {
+  while (true) {
+    if (slice.isExternal()) {
+      slice = slice.resolveExternal();
+    } else if (slice.isTagged()) {
+      slice = slice.value();
+    } else {
+      return slice;
+    }
+  }
+}
+
+SortWeight sortWeight(Slice slice) {
+  switch (slice.type()) {
+    case ValueType::MinKey:
+      return SortWeight::MinKey;
+    case ValueType::None:
+      return SortWeight::None;
+    case ValueType::Illegal:
+      return SortWeight::Illegal;
+    case ValueType::Null:
+      return SortWeight::Null;
+    case ValueType::Bool:
+      return SortWeight::Bool;
+    case ValueType::Double:
+    case ValueType::Int:
+    case ValueType::UInt:
+    case ValueType::SmallInt:
+      return SortWeight::Number;
+    case ValueType::UTCDate:
+      return SortWeight::UTCDate;
+    case ValueType::String:
+      return SortWeight::String;
+    case ValueType::Binary:
+      return SortWeight::Binary;
+    case ValueType::Array:
+      return SortWeight::Array;
+    case ValueType::Object:
+      return SortWeight::Object;
+    case ValueType::MaxKey:
+      return SortWeight::MaxKey;
+    case ValueType::BCD:
+    case ValueType::Custom:
+      throw Exception(Exception::NotImplemented, "sort order for BCD and Custom types is not implemented");
+    default:
+      throw Exception(Exception::InternalError, "invalid value type for sorting");
+  }
+}
+
+template<typename T>
+inline int compareValues(T lhs, T rhs) noexcept {
+  return (lhs < rhs) ? -1 : ((lhs > rhs) ? 1 : 0);
+}
+
+int compareBytes(uint8_t const* lhs, ValueLength nl, 
+                 uint8_t const* rhs, ValueLength nr) noexcept {
+  int res = memcmp(lhs, rhs, checkOverflow((std::min)(nl, nr)));
+  if (res != 0) {
+    return res < 0 ? -1 : 1;
+  }
+  return compareValues(nl, nr);
+}
+
+// exact comparison of an integer with a double. NaN sorts first
+int compareIntDouble(int64_t lhs, double rhs) noexcept {
+  if (std::isnan(rhs) || rhs < -9223372036854775808.0) {
+    return 1;
+  }
+  if (rhs >= 9223372036854775808.0) {
+    return -1;
+  }
+  // truncation is exact in this range
+  int64_t truncated = static_cast<int64_t>(rhs);
+  if (lhs != truncated) {
+    return compareValues(lhs, truncated);
+  }
+  return compareValues(0.0, rhs - static_cast<double>(truncated));
+}
+
+// exact comparison of an unsigned integer with a double. NaN sorts first
+int compareUIntDouble(uint64_t lhs, double rhs) noexcept {
+  if (std::isnan(rhs) || rhs < 0.0) {
+    return 1;
+  }
+  if (rhs >= 18446744073709551616.0) {
+    return -1;
+  }
+  // truncation is exact in this range
+  uint64_t truncated = static_cast<uint64_t>(rhs);
+  if (lhs != truncated) {
+    return compareValues(lhs, truncated);
+  }
+  return compareValues(0.0, rhs - static_cast<double>(truncated));
+}
+
+int compareDoubles(double lhs, double rhs) noexcept {
+  bool const lhsNaN = std::isnan(lhs);
+  bool const rhsNaN = std::isnan(rhs);
+  if (lhsNaN || rhsNaN) {
+    return compareValues(rhsNaN, lhsNaN);
+  }
+  return compareValues(lhs, rhs);
+}
+
+// returns true if both Slices have the same byte representation
+inline bool identicalBytes(Slice lhs, Slice rhs) {
+  ValueLength const n = lhs.byteSize();
+  return (n == rhs.byteSize() &&
+          (lhs.start() == rhs.start() || memcmp(lhs.start(), rhs.start(), checkOverflow(n)) == 0));
+}
+
+// compares a value with a byte-identical copy of itself, with the same
+// result as NormalizedCompare::equals(). only NaN makes such values
+// unequal, so this is a single walk over one side without any memcmp
+bool equalsIdentical(Slice slice) {
+  slice = slice.resolveExternals();
+  switch (valueTypeGroup(slice.type())) {
+    case ValueType::Illegal:
+    case ValueType::None:
+    case ValueType::Null:
+    case ValueType::MinKey:
+    case ValueType::MaxKey:
+    case ValueType::Bool:
+    case ValueType::String: {
+      return true;
+    }
+    case ValueType::Double: {
+      return !slice.isDouble() || !std::isnan(slice.getDouble());
+    }
+    case ValueType::Array: {
+      for (auto const& it : ArrayIterator(slice)) {
+        if (!equalsIdentical(it)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case ValueType::Object: {
+      ObjectIterator it(slice, true);
+      while (it.valid()) {
+        if (!equalsIdentical(it.value())) {
+          return false;
+        }
+        it.next();
+      }
+      return true;
+    }
+    case ValueType::Custom: {
+      throw Exception(Exception::NotImplemented, "equals comparison for Custom type is not implemented");
+    }
+    default: {
+      throw Exception(Exception::InternalError, "invalid value type for equals comparison");
+    }
+  }
+}
+
+typedef std::vector<std::pair<StringRef, Slice>> ObjectMembers;
+
+// collects the key/value pairs of an Object in ascending key order
+void sortedMembers(Slice slice, ObjectMembers& members) {
+  // the index table of sorted objects is already in key order
+  bool const isSorted = slice.isSorted();
+  ObjectIterator it(slice, !isSorted);
+  members.reserve(checkOverflow(it.size()));
+  while (it.valid()) {
+    auto current = (*it);
+    members.emplace_back(current.key.stringRef(), current.value);
+    it.next();
+  }
+  if (!isSorted) {
+    std::sort(members.begin(), members.end(), 
+              [](std::pair<StringRef, Slice> const& lhs, std::pair<StringRef, Slice> const& rhs) {
+      return lhs.first.compare(rhs.first) < 0;
+    });
+  }
+}
+
+// writes an unsigned integer in big-endian byte order
+void appendBigEndian(std::string& out, uint64_t value) {
+  char buffer[8];
+  for (int i = 7; i >= 0; --i) {
+    buffer[i] = static_cast<char>(value & 0xffU);
+    value >>= 8;
+  }
+  out.append(&buffer[0], sizeof(buffer));
+}
+
+// writes a signed integer so that the byte order matches the numeric order
+inline void appendSigned(std::string& out, int64_t value) {
+  appendBigEndian(out, toUInt64(value) ^ 0x8000000000000000ULL);
+}
+
+// writes a double so that the byte order matches the numeric order.
+// NaN is written as all zero bytes so that it sorts first
+void appendDouble(std::string& out, double value) {
+  if (std::isnan(value)) {
+    appendBigEndian(out, 0);
+    return;
+  }
+  if (value == 0.0) {
+    // normalize -0.0
+    value = 0.0;
+  }
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  if (bits & 0x8000000000000000ULL) {
+    bits = ~bits;
+  } else {
+    bits |= 0x8000000000000000ULL;
+  }
+  appendBigEndian(out, bits);
+}
+
+// writes a number as its nearest double, followed by the exact difference
+// between the number and that double. the difference is only non-zero for
+// integers that cannot be represented exactly as a double
+void appendNumber(std::string& out, Slice slice) {
+  int64_t residue = 0;
+  double approximation;
+
+  if (slice.isDouble()) {
+    approximation = slice.getDouble();
+  } else if (slice.isUInt()) {
+    uint64_t v = slice.getUIntUnchecked();
+    approximation = static_cast<double>(v);
+    if (approximation >= 18446744073709551616.0) {
+      residue = -static_cast<int64_t>(UINT64_MAX - v) - 1;
+    } else {
+      uint64_t truncated = static_cast<uint64_t>(approximation);
+      residue = (v >= truncated) ? static_cast<int64_t>(v - truncated) 
+                                 : -static_cast<int64_t>(truncated - v);
+    }
+  } else {
+    int64_t v = slice.getIntUnchecked();
+    approximation = static_cast<double>(v);
+    if (approximation >= 9223372036854775808.0) {
+      residue = (v - INT64_MAX) - 1;
+    } else {
+      residue = v - static_cast<int64_t>(approximation);
+    }
+  }
+
+  appendDouble(out, approximation);
+  appendSigned(out, residue);
+}
+
+// writes a byte sequence with all 0x00 bytes escaped as 0x00 0xff,
+// terminated by 0x00 0x00
+void appendEscaped(std::string& out, char const* p, ValueLength length) {
+  char const* e = p + length;
+  while (p < e) {
+    char const* zero = static_cast<char const*>(memchr(p, '\0', checkOverflow(e - p)));
+    if (zero == nullptr) {
+      out.append(p, checkOverflow(e - p));
+      break;
+    }
+    out.append(p, checkOverflow(zero - p));
+    out.push_back('\0');
+    out.push_back('\xff');
+    p = zero + 1;
+  }
+  out.push_back('\0');
+  out.push_back('\0');
+}
+
+} // namespace
+
 bool BinaryCompare::equals(Slice lhs, Slice rhs) {
   return lhs.binaryEquals(rhs);
 }
@@ -109,6 +400,11 @@ bool NormalizedCompare::equals(Slice lhs, Slice rhs) {
       return equalsStrings(lhs, rhs);
     }
     case ValueType::Array: {
+      if (::identicalBytes(lhs, rhs)) {
+        // byte-identical arrays only need a walk over one side
+        return ::equalsIdentical(lhs);
+      }
+
       ArrayIterator lhsValue(lhs);
       ArrayIterator rhsValue(rhs);
 
@@ -128,13 +424,48 @@ bool NormalizedCompare::equals(Slice lhs, Slice rhs) {
       return true;
     }
     case ValueType::Object: {
-      std::set<std::string> keys;
-      // get all keys and bring them in order
-      Collection::unorderedKeys(lhs, keys);
-      Collection::unorderedKeys(rhs, keys);
-      for (auto const& key : keys) {
+      if (::identicalBytes(lhs, rhs)) {
+        // byte-identical objects only need a walk over one side
+        return ::equalsIdentical(lhs);
+      }
+
+      ValueLength const n = lhs.length();
+      if (n != rhs.length()) {
+        // unequal number of attributes
+        return false;
+      }
+
+      if (lhs.isSorted() && rhs.isSorted()) {
+        // the index tables of both objects are in key order already,
+        // so we can walk them in lockstep without any lookups
+        ObjectIterator lhsValue(lhs, false);
+        ObjectIterator rhsValue(rhs, false);
+        while (lhsValue.valid()) {
+          if (!lhsValue.key().stringRef().equals(rhsValue.key().stringRef())) {
+            return false;
+          }
+          // recurse
+          if (!equals(lhsValue.value(), rhsValue.value())) {
+            return false;
+          }
+          lhsValue.next();
+          rhsValue.next();
+        }
+        return true;
+      }
+
+      ObjectMembers lhsMembers;
+      ObjectMembers rhsMembers;
+      ::sortedMembers(lhs, lhsMembers);
+      ::sortedMembers(rhs, rhsMembers);
+      VELOCYPACK_ASSERT(lhsMembers.size() == rhsMembers.size());
+
+      for (std::size_t i = 0; i < lhsMembers.size(); ++i) {
+        if (!lhsMembers[i].first.equals(rhsMembers[i].first)) {
+          return false;
+        }
         // recurse
-        if (!equals(lhs.get(key), rhs.get(key))) {
+        if (!equals(lhsMembers[i].second, rhsMembers[i].second)) {
           return false;
         }
       }
@@ -149,6 +480,133 @@ bool NormalizedCompare::equals(Slice lhs, Slice rhs) {
   }
 }
 
+int NormalizedCompare::compareNumbers(Slice lhs, Slice rhs) {
+  auto lhsType = lhs.type();
+  auto rhsType = rhs.type();
+
+  if (lhsType == ValueType::Double) {
+    double l = lhs.getDouble();
+    if (rhsType == ValueType::Double) {
+      return compareDoubles(l, rhs.getDouble());
+    }
+    if (rhsType == ValueType::UInt) {
+      return -compareUIntDouble(rhs.getUIntUnchecked(), l);
+    }
+    return -compareIntDouble(rhs.getIntUnchecked(), l);
+  }
+
+  if (lhsType == ValueType::UInt) {
+    uint64_t l = lhs.getUIntUnchecked();
+    if (rhsType == ValueType::Double) {
+      return compareUIntDouble(l, rhs.getDouble());
+    }
+    if (rhsType == ValueType::UInt) {
+      return compareValues(l, rhs.getUIntUnchecked());
+    }
+    int64_t r = rhs.getIntUnchecked();
+    if (r < 0) {
+      return 1;
+    }
+    return compareValues(l, static_cast<uint64_t>(r));
+  }
+
+  // Int or SmallInt
+  int64_t l = lhs.getIntUnchecked();
+  if (rhsType == ValueType::Double) {
+    return compareIntDouble(l, rhs.getDouble());
+  }
+  if (rhsType == ValueType::UInt) {
+    if (l < 0) {
+      return -1;
+    }
+    return compareValues(static_cast<uint64_t>(l), rhs.getUIntUnchecked());
+  }
+  return compareValues(l, rhs.getIntUnchecked());
+}
+
+int NormalizedCompare::compareStrings(Slice lhs, Slice rhs) {
+  ValueLength nl;
+  char const* left = lhs.getString(nl);
+  VELOCYPACK_ASSERT(left != nullptr);
+  ValueLength nr;
+  char const* right = rhs.getString(nr);
+  VELOCYPACK_ASSERT(right != nullptr);
+  return compareBytes(reinterpret_cast<uint8_t const*>(left), nl, 
+                      reinterpret_cast<uint8_t const*>(right), nr);
+}
+
+int NormalizedCompare::compare(Slice lhs, Slice rhs) {
+  lhs = ::normalize(lhs);
+  rhs = ::normalize(rhs);
+  SortWeight const lhsWeight = ::sortWeight(lhs);
+  SortWeight const rhsWeight = ::sortWeight(rhs);
+
+  if (lhsWeight != rhsWeight) {
+    return (lhsWeight < rhsWeight) ? -1 : 1;
+  }
+
+  switch (lhsWeight) {
+    case SortWeight::Bool: {
+      return compareValues(lhs.getBoolean(), rhs.getBoolean());
+    }
+    case SortWeight::Number: {
+      return compareNumbers(lhs, rhs);
+    }
+    case SortWeight::UTCDate: {
+      return compareValues(lhs.getUTCDate(), rhs.getUTCDate());
+    }
+    case SortWeight::String: {
+      return compareStrings(lhs, rhs);
+    }
+    case SortWeight::Binary: {
+      ValueLength nl;
+      uint8_t const* left = lhs.getBinary(nl);
+      ValueLength nr;
+      uint8_t const* right = rhs.getBinary(nr);
+      return compareBytes(left, nl, right, nr);
+    }
+    case SortWeight::Array: {
+      ArrayIterator lhsValue(lhs);
+      ArrayIterator rhsValue(rhs);
+
+      while (lhsValue.valid() && rhsValue.valid()) {
+        // recurse
+        int res = compare(lhsValue.value(), rhsValue.value());
+        if (res != 0) {
+          return res;
+        }
+        lhsValue.next();
+        rhsValue.next();
+      }
+      return compareValues(lhsValue.size(), rhsValue.size());
+    }
+    case SortWeight::Object: {
+      ObjectMembers lhsMembers;
+      ObjectMembers rhsMembers;
+      ::sortedMembers(lhs, lhsMembers);
+      ::sortedMembers(rhs, rhsMembers);
+
+      std::size_t const n = (std::min)(lhsMembers.size(), rhsMembers.size());
+      for (std::size_t i = 0; i < n; ++i) {
+        int res = lhsMembers[i].first.compare(rhsMembers[i].first);
+        if (res != 0) {
+          return res < 0 ? -1 : 1;
+        }
+        // recurse
+        res = compare(lhsMembers[i].second, rhsMembers[i].second);
+        if (res != 0) {
+          return res;
+        }
+      }
+      return compareValues(lhsMembers.size(), rhsMembers.size());
+    }
+    default: {
+      // all other types have only a single value
+      return 0;
+    }
+  }
+}
+
 size_t NormalizedCompare::Hash::operator()(arangodb::velocypack::Slice const& slice) const {
   return static_cast<size_t>(slice.normalizedHash());
 }
@@ -157,3 +615,73 @@ bool NormalizedCompare::Equal::operator()(arangodb::velocypack::Slice const& lhs
                                           arangodb::velocypack::Slice const& rhs) const {
   return NormalizedCompare::equals(lhs, rhs);
 }
+
+bool NormalizedCompare::Less::operator()(arangodb::velocypack::Slice const& lhs,
+                                         arangodb::velocypack::Slice const& rhs) const {
+  return NormalizedCompare::compare(lhs, rhs) < 0;
+}
+
+void SortKey::append(Slice slice, std::string& out) {
+  slice = ::normalize(slice);
+  SortWeight const weight = ::sortWeight(slice);
+  out.push_back(static_cast<char>(weight));
+
+  switch (weight) {
+    case SortWeight::Bool: {
+      out.push_back(slice.isTrue() ? '\x01' : '\0');
+      break;
+    }
+    case SortWeight::Number: {
+      ::appendNumber(out, slice);
+      break;
+    }
+    case SortWeight::UTCDate: {
+      ::appendSigned(out, slice.getUTCDate());
+      break;
+    }
+    case SortWeight::String: {
+      ValueLength length;
+      char const* p = slice.getString(length);
+      ::appendEscaped(out, p, length);
+      break;
+    }
+    case SortWeight::Binary: {
+      ValueLength length;
+      uint8_t const* p = slice.getBinary(length);
+      ::appendEscaped(out, reinterpret_cast<char const*>(p), length);
+      break;
+    }
+    case SortWeight::Array: {
+      ArrayIterator it(slice);
+      while (it.valid()) {
+        // recurse
+        append(it.value(), out);
+        it.next();
+      }
+      out.push_back(static_cast<char>(SortWeight::Terminator));
+      break;
+    }
+    case SortWeight::Object: {
+      ObjectMembers members;
+      ::sortedMembers(slice, members);
+      for (auto const& it : members) {
+        out.push_back(static_cast<char>(SortWeight::String));
+        ::appendEscaped(out, it.first.data(), it.first.size());
+        // recurse
+        append(it.second, out);
+      }
+      out.push_back(static_cast<char>(SortWeight::Terminator));
+      break;
+    }
+    default: {
+      // all other types have only a single value
+      break;
+    }
+  }
+}
+
+std::string SortKey::encode(Slice slice) {
+  std::string out;
+  append(slice, out);
+  return out;
+}
@@ -0,0 +1,540 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+
+#include "velocypack/Compression.h"
+#include "velocypack/Exception.h"
+#include "velocypack/Validator.h"
+
+#include "parallel.h"
+
+using namespace arangodb::velocypack;
+
+constexpr uint8_t CompressedFormat::version;
+constexpr std::size_t CompressedFormat::headerLength;
+constexpr std::size_t CompressedFormat::blockHeaderLength;
+constexpr std::size_t CompressedFormat::indexEntryLength;
+constexpr std::size_t CompressedFormat::footerLength;
+constexpr std::size_t CompressedWriter::defaultBlockSize;
+
+namespace {
+
+constexpr std::size_t minMatch = 4;
+constexpr std::size_t maxDistance = 65535;
+constexpr unsigned hashBits = 14;
+
+constexpr char headerMagic[] = "VPKZ";
+constexpr char footerMagic[] = "VPKI";
+
+inline uint32_t read32(uint8_t const* p) noexcept {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t hashSequence(uint32_t sequence) noexcept {
+  return (sequence * 2654435761U) >> (32 - hashBits);
+}
+
+inline uint32_t readUInt32(uint8_t const* p) noexcept {
+  return readIntegerFixed<uint32_t, 4>(p);
+}
+
+inline void storeUInt32(uint8_t* p, uint32_t value) noexcept {
+  for (std::size_t i = 0; i < 4; ++i) {
+    p[i] = static_cast<uint8_t>(value & 0xffU);
+    value >>= 8;
+  }
+}
+
+[[noreturn]] void corrupt(char const* message) {
+  throw Exception(Exception::CorruptCompressedData, message);
+}
+
+// writes the extension bytes of a length that did not fit into its nibble
+uint8_t* writeLength(uint8_t* out, std::size_t length) noexcept {
+  while (length >= 255) {
+    *out++ = 255;
+    length -= 255;
+  }
+  *out++ = static_cast<uint8_t>(length);
+  return out;
+}
+
+// reads the extension bytes of a length
+std::size_t readLength(uint8_t const*& p, uint8_t const* end) {
+  std::size_t length = 0;
+  uint8_t byte;
+  do {
+    if (p == end) {
+      corrupt("compressed data ends within a length");
+    }
+    byte = *p++;
+    length += byte;
+  } while (byte == 255);
+  return length;
+}
+
+// writes literals, followed by a match unless matchLength is 0
+uint8_t* writeSequence(uint8_t* out, uint8_t const* literals, std::size_t literalLength,
+                       std::size_t distance, std::size_t matchLength) noexcept {
+  uint8_t* token = out++;
+  std::size_t const literalNibble = (std::min)(literalLength, std::size_t(15));
+  if (literalNibble == 15) {
+    out = writeLength(out, literalLength - 15);
+  }
+  memcpy(out, literals, literalLength);
+  out += literalLength;
+
+  std::size_t matchNibble = 0;
+  if (matchLength > 0) {
+    *out++ = static_cast<uint8_t>(distance & 0xffU);
+    *out++ = static_cast<uint8_t>(distance >> 8);
+    matchNibble = (std::min)(matchLength - minMatch, std::size_t(15));
+    if (matchNibble == 15) {
+      out = writeLength(out, matchLength - minMatch - 15);
+    }
+  }
+  *token = static_cast<uint8_t>((literalNibble << 4) | matchNibble);
+  return out;
+}
+
+uint32_t adler32(uint8_t const* p, std::size_t length) noexcept {
+  // largest number of bytes that can be summed before the sums overflow
+  constexpr std::size_t chunkSize = 5552;
+  constexpr uint32_t modulus = 65521;
+
+  uint32_t a = 1;
+  uint32_t b = 0;
+  while (length > 0) {
+    std::size_t chunk = (std::min)(length, chunkSize);
+    length -= chunk;
+    // 4 bytes at a time, which shortens the dependency chain of the sums
+    while (chunk >= 4) {
+      b += 4 * a + 4 * p[0] + 3 * p[1] + 2 * p[2] + p[3];
+      a += p[0] + p[1] + p[2] + p[3];
+      p += 4;
+      chunk -= 4;
+    }
+    while (chunk-- > 0) {
+      a += *p++;
+      b += a;
+    }
+    a %= modulus;
+    b %= modulus;
+  }
+  return (b << 16) | a;
+}
+
+}  // namespace
+
+std::size_t LZCodec::compress(uint8_t const* src, std::size_t length, uint8_t* dst) {
+  uint8_t* out = dst;
+  std::size_t anchor = 0;
+
+  if (length > minMatch) {
+    // most recent position of each hashed 4 byte sequence
+    std::unique_ptr<uint32_t[]> table(new uint32_t[std::size_t(1) << hashBits]());
+    std::size_t const limit = length - minMatch;
+    std::size_t ip = 0;
+
+    while (ip <= limit) {
+      uint32_t const sequence = ::read32(src + ip);
+      uint32_t const h = ::hashSequence(sequence);
+      std::size_t ref = table[h];
+      table[h] = static_cast<uint32_t>(ip);
+
+      if (ref >= ip || ip - ref > maxDistance || ::read32(src + ref) != sequence) {
+        // skip ahead faster the longer no match was found
+        ip += 1 + ((ip - anchor) >> 6);
+        continue;
+      }
+
+      std::size_t matchLength = minMatch;
+      while (ip + matchLength + 8 <= length &&
+             memcmp(src + ref + matchLength, src + ip + matchLength, 8) == 0) {
+        matchLength += 8;
+      }
+      while (ip + matchLength < length && src[ref + matchLength] == src[ip + matchLength]) {
+        ++matchLength;
+      }
+      // extend the match backwards into the pending literals
+      while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+        --ip;
+        --ref;
+        ++matchLength;
+      }
+
+      out = ::writeSequence(out, src + anchor, ip - anchor, ip - ref, matchLength);
+      ip += matchLength;
+      anchor = ip;
+
+      if (ip <= limit + 2) {
+        // make the end of the match findable
+        table[::hashSequence(::read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+      }
+    }
+  }
+
+  out = ::writeSequence(out, src + anchor, length - anchor, 0, 0);
+  return static_cast<std::size_t>(out - dst);
+}
+
+void LZCodec::decompress(uint8_t const* src, std::size_t length,
+                         uint8_t* dst, std::size_t dstLength) {
+  uint8_t const* p = src;
+  uint8_t const* end = src + length;
+  uint8_t* out = dst;
+  uint8_t* const outEnd = dst + dstLength;
+
+  while (true) {
+    if (p == end) {
+      ::corrupt("compressed data ends within a sequence");
+    }
+    uint8_t const token = *p++;
+
+    std::size_t literalLength = token >> 4;
+    if (literalLength == 15) {
+      literalLength += ::readLength(p, end);
+    }
+    if (literalLength > static_cast<std::size_t>(end - p) ||
+        literalLength > static_cast<std::size_t>(outEnd - out)) {
+      ::corrupt("literals are out of bounds");
+    }
+    if (literalLength <= 16 && end - p >= 16 && outEnd - out >= 16) {
+      // short literals are copied with a fixed-size copy. the bytes
+      // written beyond the literals are overwritten afterwards
+      memcpy(out, p, 16);
+    } else {
+      memcpy(out, p, literalLength);
+    }
+    out += literalLength;
+    p += literalLength;
+
+    if (p == end) {
+      // the last sequence has no match
+      break;
+    }
+
+    if (end - p < 2) {
+      ::corrupt("compressed data ends within a match distance");
+    }
+    std::size_t const distance = p[0] | (static_cast<std::size_t>(p[1]) << 8);
+    p += 2;
+    if (distance == 0 || distance > static_cast<std::size_t>(out - dst)) {
+      ::corrupt("match distance is out of bounds");
+    }
+
+    std::size_t matchLength = (token & 0x0fU) + minMatch;
+    if ((token & 0x0fU) == 15) {
+      matchLength += ::readLength(p, end);
+    }
+    if (matchLength > static_cast<std::size_t>(outEnd - out)) {
+      ::corrupt("match length is out of bounds");
+    }
+
+    uint8_t const* ref = out - distance;
+    if (distance >= 8 && static_cast<std::size_t>(outEnd - out) >= matchLength + 8) {
+      // copy in 8 byte steps. each step only reads bytes that are already
+      // written, and the bytes written beyond the match are overwritten
+      // afterwards
+      for (std::size_t i = 0; i < matchLength; i += 8) {
+        memcpy(out + i, ref + i, 8);
+      }
+    } else if (distance >= matchLength) {
+      memcpy(out, ref, matchLength);
+    } else {
+      // the match overlaps the bytes it produces
+      for (std::size_t i = 0; i < matchLength; ++i) {
+        out[i] = ref[i];
+      }
+    }
+    out += matchLength;
+  }
+
+  if (out != outEnd) {
+    ::corrupt("decompressed length does not match");
+  }
+}
+
+CompressedWriter::CompressedWriter(Sink* sink, std::size_t blockSize)
+    : _sink(sink),
+      _blockSize(blockSize == 0 ? 1 : blockSize),
+      _pendingValues(0),
+      _offset(0),
+      _values(0),
+      _finished(false) {
+  uint8_t header[CompressedFormat::headerLength] = {0};
+  memcpy(header, ::headerMagic, 4);
+  header[4] = CompressedFormat::version;
+  write(header, sizeof(header));
+}
+
+void CompressedWriter::add(Slice value) {
+  if (_finished) {
+    throw Exception(Exception::InternalError, "CompressedWriter is already finished");
+  }
+
+  ValueLength const size = value.byteSize();
+  if (size > UINT32_MAX) {
+    throw Exception(Exception::NumberOutOfRange, "value is too large for a compressed block");
+  }
+  if (_pendingValues > 0 &&
+      (_pending.size() + size > _blockSize || _pending.size() + size > UINT32_MAX)) {
+    flush();
+  }
+
+  _pending.append(value.start(), size);
+  ++_pendingValues;
+  ++_values;
+
+  if (_pending.size() >= _blockSize) {
+    flush();
+  }
+}
+
+void CompressedWriter::flush() {
+  if (_pendingValues == 0) {
+    return;
+  }
+
+  std::size_t const length = checkOverflow(_pending.size());
+  _compressed.reset();
+  _compressed.reserve(CompressedFormat::blockHeaderLength + LZCodec::maxCompressedLength(length));
+
+  uint8_t* header = _compressed.data();
+  uint8_t* data = header + CompressedFormat::blockHeaderLength;
+  std::size_t compressedLength = LZCodec::compress(_pending.data(), length, data);
+  uint8_t method = CompressedFormat::LZ;
+  if (compressedLength >= length) {
+    // incompressible data
+    memcpy(data, _pending.data(), length);
+    compressedLength = length;
+    method = CompressedFormat::Stored;
+  }
+
+  header[0] = method;
+  ::storeUInt32(header + 1, static_cast<uint32_t>(compressedLength));
+  ::storeUInt32(header + 5, static_cast<uint32_t>(length));
+  ::storeUInt32(header + 9, _pendingValues);
+  ::storeUInt32(header + 13, ::adler32(_pending.data(), length));
+
+  _index.emplace_back(_offset, _values - _pendingValues);
+  write(header, CompressedFormat::blockHeaderLength + compressedLength);
+
+  _pending.reset();
+  _pendingValues = 0;
+}
+
+void CompressedWriter::finish() {
+  if (_finished) {
+    return;
+  }
+  flush();
+
+  uint64_t const indexOffset = _offset;
+  uint8_t entry[CompressedFormat::indexEntryLength];
+  for (auto const& it : _index) {
+    storeUInt64(entry, it.first);
+    storeUInt64(entry + 8, it.second);
+    write(entry, sizeof(entry));
+  }
+
+  uint8_t footer[CompressedFormat::footerLength];
+  storeUInt64(footer, indexOffset);
+  ::storeUInt32(footer + 8, static_cast<uint32_t>(_index.size()));
+  memcpy(footer + 12, ::footerMagic, 4);
+  write(footer, sizeof(footer));
+
+  _finished = true;
+}
+
+void CompressedWriter::write(uint8_t const* data, std::size_t length) {
+  _sink->append(reinterpret_cast<char const*>(data), length);
+  _offset += length;
+}
+
+CompressedReader::CompressedReader(uint8_t const* data, std::size_t length)
+    : validate(false), _data(data), _length(length), _values(0) {
+  if (length < CompressedFormat::headerLength + CompressedFormat::footerLength ||
+      memcmp(data, ::headerMagic, 4) != 0) {
+    ::corrupt("invalid compressed container header");
+  }
+  if (data[4] != CompressedFormat::version) {
+    ::corrupt("unsupported compressed container version");
+  }
+
+  uint8_t const* footer = data + length - CompressedFormat::footerLength;
+  if (memcmp(footer + 12, ::footerMagic, 4) != 0) {
+    ::corrupt("invalid compressed container footer");
+  }
+  uint64_t const indexOffset = readUInt64(footer);
+  uint64_t const count = ::readUInt32(footer + 8);
+  if (indexOffset < CompressedFormat::headerLength ||
+      indexOffset > length - CompressedFormat::footerLength ||
+      length - CompressedFormat::footerLength - indexOffset !=
+          count * CompressedFormat::indexEntryLength) {
+    ::corrupt("invalid compressed container index");
+  }
+
+  // the blocks must be contiguous and the value numbers must match
+  // the value counts in the block headers
+  _index.reserve(static_cast<std::size_t>(count));
+  uint8_t const* entry = data + indexOffset;
+  uint64_t expectedOffset = CompressedFormat::headerLength;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t const offset = readUInt64(entry);
+    uint64_t const firstValue = readUInt64(entry + 8);
+    if (offset != expectedOffset || firstValue != _values ||
+        indexOffset - offset < CompressedFormat::blockHeaderLength) {
+      ::corrupt("invalid compressed container index entry");
+    }
+    uint8_t const* header = data + offset;
+    uint64_t const compressedLength = ::readUInt32(header + 1);
+    if (indexOffset - offset - CompressedFormat::blockHeaderLength < compressedLength) {
+      ::corrupt("compressed block is out of bounds");
+    }
+    _index.emplace_back(offset, firstValue);
+    _values += ::readUInt32(header + 9);
+    expectedOffset = offset + CompressedFormat::blockHeaderLength + compressedLength;
+    entry += CompressedFormat::indexEntryLength;
+  }
+  if (expectedOffset != indexOffset) {
+    ::corrupt("invalid compressed container index");
+  }
+}
+
+std::size_t CompressedReader::findBlock(uint64_t value) const {
+  if (value >= _values) {
+    throw Exception(Exception::IndexOutOfBounds);
+  }
+  auto it = std::upper_bound(_index.begin(), _index.end(), value,
+                             [](uint64_t v, std::pair<uint64_t, uint64_t> const& entry) {
+                               return v < entry.second;
+                             });
+  return static_cast<std::size_t>(it - _index.begin()) - 1;
+}
+
+CompressedBlock CompressedReader::block(std::size_t index) const {
+  if (index >= _index.size()) {
+    throw Exception(Exception::IndexOutOfBounds);
+  }
+
+  uint8_t const* header = _data + _index[index].first;
+  uint8_t const method = header[0];
+  std::size_t const compressedLength = ::readUInt32(header + 1);
+  std::size_t const length = ::readUInt32(header + 5);
+  std::size_t const count = ::readUInt32(header + 9);
+  uint32_t const checksum = ::readUInt32(header + 13);
+  uint8_t const* compressed = header + CompressedFormat::blockHeaderLength;
+
+  // the lengths in the header are checked before anything is allocated
+  // for them
+  if (method == CompressedFormat::Stored) {
+    if (compressedLength != length) {
+      ::corrupt("stored block length does not match");
+    }
+  } else if (method == CompressedFormat::LZ) {
+    if (length > LZCodec::maxDecompressedLength(compressedLength)) {
+      ::corrupt("block length exceeds the maximum expansion of its compressed data");
+    }
+  } else {
+    ::corrupt("unknown block compression method");
+  }
+
+  std::shared_ptr<uint8_t> data(new uint8_t[(std::max)(length, std::size_t(1))],
+                                std::default_delete<uint8_t[]>());
+  if (method == CompressedFormat::Stored) {
+    memcpy(data.get(), compressed, length);
+  } else {
+    LZCodec::decompress(compressed, compressedLength, data.get(), length);
+  }
+
+  if (::adler32(data.get(), length) != checksum) {
+    ::corrupt("block checksum does not match");
+  }
+
+  CompressedBlock result;
+  // each value takes at least one byte
+  result._offsets.reserve((std::min)(count, length));
+  uint8_t const* p = data.get();
+  std::size_t position = 0;
+  Validator validator;
+  while (position < length) {
+    if (validate) {
+      validator.validate(p + position, length - position, true);
+    }
+    ValueLength const size = Slice(p + position).byteSize();
+    if (size == 0 || size > length - position) {
+      ::corrupt("value is out of block bounds");
+    }
+    result._offsets.push_back(position);
+    position += static_cast<std::size_t>(size);
+  }
+  if (result._offsets.size() != count) {
+    ::corrupt("number of values in block does not match");
+  }
+
+  result._data = std::move(data);
+  result._length = length;
+  result._firstValue = _index[index].second;
+  return result;
+}
+
+std::vector<CompressedBlock> CompressedReader::decompress(std::size_t numThreads) const {
+  ThreadPool pool(numThreads);
+  return decompress(pool);
+}
+
+std::vector<CompressedBlock> CompressedReader::decompress(ThreadPool& pool) const {
+  std::vector<CompressedBlock> result(_index.size());
+  std::size_t const numChunks = (std::min)(pool.size(), _index.size());
+
+  if (numChunks <= 1) {
+    for (std::size_t i = 0; i < _index.size(); ++i) {
+      result[i] = block(i);
+    }
+    return result;
+  }
+
+  // each thread decompresses a contiguous range of blocks
+  std::size_t const n = _index.size();
+  parallel::rethrowFirst(pool.run(numChunks, [&](std::size_t chunk) {
+    std::size_t const start = static_cast<std::size_t>(parallel::chunkStart(n, numChunks, chunk));
+    std::size_t const stop = static_cast<std::size_t>(parallel::chunkStart(n, numChunks, chunk + 1));
+    for (std::size_t i = start; i < stop; ++i) {
+      result[i] = block(i);
+    }
+  }));
+  return result;
+}
+
+#if __cplusplus >= 201703L
+SharedSlice CompressedReader::get(uint64_t value) const {
+  CompressedBlock b = block(findBlock(value));
+  return b.sharedAt(static_cast<std::size_t>(value - b.firstValue()));
+}
+#endif
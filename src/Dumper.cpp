@@ -22,14 +22,19 @@
 /// @author Jan Steemann
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 #include "velocypack/velocypack-common.h"
 #include "velocypack/Dumper.h"
 #include "velocypack/HexDump.h"
 #include "velocypack/Iterator.h"
+#include "velocypack/ShapeRegistry.h"
 #include "velocypack/ValueType.h"
 
+#include "parallel.h"
+
 using namespace arangodb::velocypack;
 
 // forward for fpconv function declared elsewhere
@@ -175,6 +180,148 @@ void Dumper::appendDouble(double v) {
   _sink->append(&temp[0], static_cast<ValueLength>(len));
 }
 
+void Dumper::dumpDouble(double v, Slice const* slice) {
+  if (!std::isnan(v) && !std::isinf(v)) {
+    appendDouble(v);
+    return;
+  }
+
+  if (options->unsupportedDoublesAsString) {
+    if (std::isnan(v)) {
+      _sink->append("\"NaN\"", 5);
+      return;
+    } else if (std::isinf(v)) {
+      _sink->push_back('"');
+      if (v == -INFINITY) {
+        _sink->push_back('-');
+      }
+      _sink->append("Infinity\"", 9);
+      return;
+    }
+  }
+
+  handleUnsupportedType(slice);
+}
+
+void Dumper::dumpPackedValue(int64_t v, Slice const*) { appendInt(v); }
+
+void Dumper::dumpPackedValue(double v, Slice const* slice) {
+  dumpDouble(v, slice);
+}
+
+void Dumper::dumpPackedValue(float v, Slice const* slice) {
+  dumpDouble(static_cast<double>(v), slice);
+}
+
+// packed arrays are dumped like regular arrays of numbers
+template <typename T>
+void Dumper::dumpPackedValues(Slice const* slice) {
+  PackedArrayView<T> values = slice->getPackedArray<T>(options);
+  std::size_t const n = values.size();
+
+  _sink->push_back('[');
+  if (options->prettyPrint) {
+    _sink->push_back('\n');
+    ++_indentation;
+    for (std::size_t i = 0; i < n; ++i) {
+      indent();
+      dumpPackedValue(values[i], slice);
+      if (i + 1 != n) {
+        _sink->push_back(',');
+      }
+      _sink->push_back('\n');
+    }
+    --_indentation;
+    indent();
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      if (i != 0) {
+        _sink->push_back(',');
+        if (options->singleLinePrettyPrint) {
+          _sink->push_back(' ');
+        }
+      }
+      dumpPackedValue(values[i], slice);
+    }
+  }
+  _sink->push_back(']');
+}
+
+void Dumper::dumpPackedArray(Slice const* slice) {
+  if (slice->isPackedArray<int64_t>(options)) {
+    dumpPackedValues<int64_t>(slice);
+  } else if (slice->isPackedArray<double>(options)) {
+    dumpPackedValues<double>(slice);
+  } else {
+    VELOCYPACK_ASSERT(slice->isPackedArray<float>(options));
+    dumpPackedValues<float>(slice);
+  }
+}
+
+// shaped objects are dumped like regular objects, with the attribute
+// names taken from the shape
+bool Dumper::dumpsAsPackedArray(Slice const* slice) const {
+  return slice->isPackedArray(options);
+}
+
+bool Dumper::dumpsAsShapedObject(Slice const* slice) const {
+  return slice->isShapedObject() && ShapeRegistry::resolve(options) != nullptr;
+}
+
+void Dumper::dumpShapedObject(Slice const* slice, ShapeRegistry const* registry) {
+  VELOCYPACK_ASSERT(registry != nullptr);
+
+  Slice payload = slice->value();
+  if (!payload.isArray() || payload.isEmptyArray()) {
+    throw Exception(Exception::InvalidValueType, "Expecting shaped object");
+  }
+  ArrayIterator it(payload);
+  ShapeRegistry::Shape const* shape = registry->shape((*it).getUInt());
+  if (shape == nullptr || it.size() != shape->size() + 1) {
+    throw Exception(Exception::UnknownShape);
+  }
+  it.next();
+
+  std::size_t position = 0;
+  _sink->push_back('{');
+  if (options->prettyPrint) {
+    _sink->push_back('\n');
+    ++_indentation;
+    while (it.valid()) {
+      indent();
+      dumpValue(shape->keyAt(position), slice);
+      _sink->append(" : ", 3);
+      dumpValue(*it, slice);
+      if (!it.isLast()) {
+        _sink->push_back(',');
+      }
+      _sink->push_back('\n');
+      ++position;
+      it.next();
+    }
+    --_indentation;
+    indent();
+  } else {
+    while (it.valid()) {
+      if (position != 0) {
+        _sink->push_back(',');
+        if (options->singleLinePrettyPrint) {
+          _sink->push_back(' ');
+        }
+      }
+      dumpValue(shape->keyAt(position), slice);
+      _sink->push_back(':');
+      if (options->singleLinePrettyPrint) {
+        _sink->push_back(' ');
+      }
+      dumpValue(*it, slice);
+      ++position;
+      it.next();
+    }
+  }
+  _sink->push_back('}');
+}
+
 void Dumper::dumpUnicodeCharacter(uint16_t value) {
   _sink->append("\\u", 2);
   
@@ -213,40 +360,45 @@ void Dumper::dumpInteger(Slice const* slice) {
   }
 }
 
-void Dumper::dumpString(char const* src, ValueLength len) {
-  static char const EscapeTable[256] = {
-      // 0    1    2    3    4    5    6    7    8    9    A    B    C    D    E
-      // F
-      'u',  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r',
-      'u',
-      'u',  // 00
-      'u',  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
-      'u',
-      'u',  // 10
-      0,    0,   '"', 0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,
-      '/',  // 20
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,
-      0,  // 30~4F
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      '\\', 0,   0,   0,  // 50
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,
-      0,  // 60~FF
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-      0,    0,   0,   0};
+namespace {
 
+// the escape character for each byte, or 0 if the byte is not escaped
+char const EscapeTable[256] = {
+    // 0    1    2    3    4    5    6    7    8    9    A    B    C    D    E
+    // F
+    'u',  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r',
+    'u',
+    'u',  // 00
+    'u',  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    'u',
+    'u',  // 10
+    0,    0,   '"', 0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,
+    '/',  // 20
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,
+    0,  // 30~4F
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    '\\', 0,   0,   0,  // 50
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,
+    0,  // 60~FF
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,    0,   0,   0};
+
+}  // namespace
+
+void Dumper::dumpString(char const* src, ValueLength len) {
   _sink->reserve(len);
 
   uint8_t const* p = reinterpret_cast<uint8_t const*>(src);
@@ -328,6 +480,125 @@ void Dumper::dumpString(char const* src, ValueLength len) {
   }
 }
 
+void Dumper::dumpParallel(Slice const& slice, std::size_t numThreads) {
+  ThreadPool pool(numThreads);
+  dumpParallel(slice, pool);
+}
+
+void Dumper::dumpParallel(Slice const& slice, ThreadPool& pool) {
+  _indentation = 0;
+
+  std::size_t numChunks = 1;
+  if (pool.size() > 1 && (slice.isArray() || slice.isObject())) {
+    numChunks = parallel::numberOfChunks(slice.length(), pool.size(), minMembersPerThread);
+  }
+  if (numChunks <= 1) {
+    dump(slice);
+    return;
+  }
+
+  _sink->reserve(slice.byteSize());
+  if (slice.isArray()) {
+    _sink->push_back('[');
+    dumpMembersParallel(slice, ArrayIterator(slice), pool, numChunks);
+    _sink->push_back(']');
+  } else {
+    _sink->push_back('{');
+    dumpMembersParallel(slice, ObjectIterator(slice, !options->dumpAttributesInIndexOrder), pool, numChunks);
+    _sink->push_back('}');
+  }
+}
+
+template <typename T>
+void Dumper::dumpMembersParallel(Slice const& slice, T it, ThreadPool& pool,
+                                 std::size_t numChunks) {
+  ValueLength const n = it.size();
+
+  // the iterators pointing to the first member of each range. positioning
+  // them is cheap compared to dumping the members
+  std::vector<T> starts;
+  starts.reserve(numChunks);
+  ValueLength position = 0;
+  for (std::size_t chunk = 0; chunk < numChunks; ++chunk) {
+    ValueLength const start = parallel::chunkStart(n, numChunks, chunk);
+    it.forward(start - position);
+    position = start;
+    starts.push_back(it);
+  }
+
+  if (options->prettyPrint) {
+    _sink->push_back('\n');
+  }
+
+  // the first range is dumped directly into the Sink, all others into
+  // buffers
+  std::vector<std::string> buffers(numChunks);
+  std::vector<std::exception_ptr> errors = pool.run(numChunks, [&](std::size_t chunk) {
+    StringSink sink(&buffers[chunk]);
+    Dumper dumper(chunk == 0 ? _sink : &sink, options);
+    dumper._indentation = _indentation + 1;
+
+    ValueLength const start = parallel::chunkStart(n, numChunks, chunk);
+    ValueLength const stop = parallel::chunkStart(n, numChunks, chunk + 1);
+    if (chunk != 0) {
+      sink.reserve(slice.byteSize() / numChunks);
+    }
+    T current = starts[chunk];
+    for (ValueLength i = start; i < stop; ++i) {
+      dumper.dumpMember(i == 0, current, slice);
+      current.next();
+    }
+  });
+  parallel::rethrowFirst(errors);
+
+  for (std::size_t chunk = 1; chunk < numChunks; ++chunk) {
+    _sink->append(buffers[chunk]);
+    std::string().swap(buffers[chunk]);
+  }
+
+  if (options->prettyPrint) {
+    _sink->push_back('\n');
+    indent();
+  }
+}
+
+void Dumper::dumpMember(bool first, ArrayIterator const& it, Slice const& base) {
+  dumpMember(first, nullptr, it.value(), &base);
+}
+
+void Dumper::dumpMember(bool first, ObjectIterator const& it, Slice const& base) {
+  auto current = (*it);
+  dumpMember(first, &current.key, current.value, &base);
+}
+
+void Dumper::dumpMember(bool first, Slice const* key, Slice const& value, Slice const* base) {
+  if (options->prettyPrint) {
+    if (!first) {
+      _sink->append(",\n", 2);
+    }
+    indent();
+    if (key != nullptr) {
+      dumpValue(key, base);
+      _sink->append(" : ", 3);
+    }
+  } else {
+    if (!first) {
+      _sink->push_back(',');
+      if (options->singleLinePrettyPrint) {
+        _sink->push_back(' ');
+      }
+    }
+    if (key != nullptr) {
+      dumpValue(key, base);
+      _sink->push_back(':');
+      if (options->singleLinePrettyPrint) {
+        _sink->push_back(' ');
+      }
+    }
+  }
+  dumpValue(&value, base);
+}
+
 void Dumper::dumpValue(Slice const* slice, Slice const* base) {
   if (base == nullptr) {
     base = slice;
@@ -443,28 +714,7 @@ void Dumper::dumpValue(Slice const* slice, Slice const* base) {
     }
 
     case ValueType::Double: {
-      double const v = slice->getDouble();
-
-      if (!std::isnan(v) && !std::isinf(v)) {
-         appendDouble(v);
-         break;
-      }
-
-      if (options->unsupportedDoublesAsString) {
-        if (std::isnan(v)) {
-          _sink->append("\"NaN\"", 5);
-          break;
-        } else if (std::isinf(v)) {
-          _sink->push_back('"');
-          if (v == -INFINITY) {
-            _sink->push_back('-');
-          }
-          _sink->append("Infinity\"", 9);
-          break;
-        }
-      }
-
-      handleUnsupportedType(slice);
+      dumpDouble(slice->getDouble(), slice);
       break;
     }
 
@@ -492,7 +742,18 @@ void Dumper::dumpValue(Slice const* slice, Slice const* base) {
     }
 
     case ValueType::Tagged: {
-      dump(slice->value());
+      if (dumpsAsPackedArray(slice)) {
+        dumpPackedArray(slice);
+        break;
+      }
+      if (slice->isShapedObject()) {
+        ShapeRegistry const* registry = ShapeRegistry::resolve(options);
+        if (registry != nullptr) {
+          dumpShapedObject(slice, registry);
+          break;
+        }
+      }
+      dumpValue(slice->value(), base);
       break;
     }
 
@@ -501,7 +762,7 @@ void Dumper::dumpValue(Slice const* slice, Slice const* base) {
         _sink->push_back('"');
         ValueLength len;
         uint8_t const *bin = slice->getBinary(len);
-        for (uint8_t i = 0; i < len; i++) {
+        for (ValueLength i = 0; i < len; i++) {
           uint8_t value = *(bin+i);
           uint8_t x = value / 16;
           _sink->push_back((x < 10 ? ('0' + x) : ('a' + x - 10)));
@@ -547,3 +808,457 @@ void Dumper::dumpValue(Slice const* slice, Slice const* base) {
     }
   }
 }
+
+namespace {
+
+// a Sink that only counts the bytes appended to it
+struct CountingSink final : public Sink {
+  CountingSink() : count(0) {}
+
+  void push_back(char) override final { ++count; }
+  void append(std::string const& p) override final { count += p.size(); }
+  void append(char const* p) override final { count += strlen(p); }
+  void append(char const*, ValueLength len) override final { count += len; }
+  void reserve(ValueLength) override final {}
+
+  ValueLength count;
+};
+
+// number of decimal digits of v
+ValueLength uintLength(uint64_t v) {
+  ValueLength length = 1;
+  while (v >= 10) {
+    v /= 10;
+    ++length;
+  }
+  return length;
+}
+
+ValueLength intLength(int64_t v) {
+  if (v == INT64_MIN) {
+    return 20;
+  }
+  if (v < 0) {
+    return 1 + uintLength(static_cast<uint64_t>(-v));
+  }
+  return uintLength(static_cast<uint64_t>(v));
+}
+
+// maximum length of a Double as produced by fpconv_dtoa
+constexpr ValueLength maxDoubleLength = 24;
+
+}  // namespace
+
+ValueLength Dumper::maxOutputSize(Slice const& slice, Options const* options) {
+  CountingSink sink;
+  Dumper dumper(&sink, options);
+  return dumper.sizeOfValue(&slice, nullptr);
+}
+
+ValueLength Dumper::sizeOfUnsupportedType(Slice const* slice) const {
+  if (options->unsupportedTypeBehavior == Options::NullifyUnsupportedType) {
+    return 4;
+  } else if (options->unsupportedTypeBehavior == Options::ConvertUnsupportedType) {
+    return strlen("\"(non-representable type ") + strlen(slice->typeName()) + 2;
+  }
+
+  throw Exception(Exception::NoJsonEquivalent);
+}
+
+ValueLength Dumper::sizeOfString(char const* src, ValueLength len) const {
+  // every byte is copied at least once. only escaped characters add to that
+  ValueLength size = 2 + len;
+
+  uint8_t const* p = reinterpret_cast<uint8_t const*>(src);
+  uint8_t const* e = p + len;
+  while (p < e) {
+    uint8_t c = *p;
+
+    if ((c & 0x80U) == 0) {
+      char esc = EscapeTable[c];
+      if (esc == 'u') {
+        size += 5;
+      } else if (esc != 0 && (c != '/' || options->escapeForwardSlashes)) {
+        size += 1;
+      }
+    } else if ((c & 0xe0U) == 0xc0U) {
+      if (p + 1 >= e) {
+        throw Exception(Exception::InvalidUtf8Sequence);
+      }
+      if (options->escapeUnicode) {
+        size += 4;
+      }
+      ++p;
+    } else if ((c & 0xf0U) == 0xe0U) {
+      if (p + 2 >= e) {
+        throw Exception(Exception::InvalidUtf8Sequence);
+      }
+      if (options->escapeUnicode) {
+        size += 3;
+      }
+      p += 2;
+    } else if ((c & 0xf8U) == 0xf0U) {
+      if (p + 3 >= e) {
+        throw Exception(Exception::InvalidUtf8Sequence);
+      }
+      if (options->escapeUnicode) {
+        size += 8;
+      }
+      p += 3;
+    } else {
+      // stray continuation bytes are not dumped
+      --size;
+    }
+
+    ++p;
+  }
+  return size;
+}
+
+// mirrors dumpValue(), but only computes the length of the output
+ValueLength Dumper::sizeOfValue(Slice const* slice, Slice const* base) {
+  if (base == nullptr) {
+    base = slice;
+  }
+
+  ValueLength size = 0;
+  if (options->debugTags && slice->isTagged()) {
+    size += uintLength(slice->getFirstTag()) + 1;
+  }
+
+  switch (slice->type()) {
+    case ValueType::Null: {
+      return size + 4;
+    }
+
+    case ValueType::Bool: {
+      return size + (slice->getBool() ? 4 : 5);
+    }
+
+    case ValueType::Array:
+    case ValueType::Object: {
+      bool const isObject = slice->isObject();
+      ValueLength n = 0;
+      ++_indentation;
+      if (isObject) {
+        ObjectIterator it(*slice, true);
+        while (it.valid()) {
+          auto current = (*it);
+          size += sizeOfValue(&current.key, slice) + sizeOfValue(&current.value, slice);
+          ++n;
+          it.next();
+        }
+      } else {
+        ArrayIterator it(*slice);
+        while (it.valid()) {
+          Slice const value = it.value();
+          size += sizeOfValue(&value, slice);
+          ++n;
+          it.next();
+        }
+      }
+      --_indentation;
+
+      // brackets, separators and key/value delimiters
+      size += 2;
+      if (options->prettyPrint) {
+        // newline after the opening bracket, indentation of the closing
+        // one, and per member its indentation, a comma and a newline
+        size += 1 + 2 * static_cast<ValueLength>(_indentation);
+        size += n * (2 * static_cast<ValueLength>(_indentation + 1) + 1);
+        if (n > 0) {
+          size += n - 1;
+        }
+        if (isObject) {
+          size += 3 * n;
+        }
+      } else {
+        ValueLength const separator = options->singleLinePrettyPrint ? 2 : 1;
+        if (n > 0) {
+          size += (n - 1) * separator;
+        }
+        if (isObject) {
+          size += n * separator;
+        }
+      }
+      return size;
+    }
+
+    case ValueType::Double: {
+      double v = slice->getDouble();
+      if (!std::isnan(v) && !std::isinf(v)) {
+        return size + maxDoubleLength;
+      }
+      if (options->unsupportedDoublesAsString) {
+        if (std::isnan(v)) {
+          return size + 5;
+        }
+        return size + (v == -INFINITY ? 11 : 10);
+      }
+      return size + sizeOfUnsupportedType(slice);
+    }
+
+    case ValueType::Int: {
+      return size + intLength(slice->getIntUnchecked());
+    }
+
+    case ValueType::UInt: {
+      return size + uintLength(slice->getUIntUnchecked());
+    }
+
+    case ValueType::SmallInt: {
+      return size + (slice->getSmallIntUnchecked() < 0 ? 2 : 1);
+    }
+
+    case ValueType::String: {
+      ValueLength len;
+      char const* p = slice->getString(len);
+      return size + sizeOfString(p, len);
+    }
+
+    case ValueType::External: {
+      Slice const external(reinterpret_cast<uint8_t const*>(slice->getExternal()));
+      return size + sizeOfValue(&external, base);
+    }
+
+    case ValueType::Tagged: {
+      if (!dumpsAsPackedArray(slice) && !dumpsAsShapedObject(slice)) {
+        Slice const value = slice->value();
+        return size + sizeOfValue(&value, base);
+      }
+      break;
+    }
+
+    case ValueType::Binary: {
+      if (options->binaryAsHex) {
+        return size + 2 + 2 * slice->getBinaryLength();
+      }
+      return size + sizeOfUnsupportedType(slice);
+    }
+
+    case ValueType::UTCDate: {
+      if (options->datesAsIntegers) {
+        return size + intLength(slice->getUTCDate());
+      }
+      return size + sizeOfUnsupportedType(slice);
+    }
+
+    case ValueType::None:
+    case ValueType::Illegal:
+    case ValueType::MinKey:
+    case ValueType::MaxKey: {
+      return size + sizeOfUnsupportedType(slice);
+    }
+
+    case ValueType::BCD: {
+      throw Exception(Exception::NotImplemented);
+    }
+
+    case ValueType::Custom: {
+      break;
+    }
+  }
+
+  // packed Arrays, shaped Objects and Custom values are rare enough to
+  // simply be dumped into a Sink that counts the bytes
+  CountingSink sink;
+  Dumper dumper(&sink, options);
+  dumper._indentation = _indentation;
+  dumper.dumpValue(slice, base);
+  return sink.count;
+}
+
+constexpr ValueLength StreamingDumper::stringPieceLength;
+
+StreamingDumper::StreamingDumper(Slice slice, Options const* options)
+    : _pendingOffset(0),
+      _sink(&_pending),
+      _dumper(&_sink, options),
+      _next(slice),
+      _haveNext(true),
+      _stringOffset(0),
+      _inString(false) {}
+
+std::size_t StreamingDumper::produce(char* buffer, std::size_t maxBytes) {
+  std::size_t written = 0;
+  while (written < maxBytes) {
+    std::size_t const available = static_cast<std::size_t>(_pending.size()) - _pendingOffset;
+    if (available > 0) {
+      std::size_t const n = (std::min)(available, maxBytes - written);
+      memcpy(buffer + written, _pending.data() + _pendingOffset, n);
+      _pendingOffset += n;
+      written += n;
+      continue;
+    }
+
+    // all pending output was handed out. produce more
+    _pending.reset();
+    _pendingOffset = 0;
+    if (!step()) {
+      break;
+    }
+  }
+  return written;
+}
+
+void StreamingDumper::reset(Slice slice) {
+  _pending.reset();
+  _pendingOffset = 0;
+  _dumper._indentation = 0;
+  _stack.clear();
+  _arrays.clear();
+  _objects.clear();
+  _next = slice;
+  _haveNext = true;
+  _inString = false;
+}
+
+// produces the next piece of output. returns false if there is none left
+bool StreamingDumper::step() {
+  if (_inString) {
+    continueString();
+    return true;
+  }
+  if (_haveNext) {
+    // the top-level value
+    _haveNext = false;
+    beginValue(_next, _next);
+    return true;
+  }
+  if (_stack.empty()) {
+    return false;
+  }
+
+  Options const* options = _dumper.options;
+  Frame& frame = _stack.back();
+  bool const valid = frame.isObject ? _objects.back().valid() : _arrays.back().valid();
+
+  if (!valid) {
+    // close the Array or Object
+    if (options->prettyPrint) {
+      if (!frame.first) {
+        _sink.push_back('\n');
+      }
+      --_dumper._indentation;
+      _dumper.indent();
+    }
+    if (frame.isObject) {
+      _sink.push_back('}');
+      _objects.pop_back();
+    } else {
+      _sink.push_back(']');
+      _arrays.pop_back();
+    }
+    _stack.pop_back();
+    return true;
+  }
+
+  if (!frame.first) {
+    _sink.push_back(',');
+    if (options->prettyPrint) {
+      _sink.push_back('\n');
+    } else if (options->singleLinePrettyPrint) {
+      _sink.push_back(' ');
+    }
+  }
+  frame.first = false;
+  if (options->prettyPrint) {
+    _dumper.indent();
+  }
+
+  Slice const base = frame.value;
+  Slice value;
+  if (frame.isObject) {
+    ObjectIterator& it = _objects.back();
+    auto current = (*it);
+    _dumper.dumpValue(current.key, &base);
+    if (options->prettyPrint) {
+      _sink.append(" : ", 3);
+    } else {
+      _sink.push_back(':');
+      if (options->singleLinePrettyPrint) {
+        _sink.push_back(' ');
+      }
+    }
+    value = current.value;
+    it.next();
+  } else {
+    ArrayIterator& it = _arrays.back();
+    value = it.value();
+    it.next();
+  }
+  // may push another frame, so frame must not be used afterwards
+  beginValue(value, base);
+  return true;
+}
+
+void StreamingDumper::beginValue(Slice slice, Slice base) {
+  Options const* options = _dumper.options;
+
+  // resolve Externals and tags, as Dumper::dumpValue() does
+  while (true) {
+    if (slice.isExternal()) {
+      slice = Slice(reinterpret_cast<uint8_t const*>(slice.getExternal()));
+    } else if (slice.isTagged() && !_dumper.dumpsAsPackedArray(&slice) &&
+               !_dumper.dumpsAsShapedObject(&slice)) {
+      if (options->debugTags) {
+        _sink.append(std::to_string(slice.getFirstTag()));
+        _sink.push_back(':');
+      }
+      slice = slice.value();
+    } else {
+      break;
+    }
+  }
+
+  if (slice.isArray()) {
+    _sink.push_back('[');
+    if (options->prettyPrint) {
+      _sink.push_back('\n');
+      ++_dumper._indentation;
+    }
+    _arrays.emplace_back(slice);
+    _stack.push_back(Frame{slice, false, true});
+  } else if (slice.isObject()) {
+    _sink.push_back('{');
+    if (options->prettyPrint) {
+      _sink.push_back('\n');
+      ++_dumper._indentation;
+    }
+    _objects.emplace_back(slice, !options->dumpAttributesInIndexOrder);
+    _stack.push_back(Frame{slice, true, true});
+  } else if (slice.isString() && slice.getStringLength() > stringPieceLength) {
+    _sink.push_back('"');
+    _string = slice;
+    _stringOffset = 0;
+    _inString = true;
+  } else {
+    // scalars, packed arrays and shaped objects are dumped in one go
+    _dumper.dumpValue(&slice, &base);
+  }
+}
+
+void StreamingDumper::continueString() {
+  ValueLength length;
+  char const* p = _string.getString(length);
+
+  ValueLength end = _stringOffset + stringPieceLength;
+  if (end >= length) {
+    end = length;
+  } else {
+    // do not split multi-byte UTF-8 sequences
+    while (end > _stringOffset && (static_cast<uint8_t>(p[end]) & 0xc0U) == 0x80U) {
+      --end;
+    }
+    if (end == _stringOffset) {
+      end = _stringOffset + stringPieceLength;
+    }
+  }
+
+  _dumper.dumpString(p + _stringOffset, end - _stringOffset);
+  _stringOffset = end;
+  if (end == length) {
+    _sink.push_back('"');
+    _inString = false;
+  }
+}
@@ -0,0 +1,551 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <string>
+
+#include "velocypack/velocypack-common.h"
+#include "velocypack/MessagePack.h"
+#include "velocypack/Iterator.h"
+#include "velocypack/ShapeRegistry.h"
+#include "velocypack/StringRef.h"
+#include "velocypack/Utf8Helper.h"
+#include "velocypack/Value.h"
+#include "velocypack/ValueType.h"
+
+using namespace arangodb::velocypack;
+
+namespace {
+
+// the extension type of timestamps
+constexpr uint8_t timestampType = 0xff;
+
+uint64_t doubleBits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double doubleFromBits(uint64_t bits) {
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+float floatFromBits(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+void MessagePackDumper::dumpBigEndian(uint64_t value, int bytes) {
+  char buffer[8];
+  for (int i = bytes - 1; i >= 0; --i) {
+    buffer[i] = static_cast<char>(value & 0xffU);
+    value >>= 8;
+  }
+  _sink->append(&buffer[0], static_cast<ValueLength>(bytes));
+}
+
+void MessagePackDumper::dumpHeader(uint8_t type, uint64_t value, int bytes) {
+  char buffer[9];
+  buffer[0] = static_cast<char>(type);
+  for (int i = bytes; i > 0; --i) {
+    buffer[i] = static_cast<char>(value & 0xffU);
+    value >>= 8;
+  }
+  _sink->append(&buffer[0], static_cast<ValueLength>(1 + bytes));
+}
+
+void MessagePackDumper::dumpLength(ValueLength length, uint8_t fixType, ValueLength fixLimit,
+                                   uint8_t type8, uint8_t type16, uint8_t type32) {
+  if (length < fixLimit) {
+    _sink->push_back(static_cast<char>(fixType | length));
+  } else if (type8 != 0 && length <= 0xffU) {
+    dumpHeader(type8, length, 1);
+  } else if (length <= 0xffffU) {
+    dumpHeader(type16, length, 2);
+  } else if (length <= 0xffffffffU) {
+    dumpHeader(type32, length, 4);
+  } else {
+    throw Exception(Exception::NumberOutOfRange, "Value is too long for MessagePack");
+  }
+}
+
+void MessagePackDumper::dumpUInt(uint64_t value) {
+  if (value <= 0x7fU) {
+    _sink->push_back(static_cast<char>(value));
+  } else if (value <= 0xffU) {
+    dumpHeader(0xcc, value, 1);
+  } else if (value <= 0xffffU) {
+    dumpHeader(0xcd, value, 2);
+  } else if (value <= 0xffffffffU) {
+    dumpHeader(0xce, value, 4);
+  } else {
+    dumpHeader(0xcf, value, 8);
+  }
+}
+
+void MessagePackDumper::dumpInt(int64_t value) {
+  if (value >= 0) {
+    dumpUInt(static_cast<uint64_t>(value));
+  } else if (value >= -32) {
+    // negative fixint
+    _sink->push_back(static_cast<char>(value));
+  } else if (value >= INT8_MIN) {
+    dumpHeader(0xd0, static_cast<uint64_t>(value), 1);
+  } else if (value >= INT16_MIN) {
+    dumpHeader(0xd1, static_cast<uint64_t>(value), 2);
+  } else if (value >= INT32_MIN) {
+    dumpHeader(0xd2, static_cast<uint64_t>(value), 4);
+  } else {
+    dumpHeader(0xd3, static_cast<uint64_t>(value), 8);
+  }
+}
+
+void MessagePackDumper::dumpDouble(double value) {
+  dumpHeader(0xcb, ::doubleBits(value), 8);
+}
+
+void MessagePackDumper::dumpString(char const* p, ValueLength length) {
+  dumpLength(length, 0xa0, 32, 0xd9, 0xda, 0xdb);
+  _sink->append(p, length);
+}
+
+// UTCDates are written with the smallest of the three timestamp formats
+// that can hold them
+void MessagePackDumper::dumpUTCDate(int64_t value) {
+  int64_t seconds = value / 1000;
+  int64_t milliseconds = value % 1000;
+  if (milliseconds < 0) {
+    --seconds;
+    milliseconds += 1000;
+  }
+  uint64_t const nanoseconds = static_cast<uint64_t>(milliseconds) * 1000000U;
+
+  if (seconds >= 0 && (static_cast<uint64_t>(seconds) >> 34) == 0) {
+    if (nanoseconds == 0 && (static_cast<uint64_t>(seconds) >> 32) == 0) {
+      dumpHeader(0xd6, timestampType, 1);
+      dumpBigEndian(static_cast<uint64_t>(seconds), 4);
+    } else {
+      dumpHeader(0xd7, timestampType, 1);
+      dumpBigEndian((nanoseconds << 34) | static_cast<uint64_t>(seconds), 8);
+    }
+  } else {
+    dumpHeader(0xc7, 12, 1);
+    _sink->push_back(static_cast<char>(timestampType));
+    dumpBigEndian(nanoseconds, 4);
+    dumpBigEndian(static_cast<uint64_t>(seconds), 8);
+  }
+}
+
+void MessagePackDumper::dumpPackedArray(Slice const& slice) {
+  if (slice.isPackedArray<int64_t>(options)) {
+    PackedArrayView<int64_t> values = slice.getPackedArray<int64_t>(options);
+    dumpLength(values.size(), 0x90, 16, 0, 0xdc, 0xdd);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      dumpInt(values[i]);
+    }
+  } else if (slice.isPackedArray<double>(options)) {
+    PackedArrayView<double> values = slice.getPackedArray<double>(options);
+    dumpLength(values.size(), 0x90, 16, 0, 0xdc, 0xdd);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      dumpDouble(values[i]);
+    }
+  } else {
+    VELOCYPACK_ASSERT(slice.isPackedArray<float>(options));
+    PackedArrayView<float> values = slice.getPackedArray<float>(options);
+    dumpLength(values.size(), 0x90, 16, 0, 0xdc, 0xdd);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      dumpDouble(static_cast<double>(values[i]));
+    }
+  }
+}
+
+void MessagePackDumper::dumpShapedObject(Slice const& slice, ShapeRegistry const* registry) {
+  VELOCYPACK_ASSERT(registry != nullptr);
+
+  Slice payload = slice.value();
+  if (!payload.isArray() || payload.isEmptyArray()) {
+    throw Exception(Exception::InvalidValueType, "Expecting shaped object");
+  }
+  ArrayIterator it(payload);
+  ShapeRegistry::Shape const* shape = registry->shape((*it).getUInt());
+  if (shape == nullptr || it.size() != shape->size() + 1) {
+    throw Exception(Exception::UnknownShape);
+  }
+  it.next();
+
+  dumpLength(shape->size(), 0x80, 16, 0, 0xde, 0xdf);
+  std::size_t position = 0;
+  while (it.valid()) {
+    dumpValue(shape->keyAt(position));
+    dumpValue(*it);
+    ++position;
+    it.next();
+  }
+}
+
+void MessagePackDumper::handleUnsupportedType(Slice const& slice) {
+  if (options->unsupportedTypeBehavior == Options::NullifyUnsupportedType) {
+    _sink->push_back(static_cast<char>(0xc0));
+    return;
+  } else if (options->unsupportedTypeBehavior == Options::ConvertUnsupportedType) {
+    std::string const value = std::string("(non-representable type ") + slice.typeName() + ")";
+    dumpString(value.data(), value.size());
+    return;
+  }
+
+  throw Exception(Exception::NoJsonEquivalent, "Type has no equivalent in MessagePack");
+}
+
+void MessagePackDumper::dumpValue(Slice const& slice) {
+  switch (slice.type()) {
+    case ValueType::Null: {
+      _sink->push_back(static_cast<char>(0xc0));
+      break;
+    }
+
+    case ValueType::Bool: {
+      _sink->push_back(static_cast<char>(slice.getBool() ? 0xc3 : 0xc2));
+      break;
+    }
+
+    case ValueType::Array: {
+      ArrayIterator it(slice);
+      dumpLength(it.size(), 0x90, 16, 0, 0xdc, 0xdd);
+      while (it.valid()) {
+        dumpValue(it.value());
+        it.next();
+      }
+      break;
+    }
+
+    case ValueType::Object: {
+      ObjectIterator it(slice, !options->dumpAttributesInIndexOrder);
+      dumpLength(it.size(), 0x80, 16, 0, 0xde, 0xdf);
+      while (it.valid()) {
+        auto current = (*it);
+        dumpValue(current.key);
+        dumpValue(current.value);
+        it.next();
+      }
+      break;
+    }
+
+    case ValueType::Double: {
+      dumpDouble(slice.getDouble());
+      break;
+    }
+
+    case ValueType::UInt: {
+      dumpUInt(slice.getUIntUnchecked());
+      break;
+    }
+
+    case ValueType::Int: {
+      dumpInt(slice.getIntUnchecked());
+      break;
+    }
+
+    case ValueType::SmallInt: {
+      dumpInt(slice.getSmallIntUnchecked());
+      break;
+    }
+
+    case ValueType::String: {
+      ValueLength length;
+      char const* p = slice.getString(length);
+      dumpString(p, length);
+      break;
+    }
+
+    case ValueType::Binary: {
+      ValueLength length;
+      uint8_t const* p = slice.getBinary(length);
+      dumpLength(length, 0, 0, 0xc4, 0xc5, 0xc6);
+      _sink->append(reinterpret_cast<char const*>(p), length);
+      break;
+    }
+
+    case ValueType::UTCDate: {
+      dumpUTCDate(slice.getUTCDate());
+      break;
+    }
+
+    case ValueType::External: {
+      dumpValue(Slice(reinterpret_cast<uint8_t const*>(slice.getExternal())));
+      break;
+    }
+
+    case ValueType::Tagged: {
+      // without a shape registry, shaped objects are dumped like other
+      // tagged values
+      ShapeRegistry const* registry =
+          slice.isShapedObject() ? ShapeRegistry::resolve(options) : nullptr;
+      if (slice.isPackedArray(options)) {
+        dumpPackedArray(slice);
+      } else if (registry != nullptr) {
+        dumpShapedObject(slice, registry);
+      } else {
+        dumpValue(slice.value());
+      }
+      break;
+    }
+
+    case ValueType::None:
+    case ValueType::Illegal:
+    case ValueType::MinKey:
+    case ValueType::MaxKey:
+    case ValueType::BCD:
+    case ValueType::Custom: {
+      handleUnsupportedType(slice);
+      break;
+    }
+  }
+}
+
+ValueLength MessagePackParser::parse(uint8_t const* start, std::size_t size) {
+  _start = start;
+  _size = size;
+  _pos = 0;
+  _key = nullptr;
+  if (options->clearBuilderBeforeParse) {
+    _builder->clear();
+  }
+  parseValue();
+  return _pos;
+}
+
+uint8_t const* MessagePackParser::consume(ValueLength length) {
+  if (VELOCYPACK_UNLIKELY(length > _size - _pos)) {
+    throw Exception(Exception::ParseError, "Unexpected end of MessagePack data");
+  }
+  uint8_t const* p = _start + _pos;
+  _pos += static_cast<std::size_t>(length);
+  return p;
+}
+
+uint64_t MessagePackParser::readUInt(int bytes) {
+  uint8_t const* p = consume(static_cast<ValueLength>(bytes));
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; ++i) {
+    value = (value << 8) | p[i];
+  }
+  return value;
+}
+
+template <typename T>
+void MessagePackParser::add(T const& value) {
+  if (_key != nullptr) {
+    char const* key = _key;
+    _key = nullptr;
+    _builder->add(StringRef(key, static_cast<std::size_t>(_keyLength)), value);
+  } else {
+    _builder->add(value);
+  }
+}
+
+// non-negative integers become UInts, like in the JSON Parser
+void MessagePackParser::addInt(int64_t value) {
+  if (value >= 0) {
+    add(Value(static_cast<uint64_t>(value)));
+  } else {
+    add(Value(value));
+  }
+}
+
+void MessagePackParser::parseArray(ValueLength length) {
+  add(Value(ValueType::Array));
+  // every member takes at least one byte, so corrupt lengths cannot make
+  // the reservation arbitrarily large
+  _builder->reserveMembers((std::min)(length, static_cast<ValueLength>(_size - _pos)));
+  for (ValueLength i = 0; i < length; ++i) {
+    parseValue();
+  }
+  _builder->close();
+}
+
+void MessagePackParser::parseMap(ValueLength length) {
+  add(Value(ValueType::Object));
+  _builder->reserveMembers((std::min)(length, static_cast<ValueLength>(_size - _pos) / 2));
+  for (ValueLength i = 0; i < length; ++i) {
+    uint8_t const head = *consume(1);
+    ValueLength keyLength;
+    if ((head & 0xe0U) == 0xa0U) {
+      keyLength = head & 0x1fU;
+    } else if (head >= 0xd9 && head <= 0xdb) {
+      keyLength = readUInt(1 << (head - 0xd9));
+    } else {
+      throw Exception(Exception::ParseError, "MessagePack map keys must be strings");
+    }
+    char const* key = reinterpret_cast<char const*>(consume(keyLength));
+    if (options->validateUtf8Strings &&
+        !Utf8Helper::isValidUtf8(reinterpret_cast<uint8_t const*>(key), keyLength)) {
+      throw Exception(Exception::InvalidUtf8Sequence);
+    }
+    _key = key;
+    _keyLength = keyLength;
+    parseValue();
+  }
+  _builder->close();
+}
+
+void MessagePackParser::parseString(ValueLength length) {
+  uint8_t const* p = consume(length);
+  if (options->validateUtf8Strings && !Utf8Helper::isValidUtf8(p, length)) {
+    throw Exception(Exception::InvalidUtf8Sequence);
+  }
+  add(ValuePair(p, length, ValueType::String));
+}
+
+void MessagePackParser::parseBinary(ValueLength length) {
+  add(ValuePair(consume(length), length, ValueType::Binary));
+}
+
+void MessagePackParser::parseExtension(ValueLength length) {
+  uint8_t const type = *consume(1);
+  if (type != timestampType) {
+    throw Exception(Exception::ParseError, "Unsupported MessagePack extension type");
+  }
+
+  int64_t seconds;
+  uint64_t nanoseconds;
+  if (length == 4) {
+    seconds = static_cast<int64_t>(readUInt(4));
+    nanoseconds = 0;
+  } else if (length == 8) {
+    uint64_t const data = readUInt(8);
+    seconds = static_cast<int64_t>(data & 0x3ffffffffULL);
+    nanoseconds = data >> 34;
+  } else if (length == 12) {
+    nanoseconds = readUInt(4);
+    seconds = static_cast<int64_t>(readUInt(8));
+  } else {
+    throw Exception(Exception::ParseError, "Invalid MessagePack timestamp");
+  }
+  if (nanoseconds >= 1000000000U) {
+    throw Exception(Exception::ParseError, "Invalid MessagePack timestamp");
+  }
+  if (seconds > INT64_MAX / 1000 || seconds < INT64_MIN / 1000) {
+    throw Exception(Exception::NumberOutOfRange, "MessagePack timestamp out of range");
+  }
+  add(Value(seconds * 1000 + static_cast<int64_t>(nanoseconds / 1000000U),
+            ValueType::UTCDate));
+}
+
+void MessagePackParser::parseValue() {
+  uint8_t const head = *consume(1);
+
+  if (head <= 0x7f) {
+    add(Value(static_cast<uint64_t>(head)));
+    return;
+  }
+  if (head >= 0xe0) {
+    add(Value(static_cast<int64_t>(static_cast<int8_t>(head))));
+    return;
+  }
+  if (head <= 0x8f) {
+    parseMap(head & 0x0fU);
+    return;
+  }
+  if (head <= 0x9f) {
+    parseArray(head & 0x0fU);
+    return;
+  }
+  if (head <= 0xbf) {
+    parseString(head & 0x1fU);
+    return;
+  }
+
+  switch (head) {
+    case 0xc0:
+      add(Value(ValueType::Null));
+      break;
+    case 0xc2:
+      add(Value(false));
+      break;
+    case 0xc3:
+      add(Value(true));
+      break;
+    case 0xc4:
+    case 0xc5:
+    case 0xc6:
+      parseBinary(readUInt(1 << (head - 0xc4)));
+      break;
+    case 0xc7:
+    case 0xc8:
+    case 0xc9:
+      parseExtension(readUInt(1 << (head - 0xc7)));
+      break;
+    case 0xca:
+      add(Value(static_cast<double>(::floatFromBits(static_cast<uint32_t>(readUInt(4))))));
+      break;
+    case 0xcb:
+      add(Value(::doubleFromBits(readUInt(8))));
+      break;
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf:
+      add(Value(readUInt(1 << (head - 0xcc))));
+      break;
+    case 0xd0:
+      addInt(static_cast<int8_t>(readUInt(1)));
+      break;
+    case 0xd1:
+      addInt(static_cast<int16_t>(readUInt(2)));
+      break;
+    case 0xd2:
+      addInt(static_cast<int32_t>(readUInt(4)));
+      break;
+    case 0xd3:
+      addInt(static_cast<int64_t>(readUInt(8)));
+      break;
+    case 0xd4:
+    case 0xd5:
+    case 0xd6:
+    case 0xd7:
+    case 0xd8:
+      parseExtension(ValueLength(1) << (head - 0xd4));
+      break;
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+      parseString(readUInt(1 << (head - 0xd9)));
+      break;
+    case 0xdc:
+    case 0xdd:
+      parseArray(readUInt(head == 0xdc ? 2 : 4));
+      break;
+    case 0xde:
+    case 0xdf:
+      parseMap(readUInt(head == 0xde ? 2 : 4));
+      break;
+    default:
+      throw Exception(Exception::ParseError, "Invalid MessagePack type byte");
+  }
+}
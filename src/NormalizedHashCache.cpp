@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "velocypack/NormalizedHashCache.h"
+
+using namespace arangodb::velocypack;
+
+uint64_t NormalizedHashCache::normalizedHash(Slice slice) {
+  auto it = _hashes.find(slice.start());
+  if (it != _hashes.end()) {
+    return (*it).second;
+  }
+  uint64_t hash = slice.normalizedHash(_seed);
+  _hashes.emplace(slice.start(), hash);
+  return hash;
+}
+
+void NormalizedHashCache::normalizedHashMany(Slice const* slices, std::size_t n,
+                                             uint64_t* hashes) {
+  _hashes.reserve(_hashes.size() + n);
+  for (std::size_t i = 0; i < n; ++i) {
+    hashes[i] = normalizedHash(slices[i]);
+  }
+}
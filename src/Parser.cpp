@@ -29,49 +29,554 @@
 #include "asm-functions.h"
 
 #include <cstdlib>
+#include <cstring>
 
 using namespace arangodb::velocypack;
 
-// The following function does the actual parse. It gets bytes
-// via peek, consume and reset appends the result to the Builder
-// in *_builderPtr. Errors are reported via an exception.
-// Behind the scenes it runs two parses, one to collect sizes and
-// check for parse errors (scan phase) and then one to actually
-// build the result (build phase).
+// The scanner below is instantiated once per handler: the BuilderHandler
+// appends the values to the Builder in *_builderPtr, the SaxHandler
+// reports them to a JsonHandler, and the ProjectionHandler appends only
+// the selected ones. A handler provides
+//
+//   startDocument(), endDocument(), abortDocument()
+//                                        around each top-level value
+//   openArray(), arrayMember(), closeArray()
+//   openObject(), key(), closeObject()
+//   string(), addNull(), addBool(), addInt(), addUInt(), addDouble()
+//
+// openArray(), openObject() and key() return false to have the Array,
+// Object or member value skipped. key() and string() are called with the
+// opening '"' consumed and must consume the string via parseString().
+// parseString() in turn writes into a target, which provides
+//
+//   reserveUpTo(n)   reserve space for up to n bytes, returns the space
+//   cursor()         the current write position
+//   advance(n), push(c), pushUnchecked(c), rollback(n)
+//   check()          called before every byte taken from the input
+//   finish()         called after the closing '"' has been consumed
 
-ValueLength Parser::parseInternal(bool multi) {
-  // skip over optional BOM
-  if (_size >= 3 && _start[0] == 0xef && _start[1] == 0xbb &&
-      _start[2] == 0xbf) {
-    // found UTF-8 BOM. simply skip over it
-    _pos += 3;
+struct Parser::BuilderStringTarget {
+  explicit BuilderStringTarget(Builder& builder)
+      : builder(builder), base(builder._pos), large(false) {
+    builder.appendByte(0x40); // correct this in finish()
   }
 
-  ValueLength nr = 0;
-  do {
-    bool haveReported = false;
-    if (!_builderPtr->_stack.empty()) {
-      ValueLength const tos = _builderPtr->_stack.back();
-      if (_builderPtr->_start[tos] == 0x0b || _builderPtr->_start[tos] == 0x14) {
-        if (!_builderPtr->_keyWritten) {
+  inline std::size_t reserveUpTo(std::size_t length) {
+    builder.reserve(length);
+    return length;
+  }
+
+  inline uint8_t* cursor() const noexcept {
+    return builder._start + builder._pos;
+  }
+
+  inline void advance(std::size_t length) { builder.advance(length); }
+  inline void push(uint8_t c) { builder.appendByte(c); }
+  inline void pushUnchecked(uint8_t c) { builder.appendByteUnchecked(c); }
+  inline void rollback(std::size_t length) { builder.rollback(length); }
+
+  // We assume that the string is short and insert 8 bytes for the
+  // length as soon as we reach 127 bytes in the VPack representation.
+  inline void check() {
+    if (!large && builder._pos - (base + 1) > 126) {
+      large = true;
+      builder.reserve(8);
+      ValueLength len = builder._pos - (base + 1);
+      memmove(builder._start + base + 9, builder._start + base + 1,
+              checkOverflow(len));
+      builder.advance(8);
+    }
+  }
+
+  void finish() {
+    ValueLength len;
+    if (!large) {
+      len = builder._pos - (base + 1);
+      builder._start[base] = 0x40 + static_cast<uint8_t>(len);
+    } else {
+      len = builder._pos - (base + 9);
+      builder._start[base] = 0xbf;
+      for (ValueLength i = 1; i <= 8; i++) {
+        builder._start[base + i] = len & 0xff;
+        len >>= 8;
+      }
+    }
+  }
+
+  Builder& builder;
+  ValueLength const base;
+  bool large;
+};
+
+struct Parser::BuilderHandler {
+  explicit BuilderHandler(Parser& parser)
+      : parser(parser), builder(*parser._builderPtr), haveReported(false) {}
+
+  void startDocument() {
+    haveReported = false;
+    if (!builder._stack.empty()) {
+      ValueLength const tos = builder._stack.back();
+      if (builder._start[tos] == 0x0b || builder._start[tos] == 0x14) {
+        if (!builder._keyWritten) {
           throw Exception(Exception::BuilderKeyMustBeString);
         }
         else {
-          _builderPtr->_keyWritten = false;
+          builder._keyWritten = false;
         }
       }
       else {
-        _builderPtr->reportAdd();
+        builder.reportAdd();
         haveReported = true;
       }
     }
+  }
+
+  inline void endDocument() noexcept {}
+
+  void abortDocument() {
+    if (haveReported) {
+      builder.cleanupAdd();
+    }
+  }
+
+  inline bool openArray() {
+    builder.addArray();
+    return true;
+  }
+
+  inline void arrayMember() { builder.reportAdd(); }
+  inline void closeArray() { builder.close(); }
+
+  inline bool openObject() {
+    builder.addObject();
+    return true;
+  }
+
+  bool key() {
+    builder.reportAdd();
+    auto const lastPos = builder._pos;
+    string();
+
+    if (parser.options->attributeTranslator != nullptr && !parser.failed()) {
+      // check if a translation for the attribute name exists
+      Slice key(builder._start + lastPos);
+
+      if (key.isString()) {
+        ValueLength keyLength;
+        char const* p = key.getString(keyLength);
+        uint8_t const* translated =
+            parser.options->attributeTranslator->translate(p, keyLength);
+
+        if (translated != nullptr) {
+          // found translation... now reset position to old key position
+          // and simply overwrite the existing key with the numeric translation
+          // id
+          builder.resetTo(lastPos);
+          builder.addUInt(Slice(translated).getUInt());
+        }
+      }
+    }
+    return true;
+  }
+
+  inline void closeObject() {
+    if (parser._nesting != 1 || !parser.options->keepTopLevelOpen) {
+      // only close if we've not been asked to keep top level open
+      builder.close();
+    }
+  }
+
+  inline void string() {
+    BuilderStringTarget target(builder);
+    parser.parseString(target);
+  }
+
+  inline void addNull() { builder.addNull(); }
+  inline void addBool(bool value) {
+    if (value) {
+      builder.addTrue();
+    } else {
+      builder.addFalse();
+    }
+  }
+  inline void addInt(int64_t value) { builder.addInt(value); }
+  inline void addUInt(uint64_t value) { builder.addUInt(value); }
+  inline void addDouble(double value) { builder.addDouble(value); }
+
+  Parser& parser;
+  Builder& builder;
+  bool haveReported;
+};
+
+namespace {
+
+// collects the unescaped bytes of a string for a JsonHandler. the buffer
+// is reused for all strings, and a single reservation is capped so that
+// long inputs do not make it grow to the size of the remaining input
+struct BufferStringTarget {
+  explicit BufferStringTarget(Buffer<uint8_t>& buffer) : buffer(buffer) {
+    buffer.reset();
+  }
+
+  inline std::size_t reserveUpTo(std::size_t length) {
+    length = (std::min)(length, std::size_t(16384));
+    if (buffer.size() + length >= buffer.capacity()) {
+      // Buffer::reserve() only leaves exactly the requested space. take
+      // twice as much, so that the next chunks of a string with escape
+      // sequences still fit
+      buffer.reserve(2 * length + 1);
+    }
+    return length;
+  }
+
+  inline uint8_t* cursor() noexcept { return buffer.data() + buffer.size(); }
+
+  inline void advance(std::size_t length) { buffer.advance(length); }
+  inline void push(uint8_t c) { buffer.push_back(static_cast<char>(c)); }
+  inline void pushUnchecked(uint8_t c) noexcept {
+    *cursor() = c;
+    buffer.advance(1);
+  }
+  inline void rollback(std::size_t length) { buffer.rollback(length); }
+  inline void check() noexcept {}
+  inline void finish() noexcept {}
+
+  StringRef value() const noexcept {
+    return StringRef(reinterpret_cast<char const*>(buffer.data()),
+                     buffer.size());
+  }
+
+  Buffer<uint8_t>& buffer;
+};
+
+}  // namespace
+
+struct Parser::SaxHandler {
+  SaxHandler(Parser& parser, JsonHandler& handler)
+      : parser(parser), handler(handler) {}
+
+  inline void startDocument() noexcept {}
+  inline void endDocument() noexcept {}
+  inline void abortDocument() noexcept {}
+
+  inline bool openArray() { return handler.startArray(); }
+  inline void arrayMember() noexcept {}
+  inline void closeArray() { handler.endArray(); }
+
+  inline bool openObject() { return handler.startObject(); }
+
+  bool key() {
+    ::BufferStringTarget target(scratch);
+    parser.parseString(target);
+    if (VELOCYPACK_UNLIKELY(parser.failed())) {
+      return false;
+    }
+    return handler.key(target.value());
+  }
+
+  inline void closeObject() { handler.endObject(); }
+
+  void string() {
+    ::BufferStringTarget target(scratch);
+    parser.parseString(target);
+    if (VELOCYPACK_UNLIKELY(parser.failed())) {
+      return;
+    }
+    handler.stringValue(target.value());
+  }
+
+  inline void addNull() { handler.nullValue(); }
+  inline void addBool(bool value) { handler.boolValue(value); }
+  inline void addInt(int64_t value) { handler.intValue(value); }
+  inline void addUInt(uint64_t value) { handler.uintValue(value); }
+  inline void addDouble(double value) { handler.doubleValue(value); }
+
+  Parser& parser;
+  JsonHandler& handler;
+  Buffer<uint8_t> scratch;
+};
+
+struct Parser::ProjectionHandler {
+  ProjectionHandler(Parser& parser, JsonProjection const& projection)
+      : parser(parser), projection(projection), builder(parser),
+        next(0), full(0), selected(false), base(0) {}
+
+  void startDocument() {
+    builder.startDocument();
+    path.clear();
+    next = 0;
+    full = 0;
+    selected = projection._nodes[0].selected;
+    base = builder.builder._pos;
+  }
+
+  void endDocument() {
+    if (builder.builder._pos == base) {
+      // the top-level value was not an Object
+      builder.builder.addObject();
+      if (!parser.options->keepTopLevelOpen) {
+        builder.builder.close();
+      }
+    }
+  }
+
+  inline void abortDocument() { builder.abortDocument(); }
+
+  // whether the next value is built, which then is the end of a path
+  inline bool take() noexcept {
+    if (full > 0) {
+      return true;
+    }
+    bool result = selected;
+    selected = false;
+    return result;
+  }
+
+  bool openArray() {
+    if (take()) {
+      ++full;
+      return builder.openArray();
+    }
+    return false;
+  }
+
+  inline void arrayMember() {
+    if (full > 0) {
+      builder.arrayMember();
+    }
+  }
+
+  void closeArray() {
+    --full;
+    builder.closeArray();
+  }
+
+  bool openObject() {
+    if (take()) {
+      ++full;
+      return builder.openObject();
+    }
+    if (next != 0 || path.empty()) {
+      // an Object on a path
+      path.push_back(next);
+      next = 0;
+      return builder.openObject();
+    }
+    return false;
+  }
+
+  bool key() {
+    if (full > 0) {
+      return builder.key();
+    }
+    std::size_t const start = parser._pos;
+    uint32_t child;
+    {
+      ::BufferStringTarget target(scratch);
+      parser.parseString(target);
+      if (VELOCYPACK_UNLIKELY(parser.failed())) {
+        return false;
+      }
+      child = projection.find(path.back(), target.value());
+    }
+    if (child == 0) {
+      return false;
+    }
+    if (projection._nodes[child].selected) {
+      selected = true;
+    } else if (valueIsObject()) {
+      next = child;
+    } else {
+      return false;
+    }
+    // build the key, this time with the Builder
+    parser._pos = start;
+    return builder.key();
+  }
+
+  void closeObject() {
+    if (full > 0) {
+      --full;
+    } else {
+      path.pop_back();
+    }
+    builder.closeObject();
+  }
+
+  void string() {
+    if (take()) {
+      builder.string();
+    } else {
+      parser.skipString();
+    }
+  }
+
+  inline void addNull() {
+    if (take()) {
+      builder.addNull();
+    }
+  }
+  inline void addBool(bool value) {
+    if (take()) {
+      builder.addBool(value);
+    }
+  }
+  inline void addInt(int64_t value) {
+    if (take()) {
+      builder.addInt(value);
+    }
+  }
+  inline void addUInt(uint64_t value) {
+    if (take()) {
+      builder.addUInt(value);
+    }
+  }
+  inline void addDouble(double value) {
+    if (take()) {
+      builder.addDouble(value);
+    }
+  }
+
+  // whether the value after the ':' following the key just parsed is an
+  // Object, without consuming anything
+  bool valueIsObject() const noexcept {
+    std::size_t pos = parser._pos;
+    while (pos < parser._size && parser.isWhiteSpace(parser._start[pos])) {
+      ++pos;
+    }
+    if (pos >= parser._size || parser._start[pos] != ':') {
+      return false;
+    }
+    ++pos;
+    while (pos < parser._size && parser.isWhiteSpace(parser._start[pos])) {
+      ++pos;
+    }
+    return pos < parser._size && parser._start[pos] == '{';
+  }
+
+  Parser& parser;
+  JsonProjection const& projection;
+  BuilderHandler builder;
+  // the projection's nodes of the open Objects on a path
+  std::vector<uint32_t> path;
+  // the node of the Object on a path that is opened next
+  uint32_t next;
+  // the nesting depth inside a selected value
+  std::size_t full;
+  // whether the next value is selected
+  bool selected;
+  // the Builder's position at the start of the document
+  ValueLength base;
+  Buffer<uint8_t> scratch;
+};
+
+void JsonProjection::add(std::vector<std::string> const& path) {
+  uint32_t node = 0;
+  for (auto const& name : path) {
+    if (_nodes[node].selected) {
+      // a prefix of the path is selected already
+      return;
+    }
+    uint32_t child = find(node, StringRef(name));
+    if (child == 0) {
+      child = static_cast<uint32_t>(_nodes.size());
+      _nodes[node].children.emplace_back(name, child);
+      _nodes.emplace_back();
+    }
+    node = child;
+  }
+  _nodes[node].selected = true;
+  // longer paths below this one are implied now
+  _nodes[node].children.clear();
+}
+
+uint32_t JsonProjection::find(uint32_t node, StringRef key) const noexcept {
+  // projections hold a handful of attributes, so a linear search is fine
+  for (auto const& it : _nodes[node].children) {
+    if (key.equals(it.first)) {
+      return it.second;
+    }
+  }
+  return 0;
+}
+
+ValueLength Parser::parse(uint8_t const* start, std::size_t size, bool multi) {
+  begin(start, size);
+  if (options->clearBuilderBeforeParse) {
+    _builder->clear();
+  }
+  BuilderHandler handler(*this);
+  ValueLength nr = parseInternal(handler, multi);
+  throwIfFailed();
+  return nr;
+}
+
+ValueLength Parser::parse(uint8_t const* start, std::size_t size,
+                          JsonHandler& handler, bool multi) {
+  begin(start, size);
+  SaxHandler sax(*this, handler);
+  ValueLength nr = parseInternal(sax, multi);
+  throwIfFailed();
+  return nr;
+}
+
+ValueLength Parser::parse(uint8_t const* start, std::size_t size,
+                          JsonProjection const& projection, bool multi) {
+  begin(start, size);
+  if (options->clearBuilderBeforeParse) {
+    _builder->clear();
+  }
+  ProjectionHandler handler(*this, projection);
+  ValueLength nr = parseInternal(handler, multi);
+  throwIfFailed();
+  return nr;
+}
+
+Status Parser::tryParse(uint8_t const* start, std::size_t size, bool multi) {
+  begin(start, size);
+  if (options->clearBuilderBeforeParse) {
+    _builder->clear();
+  }
+  BuilderHandler handler(*this);
+  try {
+    parseInternal(handler, multi);
+  } catch (Exception const& ex) {
+    // the scanner itself never throws, but the Builder may
+    return Status(ex.errorCode(), ex.what(), errorPos());
+  }
+  if (VELOCYPACK_UNLIKELY(failed())) {
+    return Status(_errorCode, _errorMessage, errorPos());
+  }
+  return Status();
+}
+
+// The following function does the actual parse. It gets bytes
+// via peek, consume and reset and reports the values to the handler.
+// Errors are recorded with fail(), after which every level of the
+// scanner returns right away. only the handler may throw.
+
+template<typename Handler>
+ValueLength Parser::parseInternal(Handler& handler, bool multi) {
+  // skip over optional BOM
+  if (_size >= 3 && _start[0] == 0xef && _start[1] == 0xbb &&
+      _start[2] == 0xbf) {
+    // found UTF-8 BOM. simply skip over it
+    _pos += 3;
+  }
+
+  ValueLength nr = 0;
+  do {
+    handler.startDocument();
     try {
-      parseJson();
+      parseJson(handler);
+      if (VELOCYPACK_UNLIKELY(failed())) {
+        handler.abortDocument();
+        return nr;
+      }
+      handler.endDocument();
     }
     catch (...) {
-      if (haveReported) {
-        _builderPtr->cleanupAdd();
-      }
+      handler.abortDocument();
       throw;
     }
     nr++;
@@ -80,7 +585,8 @@ ValueLength Parser::parseInternal(bool multi) {
     }
     if (!multi && _pos != _size) {
       consume();  // to get error reporting right. return value intentionally not checked
-      throw Exception(Exception::ParseError, "Expecting EOF");
+      fail(Exception::ParseError, "Expecting EOF");
+      return nr;
     }
   } while (multi && _pos < _size);
   return nr;
@@ -90,7 +596,8 @@ ValueLength Parser::parseInternal(bool multi) {
 // byte following the whitespace
 int Parser::skipWhiteSpace(char const* err) {
   if (VELOCYPACK_UNLIKELY(_pos >= _size)) {
-    throw Exception(Exception::ParseError, err);
+    fail(Exception::ParseError, err);
+    return -1;
   }
   uint8_t c = _start[_pos];
   if (!isWhiteSpace(c)) {
@@ -99,7 +606,8 @@ int Parser::skipWhiteSpace(char const* err) {
   if (c == ' ') {
     if (_pos + 1 >= _size) {
       _pos++;
-      throw Exception(Exception::ParseError, err);
+      fail(Exception::ParseError, err);
+      return -1;
     }
     c = _start[_pos + 1];
     if (!isWhiteSpace(c)) {
@@ -118,11 +626,13 @@ int Parser::skipWhiteSpace(char const* err) {
     }
     _pos++;
   } while (_pos < _size);
-  throw Exception(Exception::ParseError, err);
+  fail(Exception::ParseError, err);
+  return -1;
 }
 
 // parses a number value
-void Parser::parseNumber() {
+template<typename Handler>
+void Parser::parseNumber(Handler& handler) {
   std::size_t startPos = _pos;
   ParsedNumber numberValue;
   bool negative = false;
@@ -130,16 +640,20 @@ void Parser::parseNumber() {
   // We know that a character is coming, and it's a number if it
   // starts with '-' or a digit. otherwise it's invalid
   if (i == '-') {
-    i = getOneOrThrow("Incomplete number");
+    i = getOneOrFail("Incomplete number");
     negative = true;
   }
   if (i < '0' || i > '9') {
-    throw Exception(Exception::ParseError, "Expecting digit");
+    fail(Exception::ParseError, "Expecting digit");
+    return;
   }
 
   if (i != '0') {
     unconsume();
-    scanDigits(numberValue);
+    if (VELOCYPACK_UNLIKELY(!scanDigits(numberValue))) {
+      fail(Exception::NumberOutOfRange);
+      return;
+    }
   }
   i = consume();
   if (i < 0 || (i != '.' && i != 'e' && i != 'E')) {
@@ -148,20 +662,20 @@ void Parser::parseNumber() {
     }
     if (!numberValue.isInteger) {
       if (negative) {
-        _builderPtr->addDouble(-numberValue.doubleValue);
+        handler.addDouble(-numberValue.doubleValue);
       } else {
-        _builderPtr->addDouble(numberValue.doubleValue);
+        handler.addDouble(numberValue.doubleValue);
       }
     } else if (negative) {
       if (numberValue.intValue <= static_cast<uint64_t>(INT64_MAX)) {
-        _builderPtr->addInt(-static_cast<int64_t>(numberValue.intValue));
+        handler.addInt(-static_cast<int64_t>(numberValue.intValue));
       } else if (numberValue.intValue == toUInt64(INT64_MIN)) {
-        _builderPtr->addInt(INT64_MIN);
+        handler.addInt(INT64_MIN);
       } else {
-        _builderPtr->addDouble(-static_cast<double>(numberValue.intValue));
+        handler.addDouble(-static_cast<double>(numberValue.intValue));
       }
     } else {
-      _builderPtr->addUInt(numberValue.intValue);
+      handler.addUInt(numberValue.intValue);
     }
     return;
   }
@@ -169,9 +683,10 @@ void Parser::parseNumber() {
   double fractionalPart;
   if (i == '.') {
     // fraction. skip over '.'
-    i = getOneOrThrow("Incomplete number");
+    i = consume();
     if (i < '0' || i > '9') {
-      throw Exception(Exception::ParseError, "Incomplete number");
+      fail(Exception::ParseError, "Incomplete number");
+      return;
     }
     unconsume();
     fractionalPart = scanDigitsFractional();
@@ -182,7 +697,7 @@ void Parser::parseNumber() {
     }
     i = consume();
     if (i < 0) {
-      _builderPtr->addDouble(fractionalPart);
+      handler.addDouble(fractionalPart);
       return;
     }
   } else {
@@ -196,122 +711,107 @@ void Parser::parseNumber() {
     unconsume();
     // use conventional atof() conversion here, to avoid precision loss
     // when interpreting and multiplying the single digits of the input stream
-    // _builderPtr->addDouble(fractionalPart);
-    _builderPtr->addDouble(atof(reinterpret_cast<char const*>(_start) + startPos));
+    // handler.addDouble(fractionalPart);
+    handler.addDouble(atof(reinterpret_cast<char const*>(_start) + startPos));
     return;
   }
-  i = getOneOrThrow("Incomplete number");
+  i = consume();
   negative = false;
   if (i == '+' || i == '-') {
     negative = (i == '-');
-    i = getOneOrThrow("Incomplete number");
+    i = consume();
   }
   if (i < '0' || i > '9') {
-    throw Exception(Exception::ParseError, "Incomplete number");
+    fail(Exception::ParseError, "Incomplete number");
+    return;
   }
   unconsume();
   ParsedNumber exponent;
-  scanDigits(exponent);
+  if (VELOCYPACK_UNLIKELY(!scanDigits(exponent))) {
+    fail(Exception::NumberOutOfRange);
+    return;
+  }
   if (negative) {
     fractionalPart *= pow(10, -exponent.asDouble());
   } else {
     fractionalPart *= pow(10, exponent.asDouble());
   }
   if (std::isnan(fractionalPart) || !std::isfinite(fractionalPart)) {
-    throw Exception(Exception::NumberOutOfRange);
+    fail(Exception::NumberOutOfRange);
+    return;
   }
   // use conventional atof() conversion here, to avoid precision loss
   // when interpreting and multiplying the single digits of the input stream
-  // _builderPtr->addDouble(fractionalPart);
-  _builderPtr->addDouble(atof(reinterpret_cast<char const*>(_start) + startPos));
+  // handler.addDouble(fractionalPart);
+  handler.addDouble(atof(reinterpret_cast<char const*>(_start) + startPos));
 }
 
-void Parser::parseString() {
+template<typename Target>
+void Parser::parseString(Target& target) {
   // When we get here, we have seen a " character and now want to
-  // find the end of the string and parse the string value to its
-  // VPack representation. We assume that the string is short and
-  // insert 8 bytes for the length as soon as we reach 127 bytes
-  // in the VPack representation.
-  ValueLength const base = _builderPtr->_pos;
-  _builderPtr->appendByte(0x40); // correct this later
-
-  bool large = false;          // set to true when we reach 128 bytes
+  // find the end of the string and write the unescaped string value
+  // to the target.
   uint32_t highSurrogate = 0;  // non-zero if high-surrogate was seen
 
   while (true) {
     std::size_t remainder = _size - _pos;
     if (remainder >= 16) {
-      _builderPtr->reserve(remainder);
-      std::size_t count;
       // Note that the SSE4.2 accelerated string copying functions might
       // peek up to 15 bytes over the given end, because they use 128bit
       // registers. Therefore, we have to subtract 15 from remainder
       // to be on the safe side. Further bytes will be processed below.
+      std::size_t const limit = target.reserveUpTo(remainder - 15);
+      std::size_t count;
       if (options->validateUtf8Strings) {
-        count = JSONStringCopyCheckUtf8(_builderPtr->_start + _builderPtr->_pos, _start + _pos,
-                                        remainder - 15);
+        count = JSONStringCopyCheckUtf8(target.cursor(), _start + _pos, limit);
       } else {
-        count = JSONStringCopy(_builderPtr->_start + _builderPtr->_pos, _start + _pos,
-                               remainder - 15);
+        count = JSONStringCopy(target.cursor(), _start + _pos, limit);
       }
       _pos += count;
-      _builderPtr->advance(count);
+      target.advance(count);
     }
-    int i = getOneOrThrow("Unfinished string");
-    if (!large && _builderPtr->_pos - (base + 1) > 126) {
-      large = true;
-      _builderPtr->reserve(8);
-      ValueLength len = _builderPtr->_pos - (base + 1);
-      memmove(_builderPtr->_start + base + 9, _builderPtr->_start + base + 1, checkOverflow(len));
-      _builderPtr->advance(8);
+    int i = getOneOrFail("Unfinished string");
+    if (VELOCYPACK_UNLIKELY(i < 0)) {
+      return;
     }
+    target.check();
     switch (i) {
       case '"':
-        ValueLength len;
-        if (!large) {
-          len = _builderPtr->_pos - (base + 1);
-          _builderPtr->_start[base] = 0x40 + static_cast<uint8_t>(len);
-          // String is ready
-        } else {
-          len = _builderPtr->_pos - (base + 9);
-          _builderPtr->_start[base] = 0xbf;
-          for (ValueLength i = 1; i <= 8; i++) {
-            _builderPtr->_start[base + i] = len & 0xff;
-            len >>= 8;
-          }
-        }
+        // String is ready
+        target.finish();
         return;
       case '\\':
-        // Handle cases or throw error
+        // Handle cases or fail
         i = consume();
         if (VELOCYPACK_UNLIKELY(i < 0)) {
-          throw Exception(Exception::ParseError, "Invalid escape sequence");
+          fail(Exception::ParseError, "Invalid escape sequence");
+          return;
         }
         switch (i) {
           case '"':
           case '/':
           case '\\':
-            _builderPtr->appendByte(static_cast<uint8_t>(i));
+            target.push(static_cast<uint8_t>(i));
             highSurrogate = 0;
             break;
           case 'b':
-            _builderPtr->appendByte('\b');
+            target.push('\b');
             highSurrogate = 0;
             break;
           case 'f':
-            _builderPtr->appendByte('\f');
+            target.push('\f');
             highSurrogate = 0;
             break;
           case 'n':
-            _builderPtr->appendByte('\n');
+            target.push('\n');
             highSurrogate = 0;
             break;
           case 'r':
-            _builderPtr->appendByte('\r');
+            target.push('\r');
             highSurrogate = 0;
             break;
           case 't':
-            _builderPtr->appendByte('\t');
+            target.push('\t');
             highSurrogate = 0;
             break;
           case 'u': {
@@ -319,8 +819,9 @@ void Parser::parseString() {
             for (int j = 0; j < 4; j++) {
               i = consume();
               if (i < 0) {
-                throw Exception(Exception::ParseError,
-                                "Unfinished \\uXXXX escape sequence");
+                fail(Exception::ParseError,
+                     "Unfinished \\uXXXX escape sequence");
+                return;
               }
               if (i >= '0' && i <= '9') {
                 v = (v << 4) + i - '0';
@@ -329,27 +830,28 @@ void Parser::parseString() {
               } else if (i >= 'A' && i <= 'F') {
                 v = (v << 4) + i - 'A' + 10;
               } else {
-                throw Exception(Exception::ParseError,
-                                "Illegal \\uXXXX escape sequence");
+                fail(Exception::ParseError,
+                     "Illegal \\uXXXX escape sequence");
+                return;
               }
             }
             if (v < 0x80) {
-              _builderPtr->appendByte(static_cast<uint8_t>(v));
+              target.push(static_cast<uint8_t>(v));
               highSurrogate = 0;
             } else if (v < 0x800) {
-              _builderPtr->reserve(2);
-              _builderPtr->appendByteUnchecked(0xc0 + (v >> 6));
-              _builderPtr->appendByteUnchecked(0x80 + (v & 0x3f));
+              target.reserveUpTo(2);
+              target.pushUnchecked(0xc0 + (v >> 6));
+              target.pushUnchecked(0x80 + (v & 0x3f));
               highSurrogate = 0;
             } else if (v >= 0xdc00 && v < 0xe000 && highSurrogate != 0) {
               // Low surrogate, put the two together:
               v = 0x10000 + ((highSurrogate - 0xd800) << 10) + v - 0xdc00;
-              _builderPtr->rollback(3);
-              _builderPtr->reserve(4);
-              _builderPtr->appendByteUnchecked(0xf0 + (v >> 18));
-              _builderPtr->appendByteUnchecked(0x80 + ((v >> 12) & 0x3f));
-              _builderPtr->appendByteUnchecked(0x80 + ((v >> 6) & 0x3f));
-              _builderPtr->appendByteUnchecked(0x80 + (v & 0x3f));
+              target.rollback(3);
+              target.reserveUpTo(4);
+              target.pushUnchecked(0xf0 + (v >> 18));
+              target.pushUnchecked(0x80 + ((v >> 12) & 0x3f));
+              target.pushUnchecked(0x80 + ((v >> 6) & 0x3f));
+              target.pushUnchecked(0x80 + (v & 0x3f));
               highSurrogate = 0;
             } else {
               if (v >= 0xd800 && v < 0xdc00) {
@@ -358,15 +860,16 @@ void Parser::parseString() {
               } else {
                 highSurrogate = 0;
               }
-              _builderPtr->reserve(3);
-              _builderPtr->appendByteUnchecked(0xe0 + (v >> 12));
-              _builderPtr->appendByteUnchecked(0x80 + ((v >> 6) & 0x3f));
-              _builderPtr->appendByteUnchecked(0x80 + (v & 0x3f));
+              target.reserveUpTo(3);
+              target.pushUnchecked(0xe0 + (v >> 12));
+              target.pushUnchecked(0x80 + ((v >> 6) & 0x3f));
+              target.pushUnchecked(0x80 + (v & 0x3f));
             }
             break;
           }
           default:
-            throw Exception(Exception::ParseError, "Invalid escape sequence");
+            fail(Exception::ParseError, "Invalid escape sequence");
+            return;
         }
         break;
       default:
@@ -374,19 +877,21 @@ void Parser::parseString() {
           // non-UTF-8 sequence
           if (VELOCYPACK_UNLIKELY(i < 0x20)) {
             // control character
-            throw Exception(Exception::UnexpectedControlCharacter);
+            fail(Exception::UnexpectedControlCharacter);
+            return;
           }
           highSurrogate = 0;
-          _builderPtr->appendByte(static_cast<uint8_t>(i));
+          target.push(static_cast<uint8_t>(i));
         } else {
           if (!options->validateUtf8Strings) {
             highSurrogate = 0;
-            _builderPtr->appendByte(static_cast<uint8_t>(i));
+            target.push(static_cast<uint8_t>(i));
           } else {
             // multi-byte UTF-8 sequence!
             int follow = 0;
             if ((i & 0xe0) == 0x80) {
-              throw Exception(Exception::InvalidUtf8Sequence);
+              fail(Exception::InvalidUtf8Sequence);
+              return;
             } else if ((i & 0xe0) == 0xc0) {
               // two-byte sequence
               follow = 1;
@@ -397,18 +902,23 @@ void Parser::parseString() {
               // four-byte sequence
               follow = 3;
             } else {
-              throw Exception(Exception::InvalidUtf8Sequence);
+              fail(Exception::InvalidUtf8Sequence);
+              return;
             }
 
             // validate follow up characters
-            _builderPtr->reserve(1 + follow);
-            _builderPtr->appendByteUnchecked(static_cast<uint8_t>(i));
+            target.reserveUpTo(1 + follow);
+            target.pushUnchecked(static_cast<uint8_t>(i));
             for (int j = 0; j < follow; ++j) {
-              i = getOneOrThrow("scanString: truncated UTF-8 sequence");
+              i = getOneOrFail("scanString: truncated UTF-8 sequence");
+              if (VELOCYPACK_UNLIKELY(i < 0)) {
+                return;
+              }
               if ((i & 0xc0) != 0x80) {
-                throw Exception(Exception::InvalidUtf8Sequence);
+                fail(Exception::InvalidUtf8Sequence);
+                return;
               }
-              _builderPtr->appendByteUnchecked(static_cast<uint8_t>(i));
+              target.pushUnchecked(static_cast<uint8_t>(i));
             }
             highSurrogate = 0;
           }
@@ -418,14 +928,21 @@ void Parser::parseString() {
   }
 }
 
-void Parser::parseArray() {
-  _builderPtr->addArray();
+template<typename Handler>
+void Parser::parseArray(Handler& handler) {
+  if (!handler.openArray()) {
+    skipCompound();
+    return;
+  }
 
   int i = skipWhiteSpace("Expecting item or ']'");
+  if (VELOCYPACK_UNLIKELY(i < 0)) {
+    return;
+  }
   if (i == ']') {
     // empty array
     ++_pos;  // the closing ']'
-    _builderPtr->close();
+    handler.closeArray();
     return;
   }
 
@@ -433,19 +950,23 @@ void Parser::parseArray() {
 
   while (true) {
     // parse array element itself
-    _builderPtr->reportAdd();
-    parseJson();
+    handler.arrayMember();
+    parseJson(handler);
+    if (VELOCYPACK_UNLIKELY(failed())) {
+      return;
+    }
     i = skipWhiteSpace("Expecting ',' or ']'");
     if (i == ']') {
       // end of array
       ++_pos;  // the closing ']'
-      _builderPtr->close();
+      handler.closeArray();
       decreaseNesting();
       return;
     }
     // skip over ','
     if (VELOCYPACK_UNLIKELY(i != ',')) {
-      throw Exception(Exception::ParseError, "Expecting ',' or ']'");
+      fail(Exception::ParseError, "Expecting ',' or ']'");
+      return;
     }
     ++_pos;  // the ','
   }
@@ -454,77 +975,66 @@ void Parser::parseArray() {
   VELOCYPACK_ASSERT(false);
 }
 
-void Parser::parseObject() {
-  _builderPtr->addObject();
+template<typename Handler>
+void Parser::parseObject(Handler& handler) {
+  if (!handler.openObject()) {
+    skipCompound();
+    return;
+  }
+
+  increaseNesting();
 
   int i = skipWhiteSpace("Expecting item or '}'");
   if (i == '}') {
     // empty object
-    consume();  // the closing '}'. return value intentionally not checked
-
-    if (_nesting != 0 || !options->keepTopLevelOpen) {
-      // only close if we've not been asked to keep top level open
-      _builderPtr->close();
-    }
+    ++_pos;  // the closing '}'
+    handler.closeObject();
+    decreaseNesting();
     return;
   }
 
-  increaseNesting();
-
   while (true) {
     // always expecting a string attribute name here
     if (VELOCYPACK_UNLIKELY(i != '"')) {
-      throw Exception(Exception::ParseError, "Expecting '\"' or '}'");
+      fail(Exception::ParseError, "Expecting '\"' or '}'");
+      return;
     }
     // get past the initial '"'
     ++_pos;
 
-    _builderPtr->reportAdd();
-    auto const lastPos = _builderPtr->_pos;
-    parseString();
-
-    if (options->attributeTranslator != nullptr) {
-      // check if a translation for the attribute name exists
-      Slice key(_builderPtr->_start + lastPos);
-
-      if (key.isString()) {
-        ValueLength keyLength;
-        char const* p = key.getString(keyLength);
-        uint8_t const* translated =
-            options->attributeTranslator->translate(p, keyLength);
-
-        if (translated != nullptr) {
-          // found translation... now reset position to old key position
-          // and simply overwrite the existing key with the numeric translation
-          // id
-          _builderPtr->resetTo(lastPos);
-          _builderPtr->addUInt(Slice(translated).getUInt());
-        }
-      }
+    bool const wanted = handler.key();
+    if (VELOCYPACK_UNLIKELY(failed())) {
+      return;
     }
 
     i = skipWhiteSpace("Expecting ':'");
     // always expecting the ':' here
     if (VELOCYPACK_UNLIKELY(i != ':')) {
-      throw Exception(Exception::ParseError, "Expecting ':'");
+      fail(Exception::ParseError, "Expecting ':'");
+      return;
     }
     ++_pos;  // skip over the colon
 
-    parseJson();
+    if (wanted) {
+      parseJson(handler);
+    } else {
+      skipValue();
+    }
+    if (VELOCYPACK_UNLIKELY(failed())) {
+      return;
+    }
 
     i = skipWhiteSpace("Expecting ',' or '}'");
     if (i == '}') {
       // end of object
       ++_pos;  // the closing '}'
-      if (_nesting != 1 || !options->keepTopLevelOpen) {
-        // only close if we've not been asked to keep top level open
-        _builderPtr->close();
-      }
+      handler.closeObject();
       decreaseNesting();
       return;
     }
     if (VELOCYPACK_UNLIKELY(i != ',')) {
-      throw Exception(Exception::ParseError, "Expecting ',' or '}'");
+      fail(Exception::ParseError, "Expecting ',' or '}'");
+      return;
     }
     // skip over ','
     ++_pos;  // the ','
@@ -535,7 +1045,8 @@ void Parser::parseObject() {
   VELOCYPACK_ASSERT(false);
 }
 
-void Parser::parseJson() {
+template<typename Handler>
+void Parser::parseJson(Handler& handler) {
   skipWhiteSpace("Expecting item"); // return value intentionally not checked
 
   int i = consume();
@@ -544,30 +1055,126 @@ void Parser::parseJson() {
   }
   switch (i) {
     case '{':
-      parseObject();  // this consumes the closing '}' or throws
+      parseObject(handler);  // this consumes the closing '}' or fails
       break;
     case '[':
-      parseArray();  // this consumes the closing ']' or throws
+      parseArray(handler);  // this consumes the closing ']' or fails
       break;
     case 't':
-      parseTrue();  // this consumes "rue" or throws
+      parseTrue(handler);  // this consumes "rue" or fails
       break;
     case 'f':
-      parseFalse();  // this consumes "alse" or throws
+      parseFalse(handler);  // this consumes "alse" or fails
       break;
     case 'n':
-      parseNull();  // this consumes "ull" or throws
+      parseNull(handler);  // this consumes "ull" or fails
       break;
     case '"':
-      parseString();
+      handler.string();
       break;
     default: {
       // everything else must be a number or is invalid...
       // this includes '-' and '0' to '9'. scanNumber() will
-      // throw if the input is non-numeric
+      // fail if the input is non-numeric
       unconsume();
-      parseNumber();  // this consumes the number or throws
+      parseNumber(handler);  // this consumes the number or fails
+      break;
+    }
+  }
+}
+
+// skips over the rest of a string whose opening '"' has been consumed.
+// the string is not validated
+void Parser::skipString() {
+  while (_pos < _size) {
+    auto p = static_cast<uint8_t const*>(
+        memchr(_start + _pos, '"', _size - _pos));
+    if (p == nullptr) {
       break;
     }
+    // the quote is escaped if it is preceded by an odd number of
+    // backslashes. the byte before _pos is never a backslash here
+    std::size_t const quote = p - _start;
+    std::size_t backslash = quote;
+    while (backslash > _pos && _start[backslash - 1] == '\\') {
+      --backslash;
+    }
+    _pos = quote + 1;
+    if (((quote - backslash) & 1) == 0) {
+      return;
+    }
+  }
+  _pos = _size;
+  fail(Exception::ParseError, "Unfinished string");
+}
+
+// skips over the rest of an Array or Object whose opening bracket has
+// been consumed. only the strings and the nesting are checked
+void Parser::skipCompound() {
+  std::size_t depth = 1;
+  while (_pos < _size) {
+    uint8_t c = _start[_pos];
+    if (isWhiteSpace(c)) {
+      // pretty-printed input consists mostly of indentation
+      std::size_t remaining = _size - _pos;
+      if (remaining >= 16 && isWhiteSpace(_start[_pos + 1])) {
+        _pos += JSONSkipWhiteSpace(_start + _pos, remaining - 15);
+      } else {
+        ++_pos;
+      }
+      continue;
+    }
+    ++_pos;
+    switch (c) {
+      case '"':
+        skipString();
+        break;
+      case '[':
+      case '{':
+        ++depth;
+        break;
+      case ']':
+      case '}':
+        if (--depth == 0) {
+          return;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  fail(Exception::ParseError, "Unfinished Array or Object");
+}
+
+// skips over a value. strings and compound values are handled as above,
+// all other values extend up to the next delimiter
+void Parser::skipValue() {
+  int i = skipWhiteSpace("Expecting item");
+  if (VELOCYPACK_UNLIKELY(i < 0)) {
+    return;
+  }
+  ++_pos;
+  switch (i) {
+    case '"':
+      skipString();
+      break;
+    case '[':
+    case '{':
+      skipCompound();
+      break;
+    case ',':
+    case ']':
+    case '}':
+      fail(Exception::ParseError, "Expecting item");
+      return;
+    default:
+      while (_pos < _size) {
+        uint8_t c = _start[_pos];
+        if (c == ',' || c == ']' || c == '}' || isWhiteSpace(c)) {
+          break;
+        }
+        ++_pos;
+      }
+      break;
   }
 }
@@ -0,0 +1,346 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include <cstring>
+
+#include "velocypack/ShapeRegistry.h"
+#include "velocypack/Iterator.h"
+#include "velocypack/Value.h"
+
+using namespace arangodb::velocypack;
+
+namespace {
+
+// collects the (translated) attribute names of an Object
+void collectKeys(Slice object, std::vector<StringRef>& keys) {
+  keys.clear();
+  ObjectIterator it(object, true);
+  while (it.valid()) {
+    keys.push_back(it.key(true).stringRef());
+    it.next();
+  }
+}
+
+// the payload of a shaped object: [<shape id>, <values>...]
+Slice shapedPayload(Slice shaped) {
+  Slice payload(shaped.start() + (shaped.head() == 0xee ? 2 : 9));
+  if (VELOCYPACK_UNLIKELY(!payload.isArray() || payload.isEmptyArray())) {
+    throw Exception(Exception::InvalidValueType, "Expecting shaped object");
+  }
+  return payload;
+}
+
+// the shape id of a shaped object, which is the first member of its
+// payload. avoids the generic member lookup for non-compact Arrays
+uint64_t shapeId(Slice payload) {
+  auto const h = payload.head();
+  if (h == 0x13) {
+    return payload.at(0).getUInt();
+  }
+  return Slice(payload.start() + payload.findDataOffset(h)).getUInt();
+}
+
+// whether the sorted attribute names contain a name more than once
+bool hasDuplicates(std::vector<StringRef> const& keys) {
+  for (std::size_t i = 1; i < keys.size(); ++i) {
+    if (keys[i - 1] == keys[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void addKey(Builder& builder, Slice key) {
+  StringRef name = key.makeKey().stringRef();
+  builder.add(ValuePair(name.data(), name.size(), ValueType::String));
+}
+
+}  // namespace
+
+constexpr uint64_t ShapeRegistry::NotFound;
+constexpr std::size_t ShapeRegistry::Shape::linearSearchThreshold;
+
+ShapeRegistry::ShapeRegistry() {}
+
+ShapeRegistry const* ShapeRegistry::resolve(Options const* options) noexcept {
+  if (options != nullptr && options->shapeRegistry != nullptr) {
+    return options->shapeRegistry;
+  }
+  return Options::Defaults.shapeRegistry;
+}
+
+ShapeRegistry::~ShapeRegistry() {}
+
+// the signature is the concatenation of the sorted attribute names, each
+// prefixed with its length
+std::string ShapeRegistry::signature(std::vector<StringRef>& keys) {
+  std::sort(keys.begin(), keys.end(), [](StringRef const& lhs, StringRef const& rhs) {
+    return lhs.compare(rhs) < 0;
+  });
+
+  std::size_t total = 0;
+  for (auto const& key : keys) {
+    total += sizeof(uint32_t) + key.size();
+  }
+
+  std::string result;
+  result.reserve(total);
+  for (auto const& key : keys) {
+    uint32_t length = static_cast<uint32_t>(key.size());
+    result.append(reinterpret_cast<char const*>(&length), sizeof(length));
+    result.append(key.data(), key.size());
+  }
+  return result;
+}
+
+uint64_t ShapeRegistry::add(std::vector<std::string> const& keys) {
+  std::vector<StringRef> refs;
+  refs.reserve(keys.size());
+  for (auto const& key : keys) {
+    refs.emplace_back(key);
+  }
+  return add(refs);
+}
+
+uint64_t ShapeRegistry::add(Slice object) {
+  if (!object.isObject()) {
+    throw Exception(Exception::InvalidValueType, "Expecting type Object");
+  }
+  std::vector<StringRef> keys;
+  ::collectKeys(object, keys);
+  return add(keys);
+}
+
+uint64_t ShapeRegistry::add(std::vector<StringRef>& keys) {
+  std::string sig = signature(keys);
+  if (::hasDuplicates(keys)) {
+    throw Exception(Exception::DuplicateAttributeName);
+  }
+
+  auto it = _ids.find(sig);
+  if (it != _ids.end()) {
+    return (*it).second;
+  }
+
+  std::unique_ptr<Shape> shape(new Shape());
+  shape->_keys.openArray();
+  for (auto const& key : keys) {
+    shape->_keys.add(ValuePair(key.data(), key.size(), ValueType::String));
+  }
+  shape->_keys.close();
+
+  // the positions refer to the names stored in the shape's own Builder
+  std::size_t position = 0;
+  for (auto key : ArrayIterator(shape->_keys.slice())) {
+    shape->_names.push_back(key.stringRef());
+    shape->_positions.emplace(key.stringRef(), position++);
+  }
+
+  uint64_t id = _shapes.size();
+  _shapes.push_back(std::move(shape));
+  _ids.emplace(std::move(sig), id);
+  return id;
+}
+
+uint64_t ShapeRegistry::find(Slice object) const {
+  if (!object.isObject()) {
+    return NotFound;
+  }
+  std::vector<StringRef> keys;
+  return find(object, keys);
+}
+
+uint64_t ShapeRegistry::find(Slice object, std::vector<StringRef>& keys) const {
+  VELOCYPACK_ASSERT(object.isObject());
+  if (_ids.empty()) {
+    return NotFound;
+  }
+  ::collectKeys(object, keys);
+  auto it = _ids.find(signature(keys));
+  if (it == _ids.end()) {
+    return NotFound;
+  }
+  return (*it).second;
+}
+
+void ShapeRegistry::observe(Slice value) {
+  if (value.isObject()) {
+    if (!value.isEmptyObject()) {
+      std::vector<StringRef> keys;
+      ::collectKeys(value, keys);
+      std::string sig = signature(keys);
+      // Objects with duplicate attribute names have no shape
+      if (!::hasDuplicates(keys)) {
+        ++_observed[std::move(sig)];
+      }
+    }
+    ObjectIterator it(value, true);
+    while (it.valid()) {
+      observe(it.value());
+      it.next();
+    }
+  } else if (value.isArray()) {
+    for (auto member : ArrayIterator(value)) {
+      observe(member);
+    }
+  }
+}
+
+std::size_t ShapeRegistry::infer(uint64_t minOccurrences) {
+  // register the most frequent shapes first, so that they get the
+  // smallest ids. ties are broken by signature to make ids deterministic
+  std::vector<std::pair<std::string const*, uint64_t>> candidates;
+  for (auto const& it : _observed) {
+    if (it.second >= minOccurrences && _ids.find(it.first) == _ids.end()) {
+      candidates.emplace_back(&it.first, it.second);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](std::pair<std::string const*, uint64_t> const& lhs,
+               std::pair<std::string const*, uint64_t> const& rhs) {
+              if (lhs.second != rhs.second) {
+                return lhs.second > rhs.second;
+              }
+              return *lhs.first < *rhs.first;
+            });
+
+  std::vector<StringRef> keys;
+  for (auto const& candidate : candidates) {
+    std::string const& sig = *candidate.first;
+    keys.clear();
+    std::size_t offset = 0;
+    while (offset < sig.size()) {
+      uint32_t length;
+      std::memcpy(&length, sig.data() + offset, sizeof(length));
+      offset += sizeof(length);
+      keys.emplace_back(sig.data() + offset, length);
+      offset += length;
+    }
+    add(keys);
+  }
+
+  _observed.clear();
+  return candidates.size();
+}
+
+void ShapeRegistry::encode(Slice value, Builder& builder) const {
+  if (value.isObject()) {
+    std::vector<StringRef> keys;
+    uint64_t id = value.isEmptyObject() ? NotFound : find(value, keys);
+
+    if (id == NotFound) {
+      builder.openObject();
+      ObjectIterator it(value, true);
+      while (it.valid()) {
+        ::addKey(builder, it.key(false));
+        encode(it.value(), builder);
+        it.next();
+      }
+      builder.close();
+      return;
+    }
+
+    Shape const* s = shape(id);
+    std::vector<Slice> values(s->size());
+    ObjectIterator it(value, true);
+    while (it.valid()) {
+      int64_t position = s->position(it.key(true).stringRef());
+      VELOCYPACK_ASSERT(position >= 0);
+      values[static_cast<std::size_t>(position)] = it.value();
+      it.next();
+    }
+
+    // the payload keeps its index table (or uses the equal-size layout),
+    // so get() can access a value by its position in constant time
+    builder.addTagged(tag, Value(ValueType::Array));
+    builder.add(Value(id));
+    for (auto const& v : values) {
+      encode(v, builder);
+    }
+    builder.close();
+  } else if (value.isArray()) {
+    builder.openArray();
+    for (auto member : ArrayIterator(value)) {
+      encode(member, builder);
+    }
+    builder.close();
+  } else {
+    builder.add(value);
+  }
+}
+
+void ShapeRegistry::decode(Slice value, Builder& builder) const {
+  if (value.isShapedObject()) {
+    Slice payload = ::shapedPayload(value);
+    Shape const* s = shape(::shapeId(payload));
+    if (s == nullptr || payload.length() != s->size() + 1) {
+      throw Exception(Exception::UnknownShape);
+    }
+    builder.openObject();
+    ArrayIterator it(payload);
+    it.next();
+    std::size_t position = 0;
+    while (it.valid()) {
+      ::addKey(builder, s->keyAt(position++));
+      decode(it.value(), builder);
+      it.next();
+    }
+    builder.close();
+  } else if (value.isObject()) {
+    builder.openObject();
+    ObjectIterator it(value, true);
+    while (it.valid()) {
+      ::addKey(builder, it.key(false));
+      decode(it.value(), builder);
+      it.next();
+    }
+    builder.close();
+  } else if (value.isArray()) {
+    builder.openArray();
+    for (auto member : ArrayIterator(value)) {
+      decode(member, builder);
+    }
+    builder.close();
+  } else {
+    builder.add(value);
+  }
+}
+
+Slice ShapeRegistry::get(Slice shaped, StringRef const& attribute) const {
+  if (!shaped.isShapedObject()) {
+    throw Exception(Exception::InvalidValueType, "Expecting shaped object");
+  }
+  Slice payload = ::shapedPayload(shaped);
+  Shape const* s = shape(::shapeId(payload));
+  if (s == nullptr) {
+    throw Exception(Exception::UnknownShape);
+  }
+  int64_t position = s->position(attribute);
+  if (position < 0) {
+    return Slice();
+  }
+  return payload.at(static_cast<ValueLength>(position) + 1);
+}
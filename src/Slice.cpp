@@ -31,6 +31,7 @@
 #include "velocypack/HexDump.h"
 #include "velocypack/Iterator.h"
 #include "velocypack/Parser.h"
+#include "velocypack/ShapeRegistry.h"
 #include "velocypack/Slice.h"
 #include "velocypack/ValueType.h"
 
@@ -38,11 +39,31 @@ using namespace arangodb::velocypack;
 
 namespace {
 
+// returns the translator to use for integer keys: the specified one, or
+// the one bound to the calling thread, or the global default. the lookup
+// of the defaults is done only when an integer key is actually found
+inline AttributeTranslator const* resolveTranslator(AttributeTranslator const* translator) {
+  if (VELOCYPACK_LIKELY(translator != nullptr)) {
+    return translator;
+  }
+  translator = AttributeTranslatorThreadScope::current();
+  if (translator == nullptr) {
+    translator = Options::Defaults.attributeTranslator;
+    if (VELOCYPACK_UNLIKELY(translator == nullptr)) {
+      throw Exception(Exception::NeedAttributeTranslator);
+    }
+  }
+  return translator;
+}
+
 // maximum values for integers of different byte sizes
 int64_t const maxValues[] = {
   128, 32768, 8388608, 2147483648, 549755813888, 140737488355328, 36028797018963968
 };
 
+// number of Slices to look ahead when hashing many Slices at once
+constexpr std::size_t hashPrefetchDistance = 8;
+
 } // namespace
   
 uint8_t const Slice::noneSliceData[] = { 0x00 };
@@ -58,15 +79,12 @@ uint8_t const Slice::minKeySliceData[] = { 0x1e };
 uint8_t const Slice::maxKeySliceData[] = { 0x1f };
 
 // translates an integer key into a string
-Slice Slice::translate() const {
+Slice Slice::translate(AttributeTranslator const* translator) const {
   if (VELOCYPACK_UNLIKELY(!isSmallInt() && !isUInt())) {
     throw Exception(Exception::InvalidValueType,
                     "Cannot translate key of this type");
   }
-  if (Options::Defaults.attributeTranslator == nullptr) {
-    throw Exception(Exception::NeedAttributeTranslator);
-  }
-  return translateUnchecked();
+  return translateUnchecked(::resolveTranslator(translator));
 }
 
 // return the value for a UInt object, without checks!
@@ -110,8 +128,9 @@ int64_t Slice::getSmallIntUnchecked() const noexcept {
 }
 
 // translates an integer key into a string, without checks
-Slice Slice::translateUnchecked() const {
-  uint8_t const* result = Options::Defaults.attributeTranslator->translate(getUIntUnchecked());
+Slice Slice::translateUnchecked(AttributeTranslator const* translator) const {
+  VELOCYPACK_ASSERT(translator != nullptr);
+  uint8_t const* result = translator->translate(getUIntUnchecked());
   if (VELOCYPACK_LIKELY(result != nullptr)) {
     return Slice(result);
   }
@@ -187,6 +206,33 @@ uint64_t Slice::normalizedHash(uint64_t seed) const {
   return value;
 }
 
+void Slice::hashMany(Slice const* slices, std::size_t n, uint64_t* hashes,
+                     uint64_t seed) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i + ::hashPrefetchDistance < n) {
+      VELOCYPACK_PREFETCH(slices[i + ::hashPrefetchDistance].start());
+    }
+    hashes[i] = slices[i].hash(seed);
+  }
+}
+
+void Slice::normalizedHashMany(Slice const* slices, std::size_t n,
+                               uint64_t* hashes, uint64_t seed) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i + ::hashPrefetchDistance < n) {
+      VELOCYPACK_PREFETCH(slices[i + ::hashPrefetchDistance].start());
+    }
+    Slice const slice = slices[i];
+    if (slice.isString()) {
+      // strings are the most common keys, and are hashed by their
+      // binary representation anyway
+      hashes[i] = slice.hash(seed);
+    } else {
+      hashes[i] = slice.normalizedHash(seed);
+    }
+  }
+}
+
 uint32_t Slice::normalizedHash32(uint32_t seed) const {
   uint32_t value;
 
@@ -228,11 +274,41 @@ uint32_t Slice::normalizedHash32(uint32_t seed) const {
 
 // look for the specified attribute inside an Object
 // returns a Slice(ValueType::None) if not found
-Slice Slice::get(StringRef const& attribute) const {
+Slice Slice::get(StringRef const& attribute,
+                 AttributeTranslator const* translator) const {
   if (VELOCYPACK_UNLIKELY(!isObject())) {
-    throw Exception(Exception::InvalidValueType, "Expecting Object");
+    return getFromNonObject(attribute, nullptr);
   }
 
+  return searchObject(attribute, translator);
+}
+
+Slice Slice::get(StringRef const& attribute, Options const* options) const {
+  if (VELOCYPACK_UNLIKELY(!isObject())) {
+    return getFromNonObject(attribute, options);
+  }
+
+  return searchObject(attribute, options == nullptr ? nullptr : options->attributeTranslator);
+}
+
+Slice Slice::getFromNonObject(StringRef const& attribute,
+                              Options const* options) const {
+  if (isShapedObject()) {
+    ShapeRegistry const* registry = ShapeRegistry::resolve(options);
+    if (registry != nullptr) {
+      // resolve the attribute's position through the object's shape
+      return registry->get(*this, attribute);
+    }
+  }
+  throw Exception(Exception::InvalidValueType, "Expecting Object");
+}
+
+// look for the specified attribute inside an Object, without checking
+// the type of the Slice first
+Slice Slice::searchObject(StringRef const& attribute,
+                          AttributeTranslator const* translator) const {
+  VELOCYPACK_ASSERT(isObject());
+
   auto const h = head();
   if (h == 0x0a) {
     // special case, empty object
@@ -241,7 +317,7 @@ Slice Slice::get(StringRef const& attribute) const {
 
   if (h == 0x14) {
     // compact Object
-    return getFromCompactObject(attribute);
+    return getFromCompactObject(attribute, translator);
   }
 
   ValueLength const offsetSize = indexEntrySize(h);
@@ -270,10 +346,7 @@ Slice Slice::get(StringRef const& attribute) const {
       // fall through to returning None Slice below
     } else if (key.isSmallInt() || key.isUInt()) {
       // translate key
-      if (Options::Defaults.attributeTranslator == nullptr) {
-        throw Exception(Exception::NeedAttributeTranslator);
-      }
-      if (key.translateUnchecked().isEqualString(attribute)) {
+      if (key.translateUnchecked(::resolveTranslator(translator)).isEqualString(attribute)) {
         return Slice(key.start() + key.byteSize());
       }
     }
@@ -289,18 +362,18 @@ Slice Slice::get(StringRef const& attribute) const {
   if (n >= SortedSearchEntriesThreshold && (h >= 0x0b && h <= 0x0e)) {
     switch (offsetSize) {
       case 1:
-        return searchObjectKeyBinary<1>(attribute, ieBase, n);
+        return searchObjectKeyBinary<1>(attribute, ieBase, n, translator);
       case 2:
-        return searchObjectKeyBinary<2>(attribute, ieBase, n);
+        return searchObjectKeyBinary<2>(attribute, ieBase, n, translator);
       case 4:
-        return searchObjectKeyBinary<4>(attribute, ieBase, n);
+        return searchObjectKeyBinary<4>(attribute, ieBase, n, translator);
       case 8:
-        return searchObjectKeyBinary<8>(attribute, ieBase, n);
+        return searchObjectKeyBinary<8>(attribute, ieBase, n, translator);
       default: {}
     }
   }
 
-  return searchObjectKeyLinear(attribute, ieBase, offsetSize, n);
+  return searchObjectKeyLinear(attribute, ieBase, offsetSize, n, translator);
 }
 
 // return the value for an Int object
@@ -458,11 +531,12 @@ bool Slice::isEqualStringUnchecked(StringRef const& attribute) const noexcept {
           (memcmp(k, attribute.data(), attribute.size()) == 0);
 }
 
-Slice Slice::getFromCompactObject(StringRef const& attribute) const {
+Slice Slice::getFromCompactObject(StringRef const& attribute,
+                                  AttributeTranslator const* translator) const {
   ObjectIterator it(*this);
   while (it.valid()) {
     Slice key = it.key(false);
-    if (key.makeKey().isEqualString(attribute)) {
+    if (key.makeKey(translator).isEqualString(attribute)) {
       return Slice(key.start() + key.byteSize());
     }
 
@@ -552,15 +626,12 @@ Slice Slice::getNthKey(ValueLength index, bool translate) const {
   return s;
 }
 
-Slice Slice::makeKey() const {
+Slice Slice::makeKey(AttributeTranslator const* translator) const {
   if (isString()) {
     return *this;
   }
   if (isSmallInt() || isUInt()) {
-    if (VELOCYPACK_UNLIKELY(Options::Defaults.attributeTranslator == nullptr)) {
-      throw Exception(Exception::NeedAttributeTranslator);
-    }
-    return translateUnchecked();
+    return translateUnchecked(::resolveTranslator(translator));
   }
 
   throw Exception(Exception::InvalidValueType,
@@ -594,9 +665,8 @@ ValueLength Slice::getNthOffsetFromCompact(ValueLength index) const {
 // perform a linear search for the specified attribute inside an Object
 Slice Slice::searchObjectKeyLinear(StringRef const& attribute,
                                    ValueLength ieBase, ValueLength offsetSize,
-                                   ValueLength n) const {
-  bool const useTranslator = (Options::Defaults.attributeTranslator != nullptr);
-
+                                   ValueLength n,
+                                   AttributeTranslator const* translator) const {
   for (ValueLength index = 0; index < n; ++index) {
     ValueLength offset = ieBase + index * offsetSize;
     Slice key(start() + readIntegerNonEmpty<ValueLength>(start() + offset, offsetSize));
@@ -607,11 +677,8 @@ Slice Slice::searchObjectKeyLinear(StringRef const& attribute,
       } 
     } else if (key.isSmallInt() || key.isUInt()) {
       // translate key
-      if (VELOCYPACK_UNLIKELY(!useTranslator)) {
-        // no attribute translator
-        throw Exception(Exception::NeedAttributeTranslator);
-      }
-      if (!key.translateUnchecked().isEqualString(attribute)) {
+      translator = ::resolveTranslator(translator);
+      if (!key.translateUnchecked(translator).isEqualString(attribute)) {
         continue;
       }
     } else {
@@ -631,8 +698,8 @@ Slice Slice::searchObjectKeyLinear(StringRef const& attribute,
 template<ValueLength offsetSize>
 Slice Slice::searchObjectKeyBinary(StringRef const& attribute,
                                    ValueLength ieBase,
-                                   ValueLength n) const {
-  bool const useTranslator = (Options::Defaults.attributeTranslator != nullptr);
+                                   ValueLength n,
+                                   AttributeTranslator const* translator) const {
   VELOCYPACK_ASSERT(n > 0);
 
   int64_t l = 0;
@@ -649,11 +716,8 @@ Slice Slice::searchObjectKeyBinary(StringRef const& attribute,
     } else {
       VELOCYPACK_ASSERT(key.isSmallInt() || key.isUInt());
       // translate key
-      if (VELOCYPACK_UNLIKELY(!useTranslator)) {
-        // no attribute translator
-        throw Exception(Exception::NeedAttributeTranslator);
-      }
-      res = key.translateUnchecked().compareString(attribute);
+      translator = ::resolveTranslator(translator);
+      res = key.translateUnchecked(translator).compareString(attribute);
     }
 
     if (res > 0) {
@@ -674,10 +738,10 @@ Slice Slice::searchObjectKeyBinary(StringRef const& attribute,
 }
 
 // template instanciations for searchObjectKeyBinary
-template Slice Slice::searchObjectKeyBinary<1>(StringRef const& attribute, ValueLength ieBase, ValueLength n) const;
-template Slice Slice::searchObjectKeyBinary<2>(StringRef const& attribute, ValueLength ieBase, ValueLength n) const;
-template Slice Slice::searchObjectKeyBinary<4>(StringRef const& attribute, ValueLength ieBase, ValueLength n) const;
-template Slice Slice::searchObjectKeyBinary<8>(StringRef const& attribute, ValueLength ieBase, ValueLength n) const;
+template Slice Slice::searchObjectKeyBinary<1>(StringRef const& attribute, ValueLength ieBase, ValueLength n, AttributeTranslator const* translator) const;
+template Slice Slice::searchObjectKeyBinary<2>(StringRef const& attribute, ValueLength ieBase, ValueLength n, AttributeTranslator const* translator) const;
+template Slice Slice::searchObjectKeyBinary<4>(StringRef const& attribute, ValueLength ieBase, ValueLength n, AttributeTranslator const* translator) const;
+template Slice Slice::searchObjectKeyBinary<8>(StringRef const& attribute, ValueLength ieBase, ValueLength n, AttributeTranslator const* translator) const;
 
 std::ostream& operator<<(std::ostream& stream, Slice const* slice) {
   stream << "[Slice " << valueTypeName(slice->type()) << " ("
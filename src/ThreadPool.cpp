@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <atomic>
+
+#include "velocypack/ThreadPool.h"
+
+using namespace arangodb::velocypack;
+
+namespace {
+
+// the pool whose task the current thread is executing, if any
+thread_local ThreadPool const* currentPool = nullptr;
+
+// sets currentPool for the lifetime of the object
+class CurrentPoolScope {
+ public:
+  explicit CurrentPoolScope(ThreadPool const* pool) noexcept : _previous(currentPool) {
+    currentPool = pool;
+  }
+  ~CurrentPoolScope() { currentPool = _previous; }
+
+ private:
+  ThreadPool const* _previous;
+};
+
+}  // namespace
+
+// one call to run(). lives on the stack of run(), which does not return
+// before all workers have stopped using it
+struct ThreadPool::Batch {
+  Batch(std::size_t numTasks, std::function<void(std::size_t)> const& cb)
+      : cb(cb), numTasks(numTasks), next(0), active(0), errors(numTasks) {}
+
+  std::function<void(std::size_t)> const& cb;
+  std::size_t const numTasks;
+  std::atomic<std::size_t> next;
+  // number of workers working on the batch, protected by the pool's mutex
+  std::size_t active;
+  std::vector<std::exception_ptr> errors;
+};
+
+ThreadPool::ThreadPool(std::size_t numThreads)
+    : _size((std::max)(numThreads, std::size_t(1))),
+      _batch(nullptr),
+      _generation(0),
+      _stop(false) {}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (auto& worker : _workers) {
+    worker.join();
+  }
+}
+
+std::vector<std::exception_ptr> ThreadPool::run(std::size_t numTasks,
+                                                std::function<void(std::size_t)> const& cb) {
+  Batch batch(numTasks, cb);
+  if (numTasks <= 1 || _size == 1 || currentPool == this) {
+    // nothing to distribute, or called from within one of our own tasks,
+    // whose batch would never finish if we waited for it
+    work(batch);
+    return std::move(batch.errors);
+  }
+
+  std::lock_guard<std::mutex> runGuard(_runMutex);
+  startWorkers();
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _batch = &batch;
+    ++_generation;
+  }
+  _wake.notify_all();
+
+  work(batch);
+
+  // all tasks have been taken. wait for the workers still executing some
+  std::unique_lock<std::mutex> lock(_mutex);
+  _batch = nullptr;
+  _done.wait(lock, [&batch]() { return batch.active == 0; });
+  return std::move(batch.errors);
+}
+
+void ThreadPool::startWorkers() {
+  if (!_workers.empty()) {
+    return;
+  }
+  _workers.reserve(_size - 1);
+  try {
+    while (_workers.size() < _size - 1) {
+      _workers.emplace_back([this]() { workerLoop(); });
+    }
+  } catch (...) {
+    // cannot start any more threads. the calling thread of run() takes
+    // all tasks the workers do not take
+  }
+}
+
+void ThreadPool::workerLoop() {
+  uint64_t seen = 0;
+  while (true) {
+    Batch* batch;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _wake.wait(lock, [this, &seen]() { return _stop || _generation != seen; });
+      if (_stop) {
+        return;
+      }
+      seen = _generation;
+      batch = _batch;
+      if (batch == nullptr) {
+        // the batch was finished before we woke up
+        continue;
+      }
+      ++batch->active;
+    }
+
+    work(*batch);
+
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      --batch->active;
+    }
+    _done.notify_all();
+  }
+}
+
+void ThreadPool::work(Batch& batch) {
+  CurrentPoolScope scope(this);
+  while (true) {
+    std::size_t const task = batch.next.fetch_add(1);
+    if (task >= batch.numTasks) {
+      return;
+    }
+    try {
+      batch.cb(task);
+    } catch (...) {
+      batch.errors[task] = std::current_exception();
+    }
+  }
+}
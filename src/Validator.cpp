@@ -22,22 +22,29 @@
 /// @author Jan Steemann
 ////////////////////////////////////////////////////////////////////////////////
 
-#include <unordered_set>
+#include <algorithm>
+#include <exception>
+#include <limits>
 #include <memory>
+#include <unordered_set>
+#include <vector>
 
 #include "velocypack/velocypack-common.h"
 #include "velocypack/Validator.h"
 #include "velocypack/Exception.h"
 #include "velocypack/Slice.h"
+#include "velocypack/SliceStaticData.h"
 #include "velocypack/ValueType.h"
 
 #include "asm-functions.h"
+#include "parallel.h"
 
 using namespace arangodb::velocypack;
 
+// returns false if the value is not terminated before end
 template<bool reverse>
-static ValueLength ReadVariableLengthValue(uint8_t const*& p, uint8_t const* end) {
-  ValueLength value = 0;
+static bool ReadVariableLengthValue(uint8_t const*& p, uint8_t const* end, ValueLength& value) {
+  value = 0;
   ValueLength shifter = 0;
   while (true) {
     uint8_t c = *p;
@@ -52,22 +59,137 @@ static ValueLength ReadVariableLengthValue(uint8_t const*& p, uint8_t const* end
       break;
     }
     if (p == end) {
-      throw Exception(Exception::ValidatorInvalidLength, "Compound value length value is out of bounds");
+      return false;
+    }
+  }
+  return true;
+}
+  
+namespace {
+
+// determines the byte size of the value starting at p from its first
+// available bytes. returns false if more bytes are needed to do so
+bool peekByteSize(uint8_t const* p, std::size_t available, ValueLength& size) {
+  VELOCYPACK_ASSERT(available > 0);
+  uint8_t const head = *p;
+  std::size_t needed;
+  
+  if (SliceStaticData::FixedTypeLengths[head] != 0) {
+    needed = 1;
+  } else if ((head >= 0x02U && head <= 0x09U) || (head >= 0x0bU && head <= 0x12U)) {
+    needed = 1 + SliceStaticData::WidthMap[head];
+  } else if (head == 0x13U || head == 0x14U) {
+    // variable-length byte size, last byte has the high bit cleared
+    needed = 1;
+    do {
+      if (needed >= available) {
+        return false;
+      }
+      if (needed > 8) {
+        throw Exception(Exception::ValidatorInvalidLength, "Compound value length value is out of bounds");
+      }
+    } while (p[needed++] & 0x80U);
+  } else if (head == 0xbfU) {
+    needed = 1 + 8;
+  } else if (head >= 0xc0U && head <= 0xc7U) {
+    needed = 1 + head - 0xbfU;
+  } else if (head >= 0xc8U && head <= 0xcfU) {
+    needed = 1 + head - 0xc7U;
+  } else if (head >= 0xd0U && head <= 0xd7U) {
+    needed = 1 + head - 0xcfU;
+  } else if (head == 0xeeU || head == 0xefU) {
+    // tag, followed by the actual value
+    std::size_t const offset = (head == 0xeeU) ? 1 + 1 : 1 + 8;
+    if (available <= offset) {
+      return false;
+    }
+    if (!peekByteSize(p + offset, available - offset, size)) {
+      return false;
     }
+    size += offset;
+    return true;
+  } else if (head >= 0xf4U) {
+    needed = 1 + (1ULL << ((head - 0xf4U) / 3));
+  } else {
+    throw Exception(Exception::ValidatorInvalidType);
+  }
+
+  if (available < needed) {
+    return false;
   }
-  return value;
+  size = Slice(p).byteSize();
+  return true;
 }
+
+} // namespace
   
 Validator::Validator(Options const* options)
-      : options(options), _level(0) {
+      : options(options),
+        minMembersPerThread(10000),
+        _level(0),
+        _base(nullptr),
+        _errorCode(Exception::UnknownError),
+        _errorMessage(nullptr),
+        _errorPtr(nullptr) {
   if (options == nullptr) {
     throw Exception(Exception::InternalError, "Options cannot be a nullptr");
   }
 }
 
 bool Validator::validate(uint8_t const* ptr, std::size_t length, bool isSubPart) {
+  begin(ptr);
+  validateValue(ptr, length, isSubPart);
+  throwIfFailed();
+  return true;
+}
+
+bool Validator::validateParallel(uint8_t const* ptr, std::size_t length, 
+                                 std::size_t numThreads, bool isSubPart) {
+  ThreadPool pool(numThreads);
+  return validateParallel(ptr, length, pool, isSubPart);
+}
+
+bool Validator::validateParallel(uint8_t const* ptr, std::size_t length, 
+                                 ThreadPool& pool, bool isSubPart) {
+  begin(ptr);
+  validateValueParallel(ptr, length, pool, isSubPart);
+  throwIfFailed();
+  return true;
+}
+
+Status Validator::tryValidate(uint8_t const* ptr, std::size_t length, bool isSubPart) {
+  begin(ptr);
+  try {
+    validateValue(ptr, length, isSubPart);
+  } catch (Exception const& ex) {
+    // the checks themselves never throw, but the Slice methods used on
+    // values that are not validated, such as the values of tags, may
+    return Status(ex.errorCode(), ex.what(), 0);
+  }
+  return status();
+}
+
+Status Validator::tryValidateParallel(uint8_t const* ptr, std::size_t length,
+                                      std::size_t numThreads, bool isSubPart) {
+  ThreadPool pool(numThreads);
+  return tryValidateParallel(ptr, length, pool, isSubPart);
+}
+
+Status Validator::tryValidateParallel(uint8_t const* ptr, std::size_t length,
+                                      ThreadPool& pool, bool isSubPart) {
+  begin(ptr);
+  try {
+    validateValueParallel(ptr, length, pool, isSubPart);
+  } catch (Exception const& ex) {
+    return Status(ex.errorCode(), ex.what(), 0);
+  }
+  return status();
+}
+
+void Validator::validateValue(uint8_t const* ptr, std::size_t length, bool isSubPart) {
   if (length == 0) {
-    throw Exception(Exception::ValidatorInvalidLength, "length 0 is invalid for any VelocyPack value");
+    fail(ptr, Exception::ValidatorInvalidLength, "length 0 is invalid for any VelocyPack value");
+    return;
   }
 
   uint8_t const head = *ptr;
@@ -77,7 +199,8 @@ bool Validator::validate(uint8_t const* ptr, std::size_t length, bool isSubPart)
 
   if (type == ValueType::None && head != 0x00U) {
     // invalid type
-    throw Exception(Exception::ValidatorInvalidType);
+    fail(ptr, Exception::ValidatorInvalidType);
+    return;
   }
 
   // special handling for certain types...
@@ -103,19 +226,26 @@ bool Validator::validate(uint8_t const* ptr, std::size_t length, bool isSubPart)
       if (head == 0xbfU) {
         // long UTF-8 string. must be at least 9 bytes long so we
         // can read the entire string length safely
-        validateBufferLength(1 + 8, length, true);
+        if (!validateBufferLength(ptr, 1 + 8, length, true)) {
+          return;
+        }
         len = readIntegerFixed<ValueLength, 8>(ptr + 1);
         p = ptr + 1 + 8;
-        validateBufferLength(len + 1 + 8, length, true);
+        if (!validateBufferLength(ptr, len + 1 + 8, length, true)) {
+          return;
+        }
       } else {
         len = head - 0x40U;
         p = ptr + 1;
-        validateBufferLength(len + 1, length, true);
+        if (!validateBufferLength(ptr, len + 1, length, true)) {
+          return;
+        }
       }
 
       if (options->validateUtf8Strings &&
           !ValidateUtf8String(p, static_cast<std::size_t>(len))) {
-        throw Exception(Exception::InvalidUtf8Sequence);
+        fail(ptr, Exception::InvalidUtf8Sequence);
+        return;
       }
       break;
     }
@@ -124,6 +254,9 @@ bool Validator::validate(uint8_t const* ptr, std::size_t length, bool isSubPart)
       ++_level;
       validateArray(ptr, length);
       --_level;
+      if (failed()) {
+        return;
+      }
       break;
     }
 
@@ -131,36 +264,47 @@ bool Validator::validate(uint8_t const* ptr, std::size_t length, bool isSubPart)
       ++_level;
       validateObject(ptr, length);
       --_level;
+      if (failed()) {
+        return;
+      }
       break;
     }
 
     case ValueType::BCD: {
       if (options->disallowBCD) {
-        throw Exception(Exception::BuilderBCDDisallowed);
+        fail(ptr, Exception::BuilderBCDDisallowed);
+        return;
       }
-      throw Exception(Exception::NotImplemented);
+      fail(ptr, Exception::NotImplemented);
+      return;
     }
     
     case ValueType::Tagged: {
       if (options->disallowTags) {
-        throw Exception(Exception::BuilderTagsDisallowed);
+        fail(ptr, Exception::BuilderTagsDisallowed);
+        return;
       }
       if (head == 0xee) {
         // 1 byte tag type
         // the actual Slice (without tag) must be at least one byte long
-        validateBufferLength(1 + 1 + 1, length, true);
+        if (!validateBufferLength(ptr, 1 + 1 + 1, length, true)) {
+          return;
+        }
         VELOCYPACK_ASSERT(length > 2);
         ptr += 2;
         length -= 2;
       } else if (head == 0xef) {
         // 8 bytes tag type
         // the actual Slice (without tag) must be at least one byte long
-        validateBufferLength(1 + 8 + 1, length, true);
+        if (!validateBufferLength(ptr, 1 + 8 + 1, length, true)) {
+          return;
+        }
         VELOCYPACK_ASSERT(length > 9);
         ptr += 9;
         length -= 9;
       } else {
-        throw Exception(Exception::NotImplemented);
+        fail(ptr, Exception::NotImplemented);
+        return;
       }
       break;
     }
@@ -168,10 +312,13 @@ bool Validator::validate(uint8_t const* ptr, std::size_t length, bool isSubPart)
     case ValueType::External: {
       // check if Externals are forbidden
       if (options->disallowExternals) {
-        throw Exception(Exception::BuilderExternalsDisallowed);
+        fail(ptr, Exception::BuilderExternalsDisallowed);
+        return;
       }
       // validate if Slice length exceeds the given buffer
-      validateBufferLength(1 + sizeof(void*), length, true);
+      if (!validateBufferLength(ptr, 1 + sizeof(void*), length, true)) {
+        return;
+      }
       // do not perform pointer validation
       break;
     }
@@ -187,40 +334,57 @@ bool Validator::validate(uint8_t const* ptr, std::size_t length, bool isSubPart)
         byteSize = 1 + 4;
       } else if (head == 0xf3U) {
         byteSize = 1 + 8;
-      } else if (head >= 0xf4U && head <= 0xf6U) {
-        validateBufferLength(1 + 1, length, true);
-        byteSize = 1 + 1 + readIntegerNonEmpty<ValueLength>(ptr + 1, 1);
-        if (byteSize == 1 + 1) {
-          throw Exception(Exception::ValidatorInvalidLength, "Invalid size for Custom type");
-        }
-      } else if (head >= 0xf7U && head <= 0xf9U) {
-        validateBufferLength(1 + 2, length, true);
-        byteSize = 1 + 2 + readIntegerNonEmpty<ValueLength>(ptr + 1, 2);
-        if (byteSize == 1 + 2) {
-          throw Exception(Exception::ValidatorInvalidLength, "Invalid size for Custom type");
-        }
-      } else if (head >= 0xfaU && head <= 0xfcU) {
-        validateBufferLength(1 + 4, length, true);
-        byteSize = 1 + 4 + readIntegerNonEmpty<ValueLength>(ptr + 1, 4);
-        if (byteSize == 1 + 4) {
-          throw Exception(Exception::ValidatorInvalidLength, "Invalid size for Custom type");
+      } else {
+        // 1, 2, 4 or 8 bytes of length
+        ValueLength const lengthSize = 1ULL << ((head - 0xf4U) / 3);
+        if (!validateBufferLength(ptr, 1 + lengthSize, length, true)) {
+          return;
         }
-      } else if (head >= 0xfdU) {
-        validateBufferLength(1 + 8, length, true);
-        byteSize = 1 + 8 + readIntegerNonEmpty<ValueLength>(ptr + 1, 8);
-        if (byteSize == 1 + 8) {
-          throw Exception(Exception::ValidatorInvalidLength, "Invalid size for Custom type");
+        byteSize = 1 + lengthSize + readIntegerNonEmpty<ValueLength>(ptr + 1, lengthSize);
+        if (byteSize == 1 + lengthSize) {
+          fail(ptr, Exception::ValidatorInvalidLength, "Invalid size for Custom type");
+          return;
         }
       }
 
-      validateSliceLength(ptr, byteSize, isSubPart);
+      if (!validateSliceLength(ptr, byteSize, isSubPart)) {
+        return;
+      }
       break;
     }
   }
 
   // common validation that must happen for all types
   validateSliceLength(ptr, length, isSubPart);
-  return true;
+}
+
+void Validator::validateValueParallel(uint8_t const* ptr, std::size_t length,
+                                      ThreadPool& pool, bool isSubPart) {
+  if (pool.size() <= 1 || length == 0) {
+    validateValue(ptr, length, isSubPart);
+    return;
+  }
+
+  uint8_t const head = *ptr;
+  if (head >= 0x06U && head <= 0x09U) {
+    ++_level;
+    validateIndexedArrayParallel(ptr, length, pool);
+    --_level;
+  } else if (head >= 0x0bU && head <= 0x12U) {
+    ++_level;
+    validateIndexedObjectParallel(ptr, length, pool);
+    --_level;
+  } else {
+    // no index table to split the work by
+    validateValue(ptr, length, isSubPart);
+    return;
+  }
+  if (failed()) {
+    return;
+  }
+
+  // common validation that must happen for all types
+  validateSliceLength(ptr, length, isSubPart);
 }
 
 void Validator::validateArray(uint8_t const* ptr, std::size_t length) {
@@ -242,21 +406,33 @@ void Validator::validateArray(uint8_t const* ptr, std::size_t length) {
 
 void Validator::validateCompactArray(uint8_t const* ptr, std::size_t length) {
   // compact Array without index table
-  validateBufferLength(4, length, true);
+  if (!validateBufferLength(ptr, 4, length, true)) {
+    return;
+  }
 
   uint8_t const* p = ptr + 1;
   // read byteLength
-  ValueLength const byteSize = ReadVariableLengthValue<false>(p, p + length);
+  ValueLength byteSize;
+  if (!ReadVariableLengthValue<false>(p, p + length, byteSize)) {
+    fail(ptr, Exception::ValidatorInvalidLength, "Compound value length value is out of bounds");
+    return;
+  }
   if (byteSize > length || byteSize < 4) {
-    throw Exception(Exception::ValidatorInvalidLength, "Array length value is out of bounds");
+    fail(ptr, Exception::ValidatorInvalidLength, "Array length value is out of bounds");
+    return;
   }
 
   // read nrItems
   uint8_t const* data = p;
   p = ptr + byteSize - 1;
-  ValueLength nrItems = ReadVariableLengthValue<true>(p, ptr + byteSize);
+  ValueLength nrItems;
+  if (!ReadVariableLengthValue<true>(p, ptr + byteSize, nrItems)) {
+    fail(ptr, Exception::ValidatorInvalidLength, "Compound value length value is out of bounds");
+    return;
+  }
   if (nrItems == 0) {
-    throw Exception(Exception::ValidatorInvalidLength, "Array length value is out of bounds");
+    fail(ptr, Exception::ValidatorInvalidLength, "Array length value is out of bounds");
+    return;
   }
   ++p;
 
@@ -264,7 +440,10 @@ void Validator::validateCompactArray(uint8_t const* ptr, std::size_t length) {
   uint8_t const* e = p;
   p = data;
   while (nrItems-- > 0) {
-    validate(p, e - p, true);
+    validateValue(p, e - p, true);
+    if (failed()) {
+      return;
+    }
     p += Slice(p).byteSize();
   }
 }
@@ -273,11 +452,14 @@ void Validator::validateUnindexedArray(uint8_t const* ptr, std::size_t length) {
   // Array without index table, with 1-8 bytes lengths, all values with same length
   uint8_t head = *ptr;
   ValueLength const byteSizeLength = 1ULL << (static_cast<ValueLength>(head) - 0x02U);
-  validateBufferLength(1 + byteSizeLength + 1, length, true);
+  if (!validateBufferLength(ptr, 1 + byteSizeLength + 1, length, true)) {
+    return;
+  }
   ValueLength const byteSize = readIntegerNonEmpty<ValueLength>(ptr + 1, byteSizeLength);
 
   if (byteSize > length) {
-    throw Exception(Exception::ValidatorInvalidLength, "Array length is out of bounds");
+    fail(ptr, Exception::ValidatorInvalidLength, "Array length is out of bounds");
+    return;
   }
 
   // look up first member
@@ -292,24 +474,31 @@ void Validator::validateUnindexedArray(uint8_t const* ptr, std::size_t length) {
   }
 
   if (p >= ptr + byteSize) {
-    throw Exception(Exception::ValidatorInvalidLength, "Array structure is invalid");
+    fail(ptr, Exception::ValidatorInvalidLength, "Array structure is invalid");
+    return;
   }
 
   // check if padding is correct
   if (p != ptr + 1 + byteSizeLength &&
       p != ptr + 1 + byteSizeLength + (8 - byteSizeLength)) {
-    throw Exception(Exception::ValidatorInvalidLength, "Array padding is invalid");
+    fail(ptr, Exception::ValidatorInvalidLength, "Array padding is invalid");
+    return;
   }
   
-  validate(p, length - (p - ptr), true);
+  validateValue(p, length - (p - ptr), true);
+  if (failed()) {
+    return;
+  }
   ValueLength itemSize = Slice(p).byteSize();
   if (itemSize == 0) {
-    throw Exception(Exception::ValidatorInvalidLength, "Array itemSize value is invalid");
+    fail(p, Exception::ValidatorInvalidLength, "Array itemSize value is invalid");
+    return;
   }
   ValueLength nrItems = (byteSize - (p - ptr)) / itemSize;
 
   if (nrItems == 0) {
-    throw Exception(Exception::ValidatorInvalidLength, "Array nrItems value is invalid");
+    fail(ptr, Exception::ValidatorInvalidLength, "Array nrItems value is invalid");
+    return;
   }
   // we already validated p, so move it forward
   p += itemSize;
@@ -318,13 +507,18 @@ void Validator::validateUnindexedArray(uint8_t const* ptr, std::size_t length) {
 
   while (nrItems > 0) {
     if (p >= e) {
-      throw Exception(Exception::ValidatorInvalidLength, "Array value is out of bounds");
+      fail(ptr, Exception::ValidatorInvalidLength, "Array value is out of bounds");
+      return;
     }
     // validate sub value
-    validate(p, e - p, true);
+    validateValue(p, e - p, true);
+    if (failed()) {
+      return;
+    }
     if (Slice(p).byteSize() != itemSize) {
       // got a sub-object with a different size. this is not allowed
-      throw Exception(Exception::ValidatorInvalidLength, "Unexpected Array value length");
+      fail(p, Exception::ValidatorInvalidLength, "Unexpected Array value length");
+      return;
     }
     p += itemSize;
     --nrItems;
@@ -332,14 +526,25 @@ void Validator::validateUnindexedArray(uint8_t const* ptr, std::size_t length) {
 }
 
 void Validator::validateIndexedArray(uint8_t const* ptr, std::size_t length) {
+  IndexedLayout const layout = validateIndexedArrayLayout(ptr, length);
+  if (failed()) {
+    return;
+  }
+  validateIndexedArrayMembers(ptr, layout, layout.firstMember, 0, layout.nrItems, true);
+}
+
+Validator::IndexedLayout Validator::validateIndexedArrayLayout(uint8_t const* ptr, std::size_t length) {
   // Array with index table, with 1-8 bytes lengths
   uint8_t head = *ptr;
   ValueLength const byteSizeLength = 1ULL << (static_cast<ValueLength>(head) - 0x06U);
-  validateBufferLength(1 + byteSizeLength + byteSizeLength + 1, length, true);
+  if (!validateBufferLength(ptr, 1 + byteSizeLength + byteSizeLength + 1, length, true)) {
+    return IndexedLayout();
+  }
   ValueLength byteSize = readIntegerNonEmpty<ValueLength>(ptr + 1, byteSizeLength);
 
   if (byteSize > length) {
-    throw Exception(Exception::ValidatorInvalidLength, "Array length is out of bounds");
+    fail(ptr, Exception::ValidatorInvalidLength, "Array length is out of bounds");
+    return IndexedLayout();
   }
 
   ValueLength nrItems;
@@ -351,12 +556,14 @@ void Validator::validateIndexedArray(uint8_t const* ptr, std::size_t length) {
     nrItems = readIntegerNonEmpty<ValueLength>(ptr + byteSize - byteSizeLength, byteSizeLength);
 
     if (nrItems == 0) {
-      throw Exception(Exception::ValidatorInvalidLength, "Array nrItems value is invalid");
+      fail(ptr, Exception::ValidatorInvalidLength, "Array nrItems value is invalid");
+      return IndexedLayout();
     }
 
     indexTable = ptr + byteSize - byteSizeLength - (nrItems * byteSizeLength);
     if (indexTable < ptr + byteSizeLength) {
-      throw Exception(Exception::ValidatorInvalidLength, "Array index table is out of bounds");
+      fail(ptr, Exception::ValidatorInvalidLength, "Array index table is out of bounds");
+      return IndexedLayout();
     }
     
     firstMember = ptr + 1 + byteSizeLength; 
@@ -365,7 +572,8 @@ void Validator::validateIndexedArray(uint8_t const* ptr, std::size_t length) {
     nrItems = readIntegerNonEmpty<ValueLength>(ptr + 1 + byteSizeLength, byteSizeLength);
 
     if (nrItems == 0) {
-      throw Exception(Exception::ValidatorInvalidLength, "Array nrItems value is invalid");
+      fail(ptr, Exception::ValidatorInvalidLength, "Array nrItems value is invalid");
+      return IndexedLayout();
     }
 
     // look up first member
@@ -381,35 +589,127 @@ void Validator::validateIndexedArray(uint8_t const* ptr, std::size_t length) {
     // check if padding is correct
     if (p != ptr + 1 + byteSizeLength + byteSizeLength &&
         p != ptr + 1 + byteSizeLength + byteSizeLength + (8 - byteSizeLength - byteSizeLength)) {
-      throw Exception(Exception::ValidatorInvalidLength, "Array padding is invalid");
+      fail(ptr, Exception::ValidatorInvalidLength, "Array padding is invalid");
+      return IndexedLayout();
     }
   
     indexTable = ptr + byteSize - (nrItems * byteSizeLength);
     if (indexTable < ptr + byteSizeLength + byteSizeLength || indexTable < p) {
-      throw Exception(Exception::ValidatorInvalidLength, "Array index table is out of bounds");
+      fail(ptr, Exception::ValidatorInvalidLength, "Array index table is out of bounds");
+      return IndexedLayout();
     }
 
     firstMember = p;
   }
    
   VELOCYPACK_ASSERT(nrItems > 0); 
-  
-  ValueLength actualNrItems = 0;
-  uint8_t const* member = firstMember;
+
+  IndexedLayout layout;
+  layout.indexTable = indexTable;
+  layout.firstMember = firstMember;
+  layout.byteSizeLength = byteSizeLength;
+  layout.nrItems = nrItems;
+  return layout;
+}
+
+// validates the members of an indexed Array, starting with the member at
+// the given position. if isLast is false, returns as soon as the member
+// at position stopAt is reached, otherwise continues up to the index table
+uint8_t const* Validator::validateIndexedArrayMembers(uint8_t const* ptr, IndexedLayout const& layout,
+                                                      uint8_t const* member, ValueLength position,
+                                                      ValueLength stopAt, bool isLast) {
+  uint8_t const* indexTable = layout.indexTable;
   while (member < indexTable) {
-    validate(member, indexTable - member, true);
+    if (!isLast && position == stopAt) {
+      return member;
+    }
+    validateValue(member, indexTable - member, true);
+    if (failed()) {
+      return nullptr;
+    }
+    if (position >= layout.nrItems) {
+      fail(member, Exception::ValidatorInvalidLength, "Array has more items than in index");
+      return nullptr;
+    }
     ValueLength offset = readIntegerNonEmpty<ValueLength>(
-        indexTable + actualNrItems * byteSizeLength, byteSizeLength);
+        indexTable + position * layout.byteSizeLength, layout.byteSizeLength);
     if (offset != static_cast<ValueLength>(member - ptr)) {
-      throw Exception(Exception::ValidatorInvalidLength, "Array index table is wrong");
+      fail(member, Exception::ValidatorInvalidLength, "Array index table is wrong");
+      return nullptr;
     }
   
     member += Slice(member).byteSize();
-    ++actualNrItems;
+    ++position;
+  }
+
+  if (position != layout.nrItems) {
+    fail(ptr, Exception::ValidatorInvalidLength, "Array has more items than in index");
+    return nullptr;
+  }
+  return member;
+}
+
+void Validator::validateIndexedArrayParallel(uint8_t const* ptr, std::size_t length, ThreadPool& pool) {
+  IndexedLayout const layout = validateIndexedArrayLayout(ptr, length);
+  if (failed()) {
+    return;
+  }
+  std::size_t const numChunks = parallel::numberOfChunks(layout.nrItems, pool.size(), minMembersPerThread);
+  if (numChunks <= 1) {
+    validateIndexedArrayMembers(ptr, layout, layout.firstMember, 0, layout.nrItems, true);
+    return;
+  }
+
+  // the index table tells us where each range of members starts. 
+  // starts outside of the members area cannot be correct, and the
+  // members of their ranges are not validated
+  std::vector<uint8_t const*> starts(numChunks, nullptr);
+  for (std::size_t chunk = 0; chunk < numChunks; ++chunk) {
+    if (chunk == 0) {
+      starts[chunk] = layout.firstMember;
+      continue;
+    }
+    ValueLength offset = readIntegerNonEmpty<ValueLength>(
+        layout.indexTable + parallel::chunkStart(layout.nrItems, numChunks, chunk) * layout.byteSizeLength, 
+        layout.byteSizeLength);
+    if (offset >= static_cast<ValueLength>(layout.firstMember - ptr) &&
+        offset < static_cast<ValueLength>(layout.indexTable - ptr)) {
+      starts[chunk] = ptr + offset;
+    }
   }
 
-  if (actualNrItems != nrItems) {
-    throw Exception(Exception::ValidatorInvalidLength, "Array has more items than in index");
+  std::vector<uint8_t const*> ends(numChunks, nullptr);
+  std::vector<Validator> validators(numChunks, Validator(options));
+  std::vector<std::exception_ptr> errors = pool.run(numChunks, [&](std::size_t chunk) {
+    if (starts[chunk] == nullptr) {
+      return;
+    }
+    ends[chunk] = validators[chunk].validateIndexedArrayMembers(ptr, layout, starts[chunk], 
+        parallel::chunkStart(layout.nrItems, numChunks, chunk), 
+        parallel::chunkStart(layout.nrItems, numChunks, chunk + 1), chunk == numChunks - 1);
+  });
+
+  // report the errors in the order the single-threaded validation 
+  // would have encountered them
+  for (std::size_t chunk = 0; chunk < numChunks; ++chunk) {
+    if (errors[chunk] != nullptr) {
+      std::rethrow_exception(errors[chunk]);
+    }
+    if (validators[chunk].failed()) {
+      adoptError(validators[chunk]);
+      return;
+    }
+    if (chunk == numChunks - 1) {
+      break;
+    }
+    if (ends[chunk] != starts[chunk + 1]) {
+      // the range ended somewhere else than the index table claims the
+      // next range starts. continue from there as validate() would,
+      // which will produce the appropriate error
+      validateIndexedArrayMembers(ptr, layout, ends[chunk], 
+          parallel::chunkStart(layout.nrItems, numChunks, chunk + 1), layout.nrItems, true);
+      return;
+    }
   }
 }
 
@@ -429,21 +729,33 @@ void Validator::validateObject(uint8_t const* ptr, std::size_t length) {
 
 void Validator::validateCompactObject(uint8_t const* ptr, std::size_t length) {
   // compact Object without index table
-  validateBufferLength(5, length, true);
+  if (!validateBufferLength(ptr, 5, length, true)) {
+    return;
+  }
 
   uint8_t const* p = ptr + 1;
   // read byteLength
-  ValueLength const byteSize = ReadVariableLengthValue<false>(p, p + length);
+  ValueLength byteSize;
+  if (!ReadVariableLengthValue<false>(p, p + length, byteSize)) {
+    fail(ptr, Exception::ValidatorInvalidLength, "Compound value length value is out of bounds");
+    return;
+  }
   if (byteSize > length || byteSize < 5) {
-    throw Exception(Exception::ValidatorInvalidLength, "Object length value is out of bounds");
+    fail(ptr, Exception::ValidatorInvalidLength, "Object length value is out of bounds");
+    return;
   }
 
   // read nrItems
   uint8_t const* data = p;
   p = ptr + byteSize - 1;
-  ValueLength nrItems = ReadVariableLengthValue<true>(p, ptr + byteSize);
+  ValueLength nrItems;
+  if (!ReadVariableLengthValue<true>(p, ptr + byteSize, nrItems)) {
+    fail(ptr, Exception::ValidatorInvalidLength, "Compound value length value is out of bounds");
+    return;
+  }
   if (nrItems == 0) {
-    throw Exception(Exception::ValidatorInvalidLength, "Object length value is out of bounds");
+    fail(ptr, Exception::ValidatorInvalidLength, "Object length value is out of bounds");
+    return;
   }
   ++p;
 
@@ -452,42 +764,55 @@ void Validator::validateCompactObject(uint8_t const* ptr, std::size_t length) {
   p = data;
   while (nrItems-- > 0) {
     // validate key
-    validate(p, e - p, true);
+    validateValue(p, e - p, true);
+    if (failed()) {
+      return;
+    }
     Slice key(p);
     bool isString = key.isString();
     if (!isString) {
       bool const isSmallInt = key.isSmallInt();
       if ((!isSmallInt && !key.isUInt()) || (isSmallInt && key.getSmallInt() <= 0)) {
-        throw Exception(Exception::ValidatorInvalidLength, "Invalid object key type");
+        fail(p, Exception::ValidatorInvalidLength, "Invalid object key type");
+        return;
       }
     }
     ValueLength keySize = key.byteSize();
     // validate key
     if (isString && options->validateUtf8Strings) {
-      validate(p, keySize, true);
+      validateValue(p, keySize, true);
+      if (failed()) {
+        return;
+      }
     }
 
     // validate value
     p += keySize;
-    validate(p, e - p, true);
+    validateValue(p, e - p, true);
+    if (failed()) {
+      return;
+    }
     p += Slice(p).byteSize();
   }
 
   // finally check if we are now pointing at the end or not
   if (p != e) {
-    throw Exception(Exception::ValidatorInvalidLength, "Object has more members than specified");
+    fail(ptr, Exception::ValidatorInvalidLength, "Object has more members than specified");
   }
 }
 
-void Validator::validateIndexedObject(uint8_t const* ptr, std::size_t length) {
+Validator::IndexedLayout Validator::validateIndexedObjectLayout(uint8_t const* ptr, std::size_t length) {
   // Object with index table, with 1-8 bytes lengths
   uint8_t head = *ptr;
   ValueLength const byteSizeLength = 1ULL << (static_cast<ValueLength>(head) - 0x0bU);
-  validateBufferLength(1 + byteSizeLength + byteSizeLength + 1, length, true);
+  if (!validateBufferLength(ptr, 1 + byteSizeLength + byteSizeLength + 1, length, true)) {
+    return IndexedLayout();
+  }
   ValueLength const byteSize = readIntegerNonEmpty<ValueLength>(ptr + 1, byteSizeLength);
 
   if (byteSize > length) {
-    throw Exception(Exception::ValidatorInvalidLength, "Object length is out of bounds");
+    fail(ptr, Exception::ValidatorInvalidLength, "Object length is out of bounds");
+    return IndexedLayout();
   }
 
   ValueLength nrItems;
@@ -500,12 +825,14 @@ void Validator::validateIndexedObject(uint8_t const* ptr, std::size_t length) {
     nrItems = readIntegerNonEmpty<ValueLength>(ptr + byteSize - byteSizeLength, byteSizeLength);
 
     if (nrItems == 0) {
-      throw Exception(Exception::ValidatorInvalidLength, "Object nrItems value is invalid");
+      fail(ptr, Exception::ValidatorInvalidLength, "Object nrItems value is invalid");
+      return IndexedLayout();
     }
 
     indexTable = ptr + byteSize - byteSizeLength - (nrItems * byteSizeLength);
     if (indexTable < ptr + byteSizeLength) {
-      throw Exception(Exception::ValidatorInvalidLength, "Object index table is out of bounds");
+      fail(ptr, Exception::ValidatorInvalidLength, "Object index table is out of bounds");
+      return IndexedLayout();
     }
     
     firstMember = ptr + byteSize;
@@ -514,7 +841,8 @@ void Validator::validateIndexedObject(uint8_t const* ptr, std::size_t length) {
     nrItems = readIntegerNonEmpty<ValueLength>(ptr + 1 + byteSizeLength, byteSizeLength);
 
     if (nrItems == 0) {
-      throw Exception(Exception::ValidatorInvalidLength, "Object nrItems value is invalid");
+      fail(ptr, Exception::ValidatorInvalidLength, "Object nrItems value is invalid");
+      return IndexedLayout();
     }
 
     // look up first member
@@ -530,18 +858,37 @@ void Validator::validateIndexedObject(uint8_t const* ptr, std::size_t length) {
     // check if padding is correct
     if (p != ptr + 1 + byteSizeLength + byteSizeLength &&
         p != ptr + 1 + byteSizeLength + byteSizeLength + (8 - byteSizeLength - byteSizeLength)) {
-      throw Exception(Exception::ValidatorInvalidLength, "Object padding is invalid");
+      fail(ptr, Exception::ValidatorInvalidLength, "Object padding is invalid");
+      return IndexedLayout();
     }
   
     indexTable = ptr + byteSize - (nrItems * byteSizeLength);
     if (indexTable < ptr + byteSizeLength + byteSizeLength || indexTable < p) {
-      throw Exception(Exception::ValidatorInvalidLength, "Object index table is out of bounds");
+      fail(ptr, Exception::ValidatorInvalidLength, "Object index table is out of bounds");
+      return IndexedLayout();
     }
 
     firstMember = p;
   }
 
   VELOCYPACK_ASSERT(nrItems > 0);
+
+  IndexedLayout layout;
+  layout.indexTable = indexTable;
+  layout.firstMember = firstMember;
+  layout.byteSizeLength = byteSizeLength;
+  layout.nrItems = nrItems;
+  return layout;
+}
+
+void Validator::validateIndexedObject(uint8_t const* ptr, std::size_t length) {
+  IndexedLayout const layout = validateIndexedObjectLayout(ptr, length);
+  if (failed()) {
+    return;
+  }
+  ValueLength const nrItems = layout.nrItems;
+  ValueLength const byteSizeLength = layout.byteSizeLength;
+  uint8_t const* indexTable = layout.indexTable;
   
   ValueLength tableBuf[16];    // Fixed space to save offsets found sequentially
   ValueLength* table = tableBuf;
@@ -557,29 +904,17 @@ void Validator::validateIndexedObject(uint8_t const* ptr, std::size_t length) {
     }
   }
   ValueLength actualNrItems = 0;
-  uint8_t const* member = firstMember;
+  uint8_t const* member = layout.firstMember;
   while (member < indexTable) {
-    validate(member, indexTable - member, true);
-
-    Slice key(member);
-    bool const isString = key.isString();
-    if (!isString) {
-      bool const isSmallInt = key.isSmallInt();
-      if ((!isSmallInt && !key.isUInt()) || (isSmallInt && key.getSmallInt() <= 0)) {
-        throw Exception(Exception::ValidatorInvalidLength, "Invalid object key type");
-      }
-    }
-
-    ValueLength const keySize = key.byteSize();
-    if (isString && options->validateUtf8Strings) {
-      validate(member, keySize, true);
+    uint8_t const* next = validateObjectMember(member, indexTable);
+    if (failed()) {
+      return;
     }
 
-    uint8_t const* value = member + keySize;
-    if (value >= indexTable) {
-      throw Exception(Exception::ValidatorInvalidLength, "Object value leaking into index table");
+    if (actualNrItems >= nrItems) {
+      fail(member, Exception::ValidatorInvalidLength, "Object value has more key/value pairs than announced");
+      return;
     }
-    validate(value, indexTable - value, true);
 
     ValueLength offset = static_cast<ValueLength>(member - ptr);
     if (nrItems <= 128) {
@@ -588,16 +923,13 @@ void Validator::validateIndexedObject(uint8_t const* ptr, std::size_t length) {
       offsetSet->emplace(offset);
     }
 
-    member += keySize + Slice(value).byteSize();
+    member = next;
     ++actualNrItems;
-
-    if (actualNrItems > nrItems) {
-      throw Exception(Exception::ValidatorInvalidLength, "Object value has more key/value pairs than announced");
-    }
   }
 
   if (actualNrItems < nrItems) {
-    throw Exception(Exception::ValidatorInvalidLength, "Object has fewer items than in index");
+    fail(ptr, Exception::ValidatorInvalidLength, "Object has fewer items than in index");
+    return;
   }
 
   // Finally verify each offset in the index:
@@ -621,7 +953,8 @@ void Validator::validateIndexedObject(uint8_t const* ptr, std::size_t length) {
         }
       }
       if (!found) {
-        throw Exception(Exception::ValidatorInvalidLength, "Object has invalid index offset");
+        fail(ptr, Exception::ValidatorInvalidLength, "Object has invalid index offset");
+        return;
       }
     }
   } else {
@@ -630,21 +963,268 @@ void Validator::validateIndexedObject(uint8_t const* ptr, std::size_t length) {
           indexTable + pos * byteSizeLength, byteSizeLength);
       auto i = offsetSet->find(offset);
       if (i == offsetSet->end()) {
-        throw Exception(Exception::ValidatorInvalidLength, "Object has invalid index offset");
+        fail(ptr, Exception::ValidatorInvalidLength, "Object has invalid index offset");
+        return;
       }
       offsetSet->erase(i);
     }
   }
 }
 
-void Validator::validateBufferLength(std::size_t expected, std::size_t actual, bool isSubPart) {
+// validates the key and the value of an Object member, and returns 
+// the start of the next member, or nullptr if the member is invalid
+uint8_t const* Validator::validateObjectMember(uint8_t const* member, uint8_t const* indexTable) {
+  validateValue(member, indexTable - member, true);
+  if (failed()) {
+    return nullptr;
+  }
+
+  Slice key(member);
+  bool const isString = key.isString();
+  if (!isString) {
+    bool const isSmallInt = key.isSmallInt();
+    if ((!isSmallInt && !key.isUInt()) || (isSmallInt && key.getSmallInt() <= 0)) {
+      fail(member, Exception::ValidatorInvalidLength, "Invalid object key type");
+      return nullptr;
+    }
+  }
+
+  ValueLength const keySize = key.byteSize();
+  if (isString && options->validateUtf8Strings) {
+    validateValue(member, keySize, true);
+    if (failed()) {
+      return nullptr;
+    }
+  }
+
+  uint8_t const* value = member + keySize;
+  if (value >= indexTable) {
+    fail(member, Exception::ValidatorInvalidLength, "Object value leaking into index table");
+    return nullptr;
+  }
+  validateValue(value, indexTable - value, true);
+  if (failed()) {
+    return nullptr;
+  }
+
+  return value + Slice(value).byteSize();
+}
+
+// validates the members of an indexed Object, starting with the member at
+// the given position, and compares their offsets with the sorted offsets from
+// the index table. if isLast is false, returns as soon as the member at 
+// position stopAt is reached, otherwise continues up to the index table.
+// wrong offsets are not reported right away, because validate() checks
+// the index table only after all members
+uint8_t const* Validator::validateIndexedObjectMembers(uint8_t const* ptr, IndexedLayout const& layout,
+                                                       ValueLength const* offsets, uint8_t const* member, 
+                                                       ValueLength position, ValueLength stopAt, 
+                                                       bool isLast, bool& offsetsMatch) {
+  uint8_t const* indexTable = layout.indexTable;
+  while (member < indexTable) {
+    if (!isLast && position == stopAt) {
+      return member;
+    }
+    uint8_t const* next = validateObjectMember(member, indexTable);
+    if (failed()) {
+      return nullptr;
+    }
+    
+    if (position >= layout.nrItems || offsets[position] != static_cast<ValueLength>(member - ptr)) {
+      offsetsMatch = false;
+    }
+
+    ++position;
+
+    if (position > layout.nrItems) {
+      fail(member, Exception::ValidatorInvalidLength, "Object value has more key/value pairs than announced");
+      return nullptr;
+    }
+    member = next;
+  }
+
+  if (position < layout.nrItems) {
+    fail(ptr, Exception::ValidatorInvalidLength, "Object has fewer items than in index");
+    return nullptr;
+  }
+  return member;
+}
+
+void Validator::validateIndexedObjectParallel(uint8_t const* ptr, std::size_t length, ThreadPool& pool) {
+  IndexedLayout const layout = validateIndexedObjectLayout(ptr, length);
+  if (failed()) {
+    return;
+  }
+  std::size_t const numChunks = parallel::numberOfChunks(layout.nrItems, pool.size(), minMembersPerThread);
+  if (numChunks <= 1 || layout.nrItems <= 128) {
+    // small objects are validated with slightly different rules for
+    // duplicate index entries, so leave them to validateIndexedObject()
+    validateIndexedObject(ptr, length);
+    return;
+  }
+
+  // the index table is sorted by keys, not by offsets. after sorting the 
+  // offsets, they must be identical to the offsets of the members
+  std::vector<ValueLength> offsets;
+  offsets.reserve(checkOverflow(layout.nrItems));
+  for (ValueLength pos = 0; pos < layout.nrItems; ++pos) {
+    offsets.push_back(readIntegerNonEmpty<ValueLength>(
+        layout.indexTable + pos * layout.byteSizeLength, layout.byteSizeLength));
+  }
+  std::sort(offsets.begin(), offsets.end());
+  
+  // starts outside of the members area cannot be correct, and the
+  // members of their ranges are not validated
+  std::vector<uint8_t const*> starts(numChunks, nullptr);
+  for (std::size_t chunk = 0; chunk < numChunks; ++chunk) {
+    if (chunk == 0) {
+      starts[chunk] = layout.firstMember;
+      continue;
+    }
+    ValueLength offset = offsets[checkOverflow(parallel::chunkStart(layout.nrItems, numChunks, chunk))];
+    if (offset >= static_cast<ValueLength>(layout.firstMember - ptr) &&
+        offset < static_cast<ValueLength>(layout.indexTable - ptr)) {
+      starts[chunk] = ptr + offset;
+    }
+  }
+
+  std::vector<uint8_t const*> ends(numChunks, nullptr);
+  std::vector<Validator> validators(numChunks, Validator(options));
+  // std::vector<bool> cannot be written to concurrently
+  std::unique_ptr<bool[]> offsetsMatch(new bool[numChunks]);
+  std::fill(offsetsMatch.get(), offsetsMatch.get() + numChunks, true);
+  std::vector<std::exception_ptr> errors = pool.run(numChunks, [&](std::size_t chunk) {
+    if (starts[chunk] == nullptr) {
+      return;
+    }
+    ends[chunk] = validators[chunk].validateIndexedObjectMembers(ptr, layout, offsets.data(), starts[chunk], 
+        parallel::chunkStart(layout.nrItems, numChunks, chunk), 
+        parallel::chunkStart(layout.nrItems, numChunks, chunk + 1), 
+        chunk == numChunks - 1, offsetsMatch[chunk]);
+  });
+
+  // report the errors in the order the single-threaded validation 
+  // would have encountered them
+  bool allMatch = true;
+  for (std::size_t chunk = 0; chunk < numChunks; ++chunk) {
+    if (errors[chunk] != nullptr) {
+      std::rethrow_exception(errors[chunk]);
+    }
+    if (validators[chunk].failed()) {
+      adoptError(validators[chunk]);
+      return;
+    }
+    allMatch &= offsetsMatch[chunk];
+    if (chunk == numChunks - 1) {
+      break;
+    }
+    if (ends[chunk] != starts[chunk + 1]) {
+      // the range ended somewhere else than the index table claims the
+      // next range starts. continue from there as validate() would
+      allMatch = false;
+      validateIndexedObjectMembers(ptr, layout, offsets.data(), ends[chunk], 
+          parallel::chunkStart(layout.nrItems, numChunks, chunk + 1), layout.nrItems, true, allMatch);
+      if (failed()) {
+        return;
+      }
+      break;
+    }
+  }
+  
+  if (!allMatch) {
+    fail(ptr, Exception::ValidatorInvalidLength, "Object has invalid index offset");
+  }
+}
+
+bool Validator::validateBufferLength(uint8_t const* ptr, std::size_t expected,
+                                     std::size_t actual, bool isSubPart) {
   if ((expected > actual) ||
       (expected != actual && !isSubPart)) {
-    throw Exception(Exception::ValidatorInvalidLength, "given buffer length is unequal to actual length of Slice in buffer");
+    fail(ptr, Exception::ValidatorInvalidLength, "given buffer length is unequal to actual length of Slice in buffer");
+    return false;
   }
+  return true;
 }
 
-void Validator::validateSliceLength(uint8_t const* ptr, std::size_t length, bool isSubPart) {
+bool Validator::validateSliceLength(uint8_t const* ptr, std::size_t length, bool isSubPart) {
   std::size_t actual = static_cast<std::size_t>(Slice(ptr).byteSize());
-  validateBufferLength(actual, length, isSubPart);
+  return validateBufferLength(ptr, actual, length, isSubPart);
+}
+
+StreamValidator::StreamValidator(Options const* options, std::size_t numThreads)
+    : maxValueSize(std::numeric_limits<ValueLength>::max()),
+      _validator(options),
+      _pool(numThreads),
+      _pendingSize(0),
+      _values(0),
+      _bytes(0) {}
+
+std::size_t StreamValidator::feed(uint8_t const* data, std::size_t length) {
+  std::size_t count = 0;
+
+  while (length > 0) {
+    if (_pending.empty()) {
+      ValueLength size;
+      if (::peekByteSize(data, length, size)) {
+        checkValueSize(size);
+        if (size <= length) {
+          // value is complete, validate it in place
+          validateValue(data, size);
+          data += size;
+          length -= static_cast<std::size_t>(size);
+          ++count;
+          continue;
+        }
+      }
+      // value continues in the next piece
+    }
+
+    if (_pendingSize == 0) {
+      // byte size not yet known. collect the header byte by byte
+      _pending.push_back(static_cast<char>(*data));
+      ++data;
+      --length;
+
+      ValueLength size;
+      if (!::peekByteSize(_pending.data(), checkOverflow(_pending.size()), size)) {
+        continue;
+      }
+      checkValueSize(size);
+      _pendingSize = size;
+    }
+
+    VELOCYPACK_ASSERT(_pendingSize >= _pending.size());
+    std::size_t const n = static_cast<std::size_t>(
+        (std::min)(static_cast<ValueLength>(length), _pendingSize - _pending.size()));
+    _pending.append(data, n);
+    data += n;
+    length -= n;
+
+    if (_pending.size() == _pendingSize) {
+      validateValue(_pending.data(), _pendingSize);
+      _pending.clear();
+      _pendingSize = 0;
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+void StreamValidator::finish() const {
+  if (!_pending.empty()) {
+    throw Exception(Exception::ValidatorInvalidLength, "stream ended inside a value");
+  }
+}
+
+void StreamValidator::validateValue(uint8_t const* ptr, ValueLength length) {
+  _validator.validateParallel(ptr, checkOverflow(length), _pool, false);
+  ++_values;
+  _bytes += length;
+}
+
+void StreamValidator::checkValueSize(ValueLength size) const {
+  if (size > maxValueSize) {
+    throw Exception(Exception::ValidatorInvalidLength, "value exceeds maximum size");
+  }
 }
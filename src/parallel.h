@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VELOCYPACK_PARALLEL_H
+#define VELOCYPACK_PARALLEL_H 1
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+#include "velocypack/velocypack-common.h"
+
+namespace arangodb {
+namespace velocypack {
+namespace parallel {
+
+// number of ranges the members of a compound value are split into 
+// for parallel processing
+inline std::size_t numberOfChunks(ValueLength nrItems, std::size_t numThreads, ValueLength minMembersPerThread) {
+  if (minMembersPerThread == 0) {
+    minMembersPerThread = 1;
+  }
+  ValueLength const maxChunks = nrItems / minMembersPerThread;
+  return static_cast<std::size_t>((std::min)(static_cast<ValueLength>(numThreads), maxChunks));
+}
+
+// position of the first member of a range
+inline ValueLength chunkStart(ValueLength nrItems, std::size_t numChunks, std::size_t chunk) {
+  return (nrItems / numChunks) * chunk + (std::min)(static_cast<ValueLength>(chunk), nrItems % numChunks);
+}
+
+// rethrows the exception of the first range that failed, if any
+inline void rethrowFirst(std::vector<std::exception_ptr> const& errors) {
+  for (auto const& error : errors) {
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+}  // namespace arangodb::velocypack::parallel
+}  // namespace arangodb::velocypack
+}  // namespace arangodb
+
+#endif
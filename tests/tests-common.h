@@ -1,22 +1,33 @@
 
 #include "velocypack/velocypack-common.h"
+#include "velocypack/AttributeDictionary.h"
 #include "velocypack/AttributeTranslator.h"
 #include "velocypack/Basics.h"
 #include "velocypack/Buffer.h"
 #include "velocypack/Builder.h"
+#include "velocypack/Cbor.h"
 #include "velocypack/Collection.h"
+#include "velocypack/Columnar.h"
+#include "velocypack/CompactIndex.h"
 #include "velocypack/Compare.h"
+#include "velocypack/Compression.h"
 #include "velocypack/Dumper.h"
 #include "velocypack/Exception.h"
 #include "velocypack/HashedStringRef.h"
 #include "velocypack/HexDump.h"
 #include "velocypack/Iterator.h"
+#include "velocypack/MessagePack.h"
+#include "velocypack/NormalizedHashCache.h"
 #include "velocypack/Options.h"
+#include "velocypack/PackedArrayView.h"
 #include "velocypack/Parser.h"
+#include "velocypack/ShapeRegistry.h"
 #include "velocypack/Sink.h"
 #include "velocypack/Slice.h"
 #include "velocypack/SliceContainer.h"
 #include "velocypack/StringRef.h"
+#include "velocypack/ThreadPool.h"
+#include "velocypack/TrustedSlice.h"
 #include "velocypack/Validator.h"
 #include "velocypack/Value.h"
 #include "velocypack/ValueType.h"
@@ -45,6 +45,9 @@ using VPackSink = arangodb::velocypack::Sink;
 using VPackSlice = arangodb::velocypack::Slice;
 using VPackStringSink = arangodb::velocypack::StringSink;
 using VPackStringStreamSink = arangodb::velocypack::StringStreamSink;
+using VPackTrustedArrayIterator = arangodb::velocypack::TrustedArrayIterator;
+using VPackTrustedObjectIterator = arangodb::velocypack::TrustedObjectIterator;
+using VPackTrustedSlice = arangodb::velocypack::TrustedSlice;
 using VPackValue = arangodb::velocypack::Value;
 using VPackValueLength = arangodb::velocypack::ValueLength;
 using VPackValueType = arangodb::velocypack::ValueType;
@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+
+#include "tests-common.h"
+
+TEST(AttributeDictionaryTest, SaveLoad) {
+  AttributeTranslator translator;
+  translator.add("foo", 1);
+  translator.add("bar", 2);
+  translator.add("baz", 17);
+  translator.seal();
+
+  Builder dictionary = AttributeDictionary::save(translator);
+  Slice s = dictionary.slice();
+  ASSERT_EQ("velocypack-dictionary", s.get("type").copyString());
+  ASSERT_EQ(AttributeDictionary::currentVersion, s.get("version").getUInt());
+  ASSERT_EQ(3U, s.get("keys").length());
+
+  std::unique_ptr<AttributeTranslator> loaded = AttributeDictionary::load(s);
+  ASSERT_EQ(3U, loaded->count());
+  ASSERT_EQ(1U, Slice(loaded->translate("foo")).getUInt());
+  ASSERT_EQ(2U, Slice(loaded->translate("bar")).getUInt());
+  ASSERT_EQ(17U, Slice(loaded->translate("baz")).getUInt());
+  ASSERT_EQ("baz", Slice(loaded->translate(uint64_t(17))).copyString());
+  ASSERT_EQ(nullptr, loaded->translate("qux"));
+}
+
+TEST(AttributeDictionaryTest, SaveEmpty) {
+  AttributeTranslator translator;
+  translator.seal();
+
+  Builder dictionary = AttributeDictionary::save(translator);
+  ASSERT_TRUE(dictionary.slice().get("keys").isEmptyObject());
+
+  std::unique_ptr<AttributeTranslator> loaded =
+      AttributeDictionary::load(dictionary.slice());
+  ASSERT_EQ(0U, loaded->count());
+  ASSERT_EQ(nullptr, loaded->translate("foo"));
+}
+
+TEST(AttributeDictionaryTest, LoadInvalid) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[]");
+  ASSERT_VELOCYPACK_EXCEPTION(AttributeDictionary::load(b->slice()),
+                              Exception::InvalidValueType);
+
+  b = Parser::fromJson("{\"type\":\"something\",\"version\":1,\"keys\":{}}");
+  ASSERT_VELOCYPACK_EXCEPTION(AttributeDictionary::load(b->slice()),
+                              Exception::InvalidValueType);
+
+  b = Parser::fromJson("{\"type\":\"velocypack-dictionary\",\"keys\":{}}");
+  ASSERT_VELOCYPACK_EXCEPTION(AttributeDictionary::load(b->slice()),
+                              Exception::InvalidValueType);
+
+  b = Parser::fromJson("{\"type\":\"velocypack-dictionary\",\"version\":2,\"keys\":{}}");
+  ASSERT_VELOCYPACK_EXCEPTION(AttributeDictionary::load(b->slice()),
+                              Exception::InvalidValueType);
+
+  b = Parser::fromJson("{\"type\":\"velocypack-dictionary\",\"version\":1,\"keys\":[]}");
+  ASSERT_VELOCYPACK_EXCEPTION(AttributeDictionary::load(b->slice()),
+                              Exception::InvalidValueType);
+
+  b = Parser::fromJson("{\"type\":\"velocypack-dictionary\",\"version\":1,\"keys\":{\"a\":\"b\"}}");
+  ASSERT_VELOCYPACK_EXCEPTION(AttributeDictionary::load(b->slice()),
+                              Exception::InvalidValueType);
+}
+
+TEST(AttributeDictionaryTest, TrainerCounts) {
+  AttributeDictionaryTrainer trainer(16);
+  ASSERT_EQ(16U, trainer.capacity());
+  ASSERT_EQ(0U, trainer.size());
+
+  std::shared_ptr<Builder> b = Parser::fromJson(
+      "[{\"name\":1,\"value\":{\"name\":2,\"x\":3}},{\"name\":4,\"value\":[{\"y\":5}]}]");
+  trainer.observe(b->slice());
+
+  ASSERT_EQ(7U, trainer.observed());
+  ASSERT_EQ(4U, trainer.size());
+
+  auto top = trainer.top(2);
+  ASSERT_EQ(2U, top.size());
+  ASSERT_EQ("name", top[0].first);
+  ASSERT_EQ(3U, top[0].second);
+  ASSERT_EQ("value", top[1].first);
+  ASSERT_EQ(2U, top[1].second);
+}
+
+TEST(AttributeDictionaryTest, TrainerBoundedMemory) {
+  AttributeDictionaryTrainer trainer(8);
+
+  // a few frequent names and many rare ones
+  for (int i = 0; i < 1000; ++i) {
+    trainer.observeKey(StringRef("frequent"));
+    if (i % 2 == 0) {
+      trainer.observeKey(StringRef("common"));
+    }
+    trainer.observeKey(StringRef("rare-" + std::to_string(i)));
+  }
+
+  ASSERT_EQ(8U, trainer.size());
+  auto top = trainer.top(2);
+  ASSERT_EQ("frequent", top[0].first);
+  ASSERT_GE(top[0].second, 1000U);
+  ASSERT_EQ("common", top[1].first);
+  ASSERT_GE(top[1].second, 500U);
+}
+
+TEST(AttributeDictionaryTest, Train) {
+  AttributeDictionaryTrainer trainer;
+  std::shared_ptr<Builder> b = Parser::fromJson(
+      "[{\"aa\":1,\"bbb\":2,\"c\":3,\"once\":4},{\"aa\":1,\"bbb\":2,\"c\":3},"
+      "{\"aa\":1}]");
+  trainer.observe(b->slice());
+
+  std::unique_ptr<AttributeTranslator> translator = trainer.train(10);
+  ASSERT_EQ(2U, translator->count());
+  // most frequent name gets the smallest id
+  ASSERT_EQ(1U, Slice(translator->translate("aa")).getUInt());
+  ASSERT_EQ(2U, Slice(translator->translate("bbb")).getUInt());
+  // too short
+  ASSERT_EQ(nullptr, translator->translate("c"));
+  // too rare
+  ASSERT_EQ(nullptr, translator->translate("once"));
+
+  translator = trainer.train(1);
+  ASSERT_EQ(1U, translator->count());
+
+  translator = trainer.train(10, 1, 1);
+  ASSERT_EQ(4U, translator->count());
+}
+
+TEST(AttributeDictionaryTest, TrainIncremental) {
+  AttributeTranslator base;
+  base.add("bbb", 5);
+  base.add("zzz", 7);
+  base.seal();
+
+  AttributeDictionaryTrainer trainer;
+  std::shared_ptr<Builder> b = Parser::fromJson(
+      "[{\"aa\":1,\"bbb\":2},{\"aa\":1,\"bbb\":2},{\"dd\":1},{\"dd\":1}]");
+  trainer.observe(b->slice());
+
+  std::unique_ptr<AttributeTranslator> translator = trainer.train(10, 2, 2, &base);
+  ASSERT_EQ(4U, translator->count());
+  // ids of the base translator are kept
+  ASSERT_EQ(5U, Slice(translator->translate("bbb")).getUInt());
+  ASSERT_EQ(7U, Slice(translator->translate("zzz")).getUInt());
+  // new names get ids above
+  ASSERT_EQ(8U, Slice(translator->translate("aa")).getUInt());
+  ASSERT_EQ(9U, Slice(translator->translate("dd")).getUInt());
+
+  // round trip through the dictionary format
+  Builder dictionary = AttributeDictionary::save(*translator);
+  std::unique_ptr<AttributeTranslator> loaded =
+      AttributeDictionary::load(dictionary.slice());
+  ASSERT_EQ(4U, loaded->count());
+  ASSERT_EQ(9U, Slice(loaded->translate("dd")).getUInt());
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -2220,6 +2220,53 @@ TEST(BuilderTest, CloneDestroyOriginal) {
   ASSERT_EQ("foobarbaz", s.get("baz").copyString());
 }
 
+TEST(BuilderTest, AddPacked) {
+  int64_t const values[] = {1, 2, 3};
+
+  Builder b;
+  b.addPacked(&values[0], 3);
+
+  uint8_t const correctResult[] = {0xee, 0x40, 0xc0, 0x18,
+                                   0x01, 0, 0, 0, 0, 0, 0, 0,
+                                   0x02, 0, 0, 0, 0, 0, 0, 0,
+                                   0x03, 0, 0, 0, 0, 0, 0, 0};
+  ASSERT_EQ(sizeof(correctResult), b.size());
+  ASSERT_EQ(0, memcmp(b.start(), correctResult, sizeof(correctResult)));
+}
+
+TEST(BuilderTest, AddPackedInArrayAndObject) {
+  std::vector<double> values{1.0, 2.5};
+
+  Builder b;
+  b.openArray();
+  b.addPacked(values);
+  b.openObject();
+  b.addPacked(StringRef("v"), values);
+  b.close();
+  b.close();
+
+  Options options;
+  options.packedArrays = true;
+  Slice s = b.slice();
+  ASSERT_EQ(2U, s.length());
+  ASSERT_TRUE(s.at(0).isPackedArray<double>(&options));
+  ASSERT_EQ(2.5, s.at(0).getPackedArray<double>(&options)[1]);
+  ASSERT_TRUE(s.at(1).get("v").isPackedArray<double>(&options));
+  ASSERT_EQ(1.0, s.at(1).get("v").getPackedArray<double>(&options)[0]);
+}
+
+TEST(BuilderTest, AddPackedNeedsOpenCompound) {
+  std::vector<double> values{1.0};
+
+  Builder b;
+  b.openObject();
+  ASSERT_VELOCYPACK_EXCEPTION(b.addPacked(values), Exception::BuilderKeyMustBeString);
+
+  Builder b2;
+  b2.openArray();
+  ASSERT_VELOCYPACK_EXCEPTION(b2.addPacked(StringRef("v"), values), Exception::BuilderNeedOpenObject);
+}
+
 TEST(BuilderTest, AttributeTranslations) {
   std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
 
@@ -0,0 +1,350 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+#include "tests-common.h"
+
+namespace {
+
+std::string fromHex(std::string const& hex) {
+  std::string result;
+  for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+    result.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+  }
+  return result;
+}
+
+std::string toHex(std::string const& data) {
+  static char const digits[] = "0123456789abcdef";
+  std::string result;
+  for (unsigned char c : data) {
+    result.push_back(digits[c >> 4]);
+    result.push_back(digits[c & 0x0f]);
+  }
+  return result;
+}
+
+std::string toCbor(Builder const& b, Options const* options = &Options::Defaults) {
+  return toHex(CborDumper::toString(b.slice(), options));
+}
+
+std::string fromCbor(std::string const& hex) {
+  return CborParser::fromCbor(fromHex(hex))->slice().toJson();
+}
+
+}  // namespace
+
+TEST(CborDumperTest, Scalars) {
+  struct {
+    Value value;
+    char const* expected;
+  } const cases[] = {
+      {Value(ValueType::Null), "f6"},
+      {Value(false), "f4"},
+      {Value(true), "f5"},
+      {Value(0), "00"},
+      {Value(23), "17"},
+      {Value(24), "1818"},
+      {Value(1000), "1903e8"},
+      {Value(1000000), "1a000f4240"},
+      {Value(UINT64_MAX), "1bffffffffffffffff"},
+      {Value(-1), "20"},
+      {Value(-1000), "3903e7"},
+      {Value(INT64_MIN), "3b7fffffffffffffff"},
+      {Value(1.1), "fb3ff199999999999a"},
+      {Value("IETF"), "6449455446"},
+      {Value(""), "60"},
+  };
+
+  for (auto const& c : cases) {
+    Builder b;
+    b.add(c.value);
+    ASSERT_EQ(std::string(c.expected), toCbor(b));
+  }
+
+  Builder bin;
+  bin.add(ValuePair("\x01\x02\x03\x04", 4, ValueType::Binary));
+  ASSERT_EQ(std::string("4401020304"), toCbor(bin));
+}
+
+TEST(CborDumperTest, Compounds) {
+  std::shared_ptr<Builder> b = Parser::fromJson(R"({"a":1,"b":[2,3]})");
+  ASSERT_EQ(std::string("a26161016162820203"), toCbor(*b));
+
+  b = Parser::fromJson("[1,[2,3],[4,5]]");
+  ASSERT_EQ(std::string("8301820203820405"), toCbor(*b));
+}
+
+TEST(CborDumperTest, TagsDatesAndPackedArrays) {
+  Builder b;
+  b.openArray();
+  b.addTagged(23, ValuePair("\x01\x02", 2, ValueType::Binary));
+  b.add(Value(int64_t(1363896240000LL), ValueType::UTCDate));
+  b.add(Value(int64_t(1363896240500LL), ValueType::UTCDate));
+  b.addPacked(std::vector<int64_t>{1, -2});
+  b.close();
+
+  // without the option, packed arrays are tagged Binary values
+  ASSERT_EQ(std::string("84" "d7420102" "c11a514b67b0" "c1fb41d452d9ec200000"
+                        "d840500100000000000000feffffffffffffff"),
+            toCbor(b));
+
+  Options options;
+  options.packedArrays = true;
+  ASSERT_EQ(std::string("84" "d7420102" "c11a514b67b0" "c1fb41d452d9ec200000" "820121"),
+            toCbor(b, &options));
+}
+
+TEST(CborDumperTest, PackedArraysRoundTrip) {
+  Builder b;
+  b.openObject();
+  b.addPacked(StringRef("d"), std::vector<double>{0.5, -1.25});
+  b.addPacked(StringRef("i"), std::vector<int64_t>{1, -2});
+  b.close();
+
+  std::shared_ptr<Builder> parsed = CborParser::fromCbor(fromHex(toCbor(b)));
+  ASSERT_EQ(b.slice().byteSize(), parsed->slice().byteSize());
+  ASSERT_EQ(0, memcmp(b.slice().start(), parsed->slice().start(), b.slice().byteSize()));
+
+  Options options;
+  options.packedArrays = true;
+  ASSERT_TRUE(parsed->slice().get("d").isPackedArray<double>(&options));
+  ASSERT_EQ(-2, parsed->slice().get("i").getPackedArray<int64_t>(&options)[1]);
+}
+
+TEST(CborDumperTest, NestedTags) {
+  std::string const data = fromHex("d818d8198201c11864");
+  std::shared_ptr<Builder> b = CborParser::fromCbor(data);
+  ASSERT_EQ(toHex(data), toCbor(*b));
+}
+
+TEST(CborDumperTest, ShapedObjects) {
+  ShapeRegistry registry;
+  registry.add(std::vector<std::string>{"a", "b"});
+  std::shared_ptr<Builder> value = Parser::fromJson(R"({"b":2,"a":1})");
+  Builder shaped = registry.encode(value->slice());
+
+  Options options;
+  options.shapeRegistry = &registry;
+  ASSERT_EQ(std::string("a2616101616202"), toCbor(shaped, &options));
+}
+
+TEST(CborDumperTest, UnsupportedTypes) {
+  Builder b;
+  b.add(Value(ValueType::MaxKey));
+
+  Options options;
+  options.unsupportedTypeBehavior = Options::FailOnUnsupportedType;
+  ASSERT_VELOCYPACK_EXCEPTION(toCbor(b, &options), Exception::NoJsonEquivalent);
+
+  options.unsupportedTypeBehavior = Options::NullifyUnsupportedType;
+  ASSERT_EQ(std::string("f6"), toCbor(b, &options));
+
+  options.unsupportedTypeBehavior = Options::ConvertUnsupportedType;
+  std::string const data = CborDumper::toString(b.slice(), &options);
+  ASSERT_EQ(std::string("(non-representable type max-key)"),
+            CborParser::fromCbor(data)->slice().copyString());
+}
+
+// the examples from appendix A of RFC 8949
+TEST(CborParserTest, Examples) {
+  struct {
+    char const* data;
+    char const* json;
+  } const cases[] = {
+      {"00", "0"},
+      {"17", "23"},
+      {"1818", "24"},
+      {"1903e8", "1000"},
+      {"1bffffffffffffffff", "18446744073709551615"},
+      {"20", "-1"},
+      {"3903e7", "-1000"},
+      {"3b7fffffffffffffff", "-9223372036854775808"},
+      {"f90000", "0"},
+      {"f93c00", "1"},
+      {"f97bff", "65504"},
+      {"f90001", "5.960464477539063e-8"},
+      {"fa47c35000", "100000"},
+      {"fb3ff199999999999a", "1.1"},
+      {"f4", "false"},
+      {"f5", "true"},
+      {"f6", "null"},
+      {"f7", "null"},
+      {"6449455446", R"("IETF")"},
+      {"62225c", R"("\"\\")"},
+      {"80", "[]"},
+      {"83010203", "[1,2,3]"},
+      {"8301820203820405", "[1,[2,3],[4,5]]"},
+      {"a0", "{}"},
+      {"a26161016162820203", R"({"a":1,"b":[2,3]})"},
+      {"7f657374726561646d696e67ff", R"("streaming")"},
+      {"9fff", "[]"},
+      {"9f018202039f0405ffff", "[1,[2,3],[4,5]]"},
+      {"83018202039f0405ff", "[1,[2,3],[4,5]]"},
+      {"bf61610161629f0203ffff", R"({"a":1,"b":[2,3]})"},
+      {"bf6346756ef563416d7421ff", R"({"Amt":-2,"Fun":true})"},
+      {"a17f6161ff01", R"({"a":1})"},
+      {"c074323031332d30332d32315432303a30343a30305a", R"("2013-03-21T20:04:00Z")"},
+  };
+
+  for (auto const& c : cases) {
+    ASSERT_EQ(std::string(c.json), fromCbor(c.data)) << c.data;
+  }
+}
+
+TEST(CborParserTest, SpecialFloats) {
+  Options options;
+  options.unsupportedDoublesAsString = true;
+  std::shared_ptr<Builder> b = CborParser::fromCbor(fromHex("83f97c00f97e00f9fc00"));
+  ASSERT_EQ(std::string(R"(["Infinity","NaN","-Infinity"])"), b->slice().toJson(&options));
+}
+
+TEST(CborParserTest, TagsAndDates) {
+  std::shared_ptr<Builder> b = CborParser::fromCbor(fromHex("c11a514b67b0"));
+  ASSERT_TRUE(b->slice().isUTCDate());
+  ASSERT_EQ(1363896240000LL, b->slice().getUTCDate());
+
+  b = CborParser::fromCbor(fromHex("c1fb41d452d9ec200000"));
+  ASSERT_EQ(1363896240500LL, b->slice().getUTCDate());
+
+  b = CborParser::fromCbor(fromHex("c120"));
+  ASSERT_EQ(-1000LL, b->slice().getUTCDate());
+
+  b = CborParser::fromCbor(fromHex("d74401020304"));
+  ASSERT_TRUE(b->slice().isTagged());
+  ASSERT_EQ(23U, b->slice().getFirstTag());
+  ASSERT_TRUE(b->slice().value().isBinary());
+
+  // nested tags, and a tagged compound as the value of an Object member
+  b = CborParser::fromCbor(fromHex("a16161d818d81982f5c11864"));
+  Slice member = b->slice().get("a");
+  ASSERT_EQ((std::vector<uint64_t>{24, 25}), member.getTags());
+  Slice array = member.value();
+  ASSERT_TRUE(array.isArray());
+  ASSERT_TRUE(array.at(1).isUTCDate());
+  ASSERT_EQ(100000LL, array.at(1).getUTCDate());
+}
+
+TEST(CborTest, Roundtrip) {
+  Builder b;
+  b.openObject();
+  b.add("null", Value(ValueType::Null));
+  b.add("ints", Value(ValueType::Array));
+  for (int64_t v : {int64_t(0), int64_t(-1), int64_t(255), int64_t(-70000),
+                    INT64_MIN, INT64_MAX}) {
+    b.add(Value(v));
+  }
+  b.close();
+  b.add("big", Value(UINT64_MAX));
+  b.add("double", Value(-2.5e-100));
+  b.add("string", Value("äöü\n"));
+  b.add("binary", ValuePair("\x00\x01", 2, ValueType::Binary));
+  b.add("dates", Value(ValueType::Array));
+  for (int64_t v : {int64_t(0), int64_t(1), int64_t(-1), int64_t(-1001),
+                    int64_t(1600000000123LL)}) {
+    b.add(Value(v, ValueType::UTCDate));
+  }
+  b.close();
+  b.addTagged("tagged", 1000, Value(ValueType::Object));
+  b.add("x", Value(true));
+  b.close();
+  b.close();
+
+  std::string const data = CborDumper::toString(b.slice());
+  std::shared_ptr<Builder> result = CborParser::fromCbor(data);
+
+  Options options;
+  options.binaryAsHex = true;
+  options.datesAsIntegers = true;
+  options.debugTags = true;
+  ASSERT_EQ(b.slice().toJson(&options), result->slice().toJson(&options));
+  ASSERT_TRUE(result->slice().get("binary").isBinary());
+  ASSERT_TRUE(result->slice().get("dates").at(4).isUTCDate());
+  ASSERT_TRUE(result->slice().get("tagged").isTagged());
+}
+
+TEST(CborParserTest, TypedArrayTags) {
+  // RFC 8746 uint8 and uint64 typed arrays are kept as tagged Binary values
+  std::shared_ptr<Builder> b = CborParser::fromCbor(fromHex("82d84043010203d8434401020304"));
+  Slice s = b->slice();
+  ASSERT_EQ(64U, s.at(0).getFirstTag());
+  ASSERT_TRUE(s.at(0).value().isBinary());
+  ASSERT_EQ(67U, s.at(1).getFirstTag());
+  ASSERT_FALSE(s.at(1).isShapedObject());
+  ASSERT_EQ(std::string("82d84043010203d8434401020304"), toCbor(*b));
+}
+
+TEST(CborParserTest, Sequence) {
+  std::string const data = fromHex("0162686980");
+  Options options;
+  options.clearBuilderBeforeParse = false;
+  Builder b;
+  b.openArray();
+  CborParser parser(b, &options);
+  std::size_t pos = 0;
+  while (pos < data.size()) {
+    pos += parser.parse(data.data() + pos, data.size() - pos);
+  }
+  b.close();
+  ASSERT_EQ(std::string(R"([1,"hi",[]])"), b.slice().toJson());
+}
+
+TEST(CborParserTest, Errors) {
+  struct {
+    char const* data;
+    Exception::ExceptionType error;
+  } const cases[] = {
+      {"", Exception::ParseError},
+      {"1c", Exception::ParseError},
+      {"1f", Exception::ParseError},
+      {"ff", Exception::ParseError},
+      {"f818", Exception::ParseError},
+      {"6461", Exception::ParseError},
+      {"9b7fffffffffffffff", Exception::ParseError},
+      {"9f01", Exception::ParseError},
+      {"a10101", Exception::ParseError},
+      {"7f4161ff", Exception::ParseError},
+      {"c16161", Exception::ParseError},
+      {"3b8000000000000000", Exception::NumberOutOfRange},
+      {"c11b7fffffffffffffff", Exception::NumberOutOfRange},
+  };
+  for (auto const& c : cases) {
+    ASSERT_VELOCYPACK_EXCEPTION(CborParser::fromCbor(fromHex(c.data)), c.error);
+  }
+
+  Options options;
+  options.validateUtf8Strings = true;
+  ASSERT_VELOCYPACK_EXCEPTION(CborParser::fromCbor(fromHex("61ff"), &options),
+                              Exception::InvalidUtf8Sequence);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -24,6 +24,11 @@
 /// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -2114,6 +2119,437 @@ TEST(CollectionTest, SortNonArray) {
   ASSERT_VELOCYPACK_EXCEPTION(Collection::sort(b.slice(), &lt), Exception::InvalidValueType);
 }
 
+TEST(CollectionTest, PredicateTypes) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[1,2,3,4]");
+  Slice s(b->slice());
+  std::shared_ptr<Builder> three = Parser::fromJson("3");
+
+  // std::function, function objects and lambdas are all accepted
+  Collection::Predicate isEven = [](Slice const& current, ValueLength) {
+    return current.getInt() % 2 == 0;
+  };
+  ASSERT_EQ(2U, Collection::filter(s, isEven).slice().length());
+  ASSERT_EQ(2, Collection::find(&s, isEven).getInt());
+  ASSERT_TRUE(Collection::contains(s, IsEqualPredicate(three->slice())));
+  ASSERT_TRUE(Collection::any(s, IsEqualPredicate(three->slice())));
+  ASSERT_FALSE(Collection::all(&s, isEven));
+
+  // a Slice argument still selects the Slice overload of contains()
+  Slice other = three->slice();
+  ASSERT_TRUE(Collection::contains(s, other));
+  ASSERT_TRUE(Collection::contains(&s, three->slice()));
+
+  // predicates that are not copyable
+  std::unique_ptr<int> calls(new int(0));
+  auto counting = [&calls](Slice const&, ValueLength) {
+    ++*calls;
+    return true;
+  };
+  Collection::forEach(s, counting);
+  ASSERT_EQ(4, *calls);
+}
+
+// the recursive algorithm that visitRecursive() used to implement
+static bool referenceVisit(Slice slice, Collection::VisitationOrder order,
+                           std::vector<std::pair<Slice, Slice>>& result) {
+  auto visitMember = [&](Slice key, Slice value) {
+    bool const isCompound = value.isObject() || value.isArray();
+    if (isCompound && order == Collection::PreOrder) {
+      referenceVisit(value, order, result);
+    }
+    result.emplace_back(key, value);
+    if (isCompound && order == Collection::PostOrder) {
+      referenceVisit(value, order, result);
+    }
+  };
+  if (slice.isObject()) {
+    for (auto it : ObjectIterator(slice)) {
+      visitMember(it.key, it.value);
+    }
+  } else {
+    for (auto it : ArrayIterator(slice)) {
+      visitMember(Slice(), it);
+    }
+  }
+  return true;
+}
+
+TEST(CollectionTest, VisitRecursiveMatchesRecursion) {
+  std::string const json(
+      "{\"a\":[1,[2,[3,{}],[]],{\"b\":{\"c\":[4,5]},\"d\":6}],\"e\":{},"
+      "\"f\":[[[[7]]]],\"g\":{\"h\":[8,{\"i\":9}]},\"j\":10}");
+
+  for (bool compact : {false, true}) {
+    Options options;
+    options.buildUnindexedArrays = compact;
+    options.buildUnindexedObjects = compact;
+    Parser parser(&options);
+    parser.parse(json);
+    Slice s(parser.start());
+
+    for (auto order : {Collection::PreOrder, Collection::PostOrder}) {
+      std::vector<std::pair<Slice, Slice>> expected;
+      referenceVisit(s, order, expected);
+
+      // stop after each possible number of members
+      for (std::size_t limit = 1; limit <= expected.size() + 1; ++limit) {
+        std::vector<std::pair<Slice, Slice>> actual;
+        Collection::visitRecursive(
+            s, order, [&](Slice const& key, Slice const& value) {
+              actual.emplace_back(key, value);
+              return actual.size() < limit;
+            });
+        ASSERT_EQ((std::min)(limit, expected.size()), actual.size());
+        for (std::size_t i = 0; i < actual.size(); ++i) {
+          ASSERT_EQ(expected[i].first.start(), actual[i].first.start());
+          ASSERT_EQ(expected[i].second.start(), actual[i].second.start());
+        }
+      }
+    }
+  }
+}
+
+TEST(CollectionTest, VisitRecursiveDeeplyNested) {
+  int const depth = 100000;
+  Builder b;
+  for (int i = 0; i < depth; ++i) {
+    b.openArray(true);
+  }
+  for (int i = 0; i < depth; ++i) {
+    b.close();
+  }
+
+  for (auto order : {Collection::PreOrder, Collection::PostOrder}) {
+    int count = 0;
+    Collection::visitRecursive(b.slice(), order,
+                               [&count](Slice const&, Slice const& value) {
+                                 EXPECT_TRUE(value.isArray());
+                                 ++count;
+                                 return true;
+                               });
+    ASSERT_EQ(depth - 1, count);
+  }
+}
+
+static Builder buildNumbers(int n, bool compact) {
+  Options options;
+  options.buildUnindexedArrays = compact;
+  Builder b(&options);
+  b.openArray();
+  for (int i = 0; i < n; ++i) {
+    // members of different sizes
+    b.add(Value(i * 37));
+  }
+  b.close();
+  return b;
+}
+
+TEST(CollectionTest, ParallelNonArray) {
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"a\":1}");
+  auto pred = [](Slice const&, ValueLength) { return true; };
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::forEachParallel(b->slice(), 4, pred),
+                              Exception::InvalidValueType);
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::filterParallel(b->slice(), 4, pred),
+                              Exception::InvalidValueType);
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::anyParallel(b->slice(), 4, pred),
+                              Exception::InvalidValueType);
+}
+
+TEST(CollectionTest, ParallelEmpty) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[]");
+  ASSERT_EQ(0U, Collection::filterParallel(b->slice(), 4, FailCallback).slice().length());
+  ASSERT_FALSE(Collection::anyParallel(b->slice(), 4, FailCallback));
+  Collection::forEachParallel(b->slice(), 4, FailCallback);
+}
+
+TEST(CollectionTest, ParallelMatchesSequential) {
+  for (bool compact : {false, true}) {
+    for (int n : {1, 999, 2000, 10007}) {
+      Builder b = buildNumbers(n, compact);
+      Slice s = b.slice();
+
+      for (std::size_t numThreads : {0, 1, 3, 8}) {
+        auto pred = [](Slice const& current, ValueLength index) {
+          return current.getInt() == static_cast<int64_t>(index * 37) &&
+                 current.getInt() % 3 == 0;
+        };
+        Builder expected = Collection::filter(s, pred);
+        Builder actual = Collection::filterParallel(s, numThreads, pred);
+        ASSERT_TRUE(expected.slice().binaryEquals(actual.slice()));
+
+        std::vector<std::atomic<int>> seen(n);
+        Collection::forEachParallel(s, numThreads, [&](Slice const& current, ValueLength index) {
+          EXPECT_EQ(static_cast<int64_t>(index * 37), current.getInt());
+          seen[index]++;
+          return true;
+        });
+        for (auto const& it : seen) {
+          ASSERT_EQ(1, it.load());
+        }
+
+        int64_t const last = static_cast<int64_t>(n - 1) * 37;
+        ASSERT_TRUE(Collection::anyParallel(s, numThreads, [last](Slice const& current, ValueLength) {
+          return current.getInt() == last;
+        }));
+        ASSERT_FALSE(Collection::anyParallel(s, numThreads, [](Slice const& current, ValueLength) {
+          return current.getInt() < 0;
+        }));
+      }
+    }
+  }
+}
+
+TEST(CollectionTest, ParallelWithPool) {
+  Builder b = buildNumbers(10000, false);
+  ThreadPool pool(4);
+  for (int i = 0; i < 10; ++i) {
+    std::atomic<int> calls(0);
+    Collection::forEachParallel(b.slice(), pool, [&calls](Slice const&, ValueLength) {
+      calls++;
+      return true;
+    });
+    ASSERT_EQ(10000, calls.load());
+
+    Builder matches = Collection::filterParallel(b.slice(), pool, [](Slice const& current, ValueLength) {
+      return current.getInt() % 2 == 0;
+    });
+    ASSERT_EQ(5000U, matches.slice().length());
+    ASSERT_TRUE(Collection::anyParallel(b.slice(), pool, [](Slice const& current, ValueLength) {
+      return current.getInt() == 37 * 9999;
+    }));
+  }
+}
+
+TEST(CollectionTest, ParallelAbort) {
+  Builder b = buildNumbers(10000, false);
+  std::atomic<int> calls(0);
+  Collection::forEachParallel(b.slice(), 4, [&calls](Slice const&, ValueLength) {
+    calls++;
+    return false;
+  });
+  // each range stops at its first member at the latest
+  ASSERT_GE(4, calls.load());
+  ASSERT_LE(1, calls.load());
+}
+
+TEST(CollectionTest, ParallelException) {
+  Builder b = buildNumbers(10000, true);
+  ASSERT_VELOCYPACK_EXCEPTION(
+      Collection::filterParallel(b.slice(), 4, [](Slice const&, ValueLength index) -> bool {
+        if (index == 7777) {
+          throw Exception(Exception::NumberOutOfRange);
+        }
+        return true;
+      }),
+      Exception::NumberOutOfRange);
+}
+
+static Collection::NumberAggregate referenceAggregate(Slice slice) {
+  Collection::NumberAggregate result{0, 0.0, std::numeric_limits<double>::infinity(),
+                                     -std::numeric_limits<double>::infinity()};
+  for (auto it : ArrayIterator(slice)) {
+    if (it.isNumber()) {
+      double v = it.getNumber<double>();
+      ++result.count;
+      result.sum += v;
+      if (v < result.min) {
+        result.min = v;
+      }
+      if (v > result.max) {
+        result.max = v;
+      }
+    }
+  }
+  return result;
+}
+
+static void checkAggregate(Slice slice) {
+  Collection::NumberAggregate expected = referenceAggregate(slice);
+  Collection::NumberAggregate actual = Collection::aggregateNumbers(slice);
+  ASSERT_EQ(expected.count, actual.count);
+  ASSERT_EQ(expected.sum, actual.sum);
+  ASSERT_EQ(expected.min, actual.min);
+  ASSERT_EQ(expected.max, actual.max);
+  ASSERT_EQ(expected.sum, Collection::sumNumbers(slice));
+}
+
+TEST(CollectionTest, AggregateNumbersNonArray) {
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"a\":1}");
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::aggregateNumbers(b->slice()), Exception::InvalidValueType);
+  b = Parser::fromJson("1");
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::sumNumbers(b->slice()), Exception::InvalidValueType);
+}
+
+TEST(CollectionTest, AggregateNumbersEmpty) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[]");
+  Collection::NumberAggregate result = Collection::aggregateNumbers(b->slice());
+  ASSERT_EQ(0U, result.count);
+  ASSERT_EQ(0.0, result.sum);
+
+  double min, max;
+  ASSERT_FALSE(Collection::minMax(b->slice(), min, max));
+
+  b = Parser::fromJson("[\"foo\",null,[1,2],{\"a\":3}]");
+  ASSERT_EQ(0U, Collection::aggregateNumbers(b->slice()).count);
+  ASSERT_FALSE(Collection::minMax(b->slice(), min, max));
+}
+
+TEST(CollectionTest, AggregateNumbersLayouts) {
+  for (bool compact : {false, true}) {
+    Options options;
+    options.buildUnindexedArrays = compact;
+
+    // doubles only, equal sizes
+    Builder b(&options);
+    b.openArray();
+    for (int i = 0; i < 1001; ++i) {
+      b.add(Value(i * 0.5 - 100.0));
+    }
+    b.close();
+    checkAggregate(b.slice());
+
+    // SmallInts only, including negative ones
+    b.clear();
+    b.openArray();
+    for (int i = 0; i < 1000; ++i) {
+      b.add(Value((i % 16) - 6));
+    }
+    b.close();
+    checkAggregate(b.slice());
+
+    // mixed types, with runs of different lengths
+    b.clear();
+    b.openArray();
+    for (int i = 0; i < 1000; ++i) {
+      switch (i % 7) {
+        case 0: b.add(Value(i * 1.25)); break;
+        case 1: b.add(Value(i % 10)); break;
+        case 2: b.add(Value("foo")); break;
+        case 3: b.add(Value(-i * 1000)); break;
+        case 4: b.add(Value(static_cast<uint64_t>(i) * uint64_t(1000000000))); break;
+        case 5: b.add(Value(ValueType::Null)); break;
+        default: b.add(Value(-3)); break;
+      }
+    }
+    b.close();
+    checkAggregate(b.slice());
+  }
+}
+
+TEST(CollectionTest, AggregateNumbersIntegerWidths) {
+  std::vector<int64_t> const bases{1LL << 7, 1LL << 15, 1LL << 23, 1LL << 31,
+                                   1LL << 39, 1LL << 47, 1LL << 55, INT64_MAX / 2};
+  for (int64_t base : bases) {
+    for (bool negative : {false, true}) {
+      Builder b;
+      b.openArray();
+      for (int64_t i = 0; i < 100; ++i) {
+        b.add(Value(negative ? -base - i : base + i));
+      }
+      b.close();
+      checkAggregate(b.slice());
+    }
+
+    Builder b;
+    b.openArray();
+    for (uint64_t i = 0; i < 100; ++i) {
+      b.add(Value(static_cast<uint64_t>(base) * 2 + i));
+    }
+    b.close();
+    checkAggregate(b.slice());
+  }
+
+  Builder b;
+  b.openArray();
+  b.add(Value(INT64_MIN));
+  b.add(Value(INT64_MAX));
+  b.add(Value(UINT64_MAX));
+  b.close();
+  checkAggregate(b.slice());
+}
+
+TEST(CollectionTest, AggregateNumbersNaN) {
+  Builder b;
+  b.openArray();
+  for (int i = 0; i < 10; ++i) {
+    b.add(Value(i == 5 ? std::nan("") : i * 1.0));
+  }
+  b.close();
+
+  Collection::NumberAggregate result = Collection::aggregateNumbers(b.slice());
+  ASSERT_EQ(10U, result.count);
+  ASSERT_TRUE(std::isnan(result.sum));
+  ASSERT_EQ(0.0, result.min);
+  ASSERT_EQ(9.0, result.max);
+}
+
+TEST(CollectionTest, AggregateNumbersPacked) {
+  std::vector<double> doubles;
+  std::vector<float> floats;
+  std::vector<int64_t> ints;
+  for (int i = 0; i < 103; ++i) {
+    doubles.push_back(i * 0.25 - 10.0);
+    floats.push_back(static_cast<float>(i) * 0.5f);
+    ints.push_back(i * 1000 - 50000);
+  }
+  Options options;
+  options.packedArrays = true;
+
+  Builder b;
+  b.addPacked(doubles);
+  Collection::NumberAggregate result = Collection::aggregateNumbers(b.slice(), &options);
+  ASSERT_EQ(doubles.size(), result.count);
+  ASSERT_EQ(std::accumulate(doubles.begin(), doubles.end(), 0.0), result.sum);
+  ASSERT_EQ(-10.0, result.min);
+  ASSERT_EQ(doubles.back(), result.max);
+
+  b.clear();
+  b.addPacked(floats);
+  result = Collection::aggregateNumbers(b.slice(), &options);
+  ASSERT_EQ(floats.size(), result.count);
+  ASSERT_EQ(std::accumulate(floats.begin(), floats.end(), 0.0), result.sum);
+  ASSERT_EQ(0.0, result.min);
+  ASSERT_EQ(51.0, result.max);
+
+  b.clear();
+  b.addPacked(ints);
+  double min, max;
+  ASSERT_TRUE(Collection::minMax(b.slice(), min, max, &options));
+  ASSERT_EQ(-50000.0, min);
+  ASSERT_EQ(52000.0, max);
+  ASSERT_EQ(static_cast<double>(std::accumulate(ints.begin(), ints.end(), int64_t(0))),
+            Collection::sumNumbers(b.slice(), &options));
+
+  // without the option, a tagged Binary value is not an Array
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::aggregateNumbers(b.slice()), Exception::InvalidValueType);
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::minMax(b.slice(), min, max), Exception::InvalidValueType);
+}
+
+TEST(CollectionTest, Histogram) {
+  std::shared_ptr<Builder> b = Parser::fromJson(
+      "[0,1,2,3,4,5,6,7,8,9,10,-1,11,2.5,\"foo\",null,9.99]");
+  std::vector<uint64_t> counts = Collection::histogram(b->slice(), 0.0, 10.0, 5);
+  ASSERT_EQ(5U, counts.size());
+  ASSERT_EQ(2U, counts[0]);  // 0, 1
+  ASSERT_EQ(3U, counts[1]);  // 2, 3, 2.5
+  ASSERT_EQ(2U, counts[2]);  // 4, 5
+  ASSERT_EQ(2U, counts[3]);  // 6, 7
+  ASSERT_EQ(4U, counts[4]);  // 8, 9, 10, 9.99
+
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::histogram(b->slice(), 0.0, 10.0, 0), Exception::NumberOutOfRange);
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::histogram(b->slice(), 10.0, 10.0, 5), Exception::NumberOutOfRange);
+  ASSERT_VELOCYPACK_EXCEPTION(Collection::histogram(b->slice(), 10.0, 0.0, 5), Exception::NumberOutOfRange);
+
+  std::vector<double> values{0.0, 0.5, 1.0};
+  Builder packed;
+  packed.addPacked(values);
+  Options options;
+  options.packedArrays = true;
+  counts = Collection::histogram(packed.slice(), 0.0, 1.0, 2, &options);
+  ASSERT_EQ(1U, counts[0]);
+  ASSERT_EQ(2U, counts[1]);
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
 
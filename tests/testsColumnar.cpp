@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+
+#include "tests-common.h"
+
+TEST(ColumnarTest, FromRowsInvalid) {
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"a\":1}");
+  ASSERT_VELOCYPACK_EXCEPTION(Columnar::fromRows(b->slice()), Exception::InvalidValueType);
+
+  b = Parser::fromJson("[{\"a\":1},2]");
+  ASSERT_VELOCYPACK_EXCEPTION(Columnar::fromRows(b->slice()), Exception::InvalidValueType);
+}
+
+TEST(ColumnarTest, Empty) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[]");
+  Builder columnar = Columnar::fromRows(b->slice());
+  ASSERT_EQ(std::string("{\"columns\":[],\"keys\":[],\"length\":0}"),
+            columnar.slice().toJson());
+
+  ColumnarView view(columnar.slice());
+  ASSERT_EQ(0U, view.length());
+  ASSERT_EQ(0U, view.numColumns());
+  ASSERT_VELOCYPACK_EXCEPTION(view.row(0), Exception::IndexOutOfBounds);
+
+  Builder rows = Columnar::toRows(columnar.slice());
+  ASSERT_EQ(std::string("[]"), rows.slice().toJson());
+}
+
+TEST(ColumnarTest, Homogeneous) {
+  std::shared_ptr<Builder> b = Parser::fromJson(
+      "[{\"name\":\"foo\",\"value\":1,\"tags\":[1,2]},"
+      "{\"name\":\"bar\",\"value\":2.5,\"tags\":[]},"
+      "{\"name\":\"baz\",\"value\":-3,\"tags\":{\"x\":true}}]");
+
+  Builder columnar = Columnar::fromRows(b->slice());
+  Slice c = columnar.slice();
+  ASSERT_EQ(3U, c.get("length").getUInt());
+  ASSERT_EQ(std::string("[\"name\",\"value\",\"tags\"]"), c.get("keys").toJson());
+  ASSERT_EQ(std::string("[\"foo\",\"bar\",\"baz\"]"), c.get("columns").at(0).toJson());
+  ASSERT_EQ(std::string("[1,2.5,-3]"), c.get("columns").at(1).toJson());
+
+  ColumnarView view(c);
+  ASSERT_EQ(3U, view.length());
+  ASSERT_EQ(3U, view.numColumns());
+  ASSERT_EQ("value", view.keyAt(1).copyString());
+  ASSERT_EQ(1, view.columnIndex("value"));
+  ASSERT_EQ(-1, view.columnIndex("qux"));
+  ASSERT_TRUE(view.column(StringRef("qux")).isNone());
+  ASSERT_EQ(3U, view.column(StringRef("tags")).length());
+  ASSERT_EQ(0.5, Collection::sumNumbers(view.column(StringRef("value"))));
+
+  ColumnarRow row = view.row(1);
+  ASSERT_EQ(1U, row.index());
+  ASSERT_EQ("bar", row.get("name").copyString());
+  ASSERT_EQ(2.5, row.get("value").getDouble());
+  ASSERT_TRUE(row.get("tags").isEmptyArray());
+  ASSERT_TRUE(row.hasKey("name"));
+  ASSERT_FALSE(row.hasKey("qux"));
+  ASSERT_TRUE(view[2].get("tags").get("x").getBool());
+
+  Builder single;
+  view[0].toObject(single);
+  ASSERT_TRUE(NormalizedCompare::equals(b->slice().at(0), single.slice()));
+
+  Builder rows = Columnar::toRows(c);
+  ASSERT_TRUE(NormalizedCompare::equals(b->slice(), rows.slice()));
+}
+
+TEST(ColumnarTest, Heterogeneous) {
+  std::shared_ptr<Builder> b = Parser::fromJson(
+      "[{\"a\":1,\"b\":2},{\"b\":3,\"c\":4},{},{\"c\":null,\"a\":5}]");
+
+  Builder columnar = Columnar::fromRows(b->slice());
+  ColumnarView view(columnar.slice());
+  ASSERT_EQ(4U, view.length());
+  ASSERT_EQ(3U, view.numColumns());
+
+  ASSERT_EQ(1, view[0].get("a").getInt());
+  ASSERT_TRUE(view[0].get("c").isNone());
+  ASSERT_TRUE(view[1].get("a").isNone());
+  ASSERT_EQ(4, view[1].get("c").getInt());
+  ASSERT_TRUE(view[2].get("a").isNone());
+  ASSERT_TRUE(view[2].get("b").isNone());
+  ASSERT_TRUE(view[3].get("c").isNull());
+
+  // missing attributes are Illegal in the column
+  ASSERT_TRUE(view.column(StringRef("a")).at(1).isIllegal());
+
+  Builder rows = Columnar::toRows(columnar.slice());
+  ASSERT_TRUE(NormalizedCompare::equals(b->slice(), rows.slice()));
+}
+
+TEST(ColumnarTest, Compact) {
+  Options options;
+  options.buildUnindexedArrays = true;
+  options.buildUnindexedObjects = true;
+  Parser parser(&options);
+  parser.parse("[{\"a\":1,\"b\":\"x\"},{\"a\":2,\"b\":\"y\"},{\"a\":3,\"b\":\"z\"}]");
+  std::shared_ptr<Builder> b = parser.steal();
+  ASSERT_EQ(0x13, b->slice().head());
+
+  Builder columnar = Columnar::fromRows(b->slice());
+  Builder rows = Columnar::toRows(columnar.slice());
+  ASSERT_TRUE(NormalizedCompare::equals(b->slice(), rows.slice()));
+}
+
+TEST(ColumnarTest, Smaller) {
+  std::string json("[");
+  for (int i = 0; i < 1000; ++i) {
+    if (i > 0) {
+      json.push_back(',');
+    }
+    json.append("{\"identifier\":" + std::to_string(i) +
+                ",\"description\":\"item\",\"temperature\":" +
+                std::to_string(i * 0.5) + "}");
+  }
+  json.push_back(']');
+
+  std::shared_ptr<Builder> b = Parser::fromJson(json);
+  Builder columnar = Columnar::fromRows(b->slice());
+  ASSERT_LT(columnar.slice().byteSize() * 2, b->slice().byteSize());
+}
+
+TEST(ColumnarTest, ViewInvalid) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[1]");
+  ASSERT_VELOCYPACK_EXCEPTION(ColumnarView{b->slice()}, Exception::InvalidValueType);
+
+  b = Parser::fromJson("{\"length\":1,\"keys\":[\"a\"],\"columns\":[]}");
+  ASSERT_VELOCYPACK_EXCEPTION(ColumnarView{b->slice()}, Exception::InvalidValueType);
+
+  b = Parser::fromJson("{\"length\":2,\"keys\":[\"a\"],\"columns\":[[1]]}");
+  ASSERT_VELOCYPACK_EXCEPTION(ColumnarView{b->slice()}, Exception::InvalidValueType);
+
+  b = Parser::fromJson("{\"length\":1,\"keys\":[1],\"columns\":[[1]]}");
+  ASSERT_VELOCYPACK_EXCEPTION(ColumnarView{b->slice()}, Exception::InvalidValueType);
+
+  b = Parser::fromJson("{\"length\":1,\"keys\":[\"a\"],\"columns\":[[1]]}");
+  ColumnarView view(b->slice());
+  ASSERT_EQ(1, view[0].get("a").getInt());
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
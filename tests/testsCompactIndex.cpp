@@ -0,0 +1,226 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+
+#include "tests-common.h"
+
+static Builder buildCompact(std::string const& json) {
+  // inherits the attribute translator from the defaults
+  Options options = Options::Defaults;
+  options.buildUnindexedArrays = true;
+  options.buildUnindexedObjects = true;
+  Parser parser(&options);
+  parser.parse(json);
+  return *parser.steal();
+}
+
+TEST(CompactIndexTest, InvalidType) {
+  std::shared_ptr<Builder> b = Parser::fromJson("\"foo\"");
+  ASSERT_VELOCYPACK_EXCEPTION(CompactIndex(b->slice()), Exception::InvalidValueType);
+
+  b = Parser::fromJson("123");
+  ASSERT_VELOCYPACK_EXCEPTION(CompactIndex(b->slice()), Exception::InvalidValueType);
+}
+
+TEST(CompactIndexTest, EmptyValues) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[]");
+  CompactIndex array(b->slice());
+  ASSERT_EQ(0U, array.length());
+  ASSERT_FALSE(array.hasOffsets());
+  ASSERT_VELOCYPACK_EXCEPTION(array.at(0), Exception::IndexOutOfBounds);
+
+  b = Parser::fromJson("{}");
+  CompactIndex object(b->slice());
+  ASSERT_EQ(0U, object.length());
+  ASSERT_TRUE(object.get("foo").isNone());
+  ASSERT_VELOCYPACK_EXCEPTION(object.keyAt(0), Exception::IndexOutOfBounds);
+}
+
+TEST(CompactIndexTest, CompactArray) {
+  std::string json("[");
+  for (int i = 0; i < 1000; ++i) {
+    if (i > 0) {
+      json.push_back(',');
+    }
+    // members of different sizes
+    json.append((i % 3 == 0) ? std::to_string(i) : "\"value" + std::to_string(i) + "\"");
+  }
+  json.push_back(']');
+
+  Builder b = buildCompact(json);
+  Slice s = b.slice();
+  ASSERT_EQ(0x13, s.head());
+
+  CompactIndex index(s);
+  ASSERT_TRUE(index.hasOffsets());
+  ASSERT_EQ(s.start(), index.slice().start());
+  ASSERT_EQ(1000U, index.length());
+  ASSERT_GE(index.memoryUsage(), 1000U * sizeof(ValueLength));
+
+  for (ValueLength i = 0; i < 1000; ++i) {
+    ASSERT_EQ(s.getNthOffset(i), index.getNthOffset(i));
+    ASSERT_EQ(s.at(i).start(), index.at(i).start());
+    ASSERT_EQ(s[i].start(), index[i].start());
+  }
+  ASSERT_VELOCYPACK_EXCEPTION(index.at(1000), Exception::IndexOutOfBounds);
+  ASSERT_VELOCYPACK_EXCEPTION(index.keyAt(0), Exception::InvalidValueType);
+  ASSERT_VELOCYPACK_EXCEPTION(index.valueAt(0), Exception::InvalidValueType);
+  ASSERT_VELOCYPACK_EXCEPTION(index.get("foo"), Exception::InvalidValueType);
+}
+
+TEST(CompactIndexTest, IndexedArray) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[1,\"foo\",[2,3],{\"a\":4}]");
+  Slice s = b->slice();
+
+  CompactIndex index(s);
+  ASSERT_FALSE(index.hasOffsets());
+  ASSERT_EQ(0U, index.memoryUsage());
+  ASSERT_EQ(4U, index.length());
+  for (ValueLength i = 0; i < 4; ++i) {
+    ASSERT_EQ(s.at(i).start(), index.at(i).start());
+  }
+  ASSERT_VELOCYPACK_EXCEPTION(index.at(4), Exception::IndexOutOfBounds);
+}
+
+TEST(CompactIndexTest, CompactObject) {
+  std::string json("{");
+  for (int i = 999; i >= 0; --i) {
+    if (i < 999) {
+      json.push_back(',');
+    }
+    json.append("\"key" + std::to_string(i) + "\":" + std::to_string(i));
+  }
+  json.push_back('}');
+
+  Builder b = buildCompact(json);
+  Slice s = b.slice();
+  ASSERT_EQ(0x14, s.head());
+
+  CompactIndex index(s);
+  ASSERT_TRUE(index.hasOffsets());
+  ASSERT_EQ(1000U, index.length());
+
+  for (ValueLength i = 0; i < 1000; ++i) {
+    ASSERT_EQ(s.keyAt(i).copyString(), index.keyAt(i).copyString());
+    ASSERT_EQ(s.valueAt(i).start(), index.valueAt(i).start());
+  }
+  for (int i = 0; i < 1000; ++i) {
+    std::string key("key" + std::to_string(i));
+    Slice value = index.get(key);
+    ASSERT_TRUE(value.isInteger());
+    ASSERT_EQ(i, value.getInt());
+    ASSERT_EQ(s.get(key).start(), value.start());
+    ASSERT_TRUE(index.hasKey(StringRef(key)));
+  }
+
+  ASSERT_TRUE(index.get("").isNone());
+  ASSERT_TRUE(index.get("key").isNone());
+  ASSERT_TRUE(index.get("key1000").isNone());
+  ASSERT_TRUE(index.get("zzz").isNone());
+  ASSERT_FALSE(index.hasKey(StringRef("key01")));
+  ASSERT_VELOCYPACK_EXCEPTION(index.at(0), Exception::InvalidValueType);
+  ASSERT_VELOCYPACK_EXCEPTION(index.keyAt(1000), Exception::IndexOutOfBounds);
+}
+
+TEST(CompactIndexTest, UnsortedObject) {
+  // the Builder always sorts object indexes, so build it manually
+  uint8_t const data[] = {0x0f, 0x0f, 0x03, 0x41, 'z', 0x31, 0x41, 'b',
+                          0x32, 0x41, 'a', 0x33, 0x03, 0x06, 0x09};
+  Slice s(&data[0]);
+  ASSERT_EQ(sizeof(data), s.byteSize());
+
+  CompactIndex index(s);
+  ASSERT_FALSE(index.hasOffsets());
+  ASSERT_EQ(3U, index.length());
+  ASSERT_EQ(1, index.get("z").getInt());
+  ASSERT_EQ(2, index.get("b").getInt());
+  ASSERT_EQ(3, index.get("a").getInt());
+  ASSERT_TRUE(index.get("c").isNone());
+  ASSERT_TRUE(index.get("zz").isNone());
+  ASSERT_EQ("z", index.keyAt(0).copyString());
+  ASSERT_EQ(2, index.valueAt(1).getInt());
+}
+
+TEST(CompactIndexTest, SortedObject) {
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"b\":1,\"a\":2,\"c\":3}");
+  Slice s = b->slice();
+
+  CompactIndex index(s);
+  ASSERT_EQ(0U, index.memoryUsage());
+  ASSERT_EQ(1, index.get("b").getInt());
+  ASSERT_EQ(2, index.get("a").getInt());
+  ASSERT_EQ(3, index.get("c").getInt());
+  ASSERT_TRUE(index.get("d").isNone());
+}
+
+TEST(CompactIndexTest, DuplicateKeys) {
+  Builder b;
+  b.openObject(true);
+  b.add("a", Value(1));
+  b.add("b", Value(2));
+  b.add("a", Value(3));
+  b.close();
+
+  Slice s = b.slice();
+  ASSERT_EQ(0x14, s.head());
+
+  // same result as the linear search in Slice::get()
+  CompactIndex index(s);
+  ASSERT_EQ(s.get("a").getInt(), index.get("a").getInt());
+  ASSERT_EQ(1, index.get("a").getInt());
+}
+
+TEST(CompactIndexTest, TranslatedKeys) {
+  std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
+
+  translator->add("foo", 1);
+  translator->add("bar", 2);
+  translator->add("baz", 3);
+  translator->seal();
+
+  AttributeTranslatorScope scope(translator.get());
+
+  Builder b = buildCompact("{\"foo\":1,\"bar\":2,\"qux\":3,\"baz\":4}");
+  Slice s = b.slice();
+  ASSERT_EQ(0x14, s.head());
+  ASSERT_TRUE(s.keyAt(0, false).isSmallInt());
+
+  CompactIndex index(s);
+  ASSERT_EQ(1, index.get("foo").getInt());
+  ASSERT_EQ(2, index.get("bar").getInt());
+  ASSERT_EQ(3, index.get("qux").getInt());
+  ASSERT_EQ(4, index.get("baz").getInt());
+  ASSERT_TRUE(index.get("quux").isNone());
+  ASSERT_EQ("foo", index.keyAt(0).copyString());
+  ASSERT_TRUE(index.keyAt(0, false).isSmallInt());
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
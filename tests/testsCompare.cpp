@@ -24,6 +24,7 @@
 /// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <cmath>
 #include <ostream>
 #include <string>
 
@@ -402,6 +403,68 @@ TEST(NormalizedCompareTest, Objects) {
   ASSERT_FALSE(NormalizedCompare::equals(Parser::fromJson("{\"one\":{\"one-one\":1,\"one-two\":2,\"one-three\":3},\"two\":{\"two-one\":21,\"two-two\":22,\"two-three\":23},\"three\":\"three\"}")->slice(), Parser::fromJson("{\"one\":{\"one-one\":1,\"one-two\":2,\"one-three\":3},\"two\":{\"two-one\":21,\"two-two\":22,\"two-three\":23},\"three\":\"three\",\"four\":\"four\"}")->slice()));
 }
 
+TEST(NormalizedCompareTest, ObjectsDifferentLayouts) {
+  Options options;
+  options.buildUnindexedObjects = true;
+  options.buildUnindexedArrays = true;
+  std::string const json("{\"z\":[1,2,{\"c\":3,\"b\":\"x\"}],\"a\":-1.25,\"m\":{}}");
+
+  std::shared_ptr<Builder> compact = Parser::fromJson(json, &options);
+  std::shared_ptr<Builder> indexed = Parser::fromJson(json);
+  ASSERT_TRUE(NormalizedCompare::equals(compact->slice(), indexed->slice()));
+  ASSERT_TRUE(NormalizedCompare::equals(indexed->slice(), compact->slice()));
+  ASSERT_TRUE(NormalizedCompare::equals(compact->slice(), compact->slice()));
+  
+  std::shared_ptr<Builder> other = Parser::fromJson("{\"z\":[1,2,{\"c\":3,\"b\":\"y\"}],\"a\":-1.25,\"m\":{}}", &options);
+  ASSERT_FALSE(NormalizedCompare::equals(compact->slice(), other->slice()));
+  ASSERT_FALSE(NormalizedCompare::equals(indexed->slice(), other->slice()));
+  
+  other = Parser::fromJson("{\"z\":[1,2,{\"c\":3,\"b\":\"x\"}],\"b\":-1.25,\"m\":{}}", &options);
+  ASSERT_FALSE(NormalizedCompare::equals(compact->slice(), other->slice()));
+  ASSERT_FALSE(NormalizedCompare::equals(indexed->slice(), other->slice()));
+}
+
+TEST(NormalizedCompareTest, IdenticalBytes) {
+  Builder b;
+  b.openArray();
+  b.add(Value(std::nan("")));
+  b.close();
+
+  // NaN is unequal to itself, regardless of the layout around it
+  ASSERT_FALSE(NormalizedCompare::equals(b.slice().at(0), b.slice().at(0)));
+  ASSERT_FALSE(NormalizedCompare::equals(b.slice(), b.slice()));
+  
+  Builder copy(b.slice());
+  ASSERT_NE(b.slice().start(), copy.slice().start());
+  ASSERT_FALSE(NormalizedCompare::equals(b.slice(), copy.slice()));
+
+  Builder compact;
+  compact.openArray(true);
+  compact.add(Value(std::nan("")));
+  compact.close();
+  ASSERT_FALSE(NormalizedCompare::equals(b.slice(), compact.slice()));
+
+  std::shared_ptr<Builder> other = Parser::fromJson("{\"a\":[1,\"x\",null],\"b\":{\"c\":true}}");
+  Builder otherCopy(other->slice());
+  ASSERT_TRUE(NormalizedCompare::equals(other->slice(), other->slice()));
+  ASSERT_TRUE(NormalizedCompare::equals(other->slice(), otherCopy.slice()));
+
+  other = Parser::fromJson("{\"a\":[1,\"x\",null],\"b\":{\"c\":0.5}}");
+  ASSERT_TRUE(NormalizedCompare::equals(other->slice(), other->slice()));
+
+  Builder nested;
+  nested.openArray();
+  nested.openObject();
+  nested.add("a", Value(ValueType::Array));
+  nested.add(Value(1.5));
+  nested.add(Value(std::nan("")));
+  nested.close();
+  nested.close();
+  nested.close();
+  Builder nestedCopy(nested.slice());
+  ASSERT_FALSE(NormalizedCompare::equals(nested.slice(), nestedCopy.slice()));
+}
+
 TEST(NormalizedCompareTest, Custom) {
   Builder b;
   uint8_t* p = b.add(ValuePair(2ULL, ValueType::Custom));
@@ -409,6 +472,171 @@ TEST(NormalizedCompareTest, Custom) {
   *p++ = 0xaa;  
 
   ASSERT_VELOCYPACK_EXCEPTION(NormalizedCompare::equals(b.slice(), b.slice()), Exception::NotImplemented);
+
+  Builder array;
+  array.openArray();
+  array.add(b.slice());
+  array.close();
+  ASSERT_VELOCYPACK_EXCEPTION(NormalizedCompare::equals(array.slice(), array.slice()),
+                              Exception::NotImplemented);
+}
+
+TEST(NormalizedCompareTest, CompareTypeOrder) {
+  Builder b;
+  b.openArray();
+  b.add(Slice::minKeySlice());
+  b.add(Slice::noneSlice());
+  b.add(Slice::illegalSlice());
+  b.add(Slice::nullSlice());
+  b.add(Value(false));
+  b.add(Value(true));
+  b.add(Value(-1.5));
+  b.add(Value(int64_t(42)));
+  b.add(Value(int64_t(0), ValueType::UTCDate));
+  b.add(Value(""));
+  b.add(Value("abc"));
+  uint8_t const binary[] = { 0x00, 0x01 };
+  b.add(ValuePair(&binary[0], sizeof(binary), ValueType::Binary));
+  b.add(Slice::emptyArraySlice());
+  b.add(Slice::emptyObjectSlice());
+  b.add(Slice::maxKeySlice());
+  b.close();
+
+  Slice s = b.slice();
+  ValueLength const n = s.length();
+  for (ValueLength i = 0; i < n; ++i) {
+    ASSERT_EQ(0, NormalizedCompare::compare(s.at(i), s.at(i)));
+    for (ValueLength j = i + 1; j < n; ++j) {
+      ASSERT_LT(NormalizedCompare::compare(s.at(i), s.at(j)), 0);
+      ASSERT_GT(NormalizedCompare::compare(s.at(j), s.at(i)), 0);
+    }
+  }
+}
+
+TEST(NormalizedCompareTest, CompareNumbers) {
+  auto cmp = [](Value const& lhs, Value const& rhs) {
+    Builder l;
+    l.add(lhs);
+    Builder r;
+    r.add(rhs);
+    return NormalizedCompare::compare(l.slice(), r.slice());
+  };
+
+  ASSERT_EQ(0, cmp(Value(int64_t(1)), Value(uint64_t(1))));
+  ASSERT_EQ(0, cmp(Value(int64_t(1)), Value(1.0)));
+  ASSERT_EQ(0, cmp(Value(uint64_t(1)), Value(1.0)));
+  ASSERT_EQ(0, cmp(Value(0.0), Value(-0.0)));
+  ASSERT_EQ(0, cmp(Value(int64_t(0)), Value(-0.0)));
+  ASSERT_LT(cmp(Value(int64_t(-1)), Value(uint64_t(0))), 0);
+  ASSERT_LT(cmp(Value(int64_t(1)), Value(1.5)), 0);
+  ASSERT_GT(cmp(Value(int64_t(2)), Value(1.5)), 0);
+  ASSERT_LT(cmp(Value(int64_t(-2)), Value(-1.5)), 0);
+  ASSERT_GT(cmp(Value(int64_t(-1)), Value(-1.5)), 0);
+  ASSERT_LT(cmp(Value(INT64_MAX), Value(uint64_t(UINT64_MAX))), 0);
+  ASSERT_GT(cmp(Value(INT64_MIN), Value(-9223372036854775808.0 * 2)), 0);
+  ASSERT_EQ(0, cmp(Value(INT64_MIN), Value(-9223372036854775808.0)));
+  // 2^53 + 1 cannot be represented as a double
+  ASSERT_GT(cmp(Value(int64_t(9007199254740993LL)), Value(9007199254740992.0)), 0);
+  ASSERT_GT(cmp(Value(uint64_t(9007199254740993ULL)), Value(9007199254740992.0)), 0);
+  ASSERT_LT(cmp(Value(uint64_t(UINT64_MAX)), Value(18446744073709551616.0)), 0);
+  ASSERT_LT(cmp(Value(std::nan("")), Value(-INFINITY)), 0);
+  ASSERT_LT(cmp(Value(std::nan("")), Value(INT64_MIN)), 0);
+  ASSERT_EQ(0, cmp(Value(std::nan("")), Value(std::nan(""))));
+  ASSERT_LT(cmp(Value(-INFINITY), Value(INFINITY)), 0);
+}
+
+TEST(NormalizedCompareTest, CompareCompounds) {
+  auto cmp = [](std::string const& lhs, std::string const& rhs) {
+    return NormalizedCompare::compare(Parser::fromJson(lhs)->slice(), Parser::fromJson(rhs)->slice());
+  };
+  
+  ASSERT_EQ(0, cmp("[]", "[]"));
+  ASSERT_EQ(0, cmp("[1,2,3]", "[1.0,2,3.0]"));
+  ASSERT_LT(cmp("[]", "[null]"), 0);
+  ASSERT_LT(cmp("[1,2]", "[1,2,3]"), 0);
+  ASSERT_LT(cmp("[1,2,3]", "[1,3]"), 0);
+  ASSERT_GT(cmp("[\"b\"]", "[\"a\",\"z\"]"), 0);
+  
+  ASSERT_EQ(0, cmp("{}", "{}"));
+  ASSERT_EQ(0, cmp("{\"a\":1,\"b\":2}", "{\"b\":2.0,\"a\":1}"));
+  ASSERT_LT(cmp("{}", "{\"a\":null}"), 0);
+  ASSERT_LT(cmp("{\"a\":1}", "{\"a\":1,\"b\":1}"), 0);
+  ASSERT_LT(cmp("{\"a\":1}", "{\"b\":1}"), 0);
+  ASSERT_GT(cmp("{\"a\":2}", "{\"a\":1,\"b\":1}"), 0);
+  ASSERT_LT(cmp("{\"a\":{\"x\":[1]}}", "{\"a\":{\"x\":[2]}}"), 0);
+  
+  ASSERT_LT(cmp("\"a\"", "\"ab\""), 0);
+  ASSERT_LT(cmp("\"ab\"", "\"b\""), 0);
+  ASSERT_LT(cmp("\"B\"", "\"a\""), 0);
+}
+
+TEST(NormalizedCompareTest, CompareLess) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[3, \"a\", null, [1], -2.5, {\"a\":1}, true, 17, \"\"]");
+  Builder sorted = Collection::sort(b->slice(), NormalizedCompare::Less());
+  ASSERT_EQ("[null,true,-2.5,3,17,\"\",\"a\",[1],{\"a\":1}]", sorted.slice().toJson());
+}
+
+TEST(NormalizedCompareTest, CompareCustom) {
+  Builder b;
+  uint8_t* p = b.add(ValuePair(2ULL, ValueType::Custom));
+  *p++ = 0xf0;
+  *p++ = 0xaa;  
+
+  ASSERT_VELOCYPACK_EXCEPTION(NormalizedCompare::compare(b.slice(), b.slice()), Exception::NotImplemented);
+  ASSERT_VELOCYPACK_EXCEPTION(SortKey::encode(b.slice()), Exception::NotImplemented);
+}
+
+TEST(SortKeyTest, OrderMatchesCompare) {
+  std::vector<std::shared_ptr<Builder>> values;
+  for (auto const& json : { "null", "false", "true", "-1e300", "-9007199254740993", 
+                            "-9007199254740992", "-1.5", "-1", "-0.0", "0", "0.5", "1",
+                            "1.0", "9007199254740992", "9007199254740993", "9223372036854775807",
+                            "9223372036854775808", "18446744073709551615", "1e300", 
+                            "\"\"", "\"a\"", "\"a\\u0000\"", "\"a\\u0000b\"", "\"ab\"", "\"b\"",
+                            "[]", "[null]", "[1,2]", "[1,2,3]", "[1,3]", "[\"a\"]", "[\"a\",1]", "[[]]",
+                            "{}", "{\"a\":null}", "{\"a\":1}", "{\"a\":1,\"b\":1}", "{\"b\":1,\"a\":2}",
+                            "{\"a\\u0000\":1}", "{\"ab\":1}", "{\"b\":0}" }) {
+    values.emplace_back(Parser::fromJson(json));
+  }
+  
+  Builder b;
+  b.openArray();
+  b.add(Value(int64_t(-1000), ValueType::UTCDate));
+  b.add(Value(int64_t(1000), ValueType::UTCDate));
+  b.add(Slice::minKeySlice());
+  b.add(Slice::maxKeySlice());
+  uint8_t const binary[] = { 0x00, 0x01 };
+  b.add(ValuePair(&binary[0], sizeof(binary), ValueType::Binary));
+  b.add(ValuePair(&binary[0], 1, ValueType::Binary));
+  b.close();
+  for (auto const& it : ArrayIterator(b.slice())) {
+    values.emplace_back(std::make_shared<Builder>(it));
+  }
+
+  for (auto const& lhs : values) {
+    std::string const lhsKey = SortKey::encode(lhs->slice());
+    for (auto const& rhs : values) {
+      std::string const rhsKey = SortKey::encode(rhs->slice());
+      int expected = NormalizedCompare::compare(lhs->slice(), rhs->slice());
+      int actual = lhsKey.compare(rhsKey);
+      ASSERT_EQ(expected < 0, actual < 0) << lhs->slice().toHex() << " vs " << rhs->slice().toHex();
+      ASSERT_EQ(expected == 0, actual == 0) << lhs->slice().toHex() << " vs " << rhs->slice().toHex();
+    }
+  }
+}
+
+TEST(SortKeyTest, CompactAndIndexedAreEqual) {
+  Options options;
+  options.buildUnindexedArrays = true;
+  options.buildUnindexedObjects = true;
+  std::string const json("{\"z\":[1,2,{\"c\":3,\"b\":\"x\"}],\"a\":-1.25,\"m\":{}}");
+  
+  std::shared_ptr<Builder> compact = Parser::fromJson(json, &options);
+  std::shared_ptr<Builder> indexed = Parser::fromJson(json);
+  ASSERT_NE(compact->slice().head(), indexed->slice().head());
+  
+  ASSERT_EQ(0, NormalizedCompare::compare(compact->slice(), indexed->slice()));
+  ASSERT_EQ(SortKey::encode(compact->slice()), SortKey::encode(indexed->slice()));
 }
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,341 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+#include "tests-common.h"
+
+namespace {
+
+std::string roundtrip(std::string const& input) {
+  auto src = reinterpret_cast<uint8_t const*>(input.data());
+  std::string compressed(LZCodec::maxCompressedLength(input.size()), '\0');
+  std::size_t length = LZCodec::compress(
+      src, input.size(), reinterpret_cast<uint8_t*>(&compressed[0]));
+  EXPECT_LE(length, LZCodec::maxCompressedLength(input.size()));
+
+  std::string result(input.size(), '\0');
+  LZCodec::decompress(reinterpret_cast<uint8_t const*>(compressed.data()),
+                      length, reinterpret_cast<uint8_t*>(&result[0]),
+                      result.size());
+  return result;
+}
+
+// writes n Objects into a container with the specified block size
+std::string writeValues(std::size_t n, std::size_t blockSize) {
+  std::string out;
+  StringSink sink(&out);
+  CompressedWriter writer(&sink, blockSize);
+  for (std::size_t i = 0; i < n; ++i) {
+    Builder b;
+    b.openObject();
+    b.add("_key", Value("key" + std::to_string(i)));
+    b.add("value", Value(i));
+    b.add("name", Value("some repeated text that compresses well"));
+    b.close();
+    writer.add(b.slice());
+  }
+  writer.finish();
+  EXPECT_EQ(n, writer.values());
+  EXPECT_EQ(out.size(), writer.bytesWritten());
+  return out;
+}
+
+}  // namespace
+
+TEST(CompressionTest, CodecRoundtrip) {
+  ASSERT_EQ("", roundtrip(""));
+  ASSERT_EQ("a", roundtrip("a"));
+  ASSERT_EQ("abcde", roundtrip("abcde"));
+  ASSERT_EQ(std::string(100000, 'x'), roundtrip(std::string(100000, 'x')));
+
+  std::string text;
+  for (int i = 0; i < 5000; ++i) {
+    text.append("the quick brown fox " + std::to_string(i % 97) + " ");
+  }
+  ASSERT_EQ(text, roundtrip(text));
+
+  // pseudo-random data does not compress, but must roundtrip
+  std::string random;
+  uint32_t state = 42;
+  for (int i = 0; i < 70000; ++i) {
+    state = state * 1103515245U + 12345U;
+    random.push_back(static_cast<char>(state >> 24));
+  }
+  ASSERT_EQ(random, roundtrip(random));
+}
+
+TEST(CompressionTest, CodecCompresses) {
+  std::string input(65536, 'a');
+  std::string compressed(LZCodec::maxCompressedLength(input.size()), '\0');
+  std::size_t length = LZCodec::compress(
+      reinterpret_cast<uint8_t const*>(input.data()), input.size(),
+      reinterpret_cast<uint8_t*>(&compressed[0]));
+  ASSERT_LT(length, 300U);
+}
+
+TEST(CompressionTest, CodecCorruptData) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i) {
+    input.append("abcdefgh");
+  }
+  std::string compressed(LZCodec::maxCompressedLength(input.size()), '\0');
+  std::size_t length = LZCodec::compress(
+      reinterpret_cast<uint8_t const*>(input.data()), input.size(),
+      reinterpret_cast<uint8_t*>(&compressed[0]));
+  auto src = reinterpret_cast<uint8_t const*>(compressed.data());
+
+  std::string out(input.size(), '\0');
+  auto dst = reinterpret_cast<uint8_t*>(&out[0]);
+
+  // truncated input
+  ASSERT_VELOCYPACK_EXCEPTION(LZCodec::decompress(src, length - 1, dst, out.size()),
+                              Exception::CorruptCompressedData);
+  // wrong output length
+  ASSERT_VELOCYPACK_EXCEPTION(LZCodec::decompress(src, length, dst, out.size() - 1),
+                              Exception::CorruptCompressedData);
+  ASSERT_VELOCYPACK_EXCEPTION(LZCodec::decompress(src, 0, dst, out.size()),
+                              Exception::CorruptCompressedData);
+
+  // match distance beyond the start of the output
+  uint8_t const badDistance[] = {0x10, 'a', 0x05, 0x00, 0x00};
+  ASSERT_VELOCYPACK_EXCEPTION(LZCodec::decompress(badDistance, sizeof(badDistance), dst, 5),
+                              Exception::CorruptCompressedData);
+}
+
+TEST(CompressionTest, WriteAndReadValues) {
+  std::string data = writeValues(1000, 4096);
+
+  CompressedReader reader(data.data(), data.size());
+  ASSERT_EQ(1000U, reader.values());
+  ASSERT_TRUE(reader.blocks() > 1);
+
+  uint64_t expected = 0;
+  for (std::size_t i = 0; i < reader.blocks(); ++i) {
+    CompressedBlock block = reader.block(i);
+    ASSERT_EQ(expected, block.firstValue());
+    for (std::size_t j = 0; j < block.size(); ++j) {
+      Slice s = block.at(j);
+      ASSERT_EQ(expected, s.get("value").getUInt());
+      ASSERT_EQ("key" + std::to_string(expected), s.get("_key").copyString());
+      ++expected;
+    }
+  }
+  ASSERT_EQ(1000U, expected);
+}
+
+TEST(CompressionTest, BlocksAreCompressed) {
+  std::string data = writeValues(1000, CompressedWriter::defaultBlockSize);
+
+  uint64_t uncompressed = 0;
+  CompressedReader reader(data.data(), data.size());
+  for (auto const& block : reader.decompress()) {
+    uncompressed += block.length();
+  }
+  ASSERT_LT(data.size() * 3, uncompressed);
+}
+
+TEST(CompressionTest, LargeValueGetsOwnBlock) {
+  std::string out;
+  StringSink sink(&out);
+  CompressedWriter writer(&sink, 64);
+
+  Builder small;
+  small.add(Value(1));
+  Builder large;
+  large.add(Value(std::string(1000, 'z')));
+
+  writer.add(small.slice());
+  writer.add(large.slice());
+  writer.add(small.slice());
+  writer.finish();
+  ASSERT_EQ(3U, writer.blocks());
+
+  CompressedReader reader(out.data(), out.size());
+  ASSERT_EQ(3U, reader.values());
+  ASSERT_EQ(1U, reader.findBlock(1));
+  ASSERT_EQ(std::string(1000, 'z'), reader.block(1).at(0).copyString());
+}
+
+TEST(CompressionTest, EmptyContainer) {
+  std::string out;
+  StringSink sink(&out);
+  CompressedWriter writer(&sink);
+  writer.finish();
+  ASSERT_EQ(0U, writer.blocks());
+
+  CompressedReader reader(out.data(), out.size());
+  ASSERT_EQ(0U, reader.blocks());
+  ASSERT_EQ(0U, reader.values());
+  ASSERT_TRUE(reader.decompress(4).empty());
+  ASSERT_VELOCYPACK_EXCEPTION(reader.findBlock(0), Exception::IndexOutOfBounds);
+}
+
+TEST(CompressionTest, FlushEndsBlock) {
+  std::string out;
+  StringSink sink(&out);
+  CompressedWriter writer(&sink);
+
+  Builder b;
+  b.add(Value("foo"));
+  writer.add(b.slice());
+  writer.flush();
+  writer.flush();
+  writer.add(b.slice());
+  writer.finish();
+  ASSERT_EQ(2U, writer.blocks());
+
+  ASSERT_VELOCYPACK_EXCEPTION(writer.add(b.slice()), Exception::InternalError);
+}
+
+TEST(CompressionTest, FindBlock) {
+  std::string data = writeValues(500, 1024);
+  CompressedReader reader(data.data(), data.size());
+
+  for (uint64_t i = 0; i < reader.values(); ++i) {
+    CompressedBlock block = reader.block(reader.findBlock(i));
+    ASSERT_LE(block.firstValue(), i);
+    ASSERT_LT(i, block.firstValue() + block.size());
+    ASSERT_EQ(i, block.at(static_cast<std::size_t>(i - block.firstValue()))
+                     .get("value").getUInt());
+  }
+  ASSERT_VELOCYPACK_EXCEPTION(reader.findBlock(500), Exception::IndexOutOfBounds);
+  ASSERT_VELOCYPACK_EXCEPTION(reader.block(reader.blocks()), Exception::IndexOutOfBounds);
+}
+
+TEST(CompressionTest, ParallelDecompression) {
+  std::string data = writeValues(2000, 2048);
+  CompressedReader reader(data.data(), data.size());
+  reader.validate = true;
+
+  std::vector<CompressedBlock> serial = reader.decompress(1);
+  ThreadPool pool(3);
+  for (std::vector<CompressedBlock> const& parallel : {reader.decompress(4), reader.decompress(pool)}) {
+    ASSERT_EQ(reader.blocks(), serial.size());
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+      ASSERT_EQ(serial[i].firstValue(), parallel[i].firstValue());
+      ASSERT_EQ(serial[i].length(), parallel[i].length());
+      ASSERT_EQ(0, memcmp(serial[i].data().get(), parallel[i].data().get(),
+                          serial[i].length()));
+    }
+  }
+}
+
+TEST(CompressionTest, BlockOutlivesReader) {
+  CompressedBlock block;
+  {
+    std::string data = writeValues(10, 4096);
+    CompressedReader reader(data.data(), data.size());
+    block = reader.block(0);
+  }
+  ASSERT_EQ(10U, block.size());
+  ASSERT_EQ(9U, block[9].get("value").getUInt());
+}
+
+TEST(CompressionTest, CorruptContainer) {
+  std::string data = writeValues(100, 1024);
+
+  ASSERT_VELOCYPACK_EXCEPTION(CompressedReader(data.data(), 10),
+                              Exception::CorruptCompressedData);
+
+  std::string badHeader = data;
+  badHeader[0] = 'X';
+  ASSERT_VELOCYPACK_EXCEPTION(CompressedReader(badHeader.data(), badHeader.size()),
+                              Exception::CorruptCompressedData);
+
+  std::string badFooter = data;
+  badFooter[badFooter.size() - 1] = 'X';
+  ASSERT_VELOCYPACK_EXCEPTION(CompressedReader(badFooter.data(), badFooter.size()),
+                              Exception::CorruptCompressedData);
+
+  // truncated container
+  ASSERT_VELOCYPACK_EXCEPTION(CompressedReader(data.data(), data.size() - 1),
+                              Exception::CorruptCompressedData);
+
+  // flipping a byte of the first block's data is detected when reading it
+  std::string badBlock = data;
+  badBlock[CompressedFormat::headerLength + CompressedFormat::blockHeaderLength + 10] ^= 0x01;
+  CompressedReader reader(badBlock.data(), badBlock.size());
+  ASSERT_VELOCYPACK_EXCEPTION(reader.block(0), Exception::CorruptCompressedData);
+  ASSERT_VELOCYPACK_EXCEPTION(reader.decompress(2), Exception::CorruptCompressedData);
+  reader.block(1);
+}
+
+TEST(CompressionTest, CorruptBlockHeader) {
+  // a single LZ compressed block
+  std::string data = writeValues(100, 1 << 20);
+  std::size_t const header = CompressedFormat::headerLength;
+  ASSERT_EQ(static_cast<uint8_t>(CompressedFormat::LZ), static_cast<uint8_t>(data[header]));
+
+  // a decompressed length the compressed data cannot expand to is
+  // rejected before it is allocated
+  std::string badLength = data;
+  for (std::size_t i = 5; i < 9; ++i) {
+    badLength[header + i] = '\xff';
+  }
+  CompressedReader lengthReader(badLength.data(), badLength.size());
+  ASSERT_VELOCYPACK_EXCEPTION(lengthReader.block(0), Exception::CorruptCompressedData);
+
+  // a huge value count does not reserve memory for that many values
+  std::string badCount = data;
+  for (std::size_t i = 9; i < 13; ++i) {
+    badCount[header + i] = '\xff';
+  }
+  CompressedReader countReader(badCount.data(), badCount.size());
+  ASSERT_VELOCYPACK_EXCEPTION(countReader.block(0), Exception::CorruptCompressedData);
+}
+
+TEST(CompressionTest, MaxDecompressedLength) {
+  // a run of identical bytes compresses best
+  std::string input(1000000, 'x');
+  auto src = reinterpret_cast<uint8_t const*>(input.data());
+  std::string compressed(LZCodec::maxCompressedLength(input.size()), '\0');
+  std::size_t length = LZCodec::compress(
+      src, input.size(), reinterpret_cast<uint8_t*>(&compressed[0]));
+  ASSERT_LE(input.size(), LZCodec::maxDecompressedLength(length));
+}
+
+#if __cplusplus >= 201703L
+TEST(CompressionTest, SharedSlices) {
+  std::string data = writeValues(100, 1024);
+  CompressedReader reader(data.data(), data.size());
+
+  SharedSlice value = reader.get(42);
+  ASSERT_EQ(42U, value.get("value").getUInt());
+
+  CompressedBlock block = reader.block(0);
+  SharedSlice first = block.sharedAt(0);
+  ASSERT_EQ(block.data(), first.buffer());
+}
+#endif
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
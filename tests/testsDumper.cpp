@@ -1596,6 +1596,406 @@ TEST(DumperTest, EmptyAttributeName) {
   ASSERT_EQ(std::string(R"({"":123,"a":"abc"})"), buffer);
 }
 
+TEST(DumperTest, PackedArrays) {
+  std::vector<int64_t> ints{1, -2, 3};
+  std::vector<double> doubles{1.5, -2.25};
+  std::vector<float> floats{0.5f};
+
+  Builder b;
+  b.openObject();
+  b.addPacked(StringRef("d"), doubles);
+  b.addPacked(StringRef("e"), std::vector<int64_t>());
+  b.addPacked(StringRef("f"), floats);
+  b.addPacked(StringRef("i"), ints);
+  b.close();
+
+  Options options;
+  options.packedArrays = true;
+  ASSERT_EQ(std::string(R"({"d":[1.5,-2.25],"e":[],"f":[0.5],"i":[1,-2,3]})"),
+            b.slice().toJson(&options));
+
+  options.prettyPrint = true;
+  Builder b2;
+  b2.addPacked(ints);
+  ASSERT_EQ(std::string("[\n  1,\n  -2,\n  3\n]"), b2.slice().toJson(&options));
+}
+
+TEST(DumperTest, PackedArrayTagsWithoutOption) {
+  // Binary values under application tags 64 to 66 keep being read and dumped
+  // like any other tagged Binary value
+  Builder b;
+  b.openArray();
+  b.addTagged(0x40, ValuePair("\x01\x00\x00\x00\x00\x00\x00\x00", 8, ValueType::Binary));
+  b.addTagged(0x42, ValuePair("\x00\x00\x00\x3f", 4, ValueType::Binary));
+  b.close();
+  ASSERT_FALSE(b.slice().at(0).isPackedArray());
+
+  Options options;
+  ASSERT_VELOCYPACK_EXCEPTION(b.slice().toJson(&options), Exception::NoJsonEquivalent);
+  ASSERT_VELOCYPACK_EXCEPTION(Dumper::maxOutputSize(b.slice(), &options),
+                              Exception::NoJsonEquivalent);
+
+  options.binaryAsHex = true;
+  ASSERT_EQ(std::string(R"(["0100000000000000","0000003f"])"), b.slice().toJson(&options));
+  ASSERT_EQ(b.slice().toJson(&options).size(), Dumper::maxOutputSize(b.slice(), &options));
+
+  options.packedArrays = true;
+  ASSERT_EQ(std::string("[[1],[0.5]]"), b.slice().toJson(&options));
+}
+
+TEST(DumperTest, PackedArrayUnsupportedDoubles) {
+  std::vector<double> doubles{1.0, std::nan("")};
+
+  Builder b;
+  b.addPacked(doubles);
+
+  Options options;
+  options.packedArrays = true;
+  ASSERT_VELOCYPACK_EXCEPTION(b.slice().toJson(&options), Exception::NoJsonEquivalent);
+
+  options.unsupportedDoublesAsString = true;
+  ASSERT_EQ(std::string(R"([1,"NaN"])"), b.slice().toJson(&options));
+}
+
+TEST(DumperTest, TaggedCompoundKeepsIndentation) {
+  Builder b;
+  b.openArray();
+  b.addTagged(42, Value(ValueType::Object));
+  b.add("a", Value(1));
+  b.close();
+  b.add(Value(2));
+  b.close();
+
+  Options options;
+  options.prettyPrint = true;
+  ASSERT_EQ(std::string("[\n  {\n    \"a\" : 1\n  },\n  2\n]"),
+            b.slice().toJson(&options));
+}
+
+TEST(DumperTest, DumpParallel) {
+  Builder b;
+  b.openArray();
+  for (int i = 0; i < 1000; ++i) {
+    b.openObject();
+    b.add("id", Value(i));
+    b.add("name", Value("name" + std::to_string(i)));
+    b.add("tags", Value(ValueType::Array));
+    b.add(Value("a"));
+    b.add(Value(i % 7 == 0));
+    b.close();
+    b.close();
+  }
+  b.close();
+
+  Builder o;
+  o.openObject();
+  for (int i = 0; i < 1000; ++i) {
+    o.add("key" + std::to_string(i), Value(i));
+  }
+  o.close();
+
+  for (Slice slice : {b.slice(), o.slice()}) {
+    for (int mode = 0; mode < 4; ++mode) {
+      Options options;
+      options.prettyPrint = (mode == 1);
+      options.singleLinePrettyPrint = (mode == 2);
+      options.dumpAttributesInIndexOrder = (mode == 3);
+      std::string const expected = slice.toJson(&options);
+
+      for (std::size_t threads : {1, 2, 3, 8}) {
+        for (ValueLength minMembers : {1, 100, 10000}) {
+          std::string buffer;
+          StringSink sink(&buffer);
+          Dumper dumper(&sink, &options);
+          dumper.minMembersPerThread = minMembers;
+          dumper.dumpParallel(slice, threads);
+          ASSERT_EQ(expected, buffer);
+        }
+      }
+    }
+  }
+}
+
+TEST(DumperTest, DumpParallelWithPool) {
+  Builder b;
+  b.openArray();
+  for (int i = 0; i < 1000; ++i) {
+    b.add(Value(i));
+  }
+  b.close();
+
+  ThreadPool pool(4);
+  for (int i = 0; i < 10; ++i) {
+    std::string buffer;
+    StringSink sink(&buffer);
+    Dumper dumper(&sink);
+    dumper.minMembersPerThread = 10;
+    dumper.dumpParallel(b.slice(), pool);
+    ASSERT_EQ(b.slice().toJson(), buffer);
+  }
+}
+
+TEST(DumperTest, DumpParallelScalarsAndCompact) {
+  Options options;
+  options.buildUnindexedArrays = true;
+  options.buildUnindexedObjects = true;
+  std::shared_ptr<Builder> compact = Parser::fromJson(R"([1,"a",{"b":[2,3]},null,4.5])", &options);
+  std::shared_ptr<Builder> scalar = Parser::fromJson(R"("foo")");
+
+  for (Slice slice : {compact->slice(), scalar->slice()}) {
+    std::string buffer;
+    StringSink sink(&buffer);
+    Dumper dumper(&sink);
+    dumper.minMembersPerThread = 1;
+    dumper.dumpParallel(slice, 4);
+    ASSERT_EQ(slice.toJson(), buffer);
+  }
+}
+
+TEST(DumperTest, DumpParallelError) {
+  Builder b;
+  b.openArray();
+  for (int i = 0; i < 100; ++i) {
+    b.add(Value(i));
+  }
+  b.add(Value(ValueType::MinKey));
+  b.close();
+
+  Options options;
+  options.unsupportedTypeBehavior = Options::FailOnUnsupportedType;
+  std::string buffer;
+  StringSink sink(&buffer);
+  Dumper dumper(&sink, &options);
+  dumper.minMembersPerThread = 10;
+  ASSERT_VELOCYPACK_EXCEPTION(dumper.dumpParallel(b.slice(), 4), Exception::NoJsonEquivalent);
+}
+
+TEST(DumperTest, MaxOutputSizeIsExactWithoutDoubles) {
+  std::string const value(R"({"a":[1,-2,-3000000000,18446744073709551615,[],{},)"
+                          R"([[[]]],{"b":{"c":null}}],"d":"foo\n\"bar\"\u0001/",)"
+                          R"("e":true,"f":false,"g":[{"x":0,"y":[-9223372036854775808]},)"
+                          R"({"x":"ä€𝄞"}],"h":"\/\\\t"})");
+  Options parseOptions;
+  Builder indexed = *Parser::fromJson(value, &parseOptions);
+  parseOptions.buildUnindexedArrays = true;
+  parseOptions.buildUnindexedObjects = true;
+  Builder compact = *Parser::fromJson(value, &parseOptions);
+
+  Builder other;
+  other.openArray();
+  other.addTagged(42, Value(ValueType::Object));
+  other.add("a", Value(ValueType::MinKey));
+  other.close();
+  other.add(ValuePair("", 0, ValueType::Binary));
+  other.add(ValuePair("\x01\xff\x10", 3, ValueType::Binary));
+  other.add(Value(12345, ValueType::UTCDate));
+  other.add(Value(-1, ValueType::UTCDate));
+  other.addPacked(std::vector<int64_t>{1, -2, 300});
+  other.close();
+
+  for (Slice slice : {indexed.slice(), compact.slice(), other.slice()}) {
+    for (int mode = 0; mode < 6; ++mode) {
+      Options options;
+      options.prettyPrint = (mode == 1 || mode == 4);
+      options.singleLinePrettyPrint = (mode == 2);
+      options.escapeUnicode = (mode == 3 || mode == 4);
+      options.escapeForwardSlashes = (mode == 3);
+      options.binaryAsHex = (mode == 1 || mode == 3);
+      options.datesAsIntegers = (mode == 2 || mode == 5);
+      options.debugTags = (mode == 4 || mode == 5);
+      options.packedArrays = (mode != 0);
+      options.unsupportedTypeBehavior = (mode % 2 == 0) ? Options::NullifyUnsupportedType
+                                                        : Options::ConvertUnsupportedType;
+      ASSERT_EQ(slice.toJson(&options).size(), Dumper::maxOutputSize(slice, &options));
+    }
+  }
+}
+
+TEST(DumperTest, MaxOutputSizeWithDoubles) {
+  std::shared_ptr<Builder> b = Parser::fromJson(
+      R"([0.5,-1.25,1e300,-2.2250738585072014e-308,{"a":3.141592653589793}])");
+  Builder packed;
+  packed.addPacked(std::vector<double>{1.5, -0.1});
+
+  Options plain;
+  plain.packedArrays = true;
+  Options options = plain;
+  options.prettyPrint = true;
+  for (Slice slice : {b->slice(), packed.slice()}) {
+    ASSERT_LE(slice.toJson(&plain).size(), Dumper::maxOutputSize(slice, &plain));
+    ASSERT_LE(slice.toJson(&options).size(), Dumper::maxOutputSize(slice, &options));
+  }
+
+  Builder special;
+  special.openArray();
+  special.add(Value(std::nan("")));
+  special.add(Value(INFINITY));
+  special.add(Value(-INFINITY));
+  special.close();
+  ASSERT_VELOCYPACK_EXCEPTION(Dumper::maxOutputSize(special.slice()), Exception::NoJsonEquivalent);
+  options.unsupportedDoublesAsString = true;
+  ASSERT_EQ(special.slice().toJson(&options).size(),
+            Dumper::maxOutputSize(special.slice(), &options));
+}
+
+TEST(DumperTest, MaxOutputSizeErrors) {
+  Builder b;
+  b.add(Value(ValueType::MaxKey));
+  Options options;
+  options.unsupportedTypeBehavior = Options::FailOnUnsupportedType;
+  ASSERT_VELOCYPACK_EXCEPTION(Dumper::maxOutputSize(b.slice(), &options),
+                              Exception::NoJsonEquivalent);
+
+  Builder s;
+  s.add(ValuePair("ab\xc3", 3, ValueType::String));
+  ASSERT_VELOCYPACK_EXCEPTION(Dumper::maxOutputSize(s.slice()),
+                              Exception::InvalidUtf8Sequence);
+}
+
+static std::string produceAll(Slice slice, Options const* options, std::size_t maxBytes) {
+  StreamingDumper dumper(slice, options);
+  std::string result;
+  std::vector<char> buffer(maxBytes);
+  while (true) {
+    std::size_t n = dumper.produce(buffer.data(), maxBytes);
+    result.append(buffer.data(), n);
+    if (n < maxBytes) {
+      EXPECT_TRUE(dumper.done());
+      EXPECT_EQ(0U, dumper.produce(buffer.data(), maxBytes));
+      return result;
+    }
+  }
+}
+
+TEST(StreamingDumperTest, SameOutputAsDumper) {
+  std::string const value(R"({"a":[1,2.5,-3,[],{},[[[]]],{"b":{"c":null}}],)"
+                          R"("d":"foo\n\"bar\"\u0001","e":true,"f":false,)"
+                          R"("g":[{"x":1,"y":[2,3]},{"x":"ä€"}]})");
+  Options parseOptions;
+  Builder indexed = *Parser::fromJson(value, &parseOptions);
+  parseOptions.buildUnindexedArrays = true;
+  parseOptions.buildUnindexedObjects = true;
+  Builder compact = *Parser::fromJson(value, &parseOptions);
+
+  for (Slice slice : {indexed.slice(), compact.slice()}) {
+    for (int mode = 0; mode < 4; ++mode) {
+      Options options;
+      options.prettyPrint = (mode == 1);
+      options.singleLinePrettyPrint = (mode == 2);
+      options.dumpAttributesInIndexOrder = (mode == 3);
+      options.escapeUnicode = (mode == 3);
+      std::string expected = slice.toJson(&options);
+      for (std::size_t maxBytes : {1, 2, 7, 64, 4096}) {
+        ASSERT_EQ(expected, produceAll(slice, &options, maxBytes));
+      }
+    }
+  }
+}
+
+TEST(StreamingDumperTest, Scalars) {
+  Options options;
+  for (auto const& json : {"null", "true", "-17", "3.25", R"("")", R"("abc")", "[]", "{}"}) {
+    std::shared_ptr<Builder> b = Parser::fromJson(json);
+    ASSERT_EQ(std::string(json), produceAll(b->slice(), &options, 3));
+  }
+
+  options.prettyPrint = true;
+  std::shared_ptr<Builder> b = Parser::fromJson("[]");
+  ASSERT_EQ(std::string("[\n]"), produceAll(b->slice(), &options, 3));
+}
+
+TEST(StreamingDumperTest, LongStrings) {
+  // multi-byte UTF-8 sequences at all possible positions relative to
+  // the boundaries of the pieces the string is escaped in
+  std::string value;
+  for (std::size_t i = 0; i < 5000; ++i) {
+    value.append(i % 3 == 0 ? "\xe2\x82\xac" : (i % 3 == 1 ? "\xc3\xa4" : "x\""));
+  }
+  Builder b;
+  b.openArray();
+  b.add(Value(value));
+  b.add(Value(value.substr(1)));
+  b.close();
+
+  for (bool escapeUnicode : {false, true}) {
+    Options options;
+    options.escapeUnicode = escapeUnicode;
+    std::string expected = b.slice().toJson(&options);
+    ASSERT_EQ(expected, produceAll(b.slice(), &options, 1000));
+    ASSERT_EQ(expected, produceAll(b.slice(), &options, 1));
+  }
+}
+
+TEST(StreamingDumperTest, TaggedAndExternalValues) {
+  Builder inner;
+  inner.openObject();
+  inner.add("x", Value(1));
+  inner.close();
+
+  Builder b;
+  b.openArray();
+  b.addTagged(7, Value(ValueType::Array));
+  b.add(Value(1));
+  b.close();
+  b.add(Value(static_cast<void const*>(inner.slice().start())));
+  b.addPacked(std::vector<int64_t>{1, 2});
+  b.close();
+
+  for (int mode = 0; mode < 3; ++mode) {
+    Options options;
+    options.prettyPrint = (mode == 1);
+    options.debugTags = (mode == 2);
+    options.binaryAsHex = true;
+    options.packedArrays = (mode != 0);
+    ASSERT_EQ(b.slice().toJson(&options), produceAll(b.slice(), &options, 5));
+  }
+}
+
+TEST(StreamingDumperTest, DeepNesting) {
+  std::string value;
+  for (int i = 0; i < 1000; ++i) {
+    value.append(R"({"a":[)");
+  }
+  for (int i = 0; i < 1000; ++i) {
+    value.append("]}");
+  }
+  std::shared_ptr<Builder> b = Parser::fromJson(value);
+  Options options;
+  ASSERT_EQ(value, produceAll(b->slice(), &options, 100));
+}
+
+TEST(StreamingDumperTest, Reset) {
+  std::shared_ptr<Builder> first = Parser::fromJson(R"([1,2,3,4,5,6,7,8,9])");
+  std::shared_ptr<Builder> second = Parser::fromJson(R"({"a":"b"})");
+
+  StreamingDumper dumper(first->slice());
+  char buffer[5];
+  ASSERT_EQ(5U, dumper.produce(buffer, sizeof(buffer)));
+  ASSERT_EQ(std::string("[1,2,"), std::string(buffer, 5));
+  ASSERT_FALSE(dumper.done());
+
+  dumper.reset(second->slice());
+  ASSERT_EQ(5U, dumper.produce(buffer, sizeof(buffer)));
+  ASSERT_EQ(std::string(R"({"a":)"), std::string(buffer, 5));
+  ASSERT_EQ(4U, dumper.produce(buffer, sizeof(buffer)));
+  ASSERT_EQ(std::string(R"("b"})"), std::string(buffer, 4));
+  ASSERT_TRUE(dumper.done());
+}
+
+TEST(StreamingDumperTest, UnsupportedType) {
+  Builder b;
+  b.openArray();
+  b.add(Value(ValueType::MinKey));
+  b.close();
+
+  Options options;
+  options.unsupportedTypeBehavior = Options::FailOnUnsupportedType;
+  StreamingDumper dumper(b.slice(), &options);
+  char buffer[16];
+  ASSERT_VELOCYPACK_EXCEPTION(dumper.produce(buffer, sizeof(buffer)),
+                              Exception::NoJsonEquivalent);
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
 
@@ -54,6 +54,11 @@ TEST(ExceptionTest, TestMessages) {
   ASSERT_STREQ("Cannot translate key",
                Exception::message(Exception::CannotTranslateKey));
   ASSERT_STREQ("Key not found", Exception::message(Exception::KeyNotFound));
+  ASSERT_STREQ("Cannot execute operation without shape registry",
+               Exception::message(Exception::NeedShapeRegistry));
+  ASSERT_STREQ("Unknown shape", Exception::message(Exception::UnknownShape));
+  ASSERT_STREQ("Corrupt compressed data",
+               Exception::message(Exception::CorruptCompressedData));
   ASSERT_STREQ("Builder value not yet sealed",
                Exception::message(Exception::BuilderNotSealed));
   ASSERT_STREQ("Need open Object",
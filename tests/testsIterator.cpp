@@ -295,6 +295,42 @@ TEST(IteratorTest, IterateCompactArrayForward) {
   ASSERT_VELOCYPACK_EXCEPTION(it.value(), Exception::IndexOutOfBounds);
 }
 
+TEST(IteratorTest, IterateObjectForward) {
+  std::string const value(R"({"a":1,"b":2,"c":3,"d":4,"e":5})");
+
+  for (bool compact : {false, true}) {
+    Options options;
+    options.buildUnindexedObjects = compact;
+
+    Parser parser(&options);
+    parser.parse(value);
+    Slice s(parser.start());
+
+    for (bool sequential : {false, true}) {
+      ObjectIterator it(s, sequential);
+      ASSERT_EQ(5U, it.size());
+
+      it.forward(1);
+      ASSERT_TRUE(it.valid());
+      ASSERT_EQ("b", it.key().copyString());
+      ASSERT_EQ(2UL, it.value().getUInt());
+
+      it.forward(2);
+      ASSERT_TRUE(it.valid());
+      ASSERT_EQ(3U, it.index());
+      ASSERT_EQ("d", it.key().copyString());
+      ASSERT_EQ(4UL, it.value().getUInt());
+
+      it.forward(0);
+      ASSERT_EQ("d", it.key().copyString());
+
+      it.forward(2);
+      ASSERT_FALSE(it.valid());
+      ASSERT_VELOCYPACK_EXCEPTION(it.value(), Exception::IndexOutOfBounds);
+    }
+  }
+}
+
 TEST(IteratorTest, IterateSubArray) {
   std::string const value("[[1,2,3],[\"foo\",\"bar\"]]");
 
@@ -0,0 +1,288 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+#include "tests-common.h"
+
+namespace {
+
+std::string fromHex(std::string const& hex) {
+  std::string result;
+  for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+    result.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+  }
+  return result;
+}
+
+std::string toHex(std::string const& data) {
+  static char const digits[] = "0123456789abcdef";
+  std::string result;
+  for (unsigned char c : data) {
+    result.push_back(digits[c >> 4]);
+    result.push_back(digits[c & 0x0f]);
+  }
+  return result;
+}
+
+std::string toMessagePack(Builder const& b, Options const* options = &Options::Defaults) {
+  return toHex(MessagePackDumper::toString(b.slice(), options));
+}
+
+std::string roundtrip(std::string const& json) {
+  std::shared_ptr<Builder> b = Parser::fromJson(json);
+  std::string const data = MessagePackDumper::toString(b->slice());
+  std::shared_ptr<Builder> result = MessagePackParser::fromMessagePack(data);
+  return result->slice().toJson();
+}
+
+}  // namespace
+
+TEST(MessagePackDumperTest, Scalars) {
+  struct {
+    Value value;
+    char const* expected;
+  } const cases[] = {
+      {Value(ValueType::Null), "c0"},
+      {Value(false), "c2"},
+      {Value(true), "c3"},
+      {Value(0), "00"},
+      {Value(127), "7f"},
+      {Value(128), "cc80"},
+      {Value(256), "cd0100"},
+      {Value(65536), "ce00010000"},
+      {Value(uint64_t(4294967296ULL)), "cf0000000100000000"},
+      {Value(UINT64_MAX), "cfffffffffffffffff"},
+      {Value(-1), "ff"},
+      {Value(-32), "e0"},
+      {Value(-33), "d0df"},
+      {Value(-129), "d1ff7f"},
+      {Value(-32769), "d2ffff7fff"},
+      {Value(INT64_MIN), "d38000000000000000"},
+      {Value(1.5), "cb3ff8000000000000"},
+      {Value("abc"), "a3616263"},
+      {Value(""), "a0"},
+  };
+
+  for (auto const& c : cases) {
+    Builder b;
+    b.add(c.value);
+    ASSERT_EQ(std::string(c.expected), toMessagePack(b));
+  }
+}
+
+TEST(MessagePackDumperTest, Lengths) {
+  struct {
+    std::size_t length;
+    char const* header;
+  } const strings[] = {{31, "bf"}, {32, "d920"}, {255, "d9ff"}, {256, "da0100"},
+                       {65536, "db00010000"}};
+  for (auto const& c : strings) {
+    Builder b;
+    b.add(Value(std::string(c.length, 'x')));
+    ASSERT_EQ(std::string(c.header), toMessagePack(b).substr(0, strlen(c.header)));
+  }
+
+  struct {
+    std::size_t length;
+    char const* array;
+    char const* map;
+  } const compounds[] = {{0, "90", "80"},
+                         {15, "9f", "8f"},
+                         {16, "dc0010", "de0010"},
+                         {65536, "dd00010000", "df00010000"}};
+  for (auto const& c : compounds) {
+    Builder a;
+    a.openArray();
+    Builder o;
+    o.openObject();
+    for (std::size_t i = 0; i < c.length; ++i) {
+      a.add(Value(i));
+      o.add(std::to_string(i), Value(i));
+    }
+    a.close();
+    o.close();
+    ASSERT_EQ(std::string(c.array), toMessagePack(a).substr(0, strlen(c.array)));
+    ASSERT_EQ(std::string(c.map), toMessagePack(o).substr(0, strlen(c.map)));
+  }
+
+  Builder bin;
+  bin.add(ValuePair("\x01\x02", 2, ValueType::Binary));
+  ASSERT_EQ(std::string("c4020102"), toMessagePack(bin));
+}
+
+TEST(MessagePackDumperTest, Compounds) {
+  std::shared_ptr<Builder> b = Parser::fromJson(R"({"a":1,"b":[2,"c"],"d":{}})");
+  ASSERT_EQ(std::string("83a16101a1629202a163a16480"), toMessagePack(*b));
+}
+
+TEST(MessagePackDumperTest, TagsPackedArraysAndExternals) {
+  Builder inner;
+  inner.add(Value("x"));
+
+  Builder b;
+  b.openArray();
+  b.addTagged(42, Value(5));
+  b.addPacked(std::vector<int64_t>{1, -2});
+  b.addPacked(std::vector<double>{0.5});
+  b.add(Value(static_cast<void const*>(inner.slice().start())));
+  b.close();
+
+  Options options;
+  options.packedArrays = true;
+  ASSERT_EQ(std::string("9405" "9201fe" "91cb3fe0000000000000" "a178"),
+            toMessagePack(b, &options));
+
+  // without the option, packed arrays are tagged Binary values
+  ASSERT_EQ(std::string("9405" "c4100100000000000000feffffffffffffff"
+                        "c408000000000000e03f" "a178"),
+            toMessagePack(b));
+}
+
+TEST(MessagePackDumperTest, ShapedObjects) {
+  ShapeRegistry registry;
+  registry.add(std::vector<std::string>{"a", "b"});
+  std::shared_ptr<Builder> value = Parser::fromJson(R"({"b":2,"a":1})");
+  Builder shaped = registry.encode(value->slice());
+  ASSERT_TRUE(shaped.slice().isShapedObject());
+
+  Options options;
+  // without a registry the payload is dumped like any tagged value
+  ASSERT_EQ(std::string("93000102"), toMessagePack(shaped, &options));
+  options.shapeRegistry = &registry;
+  ASSERT_EQ(std::string("82a16101a16202"), toMessagePack(shaped, &options));
+}
+
+TEST(MessagePackDumperTest, UnsupportedTypes) {
+  Builder b;
+  b.add(Value(ValueType::MinKey));
+
+  Options options;
+  options.unsupportedTypeBehavior = Options::FailOnUnsupportedType;
+  ASSERT_VELOCYPACK_EXCEPTION(toMessagePack(b, &options), Exception::NoJsonEquivalent);
+
+  options.unsupportedTypeBehavior = Options::NullifyUnsupportedType;
+  ASSERT_EQ(std::string("c0"), toMessagePack(b, &options));
+
+  options.unsupportedTypeBehavior = Options::ConvertUnsupportedType;
+  std::string const data = MessagePackDumper::toString(b.slice(), &options);
+  ASSERT_EQ(std::string("(non-representable type min-key)"),
+            MessagePackParser::fromMessagePack(data)->slice().copyString());
+}
+
+TEST(MessagePackTest, Roundtrip) {
+  std::string const values[] = {
+      "null", "true", "false", "0", "-1", "-9223372036854775808",
+      "18446744073709551615", "1.5", "-0.25", "\"\"", "\"foo\\nbar\\u00e4\"", "[]",
+      "{}", R"([1,[2,[3,[]]],{"a":{"b":{}}}])",
+      R"({"name":"test","values":[1,-200,70000,-5000000000,2.5e100],"ok":true,"none":null})"};
+  for (auto const& value : values) {
+    ASSERT_EQ(Parser::fromJson(value)->slice().toJson(), roundtrip(value));
+  }
+}
+
+TEST(MessagePackTest, RoundtripBinaryAndDates) {
+  Builder b;
+  b.openArray();
+  b.add(ValuePair("\x00\xff\x10", 3, ValueType::Binary));
+  for (int64_t date : {int64_t(0), int64_t(1000), int64_t(1500), int64_t(-1),
+                       int64_t(-1500), int64_t(4294967296000LL), int64_t(17179869184001LL),
+                       int64_t(-8640000000000000LL)}) {
+    b.add(Value(date, ValueType::UTCDate));
+  }
+  b.close();
+
+  std::string const data = MessagePackDumper::toString(b.slice());
+  std::shared_ptr<Builder> result = MessagePackParser::fromMessagePack(data);
+  ASSERT_TRUE(result->slice().binaryEquals(b.slice()));
+}
+
+TEST(MessagePackTest, TimestampFormats) {
+  // timestamp 32, 64 and 96
+  Builder b;
+  b.add(Value(int64_t(1000), ValueType::UTCDate));
+  ASSERT_EQ(std::string("d6ff00000001"), toMessagePack(b));
+  b.clear();
+  b.add(Value(int64_t(1001), ValueType::UTCDate));
+  ASSERT_EQ(std::string("d7ff003d090000000001"), toMessagePack(b));
+  b.clear();
+  b.add(Value(int64_t(-1), ValueType::UTCDate));
+  ASSERT_EQ(std::string("c70cff3b8b87c0ffffffffffffffff"), toMessagePack(b));
+}
+
+TEST(MessagePackParserTest, Floats) {
+  std::shared_ptr<Builder> b = MessagePackParser::fromMessagePack(fromHex("ca3fc00000"));
+  ASSERT_TRUE(b->slice().isDouble());
+  ASSERT_EQ(1.5, b->slice().getDouble());
+}
+
+TEST(MessagePackParserTest, Sequence) {
+  std::string const data = fromHex("01a26869c0");
+  Options options;
+  options.clearBuilderBeforeParse = false;
+  Builder b;
+  b.openArray();
+  MessagePackParser parser(b, &options);
+  std::size_t pos = 0;
+  while (pos < data.size()) {
+    pos += parser.parse(data.data() + pos, data.size() - pos);
+  }
+  b.close();
+  ASSERT_EQ(std::string(R"([1,"hi",null])"), b.slice().toJson());
+}
+
+TEST(MessagePackParserTest, Errors) {
+  struct {
+    char const* data;
+    Exception::ExceptionType error;
+  } const cases[] = {
+      {"", Exception::ParseError},
+      {"c1", Exception::ParseError},
+      {"a36162", Exception::ParseError},
+      {"92", Exception::ParseError},
+      {"dd7fffffff", Exception::ParseError},
+      {"810101", Exception::ParseError},
+      {"d40100", Exception::ParseError},
+      {"d6ff", Exception::ParseError},
+      {"c705ff0000000000", Exception::ParseError},
+      {"d7ffffffffff00000000", Exception::ParseError},
+  };
+  for (auto const& c : cases) {
+    ASSERT_VELOCYPACK_EXCEPTION(MessagePackParser::fromMessagePack(fromHex(c.data)), c.error);
+  }
+
+  Options options;
+  options.validateUtf8Strings = true;
+  ASSERT_VELOCYPACK_EXCEPTION(MessagePackParser::fromMessagePack(fromHex("a1ff"), &options),
+                              Exception::InvalidUtf8Sequence);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+#include "tests-common.h"
+
+TEST(NormalizedHashCacheTest, Empty) {
+  NormalizedHashCache cache;
+  ASSERT_TRUE(cache.empty());
+  ASSERT_EQ(0U, cache.size());
+  uint64_t const seed = Slice::defaultSeed64;
+  ASSERT_EQ(seed, cache.seed());
+}
+
+TEST(NormalizedHashCacheTest, Seed) {
+  NormalizedHashCache cache(42);
+  ASSERT_EQ(42U, cache.seed());
+
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"a\":[1,2,3],\"b\":\"foo\"}");
+  ASSERT_EQ(b->slice().normalizedHash(42), cache.normalizedHash(b->slice()));
+  ASSERT_NE(b->slice().normalizedHash(), cache.normalizedHash(b->slice()));
+}
+
+TEST(NormalizedHashCacheTest, CachesValues) {
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"a\":[1,2,3],\"b\":\"foo\"}");
+  Slice s = b->slice();
+
+  NormalizedHashCache cache;
+  ASSERT_FALSE(cache.contains(s));
+  ASSERT_EQ(s.normalizedHash(), cache.normalizedHash(s));
+  ASSERT_TRUE(cache.contains(s));
+  ASSERT_EQ(1U, cache.size());
+
+  ASSERT_EQ(s.normalizedHash(), cache.normalizedHash(s));
+  ASSERT_EQ(1U, cache.size());
+
+  // a Slice pointing to the same memory uses the cached value
+  ASSERT_EQ(s.normalizedHash(), cache.normalizedHash(Slice(b->start())));
+  ASSERT_EQ(1U, cache.size());
+
+  // an equal value at another address gets its own entry
+  Builder copy(s);
+  ASSERT_EQ(s.normalizedHash(), cache.normalizedHash(copy.slice()));
+  ASSERT_EQ(2U, cache.size());
+}
+
+TEST(NormalizedHashCacheTest, Store) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[1,2,3]");
+  Slice s = b->slice();
+
+  NormalizedHashCache cache;
+  cache.store(s, 12345);
+  ASSERT_TRUE(cache.contains(s));
+  ASSERT_EQ(12345U, cache.normalizedHash(s));
+}
+
+TEST(NormalizedHashCacheTest, Invalidate) {
+  Builder b;
+  b.add(Value("foo"));
+  Slice s = b.slice();
+
+  NormalizedHashCache cache;
+  uint64_t hash = cache.normalizedHash(s);
+  ASSERT_EQ(s.normalizedHash(), hash);
+
+  cache.invalidate(s);
+  ASSERT_FALSE(cache.contains(s));
+  ASSERT_TRUE(cache.empty());
+  
+  // reuse the memory for another value
+  b.clear();
+  b.add(Value("bar"));
+  ASSERT_EQ(s.start(), b.slice().start());
+  ASSERT_EQ(b.slice().normalizedHash(), cache.normalizedHash(b.slice()));
+  ASSERT_NE(hash, cache.normalizedHash(b.slice()));
+}
+
+TEST(NormalizedHashCacheTest, Clear) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[1,2,3]");
+
+  NormalizedHashCache cache;
+  for (auto const& it : ArrayIterator(b->slice())) {
+    cache.normalizedHash(it);
+  }
+  ASSERT_EQ(3U, cache.size());
+
+  cache.clear();
+  ASSERT_TRUE(cache.empty());
+  ASSERT_FALSE(cache.contains(b->slice().at(0)));
+}
+
+TEST(NormalizedHashCacheTest, NormalizedHashMany) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[null,1,-2.5,\"foo\",[1,2],{\"a\":{\"b\":1}},1]");
+
+  std::vector<Slice> slices;
+  for (auto const& it : ArrayIterator(b->slice())) {
+    slices.push_back(it);
+  }
+
+  NormalizedHashCache cache;
+  std::vector<uint64_t> hashes(slices.size());
+  cache.normalizedHashMany(slices.data(), slices.size(), hashes.data());
+  ASSERT_EQ(slices.size(), cache.size());
+  for (std::size_t i = 0; i < slices.size(); ++i) {
+    ASSERT_EQ(slices[i].normalizedHash(), hashes[i]);
+    ASSERT_TRUE(cache.contains(slices[i]));
+  }
+  ASSERT_EQ(hashes[1], hashes[6]);
+  
+  // second round is served from the cache
+  std::vector<uint64_t> hashes2(slices.size());
+  cache.normalizedHashMany(slices.data(), slices.size(), hashes2.data());
+  ASSERT_EQ(hashes, hashes2);
+  ASSERT_EQ(slices.size(), cache.size());
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -2534,6 +2534,432 @@ TEST(ParserTest, UseBuilderOnStackOptionsNullPtr) {
   delete parser;
 }
 
+namespace {
+
+// records all events as a compact, JSON-like string. skipped values
+// leave no trace
+struct RecordingHandler : public JsonHandler {
+  void nullValue() override { add("null"); }
+  void boolValue(bool value) override { add(value ? "true" : "false"); }
+  void intValue(int64_t value) override { add("i" + std::to_string(value)); }
+  void uintValue(uint64_t value) override {
+    add("u" + std::to_string(value));
+  }
+  void doubleValue(double value) override {
+    add("d" + std::to_string(value));
+  }
+  void stringValue(StringRef value) override {
+    add("\"" + value.toString() + "\"");
+  }
+
+  bool startArray() override {
+    add("[");
+    first = true;
+    return skipArrays == 0 || --skipArrays != 0;
+  }
+  void endArray() override {
+    out.push_back(']');
+    first = false;
+  }
+
+  bool startObject() override {
+    add("{");
+    first = true;
+    return true;
+  }
+  bool key(StringRef key) override {
+    add(key.toString() + ":");
+    first = true;
+    return key.toString() != skipKey;
+  }
+  void endObject() override {
+    out.push_back('}');
+    first = false;
+  }
+
+  void add(std::string const& value) {
+    if (!first) {
+      out.push_back(',');
+    }
+    out.append(value);
+    first = false;
+  }
+
+  std::string out;
+  std::string skipKey;
+  int skipArrays = 0;
+  bool first = true;
+};
+
+// rebuilds the parsed values as VPack
+struct RebuildingHandler : public JsonHandler {
+  void nullValue() override { builder.add(Value(ValueType::Null)); }
+  void boolValue(bool value) override { builder.add(Value(value)); }
+  void intValue(int64_t value) override { builder.add(Value(value)); }
+  void uintValue(uint64_t value) override { builder.add(Value(value)); }
+  void doubleValue(double value) override { builder.add(Value(value)); }
+  void stringValue(StringRef value) override {
+    builder.add(ValuePair(value.data(), value.size(), ValueType::String));
+  }
+  bool startArray() override {
+    builder.openArray();
+    return true;
+  }
+  void endArray() override { builder.close(); }
+  bool startObject() override {
+    builder.openObject();
+    return true;
+  }
+  bool key(StringRef key) override {
+    builder.add(ValuePair(key.data(), key.size(), ValueType::String));
+    return true;
+  }
+  void endObject() override { builder.close(); }
+
+  Builder builder;
+};
+
+}  // namespace
+
+TEST(ParserTest, HandlerEvents) {
+  std::string const value(
+      "{\"a\":[1,-2,3.5,true,false,null,\"x\\ty\"],\"b\":{},\"c\":[[]]}");
+
+  RecordingHandler handler;
+  Parser parser;
+  ASSERT_EQ(1UL, parser.parse(value, handler));
+  ASSERT_EQ(
+      "{a:[u1,i-2,d3.500000,true,false,null,\"x\ty\"],b:{},c:[[]]}",
+      handler.out);
+}
+
+TEST(ParserTest, HandlerDoesNotTouchBuilder) {
+  Builder builder;
+  builder.add(Value(42));
+  Parser parser(builder);
+
+  RecordingHandler handler;
+  parser.parse("[1,2,3]", handler);
+  ASSERT_EQ("[u1,u2,u3]", handler.out);
+  ASSERT_EQ(42UL, builder.slice().getUInt());
+}
+
+TEST(ParserTest, HandlerMatchesBuilder) {
+  std::string const value(
+      "{\"string\":\"abc\\\"\\\\\\/\\b\\f\\n\\r\\t\\u00e4\\u20ac\\ud83d\\ude00\","
+      "\"numbers\":[0,-0,18446744073709551615,18446744073709551616,"
+      "-9223372036854775808,1e10,-1.5E-3,123.456],"
+      "\"nested\":{\"a\":{\"b\":[null,true,{\"c\":false}]}},"
+      "\"utf8\":\"\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80\"}");
+
+  Options options;
+  options.validateUtf8Strings = true;
+  Parser parser(&options);
+  parser.parse(value);
+
+  RebuildingHandler handler;
+  parser.parse(value, handler);
+
+  ASSERT_EQ(parser.steal()->slice().toJson(), handler.builder.slice().toJson());
+}
+
+TEST(ParserTest, HandlerLongStrings) {
+  // longer than the chunk the handler's scratch buffer reserves at once
+  std::string const raw(100000, 'x');
+  std::string const value = "[\"" + raw + "\",\"" + raw + "\\n\"]";
+
+  RebuildingHandler handler;
+  Parser parser;
+  parser.parse(value, handler);
+
+  Slice s = handler.builder.slice();
+  ASSERT_EQ(raw, s.at(0).copyString());
+  ASSERT_EQ(raw + "\n", s.at(1).copyString());
+}
+
+TEST(ParserTest, HandlerMulti) {
+  RecordingHandler handler;
+  Parser parser;
+  ASSERT_EQ(3UL, parser.parse("1 \"a\" {}", handler, true));
+  ASSERT_EQ("u1,\"a\",{}", handler.out);
+}
+
+TEST(ParserTest, HandlerSkipsValuesOfKeys) {
+  std::string const value(
+      "{\"a\":1,\"skip\":{\"x\":[1,{\"y\":\"}]\\\"\"}],\"z\":\"\\\\\"},"
+      "\"b\":2,\"skip\":\"a\\\"b\",\"c\":3,\"skip\":[[[]]],\"d\":4,"
+      "\"skip\": -12.5e3 ,\"e\":5,\"skip\":true}");
+
+  RecordingHandler handler;
+  handler.skipKey = "skip";
+  Parser parser;
+  parser.parse(value, handler);
+  ASSERT_EQ("{a:u1,skip:b:u2,skip:c:u3,skip:d:u4,skip:e:u5,skip:}",
+            handler.out);
+}
+
+TEST(ParserTest, HandlerSkipsArrays) {
+  RecordingHandler handler;
+  handler.skipArrays = 2;  // skip the second Array
+  Parser parser;
+  parser.parse("[1,[2,\"]\",[3]],{\"a\":[4]}]", handler);
+  ASSERT_EQ("[u1,[{a:[u4]}]", handler.out);
+}
+
+TEST(ParserTest, HandlerErrors) {
+  Parser parser;
+  {
+    RecordingHandler handler;
+    ASSERT_VELOCYPACK_EXCEPTION(parser.parse("[1,2", handler),
+                                Exception::ParseError);
+  }
+  {
+    RecordingHandler handler;
+    ASSERT_VELOCYPACK_EXCEPTION(parser.parse("[1,x]", handler),
+                                Exception::ParseError);
+    ASSERT_EQ(3U, parser.errorPos());
+  }
+  {
+    RecordingHandler handler;
+    handler.skipKey = "skip";
+    ASSERT_VELOCYPACK_EXCEPTION(parser.parse("{\"skip\":\"abc\\\"}", handler),
+                                Exception::ParseError);
+  }
+  {
+    RecordingHandler handler;
+    handler.skipKey = "skip";
+    ASSERT_VELOCYPACK_EXCEPTION(parser.parse("{\"skip\":[[1]}", handler),
+                                Exception::ParseError);
+  }
+  {
+    RecordingHandler handler;
+    handler.skipKey = "skip";
+    ASSERT_VELOCYPACK_EXCEPTION(parser.parse("{\"skip\":}", handler),
+                                Exception::ParseError);
+  }
+  {
+    RecordingHandler handler;
+    ASSERT_VELOCYPACK_EXCEPTION(parser.parse("[1] 2", handler),
+                                Exception::ParseError);
+  }
+}
+
+TEST(ParserTest, KeepTopLevelOpenAfterError) {
+  Options options;
+  options.keepTopLevelOpen = true;
+  Parser parser(&options);
+  ASSERT_VELOCYPACK_EXCEPTION(parser.parse("{\"a\":{\"b\":"),
+                              Exception::ParseError);
+
+  parser.parse("{}");
+  Builder const& builder = parser.builder();
+  ASSERT_FALSE(builder.isClosed());
+}
+
+TEST(ParserTest, ProjectionTopLevelMembers) {
+  JsonProjection projection;
+  projection.add({"b"});
+  projection.add({"d"});
+
+  Parser parser;
+  parser.parse(
+      "{\"a\":1,\"b\":[1,{\"x\":2}],\"c\":{\"b\":3},\"d\":\"foo\",\"e\":null}",
+      projection);
+  ASSERT_EQ("{\"b\":[1,{\"x\":2}],\"d\":\"foo\"}",
+            parser.builder().slice().toJson());
+}
+
+TEST(ParserTest, ProjectionNestedPaths) {
+  JsonProjection projection;
+  projection.add({"a", "b", "c"});
+  projection.add({"a", "d"});
+  projection.add({"x", "y"});
+
+  Parser parser;
+  parser.parse(
+      "{\"a\":{\"b\":{\"c\":true,\"z\":1},\"d\":{\"e\":[]},\"f\":2},"
+      "\"x\":{\"z\":3},\"y\":4}",
+      projection);
+  ASSERT_EQ("{\"a\":{\"b\":{\"c\":true},\"d\":{\"e\":[]}},\"x\":{}}",
+            parser.builder().slice().toJson());
+}
+
+TEST(ParserTest, ProjectionNonObjectOnPath) {
+  JsonProjection projection;
+  projection.add({"a", "b"});
+
+  Parser parser;
+  parser.parse("{\"a\":[{\"b\":1}],\"a\":\"b\",\"a\" : {\"b\":2}}", projection);
+  ASSERT_EQ("{\"a\":{\"b\":2}}", parser.builder().slice().toJson());
+}
+
+TEST(ParserTest, ProjectionShorterPathWins) {
+  JsonProjection projection;
+  projection.add({"a", "b"});
+  projection.add({"a"});
+  projection.add({"a", "c"});
+
+  Parser parser;
+  parser.parse("{\"a\":{\"b\":1,\"c\":2,\"d\":3}}", projection);
+  ASSERT_EQ("{\"a\":{\"b\":1,\"c\":2,\"d\":3}}",
+            parser.builder().slice().toJson());
+}
+
+TEST(ParserTest, ProjectionEmptyPath) {
+  JsonProjection projection;
+  projection.add({});
+
+  Parser parser;
+  parser.parse("[1,{\"a\":2}]", projection);
+  ASSERT_EQ("[1,{\"a\":2}]", parser.builder().slice().toJson());
+}
+
+TEST(ParserTest, ProjectionOfNonObject) {
+  JsonProjection projection;
+  projection.add({"a"});
+
+  Parser parser;
+  for (char const* value : {"[{\"a\":1}]", "\"a\"", "12", "null"}) {
+    parser.parse(value, projection);
+    ASSERT_EQ("{}", parser.builder().slice().toJson());
+  }
+}
+
+TEST(ParserTest, ProjectionMulti) {
+  JsonProjection projection;
+  projection.add({"a"});
+
+  Builder builder;
+  builder.openArray();
+  Options options;
+  options.clearBuilderBeforeParse = false;
+  Parser parser(builder, &options);
+  ASSERT_EQ(3UL, parser.parse("{\"a\":1,\"b\":2} [] {\"b\":3,\"a\":4}",
+                              projection, true));
+  builder.close();
+  ASSERT_EQ("[{\"a\":1},{},{\"a\":4}]", builder.slice().toJson());
+}
+
+TEST(ParserTest, ProjectionKeysWithEscapes) {
+  JsonProjection projection;
+  projection.add({"a\"b", "\xc3\xa4"});
+
+  Parser parser;
+  parser.parse("{\"a\\\"b\":{\"\\u00e4\":\"x\",\"\\u00e5\":\"y\"}}",
+               projection);
+  Slice s = parser.builder().slice();
+  ASSERT_EQ(1UL, s.length());
+  ASSERT_EQ("x", s.get(std::vector<std::string>({"a\"b", "\xc3\xa4"}))
+                     .copyString());
+}
+
+TEST(ParserTest, ProjectionTranslatesKeys) {
+  std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
+  translator->add("a", 1);
+  translator->seal();
+
+  AttributeTranslatorScope scope(translator.get());
+
+  Options options;
+  options.attributeTranslator = translator.get();
+
+  JsonProjection projection;
+  projection.add({"a", "a"});
+
+  Parser parser(&options);
+  parser.parse("{\"b\":1,\"a\":{\"a\":2,\"c\":3}}", projection);
+  Slice s = parser.builder().slice();
+  ASSERT_EQ(1UL, s.length());
+  ASSERT_TRUE(s.keyAt(0, false).isSmallInt());
+  ASSERT_EQ(2UL, s.get("a", true).get("a", true).getUInt());
+}
+
+TEST(ParserTest, ProjectionErrors) {
+  JsonProjection projection;
+  projection.add({"a"});
+
+  Parser parser;
+  ASSERT_VELOCYPACK_EXCEPTION(parser.parse("{\"b\":[1,\"]\"}", projection),
+                              Exception::ParseError);
+  ASSERT_VELOCYPACK_EXCEPTION(parser.parse("{\"b\":\"x}", projection),
+                              Exception::ParseError);
+  ASSERT_VELOCYPACK_EXCEPTION(parser.parse("{\"a\":[1,}", projection),
+                              Exception::ParseError);
+  ASSERT_VELOCYPACK_EXCEPTION(parser.parse("{\"a\":1,\"b\":2", projection),
+                              Exception::ParseError);
+  ASSERT_VELOCYPACK_EXCEPTION(parser.parse("{\"b\"}", projection),
+                              Exception::ParseError);
+}
+
+TEST(ParserTest, TryParseValid) {
+  Parser parser;
+  Status status = parser.tryParse("{\"a\":[1,2.5,\"x\",null,true]}");
+  ASSERT_TRUE(status.ok());
+  ASSERT_EQ("{\"a\":[1,2.5,\"x\",null,true]}",
+            parser.builder().slice().toJson());
+
+  status = parser.tryParse(std::string("1 2 3"), true);
+  ASSERT_TRUE(status.ok());
+  // three SmallInt values
+  ASSERT_EQ(3UL, parser.builder().size());
+}
+
+TEST(ParserTest, TryParseMatchesParse) {
+  Options options;
+  options.validateUtf8Strings = true;
+
+  char const* invalid[] = {
+    "", "  ", "[", "[1,", "[1,2", "[1 2]", "[1,]", "{", "{\"a\"", "{\"a\":",
+    "{\"a\":1", "{\"a\" 1}", "{\"a\":1,}", "{a:1}", "{\"a\":1 \"b\":2}",
+    "tru", "fals", "nul", "nulx", "-", "-x", "1.", "1.x", "1e", "1e+", "1ex",
+    "1e999", "\"abc", "\"\\", "\"\\x\"", "\"\\u12\"", "\"\\u12x4\"",
+    "\"\x01\"", "\"\xff\"", "\"\xc3\"", "\"\xc3\x28\"", "[1] 2", "1 x",
+    "[[[{\"a\":[1,{\"b\":x}]}]]]", "{\"a\":{\"b\":{\"c\":\"d}}}",
+  };
+
+  for (auto const& value : invalid) {
+    Parser parser(&options);
+    Status status = parser.tryParse(value);
+    ASSERT_FALSE(status.ok());
+    std::string const builderAfterTry =
+        parser.builder().bufferRef().toString();
+
+    try {
+      parser.parse(value);
+      ASSERT_TRUE(false);
+    } catch (Exception const& ex) {
+      ASSERT_EQ(ex.errorCode(), status.code);
+      ASSERT_STREQ(ex.what(), status.message);
+      ASSERT_EQ(parser.errorPos(), status.position);
+      ASSERT_EQ(builderAfterTry, parser.builder().bufferRef().toString());
+    }
+  }
+}
+
+TEST(ParserTest, TryParseErrorPosition) {
+  Parser parser;
+  Status status = parser.tryParse("[1,x]");
+  ASSERT_FALSE(status.ok());
+  ASSERT_EQ(Exception::ParseError, status.code);
+  ASSERT_EQ(3U, status.position);
+  ASSERT_VELOCYPACK_EXCEPTION(status.raise(), Exception::ParseError);
+
+  // a failure does not affect the next parse
+  status = parser.tryParse("[1,2]");
+  ASSERT_TRUE(status.ok());
+  ASSERT_EQ("[1,2]", parser.builder().slice().toJson());
+}
+
+TEST(ParserTest, TryParseReturnsBuilderErrors) {
+  Options options;
+  options.checkAttributeUniqueness = true;
+  Parser parser(&options);
+
+  Status status = parser.tryParse("{\"a\":1,\"a\":2}");
+  ASSERT_FALSE(status.ok());
+  ASSERT_EQ(Exception::DuplicateAttributeName, status.code);
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
 
@@ -0,0 +1,303 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+
+#include "tests-common.h"
+
+namespace {
+
+struct ShapeRegistryScope {
+  explicit ShapeRegistryScope(ShapeRegistry* registry)
+      : _old(Options::Defaults.shapeRegistry) {
+    Options::Defaults.shapeRegistry = registry;
+  }
+  ~ShapeRegistryScope() { Options::Defaults.shapeRegistry = _old; }
+
+  ShapeRegistry* _old;
+};
+
+}  // namespace
+
+TEST(ShapeRegistryTest, Add) {
+  ShapeRegistry registry;
+  ASSERT_EQ(0U, registry.count());
+  ASSERT_EQ(nullptr, registry.shape(0));
+
+  ASSERT_EQ(0U, registry.add(std::vector<std::string>{"b", "a", "c"}));
+  ASSERT_EQ(1U, registry.add(std::vector<std::string>{"a"}));
+  ASSERT_EQ(0U, registry.add(std::vector<std::string>{"c", "b", "a"}));
+  ASSERT_EQ(2U, registry.count());
+
+  ShapeRegistry::Shape const* shape = registry.shape(0);
+  ASSERT_NE(nullptr, shape);
+  ASSERT_EQ(3U, shape->size());
+  ASSERT_EQ(std::string("[\"a\",\"b\",\"c\"]"), shape->keys().toJson());
+  ASSERT_EQ("b", shape->keyAt(1).copyString());
+  ASSERT_EQ(2, shape->position(StringRef("c")));
+  ASSERT_EQ(-1, shape->position(StringRef("d")));
+
+  ASSERT_VELOCYPACK_EXCEPTION(registry.add(std::vector<std::string>{"a", "a"}),
+                              Exception::DuplicateAttributeName);
+}
+
+TEST(ShapeRegistryTest, AddFromObject) {
+  ShapeRegistry registry;
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"z\":1,\"y\":2}");
+  ASSERT_EQ(0U, registry.add(b->slice()));
+  ASSERT_EQ(0U, registry.add(std::vector<std::string>{"y", "z"}));
+
+  b = Parser::fromJson("[1]");
+  ASSERT_VELOCYPACK_EXCEPTION(registry.add(b->slice()), Exception::InvalidValueType);
+}
+
+TEST(ShapeRegistryTest, Find) {
+  ShapeRegistry registry;
+  registry.add(std::vector<std::string>{"a", "b"});
+
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"b\":1,\"a\":2}");
+  ASSERT_EQ(0U, registry.find(b->slice()));
+  b = Parser::fromJson("{\"a\":1,\"b\":2,\"c\":3}");
+  ASSERT_EQ(ShapeRegistry::NotFound, registry.find(b->slice()));
+  b = Parser::fromJson("{\"a\":1}");
+  ASSERT_EQ(ShapeRegistry::NotFound, registry.find(b->slice()));
+  b = Parser::fromJson("[1,2]");
+  ASSERT_EQ(ShapeRegistry::NotFound, registry.find(b->slice()));
+}
+
+TEST(ShapeRegistryTest, EncodeDecode) {
+  ShapeRegistry registry;
+  registry.add(std::vector<std::string>{"name", "value", "sub"});
+  registry.add(std::vector<std::string>{"x", "y"});
+
+  std::shared_ptr<Builder> b = Parser::fromJson(
+      "[{\"value\":1,\"name\":\"foo\",\"sub\":{\"x\":1,\"y\":2}},"
+      "{\"name\":\"bar\",\"value\":[{\"y\":3,\"x\":4}],\"sub\":null},"
+      "{\"name\":\"baz\",\"other\":true},{}]");
+
+  Builder encoded = registry.encode(b->slice());
+  Slice s = encoded.slice();
+  ASSERT_TRUE(s.isArray());
+  ASSERT_TRUE(s.at(0).isShapedObject());
+  ASSERT_TRUE(s.at(1).isShapedObject());
+  ASSERT_FALSE(s.at(2).isShapedObject());
+  ASSERT_TRUE(s.at(2).isObject());
+  ASSERT_TRUE(s.at(3).isEmptyObject());
+  ASSERT_TRUE(s.at(0).value().at(2).isShapedObject());
+  ASSERT_LT(s.byteSize(), b->slice().byteSize());
+
+  Builder decoded = registry.decode(s);
+  ASSERT_TRUE(NormalizedCompare::equals(b->slice(), decoded.slice()));
+}
+
+TEST(ShapeRegistryTest, DecodeUnknownShape) {
+  ShapeRegistry registry;
+  registry.add(std::vector<std::string>{"a"});
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"a\":1}");
+  Builder encoded = registry.encode(b->slice());
+
+  ShapeRegistry other;
+  ASSERT_VELOCYPACK_EXCEPTION(other.decode(encoded.slice()), Exception::UnknownShape);
+  ASSERT_VELOCYPACK_EXCEPTION(other.get(encoded.slice(), StringRef("a")),
+                              Exception::UnknownShape);
+}
+
+TEST(ShapeRegistryTest, SliceGet) {
+  ShapeRegistry registry;
+  registry.add(std::vector<std::string>{"a", "b", "c"});
+  registry.add(std::vector<std::string>{"x"});
+
+  std::shared_ptr<Builder> b =
+      Parser::fromJson("{\"c\":\"foo\",\"a\":1,\"b\":{\"x\":[1,2]}}");
+  Builder encoded = registry.encode(b->slice());
+  Slice s = encoded.slice();
+  ASSERT_TRUE(s.isShapedObject());
+  ASSERT_FALSE(s.isObject());
+
+  // without a registry shaped objects are ordinary tagged values
+  ASSERT_VELOCYPACK_EXCEPTION(s.get("a"), Exception::InvalidValueType);
+
+  Options options;
+  options.shapeRegistry = &registry;
+  ASSERT_EQ(1, s.get(StringRef("a"), &options).getInt());
+  ASSERT_TRUE(s.get(StringRef("d"), &options).isNone());
+
+  ShapeRegistryScope scope(&registry);
+  ASSERT_EQ(1, s.get("a").getInt());
+  ASSERT_EQ("foo", s.get("c").copyString());
+  ASSERT_TRUE(s.get("d").isNone());
+  ASSERT_TRUE(s.hasKey("b"));
+  ASSERT_FALSE(s.hasKey("d"));
+  ASSERT_EQ(2, s.get(std::vector<std::string>{"b", "x"}).at(1).getInt());
+  ASSERT_TRUE(s.get(std::vector<std::string>{"b", "y"}).isNone());
+
+  ASSERT_EQ(1, registry.get(s, StringRef("a")).getInt());
+  ASSERT_VELOCYPACK_EXCEPTION(registry.get(b->slice(), StringRef("a")),
+                              Exception::InvalidValueType);
+}
+
+TEST(ShapeRegistryTest, Dump) {
+  ShapeRegistry registry;
+  registry.add(std::vector<std::string>{"b", "a"});
+
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"b\":[true],\"a\":\"x\"}");
+  Builder encoded = registry.encode(b->slice());
+
+  // without a registry the payload is dumped like any tagged value
+  ASSERT_EQ(std::string("[0,\"x\",[true]]"), encoded.slice().toJson());
+
+  Options options;
+  options.shapeRegistry = &registry;
+  ASSERT_EQ(std::string("{\"a\":\"x\",\"b\":[true]}"), encoded.slice().toJson(&options));
+
+  options.prettyPrint = true;
+  ASSERT_EQ(std::string("{\n  \"a\" : \"x\",\n  \"b\" : [\n    true\n  ]\n}"),
+            encoded.slice().toJson(&options));
+
+  ShapeRegistryScope scope(&registry);
+  ASSERT_EQ(std::string("{\"a\":\"x\",\"b\":[true]}"), encoded.slice().toJson());
+}
+
+TEST(ShapeRegistryTest, Infer) {
+  std::string json("[");
+  for (int i = 0; i < 10; ++i) {
+    json.append("{\"id\":" + std::to_string(i) + ",\"pos\":[{\"x\":1,\"y\":2},{\"y\":3,\"x\":4}]},");
+  }
+  json.append("{\"id\":10,\"rare\":true},{\"id\":11,\"rare\":false},{\"once\":1}]");
+  std::shared_ptr<Builder> b = Parser::fromJson(json);
+
+  ShapeRegistry registry;
+  registry.observe(b->slice());
+  ASSERT_EQ(3U, registry.infer(2));
+  ASSERT_EQ(3U, registry.count());
+
+  // most frequent shapes get the smallest ids
+  ASSERT_EQ(std::string("[\"x\",\"y\"]"), registry.shape(0)->keys().toJson());
+  ASSERT_EQ(std::string("[\"id\",\"pos\"]"), registry.shape(1)->keys().toJson());
+  ASSERT_EQ(std::string("[\"id\",\"rare\"]"), registry.shape(2)->keys().toJson());
+
+  // counts are reset
+  ASSERT_EQ(0U, registry.infer(1));
+
+  Builder encoded = registry.encode(b->slice());
+  ASSERT_TRUE(encoded.slice().at(11).isShapedObject());
+  ASSERT_FALSE(encoded.slice().at(12).isShapedObject());
+  Builder decoded = registry.decode(encoded.slice());
+  ASSERT_TRUE(NormalizedCompare::equals(b->slice(), decoded.slice()));
+}
+
+TEST(ShapeRegistryTest, EncodedSize) {
+  ShapeRegistry registry;
+  registry.add(std::vector<std::string>{"name", "value"});
+
+  std::shared_ptr<Builder> b = Parser::fromJson("{\"name\":\"hello\",\"value\":1}");
+  ASSERT_EQ(23U, b->slice().byteSize());
+  Builder encoded = registry.encode(b->slice());
+
+  // the payload is an indexed array, so values are found by position
+  // without walking the members
+  Slice payload = encoded.slice().value();
+  ASSERT_EQ(0x06, payload.head());
+  ASSERT_EQ(16U, encoded.slice().byteSize());
+
+  // members of equal size need no index table at all
+  b = Parser::fromJson("{\"name\":2,\"value\":1}");
+  encoded = registry.encode(b->slice());
+  ASSERT_EQ(0x02, encoded.slice().value().head());
+  ASSERT_EQ(7U, encoded.slice().byteSize());
+}
+
+TEST(ShapeRegistryTest, ApplicationTag) {
+  ShapeRegistry registry;
+  registry.add(std::vector<std::string>{"x"});
+
+  // a value tagged 67 by the application is not a shaped object
+  Builder b;
+  b.openObject();
+  b.addTagged("x", ShapeRegistry::tag, Value(5));
+  b.close();
+  Slice tagged = b.slice().get("x");
+  ASSERT_TRUE(tagged.isTagged());
+  ASSERT_FALSE(tagged.isShapedObject());
+  ASSERT_EQ(std::string("{\"x\":5}"), b.slice().toJson());
+
+  Builder c;
+  c.addTagged(ShapeRegistry::tag, Value(ValueType::Array));
+  c.add(Value("foo"));
+  c.close();
+  ASSERT_FALSE(c.slice().isShapedObject());
+  ASSERT_VELOCYPACK_EXCEPTION(c.slice().get("x"), Exception::InvalidValueType);
+
+  ShapeRegistryScope scope(&registry);
+  ASSERT_EQ(std::string("{\"x\":5}"), b.slice().toJson());
+  ASSERT_EQ(std::string("[\"foo\"]"), c.slice().toJson());
+  ASSERT_VELOCYPACK_EXCEPTION(c.slice().get("x"), Exception::InvalidValueType);
+}
+
+TEST(ShapeRegistryTest, InferSkipsDuplicateKeys) {
+  Options options;
+  options.checkAttributeUniqueness = false;
+  Parser parser(&options);
+  parser.parse("[{\"x\":1,\"x\":2},{\"p\":1,\"q\":2}]");
+  std::shared_ptr<Builder> b = parser.steal();
+
+  ShapeRegistry registry;
+  registry.observe(b->slice());
+  ASSERT_EQ(1U, registry.infer(1));
+  ASSERT_EQ(1U, registry.count());
+  ASSERT_EQ(std::string("[\"p\",\"q\"]"), registry.shape(0)->keys().toJson());
+  ASSERT_EQ(0U, registry.infer(1));
+}
+
+TEST(ShapeRegistryTest, TranslatedKeys) {
+  std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
+  translator->add("name", 1);
+  translator->add("value", 2);
+  translator->seal();
+  AttributeTranslatorScope translatorScope(translator.get());
+
+  Options options = Options::Defaults;
+  Parser parser(&options);
+  parser.parse("{\"name\":\"foo\",\"value\":1}");
+  std::shared_ptr<Builder> b = parser.steal();
+  ASSERT_TRUE(b->slice().keyAt(0, false).isSmallInt());
+
+  ShapeRegistry registry;
+  ASSERT_EQ(0U, registry.add(b->slice()));
+  ASSERT_EQ(0U, registry.add(std::vector<std::string>{"name", "value"}));
+
+  Builder encoded = registry.encode(b->slice());
+  ShapeRegistryScope scope(&registry);
+  ASSERT_EQ("foo", encoded.slice().get("name").copyString());
+  Builder decoded = registry.decode(encoded.slice());
+  ASSERT_TRUE(NormalizedCompare::equals(b->slice(), decoded.slice()));
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -27,6 +27,7 @@
 #include <ostream>
 #include <string>
 #include <iostream>
+#include <thread>
 
 #include "tests-common.h"
 
@@ -2295,6 +2296,197 @@ TEST(SliceTest, NormalizedHashObjectOrder) {
 
 #endif
 
+TEST(SliceTest, HashMany) {
+  Builder b;
+  b.openArray();
+  for (int i = 0; i < 100; ++i) {
+    b.add(Value(i));
+    b.add(Value(std::string("value-") + std::to_string(i)));
+  }
+  b.add(Slice::nullSlice());
+  b.add(Slice::emptyObjectSlice());
+  b.close();
+
+  std::vector<Slice> slices;
+  for (auto const& it : ArrayIterator(b.slice())) {
+    slices.push_back(it);
+  }
+
+  std::vector<uint64_t> hashes(slices.size());
+  Slice::hashMany(slices.data(), slices.size(), hashes.data());
+  for (std::size_t i = 0; i < slices.size(); ++i) {
+    ASSERT_EQ(slices[i].hash(), hashes[i]);
+  }
+
+  Slice::hashMany(slices.data(), slices.size(), hashes.data(), 42);
+  for (std::size_t i = 0; i < slices.size(); ++i) {
+    ASSERT_EQ(slices[i].hash(42), hashes[i]);
+  }
+  
+  // fewer values than the prefetch distance
+  Slice::hashMany(slices.data(), 3, hashes.data());
+  for (std::size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(slices[i].hash(), hashes[i]);
+  }
+}
+
+TEST(SliceTest, NormalizedHashMany) {
+  std::shared_ptr<Builder> b = Parser::fromJson(
+      "[null,true,false,0,-1,1.5,12345678901234,\"\",\"foo\","
+      "\"a somewhat longer string value\",[],[1,2,3],{},{\"a\":1,\"b\":[2]}]");
+  Slice s = b->slice();
+
+  std::vector<Slice> slices;
+  for (auto const& it : ArrayIterator(s)) {
+    slices.push_back(it);
+  }
+
+  std::vector<uint64_t> hashes(slices.size());
+  Slice::normalizedHashMany(slices.data(), slices.size(), hashes.data());
+  for (std::size_t i = 0; i < slices.size(); ++i) {
+    ASSERT_EQ(slices[i].normalizedHash(), hashes[i]);
+  }
+
+  Slice::normalizedHashMany(slices.data(), slices.size(), hashes.data(), 42);
+  for (std::size_t i = 0; i < slices.size(); ++i) {
+    ASSERT_EQ(slices[i].normalizedHash(42), hashes[i]);
+  }
+
+  // must not touch the output for empty input
+  hashes[0] = 0;
+  Slice::normalizedHashMany(slices.data(), 0, hashes.data());
+  ASSERT_EQ(0U, hashes[0]);
+}
+
+TEST(SliceTest, PackedArrayInt64) {
+  std::vector<int64_t> values{0, 1, -1, INT64_MAX, INT64_MIN, 1234567890123};
+  Options options;
+  options.packedArrays = true;
+
+  Builder b;
+  b.addPacked(values);
+  Slice s = b.slice();
+
+  ASSERT_TRUE(s.isTagged());
+  ASSERT_EQ(uint64_t(PackedArrayTraits<int64_t>::tag), s.getFirstTag());
+  ASSERT_TRUE(s.isPackedArray(&options));
+  ASSERT_TRUE(s.isPackedArray<int64_t>(&options));
+  ASSERT_FALSE(s.isPackedArray<double>(&options));
+  ASSERT_FALSE(s.isPackedArray<float>(&options));
+
+  PackedArrayView<int64_t> view = s.getPackedArray<int64_t>(&options);
+  ASSERT_EQ(values.size(), view.size());
+  ASSERT_FALSE(view.empty());
+  ASSERT_EQ(values.size() * sizeof(int64_t), view.byteSize());
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    ASSERT_EQ(values[i], view[i]);
+    ASSERT_EQ(values[i], view.at(i));
+  }
+  ASSERT_VELOCYPACK_EXCEPTION(view.at(values.size()), Exception::IndexOutOfBounds);
+
+  std::vector<int64_t> copy(view.begin(), view.end());
+  ASSERT_EQ(values, copy);
+
+  std::vector<int64_t> target(view.size());
+  view.copyTo(target.data());
+  ASSERT_EQ(values, target);
+
+  int64_t const* p = view.pointer();
+  if (p != nullptr) {
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(p) % alignof(int64_t));
+    ASSERT_EQ(INT64_MAX, p[3]);
+  }
+
+  ASSERT_VELOCYPACK_EXCEPTION(s.getPackedArray<double>(&options), Exception::InvalidValueType);
+}
+
+TEST(SliceTest, PackedArrayFloatingPoint) {
+  std::vector<double> doubles{0.0, -1.5, 3.25, 1.0e300};
+  std::vector<float> floats{0.0f, -1.5f, 3.25f, 1.0e30f, 0.1f};
+  Options options;
+  options.packedArrays = true;
+
+  Builder b;
+  b.openObject();
+  b.addPacked(StringRef("doubles"), doubles);
+  b.addPacked(StringRef("floats"), floats.data(), floats.size());
+  b.close();
+
+  Slice d = b.slice().get("doubles");
+  ASSERT_TRUE(d.isPackedArray<double>(&options));
+  // 4 values of 8 bytes, plus tag, Binary head byte and length byte
+  ASSERT_EQ(4U * 8U + 4U, d.byteSize());
+  PackedArrayView<double> dv = d.getPackedArray<double>(&options);
+  ASSERT_EQ(doubles.size(), dv.size());
+  for (std::size_t i = 0; i < doubles.size(); ++i) {
+    ASSERT_EQ(doubles[i], dv[i]);
+  }
+
+  Slice f = b.slice().get("floats");
+  ASSERT_TRUE(f.isPackedArray<float>(&options));
+  ASSERT_FALSE(f.isPackedArray<double>(&options));
+  PackedArrayView<float> fv = f.getPackedArray<float>(&options);
+  ASSERT_EQ(floats.size(), fv.size());
+  for (std::size_t i = 0; i < floats.size(); ++i) {
+    ASSERT_EQ(floats[i], fv[i]);
+  }
+}
+
+TEST(SliceTest, PackedArrayEmpty) {
+  Options options;
+  options.packedArrays = true;
+
+  Builder b;
+  b.addPacked<double>(nullptr, 0);
+  Slice s = b.slice();
+
+  ASSERT_TRUE(s.isPackedArray<double>(&options));
+  PackedArrayView<double> view = s.getPackedArray<double>(&options);
+  ASSERT_TRUE(view.empty());
+  ASSERT_EQ(0U, view.size());
+  ASSERT_TRUE(view.begin() == view.end());
+}
+
+TEST(SliceTest, PackedArrayDisabled) {
+  Builder b;
+  b.addPacked(std::vector<int64_t>{1, 2});
+
+  // applications may use the same tags for their own Binary values
+  ASSERT_FALSE(b.slice().isPackedArray());
+  ASSERT_FALSE(b.slice().isPackedArray<int64_t>());
+  ASSERT_VELOCYPACK_EXCEPTION(b.slice().getPackedArray<int64_t>(), Exception::InvalidValueType);
+  ASSERT_TRUE(b.slice().value().isBinary());
+}
+
+TEST(SliceTest, PackedArrayInvalid) {
+  Options options;
+  options.packedArrays = true;
+  // tagged, but not a Binary
+  Builder b;
+  b.addTagged(PackedArrayTraits<int64_t>::tag, Value(1));
+  ASSERT_FALSE(b.slice().isPackedArray(&options));
+  ASSERT_VELOCYPACK_EXCEPTION(b.slice().getPackedArray<int64_t>(&options), Exception::InvalidValueType);
+
+  // length not a multiple of the element size
+  uint8_t const data[] = {0x01, 0x02, 0x03};
+  b.clear();
+  b.addTagged(PackedArrayTraits<int64_t>::tag,
+              ValuePair(&data[0], sizeof(data), ValueType::Binary));
+  ASSERT_FALSE(b.slice().isPackedArray(&options));
+
+  // untagged Binary
+  b.clear();
+  b.add(ValuePair(&data[0], sizeof(data), ValueType::Binary));
+  ASSERT_FALSE(b.slice().isPackedArray(&options));
+
+  // regular Array
+  b.clear();
+  b.openArray();
+  b.add(Value(1));
+  b.close();
+  ASSERT_FALSE(b.slice().isPackedArray(&options));
+}
+
 TEST(SliceTest, GetNumericValueIntNoLoss) {
   Builder b;
   b.add(Value(ValueType::Array));
@@ -2482,6 +2674,209 @@ TEST(SliceTest, Translate) {
   ASSERT_VELOCYPACK_EXCEPTION(Slice(s.start() + s.getNthOffset(0)).translate().copyString(), Exception::NeedAttributeTranslator); 
 }
 
+TEST(SliceTest, TranslatorLookups) {
+  std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
+
+  ASSERT_EQ(nullptr, translator->translate("foo"));
+  translator->seal();
+  ASSERT_EQ(nullptr, translator->translate("foo"));
+  ASSERT_EQ(nullptr, translator->translate(uint64_t(0)));
+
+  translator.reset(new AttributeTranslator);
+  for (uint64_t i = 0; i < 1000; ++i) {
+    translator->add("attribute-" + std::to_string(i), i + 1);
+  }
+  translator->add("", 1001);
+  translator->add("averyveryverylongattributename", 1002);
+  translator->seal();
+  ASSERT_EQ(1002UL, translator->count());
+
+  for (uint64_t i = 0; i < 1000; ++i) {
+    std::string key("attribute-" + std::to_string(i));
+    uint8_t const* id = translator->translate(key);
+    ASSERT_NE(nullptr, id);
+    ASSERT_EQ(i + 1, Slice(id).getUInt());
+    uint8_t const* name = translator->translate(i + 1);
+    ASSERT_NE(nullptr, name);
+    ASSERT_EQ(key, Slice(name).copyString());
+  }
+  ASSERT_EQ(1001UL, Slice(translator->translate("")).getUInt());
+  ASSERT_EQ(1002UL, Slice(translator->translate("averyveryverylongattributename")).getUInt());
+
+  ASSERT_EQ(nullptr, translator->translate("attribute-1000"));
+  ASSERT_EQ(nullptr, translator->translate("attribute-"));
+  ASSERT_EQ(nullptr, translator->translate("attribute-1x"));
+  ASSERT_EQ(nullptr, translator->translate("averyveryverylongattributenamf"));
+  ASSERT_EQ(nullptr, translator->translate(uint64_t(0)));
+  ASSERT_EQ(nullptr, translator->translate(uint64_t(1003)));
+  ASSERT_EQ(nullptr, translator->translate(uint64_t(1000000)));
+}
+
+TEST(SliceTest, TranslatorSparseIds) {
+  std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
+
+  translator->add("foo", 1);
+  translator->add("bar", 1000000);
+  translator->add("baz", UINT64_MAX);
+  translator->seal();
+
+  ASSERT_EQ(1UL, Slice(translator->translate("foo")).getUInt());
+  ASSERT_EQ(1000000UL, Slice(translator->translate("bar")).getUInt());
+  ASSERT_EQ(UINT64_MAX, Slice(translator->translate("baz")).getUInt());
+  ASSERT_EQ("foo", Slice(translator->translate(uint64_t(1))).copyString());
+  ASSERT_EQ("bar", Slice(translator->translate(uint64_t(1000000))).copyString());
+  ASSERT_EQ("baz", Slice(translator->translate(UINT64_MAX)).copyString());
+  ASSERT_EQ(nullptr, translator->translate(uint64_t(2)));
+}
+
+TEST(SliceTest, TranslatorDuplicateKeys) {
+  std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
+
+  translator->add("foo", 1);
+  translator->add("foo", 2);
+  translator->add("bar", 3);
+  translator->seal();
+
+  uint8_t const* id = translator->translate("foo");
+  ASSERT_NE(nullptr, id);
+  ASSERT_TRUE(Slice(id).getUInt() == 1 || Slice(id).getUInt() == 2);
+  ASSERT_EQ("foo", Slice(translator->translate(uint64_t(1))).copyString());
+  ASSERT_EQ("foo", Slice(translator->translate(uint64_t(2))).copyString());
+  ASSERT_EQ(3UL, Slice(translator->translate("bar")).getUInt());
+}
+
+TEST(SliceTest, TranslateWithExplicitTranslator) {
+  std::unique_ptr<AttributeTranslator> first(new AttributeTranslator);
+  first->add("foo", 1);
+  first->add("bar", 2);
+  first->seal();
+
+  std::unique_ptr<AttributeTranslator> second(new AttributeTranslator);
+  second->add("qux", 1);
+  second->add("baz", 2);
+  second->seal();
+
+  Options options;
+  options.attributeTranslator = first.get();
+  Builder b(&options);
+  b.openObject();
+  b.add("foo", Value(1));
+  b.add("bar", Value(2));
+  b.close();
+
+  Slice s = b.slice();
+  // no default translator
+  ASSERT_VELOCYPACK_EXCEPTION(s.get("foo"), Exception::NeedAttributeTranslator);
+
+  ASSERT_EQ(1, s.get(StringRef("foo"), first.get()).getInt());
+  ASSERT_EQ(2, s.get(StringRef("bar"), &options).getInt());
+  ASSERT_TRUE(s.get(StringRef("qux"), first.get()).isNone());
+  ASSERT_TRUE(s.hasKey(StringRef("bar"), first.get()));
+
+  // the same ids mean different names in the second translator
+  ASSERT_EQ(1, s.get(StringRef("qux"), second.get()).getInt());
+  ASSERT_EQ(2, s.get(StringRef("baz"), second.get()).getInt());
+  ASSERT_TRUE(s.get(StringRef("foo"), second.get()).isNone());
+  ASSERT_FALSE(s.hasKey(StringRef("foo"), second.get()));
+
+  // a nullptr means the default translator
+  ASSERT_VELOCYPACK_EXCEPTION(s.get(StringRef("foo"), nullptr), Exception::NeedAttributeTranslator);
+  ASSERT_VELOCYPACK_EXCEPTION(s.hasKey(StringRef("foo"), nullptr), Exception::NeedAttributeTranslator);
+
+  std::shared_ptr<Builder> plain = Parser::fromJson("{\"a\":1}");
+  ASSERT_EQ(1, plain->slice().get(StringRef("a"), nullptr).getInt());
+  ASSERT_TRUE(plain->slice().hasKey(StringRef("a"), nullptr));
+  ASSERT_FALSE(plain->slice().hasKey(StringRef("b"), nullptr));
+  ASSERT_EQ(1, plain->slice().get(StringRef("a"), static_cast<Options const*>(nullptr)).getInt());
+
+  // keys are sorted by their names in the first translator
+  Slice key = s.keyAt(0, false);
+  ASSERT_EQ("baz", key.translate(second.get()).copyString());
+  ASSERT_EQ("bar", key.makeKey(first.get()).copyString());
+  ASSERT_VELOCYPACK_EXCEPTION(key.translate(), Exception::NeedAttributeTranslator);
+}
+
+TEST(SliceTest, TranslateThreadScope) {
+  std::unique_ptr<AttributeTranslator> first(new AttributeTranslator);
+  first->add("foo", 1);
+  first->seal();
+
+  std::unique_ptr<AttributeTranslator> second(new AttributeTranslator);
+  second->add("bar", 1);
+  second->seal();
+
+  Options options;
+  options.attributeTranslator = first.get();
+  Builder b(&options);
+  b.openObject();
+  b.add("foo", Value(42));
+  b.close();
+  Slice s = b.slice();
+
+  ASSERT_EQ(nullptr, AttributeTranslatorThreadScope::current());
+  {
+    AttributeTranslatorThreadScope scope(first.get());
+    ASSERT_EQ(first.get(), AttributeTranslatorThreadScope::current());
+    ASSERT_EQ(42, s.get("foo").getInt());
+    ASSERT_EQ("foo", s.keyAt(0).copyString());
+
+    {
+      AttributeTranslatorThreadScope inner(second.get());
+      ASSERT_EQ(42, s.get("bar").getInt());
+      ASSERT_TRUE(s.get("foo").isNone());
+      // an explicit translator takes precedence
+      ASSERT_EQ(42, s.get(StringRef("foo"), first.get()).getInt());
+    }
+
+    ASSERT_EQ(42, s.get("foo").getInt());
+    scope.revert();
+    ASSERT_EQ(nullptr, AttributeTranslatorThreadScope::current());
+    ASSERT_VELOCYPACK_EXCEPTION(s.get("foo"), Exception::NeedAttributeTranslator);
+  }
+
+  // the thread binding takes precedence over the global default
+  AttributeTranslatorScope global(first.get());
+  AttributeTranslatorThreadScope scope(second.get());
+  ASSERT_EQ(42, s.get("bar").getInt());
+}
+
+TEST(SliceTest, TranslateThreadScopeIsPerThread) {
+  std::unique_ptr<AttributeTranslator> first(new AttributeTranslator);
+  first->add("foo", 1);
+  first->seal();
+
+  std::unique_ptr<AttributeTranslator> second(new AttributeTranslator);
+  second->add("bar", 1);
+  second->seal();
+
+  Options options;
+  options.attributeTranslator = first.get();
+  Builder b(&options);
+  b.openObject();
+  b.add("foo", Value(42));
+  b.close();
+  Slice s = b.slice();
+
+  auto run = [&s](AttributeTranslator const* translator, char const* name,
+                  bool& ok) {
+    AttributeTranslatorThreadScope scope(translator);
+    ok = true;
+    for (int i = 0; i < 10000; ++i) {
+      ok &= (s.get(name).getInt() == 42);
+    }
+  };
+
+  bool ok1 = false;
+  bool ok2 = false;
+  std::thread t1(run, first.get(), "foo", std::ref(ok1));
+  std::thread t2(run, second.get(), "bar", std::ref(ok2));
+  t1.join();
+  t2.join();
+  ASSERT_TRUE(ok1);
+  ASSERT_TRUE(ok2);
+  ASSERT_EQ(nullptr, AttributeTranslatorThreadScope::current());
+}
+
 TEST(SliceTest, TranslateSingleMember) {
   std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
 
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "tests-common.h"
+
+TEST(ThreadPoolTest, Size) {
+  ASSERT_EQ(1UL, ThreadPool(0).size());
+  ASSERT_EQ(1UL, ThreadPool(1).size());
+  ASSERT_EQ(4UL, ThreadPool(4).size());
+}
+
+TEST(ThreadPoolTest, RunsAllTasks) {
+  for (std::size_t threads : { 1, 2, 4, 8 }) {
+    ThreadPool pool(threads);
+    for (std::size_t numTasks : { 0, 1, 3, 4, 100 }) {
+      std::vector<std::atomic<int>> calls(numTasks);
+      for (auto& it : calls) {
+        it = 0;
+      }
+      auto errors = pool.run(numTasks, [&](std::size_t task) { ++calls[task]; });
+      ASSERT_EQ(numTasks, errors.size());
+      for (std::size_t i = 0; i < numTasks; ++i) {
+        ASSERT_EQ(1, calls[i].load());
+        ASSERT_EQ(nullptr, errors[i]);
+      }
+    }
+  }
+}
+
+TEST(ThreadPoolTest, UsesSeveralThreads) {
+  ThreadPool pool(4);
+  // each task waits until all of them have started, which only finishes
+  // if they run concurrently
+  std::atomic<std::size_t> started(0);
+  auto errors = pool.run(4, [&](std::size_t) {
+    ++started;
+    while (started.load() < 4) {
+      std::this_thread::yield();
+    }
+  });
+  ASSERT_EQ(4UL, started.load());
+}
+
+TEST(ThreadPoolTest, Exceptions) {
+  ThreadPool pool(4);
+  auto errors = pool.run(10, [&](std::size_t task) {
+    if (task % 3 == 0) {
+      throw std::runtime_error("task failed");
+    }
+  });
+  ASSERT_EQ(10UL, errors.size());
+  for (std::size_t i = 0; i < errors.size(); ++i) {
+    ASSERT_EQ(i % 3 == 0, errors[i] != nullptr);
+  }
+  ASSERT_THROW(std::rethrow_exception(errors[0]), std::runtime_error);
+
+  // the pool can still be used afterwards
+  std::atomic<std::size_t> calls(0);
+  pool.run(10, [&](std::size_t) { ++calls; });
+  ASSERT_EQ(10UL, calls.load());
+}
+
+TEST(ThreadPoolTest, ReusesThreads) {
+  ThreadPool pool(4);
+  std::atomic<std::size_t> calls(0);
+  for (int i = 0; i < 1000; ++i) {
+    pool.run(4, [&](std::size_t) { ++calls; });
+  }
+  ASSERT_EQ(4000UL, calls.load());
+}
+
+TEST(ThreadPoolTest, NestedRun) {
+  ThreadPool pool(4);
+  std::atomic<std::size_t> calls(0);
+  pool.run(4, [&](std::size_t) {
+    auto errors = pool.run(4, [&](std::size_t) { ++calls; });
+    for (auto const& error : errors) {
+      ASSERT_EQ(nullptr, error);
+    }
+  });
+  ASSERT_EQ(16UL, calls.load());
+}
+
+TEST(ThreadPoolTest, ConcurrentRuns) {
+  ThreadPool pool(4);
+  std::atomic<std::size_t> calls(0);
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i) {
+    callers.emplace_back([&]() {
+      for (int j = 0; j < 100; ++j) {
+        pool.run(8, [&](std::size_t) { ++calls; });
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  ASSERT_EQ(3200UL, calls.load());
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,254 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Library to build up VPack documents.
+///
+/// DISCLAIMER
+///
+/// Copyright 2015 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+/// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <limits>
+#include <string>
+
+#include "tests-common.h"
+
+static Builder buildWith(std::string const& json, bool compact) {
+  // inherits the attribute translator from the defaults
+  Options options = Options::Defaults;
+  options.buildUnindexedArrays = compact;
+  options.buildUnindexedObjects = compact;
+  Parser parser(&options);
+  parser.parse(json);
+  return *parser.steal();
+}
+
+// a document with members of all sizes, nested compound values and enough
+// data to require 2-byte offsets
+static std::string buildJson() {
+  std::string json("{\"numbers\":[0,1,-1,9,-6,-7,127,-128,255,65535,-32769,");
+  json.append("4294967296,-4294967297,9223372036854775807,-9223372036854775808,");
+  json.append("18446744073709551615,0.5,-1.25e100],\"same\":[1,2,3,4],");
+  json.append("\"single\":[\"x\"],\"one\":{\"a\":true},\"empty\":[],\"none\":{},");
+  json.append("\"long\":\"");
+  json.append(300, 'z');
+  json.append("\",\"objects\":[");
+  for (int i = 0; i < 40; ++i) {
+    if (i > 0) {
+      json.push_back(',');
+    }
+    json.append("{\"id\":" + std::to_string(i) + ",\"name\":\"item" +
+                std::to_string(i) + "\",\"flag\":" +
+                (i % 2 == 0 ? "false" : "true") + ",\"zz\":null}");
+  }
+  json.append("]}");
+  return json;
+}
+
+// checks that TrustedSlice and its iterators produce the same results as
+// Slice and the regular iterators, recursively
+static void compare(Slice s) {
+  TrustedSlice t(s);
+  ASSERT_EQ(s.start(), t.start());
+  ASSERT_EQ(s.type(), t.type());
+  ASSERT_EQ(s.byteSize(), t.byteSize());
+
+  if (s.isArray()) {
+    ValueLength const n = s.length();
+    ASSERT_EQ(n, t.length());
+    for (ValueLength i = 0; i < n; ++i) {
+      ASSERT_EQ(s.at(i).start(), t.at(i).start());
+      ASSERT_EQ(s[i].start(), t[i].start());
+    }
+
+    ArrayIterator it(s);
+    TrustedArrayIterator tit(t);
+    ASSERT_EQ(it.size(), tit.size());
+    while (it.valid()) {
+      ASSERT_TRUE(tit.valid());
+      ASSERT_EQ(it.index(), tit.index());
+      ASSERT_EQ(it.isFirst(), tit.isFirst());
+      ASSERT_EQ(it.isLast(), tit.isLast());
+      ASSERT_EQ(it.value().start(), tit.value().start());
+      compare(it.value());
+      it.next();
+      tit.next();
+    }
+    ASSERT_FALSE(tit.valid());
+
+    ValueLength count = 0;
+    for (auto value : TrustedArrayIterator(s)) {
+      ASSERT_EQ(s.at(count).start(), value.start());
+      ++count;
+    }
+    ASSERT_EQ(n, count);
+  } else if (s.isObject()) {
+    ValueLength const n = s.length();
+    ASSERT_EQ(n, t.length());
+    for (ValueLength i = 0; i < n; ++i) {
+      ASSERT_EQ(s.keyAt(i, false).start(), t.keyAt(i, false).start());
+      ASSERT_TRUE(s.keyAt(i).binaryEquals(t.keyAt(i).slice()));
+      ASSERT_EQ(s.valueAt(i).start(), t.valueAt(i).start());
+
+      std::string key = s.keyAt(i).copyString();
+      ASSERT_EQ(s.get(key).start(), t.get(key).start());
+      ASSERT_EQ(s.get(key.c_str()).start(), t.get(key.c_str()).start());
+    }
+    ASSERT_TRUE(t.get("does-not-exist").isNone());
+
+    for (bool sequential : {false, true}) {
+      ObjectIterator it(s, sequential);
+      TrustedObjectIterator tit(t, sequential);
+      ASSERT_EQ(it.size(), tit.size());
+      while (it.valid()) {
+        ASSERT_TRUE(tit.valid());
+        ASSERT_EQ(it.index(), tit.index());
+        ASSERT_EQ(it.key(false).start(), tit.key(false).start());
+        ASSERT_TRUE(it.key().binaryEquals(tit.key()));
+        ASSERT_EQ(it.value().start(), tit.value().start());
+        auto pair = *tit;
+        ASSERT_TRUE(it.key().binaryEquals(pair.key));
+        ASSERT_EQ(it.value().start(), pair.value.start());
+        compare(it.value());
+        it.next();
+        tit.next();
+      }
+      ASSERT_FALSE(tit.valid());
+    }
+
+    ObjectIterator it(s, true);
+    for (auto pair : TrustedObjectIterator(s, true)) {
+      ASSERT_EQ(it.value().start(), pair.value.start());
+      it.next();
+    }
+    ASSERT_FALSE(it.valid());
+  } else if (s.isString()) {
+    ASSERT_EQ(s.getStringLength(), t.getStringLength());
+    ASSERT_EQ(s.copyString(), t.copyString());
+    ASSERT_TRUE(s.stringRef().equals(t.stringRef()));
+    ValueLength l1, l2;
+    ASSERT_EQ(s.getString(l1), t.getString(l2));
+    ASSERT_EQ(l1, l2);
+  } else if (s.isBool()) {
+    ASSERT_EQ(s.getBool(), t.getBool());
+  } else if (s.isDouble()) {
+    ASSERT_EQ(s.getDouble(), t.getDouble());
+    ASSERT_EQ(s.getNumber<double>(), t.getNumber<double>());
+  } else if (s.isUInt() &&
+             s.getUInt() > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+    ASSERT_EQ(s.getUInt(), t.getUInt());
+    ASSERT_EQ(s.getNumber<uint64_t>(), t.getNumber<uint64_t>());
+    ASSERT_EQ(s.getNumber<double>(), t.getNumber<double>());
+  } else if (s.isInteger()) {
+    ASSERT_EQ(s.getInt(), t.getInt());
+    ASSERT_EQ(s.getNumber<int64_t>(), t.getNumber<int64_t>());
+    ASSERT_EQ(s.getNumber<double>(), t.getNumber<double>());
+    if (s.getInt() >= 0) {
+      ASSERT_EQ(s.getUInt(), t.getUInt());
+    }
+    if (s.isSmallInt()) {
+      ASSERT_EQ(s.getSmallInt(), t.getSmallInt());
+    }
+  }
+}
+
+TEST(TrustedSliceTest, DefaultIsNone) {
+  TrustedSlice t;
+  ASSERT_TRUE(t.isNone());
+  ASSERT_TRUE(t.slice().isNone());
+}
+
+TEST(TrustedSliceTest, Indexed) {
+  Builder b = buildWith(buildJson(), false);
+  ASSERT_EQ(0x0c, b.slice().head());
+  compare(b.slice());
+}
+
+TEST(TrustedSliceTest, Compact) {
+  Builder b = buildWith(buildJson(), true);
+  ASSERT_EQ(0x14, b.slice().head());
+  ASSERT_EQ(0x13, b.slice().get("numbers").head());
+  compare(b.slice());
+}
+
+TEST(TrustedSliceTest, ArraysWithoutIndexTable) {
+  Builder b = buildWith("[[1,2,3],[4,5,6],[7,8,9]]", false);
+  Slice s = b.slice();
+  ASSERT_EQ(0x02, s.head());
+  ASSERT_EQ(0x02, s.at(0).head());
+  compare(s);
+  ASSERT_EQ(3, TrustedSlice(s).at(0).at(2).getInt());
+  ASSERT_EQ(8, TrustedSlice(s).at(2).at(1).getInt());
+
+  b = buildWith("[\"ab\",\"cd\",\"ef\"]", false);
+  s = b.slice();
+  ASSERT_EQ(0x02, s.head());
+  compare(s);
+  ASSERT_EQ("cd", TrustedSlice(s).at(1).copyString());
+}
+
+TEST(TrustedSliceTest, LargeOffsets) {
+  std::string json("[");
+  for (int i = 0; i < 20000; ++i) {
+    if (i > 0) {
+      json.push_back(',');
+    }
+    json.append((i % 3 == 0) ? std::to_string(i) : "\"value" + std::to_string(i) + "\"");
+  }
+  json.push_back(']');
+
+  Builder b = buildWith(json, false);
+  ASSERT_EQ(0x08, b.slice().head());
+  compare(b.slice());
+}
+
+TEST(TrustedSliceTest, TranslatedKeys) {
+  std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
+
+  translator->add("foo", 1);
+  translator->add("bar", 2);
+  translator->add("baz", 3);
+  translator->seal();
+
+  AttributeTranslatorScope scope(translator.get());
+
+  for (bool compact : {false, true}) {
+    Builder b = buildWith(
+        "{\"foo\":1,\"bar\":2,\"qux\":3,\"baz\":4,\"one\":{\"foo\":5}}",
+        compact);
+    Slice s = b.slice();
+    ASSERT_TRUE(s.keyAt(0, false).isSmallInt());
+    compare(s);
+
+    TrustedSlice t(s);
+    ASSERT_EQ(1, t.get("foo").getInt());
+    ASSERT_EQ(3, t.get("qux").getInt());
+    ASSERT_EQ(4, t.get("baz").getInt());
+    ASSERT_EQ(5, t.get("one").get("foo").getInt());
+    ASSERT_EQ(2, t.get(StringRef("bar"), translator.get()).getInt());
+    ASSERT_TRUE(t.get("quux").isNone());
+  }
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
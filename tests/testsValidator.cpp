@@ -24,6 +24,7 @@
 /// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <functional>
 #include <ostream>
 #include <string>
 
@@ -2380,6 +2381,356 @@ TEST(ValidatorTest, ObjectFourByteManyEntries) {
   ASSERT_TRUE(validator.validate(b.slice().start(), b.slice().byteSize()));
 }
 
+static std::string validationResult(std::function<void()> const& cb) {
+  try {
+    cb();
+    return "ok";
+  } catch (Exception const& ex) {
+    return std::to_string(ex.errorCode()) + ": " + ex.what();
+  }
+}
+
+static void checkParallelMatchesSerial(std::string const& original, std::size_t start, std::size_t end) {
+  Validator validator;
+  validator.minMembersPerThread = 10;
+  
+  for (std::size_t i = start; i < end; ++i) {
+    for (uint8_t c : { 0x00, 0x01, 0x18, 0x31, 0x42, 0x7f, 0xff }) {
+      std::string value = original;
+      value[i] = static_cast<char>(c);
+      std::string serial = validationResult([&]() { validator.validate(value.data(), value.size()); });
+      std::string parallel = validationResult([&]() { validator.validateParallel(value.data(), value.size(), 4); });
+      ASSERT_EQ(serial, parallel) << "position " << i << ", byte " << int(c);
+    }
+  }
+}
+
+TEST(ValidatorTest, ParallelArray) {
+  Builder b;
+  b.openArray();
+  for (std::size_t i = 0; i < 1000; ++i) {
+    if (i % 3 == 0) {
+      b.add(Value("test" + std::to_string(i)));
+    } else {
+      b.add(Value(i));
+    }
+  }
+  b.close();
+  ASSERT_EQ(0x07, b.slice().head());
+  
+  Validator validator;
+  validator.minMembersPerThread = 10;
+  for (std::size_t threads : { 0, 1, 2, 3, 4, 7, 16, 1000, 2000 }) {
+    ASSERT_TRUE(validator.validateParallel(b.slice().start(), b.slice().byteSize(), threads));
+  }
+
+  ASSERT_VELOCYPACK_EXCEPTION(validator.validateParallel(b.slice().start(), b.slice().byteSize() - 1, 4), Exception::ValidatorInvalidLength);
+  ASSERT_VELOCYPACK_EXCEPTION(validator.validateParallel(b.slice().start(), b.slice().byteSize() + 1, 4), Exception::ValidatorInvalidLength);
+  ASSERT_TRUE(validator.validateParallel(b.slice().start(), b.slice().byteSize() + 1, 4, true));
+}
+
+TEST(ValidatorTest, ParallelWithPool) {
+  Builder array;
+  array.openArray();
+  Builder object;
+  object.openObject();
+  for (std::size_t i = 0; i < 1000; ++i) {
+    array.add(Value(i));
+    object.add("test" + std::to_string(i), Value(i));
+  }
+  array.close();
+  object.close();
+
+  Validator validator;
+  validator.minMembersPerThread = 10;
+  ThreadPool pool(4);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(validator.validateParallel(array.slice().start(), array.slice().byteSize(), pool));
+    ASSERT_TRUE(validator.validateParallel(object.slice().start(), object.slice().byteSize(), pool));
+    ASSERT_TRUE(validator.tryValidateParallel(array.slice().start(), array.slice().byteSize(), pool).ok());
+  }
+  ASSERT_VELOCYPACK_EXCEPTION(validator.validateParallel(array.slice().start(), array.slice().byteSize() - 1, pool), Exception::ValidatorInvalidLength);
+  ASSERT_EQ(Exception::ValidatorInvalidLength,
+            validator.tryValidateParallel(object.slice().start(), object.slice().byteSize() - 1, pool).code);
+
+  // validating from within a task of the same pool runs on that task's thread
+  std::atomic<int> valid(0);
+  pool.run(4, [&](std::size_t) {
+    Validator nested;
+    nested.minMembersPerThread = 10;
+    if (nested.validateParallel(array.slice().start(), array.slice().byteSize(), pool)) {
+      ++valid;
+    }
+  });
+  ASSERT_EQ(4, valid.load());
+}
+
+TEST(ValidatorTest, ParallelObject) {
+  Builder b;
+  b.openObject();
+  for (std::size_t i = 0; i < 1000; ++i) {
+    b.add("test" + std::to_string(i), Value(i));
+  }
+  b.close();
+  ASSERT_EQ(0x0c, b.slice().head());
+  
+  Validator validator;
+  validator.minMembersPerThread = 10;
+  for (std::size_t threads : { 0, 1, 2, 3, 4, 7, 16, 1000, 2000 }) {
+    ASSERT_TRUE(validator.validateParallel(b.slice().start(), b.slice().byteSize(), threads));
+  }
+  
+  ASSERT_VELOCYPACK_EXCEPTION(validator.validateParallel(b.slice().start(), b.slice().byteSize() - 1, 4), Exception::ValidatorInvalidLength);
+}
+
+TEST(ValidatorTest, ParallelOtherTypes) {
+  Options options;
+  options.buildUnindexedArrays = true;
+  options.buildUnindexedObjects = true;
+  
+  Validator validator;
+  validator.minMembersPerThread = 1;
+  for (auto const& json : { "null", "\"foo\"", "[]", "{}", "[1,2,3]", "[1,\"a\",[]]", "{\"a\":1}", "{\"a\":1,\"b\":[1,2]}" }) {
+    for (Options const* o : { &Options::Defaults, &options }) {
+      std::shared_ptr<Builder> b = Parser::fromJson(json, o);
+      ASSERT_TRUE(validator.validateParallel(b->slice().start(), b->slice().byteSize(), 4));
+    }
+  }
+  
+  std::string const value("\x15", 1);
+  ASSERT_VELOCYPACK_EXCEPTION(validator.validateParallel(value.c_str(), value.size(), 4), Exception::ValidatorInvalidType);
+}
+
+TEST(ValidatorTest, ParallelArrayErrorsMatchSerial) {
+  Builder b;
+  b.openArray();
+  for (std::size_t i = 0; i < 100; ++i) {
+    b.add(Value(i * 1000));
+    b.add(Value("x" + std::to_string(i)));
+  }
+  b.close();
+  ASSERT_EQ(0x07, b.slice().head());
+  
+  std::string const original(b.slice().startAs<char>(), b.slice().byteSize());
+  checkParallelMatchesSerial(original, 0, original.size());
+}
+
+TEST(ValidatorTest, ParallelObjectErrorsMatchSerial) {
+  Builder b;
+  b.openObject();
+  for (std::size_t i = 0; i < 200; ++i) {
+    b.add("k" + std::to_string(i), Value(i * 1000));
+  }
+  b.close();
+  ASSERT_EQ(0x0c, b.slice().head());
+  
+  std::string const original(b.slice().startAs<char>(), b.slice().byteSize());
+  // skip the header, where single-threaded validation for small objects
+  // would be used anyway
+  checkParallelMatchesSerial(original, 5, original.size());
+}
+
+TEST(ValidatorTest, StreamEmpty) {
+  StreamValidator validator;
+  ASSERT_EQ(0U, validator.feed("", 0));
+  validator.finish();
+  ASSERT_EQ(0U, validator.values());
+  ASSERT_EQ(0U, validator.bytes());
+}
+
+TEST(ValidatorTest, StreamPieces) {
+  Options options;
+  options.buildUnindexedArrays = true;
+  options.buildUnindexedObjects = true;
+
+  std::string stream;
+  std::size_t expected = 0;
+  for (auto const& json : { "null", "17", "-3.5", "\"foo\"", "\"a long string value that does not fit into a short string, with more than 127 bytes in it, so we need even more text than this\"",
+                            "[]", "{}", "[1,2,3]", "[1,\"a\",[]]", "{\"a\":1}", "{\"a\":1,\"b\":[1,2]}" }) {
+    for (Options const* o : { &Options::Defaults, &options }) {
+      std::shared_ptr<Builder> b = Parser::fromJson(json, o);
+      stream.append(b->slice().startAs<char>(), b->slice().byteSize());
+      ++expected;
+    }
+  }
+  
+  Builder b;
+  b.addTagged(42, Value(1));
+  b.addTagged(uint64_t(1) << 40, Value("bar"));
+  stream.append(b.slice().startAs<char>(), b.size());
+  expected += 2;
+  
+  uint8_t const binary[] = { 0x00, 0x01, 0x02 };
+  Builder b2;
+  b2.add(ValuePair(&binary[0], sizeof(binary), ValueType::Binary));
+  stream.append(b2.slice().startAs<char>(), b2.size());
+  ++expected;
+
+  for (std::size_t pieceSize : { 1, 2, 3, 7, 64, 1000 }) {
+    StreamValidator validator;
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < stream.size(); i += pieceSize) {
+      count += validator.feed(stream.data() + i, (std::min)(pieceSize, stream.size() - i));
+    }
+    validator.finish();
+    ASSERT_EQ(expected, count);
+    ASSERT_EQ(expected, validator.values());
+    ASSERT_EQ(stream.size(), validator.bytes());
+  }
+}
+
+TEST(ValidatorTest, StreamParallel) {
+  Builder b;
+  b.openArray();
+  for (std::size_t i = 0; i < 1000; ++i) {
+    b.add(Value(i));
+  }
+  b.close();
+
+  std::string stream(b.slice().startAs<char>(), b.size());
+  stream.append(stream);
+
+  StreamValidator validator(&Options::Defaults, 4);
+  ASSERT_EQ(1U, validator.feed(stream.data(), 100 + b.size()));
+  ASSERT_EQ(1U, validator.feed(stream.data() + 100 + b.size(), stream.size() - 100 - b.size()));
+  validator.finish();
+}
+
+TEST(ValidatorTest, StreamIncomplete) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[1,2,3]");
+
+  StreamValidator validator;
+  ASSERT_EQ(0U, validator.feed(b->slice().startAs<char>(), b->size() - 1));
+  ASSERT_VELOCYPACK_EXCEPTION(validator.finish(), Exception::ValidatorInvalidLength);
+  ASSERT_EQ(1U, validator.feed(b->slice().startAs<char>() + b->size() - 1, 1));
+  validator.finish();
+}
+
+TEST(ValidatorTest, StreamInvalid) {
+  {
+    std::string const value("\x18\x16", 2);
+    StreamValidator validator;
+    ASSERT_VELOCYPACK_EXCEPTION(validator.feed(value.data(), value.size()), Exception::ValidatorInvalidType);
+    ASSERT_EQ(1U, validator.values());
+  }
+  
+  {
+    std::string const value("\x18\x15\x00\x00", 4);
+    StreamValidator validator;
+    ASSERT_VELOCYPACK_EXCEPTION(validator.feed(value.data(), value.size()), Exception::ValidatorInvalidType);
+  }
+  
+  {
+    // index table is wrong
+    std::string const value("\x06\x05\x01\x31\x04", 5);
+    StreamValidator validator;
+    ASSERT_VELOCYPACK_EXCEPTION(validator.feed(value.data(), value.size()), Exception::ValidatorInvalidLength);
+  }
+  
+  {
+    // invalid value split over two pieces
+    std::string const value("\x06\x05\x01\x31\x04", 5);
+    StreamValidator validator;
+    ASSERT_EQ(0U, validator.feed(value.data(), 2));
+    ASSERT_VELOCYPACK_EXCEPTION(validator.feed(value.data() + 2, 3), Exception::ValidatorInvalidLength);
+  }
+}
+
+TEST(ValidatorTest, StreamMaxValueSize) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[1,2,3,4,5,6,7,8,9,10]");
+  
+  StreamValidator validator;
+  validator.maxValueSize = b->size();
+  ASSERT_EQ(1U, validator.feed(b->slice().startAs<char>(), b->size()));
+  
+  validator.maxValueSize = b->size() - 1;
+  ASSERT_VELOCYPACK_EXCEPTION(validator.feed(b->slice().startAs<char>(), b->size()), Exception::ValidatorInvalidLength);
+  
+  StreamValidator validator2;
+  validator2.maxValueSize = b->size() - 1;
+  ASSERT_EQ(0U, validator2.feed(b->slice().startAs<char>(), 1));
+  ASSERT_VELOCYPACK_EXCEPTION(validator2.feed(b->slice().startAs<char>() + 1, 1), Exception::ValidatorInvalidLength);
+}
+
+static std::string statusResult(Status const& status) {
+  if (status.ok()) {
+    return "ok";
+  }
+  return std::to_string(status.code) + ": " + status.message;
+}
+
+TEST(ValidatorTest, TryValidateMatchesValidate) {
+  Options options;
+  options.validateUtf8Strings = true;
+  Options compact;
+  compact.buildUnindexedArrays = true;
+  compact.buildUnindexedObjects = true;
+
+  Validator validator(&options);
+  validator.minMembersPerThread = 10;
+  for (auto const& json : { "[1,2,3,\"abc\",[4,5],{\"a\":true}]", 
+                            "{\"a\":1,\"b\":[1,2],\"c\":{\"d\":\"e\"}}",
+                            "[\"\xc3\xa4\xc3\xb6\",1.5,null,-3]" }) {
+    for (Options const* o : { &Options::Defaults, &compact }) {
+      std::shared_ptr<Builder> b = Parser::fromJson(json, o);
+      std::string const original(b->slice().startAs<char>(), b->slice().byteSize());
+      for (std::size_t i = 0; i < original.size(); ++i) {
+        for (uint8_t c : { 0x00, 0x01, 0x0b, 0x13, 0x18, 0x31, 0x42, 0x7f, 0xbf, 0xff }) {
+          std::string value = original;
+          value[i] = static_cast<char>(c);
+          std::string const thrown = validationResult([&]() { validator.validate(value.data(), value.size()); });
+          Status status = validator.tryValidate(value.data(), value.size());
+          ASSERT_EQ(thrown, statusResult(status)) << "position " << i << ", byte " << int(c);
+          ASSERT_TRUE(status.ok() || status.position < value.size());
+          status = validator.tryValidateParallel(value.data(), value.size(), 4);
+          ASSERT_EQ(thrown, statusResult(status)) << "position " << i << ", byte " << int(c);
+        }
+      }
+    }
+  }
+}
+
+TEST(ValidatorTest, TryValidateErrorPosition) {
+  std::shared_ptr<Builder> b = Parser::fromJson("[1,\"abc\",3]");
+  std::string value(b->slice().startAs<char>(), b->slice().byteSize());
+  // the index table holds the offsets of the members
+  Slice s(reinterpret_cast<uint8_t const*>(value.data()));
+  ValueLength const offset = s.at(1).start() - s.start();
+  value[offset] = '\x15';
+
+  Validator validator;
+  Status status = validator.tryValidate(value.data(), value.size());
+  ASSERT_FALSE(status.ok());
+  ASSERT_EQ(Exception::ValidatorInvalidType, status.code);
+  ASSERT_EQ(offset, status.position);
+  ASSERT_VELOCYPACK_EXCEPTION(status.raise(), Exception::ValidatorInvalidType);
+
+  // a failure does not affect the next validation
+  ASSERT_TRUE(validator.tryValidate(b->slice().start(), b->slice().byteSize()).ok());
+}
+
+TEST(ValidatorTest, TryValidateParallel) {
+  Builder b;
+  b.openArray();
+  for (std::size_t i = 0; i < 1000; ++i) {
+    b.add(Value("test" + std::to_string(i)));
+  }
+  b.close();
+  std::string value(b.slice().startAs<char>(), b.slice().byteSize());
+
+  Validator validator;
+  validator.minMembersPerThread = 10;
+  ASSERT_TRUE(validator.tryValidateParallel(value.data(), value.size(), 4).ok());
+
+  // break a member in the range of the last thread
+  ValueLength const offset = b.slice().at(900).start() - b.slice().start();
+  value[offset] = '\x15';
+  Status status = validator.tryValidateParallel(value.data(), value.size(), 4);
+  ASSERT_FALSE(status.ok());
+  ASSERT_EQ(Exception::ValidatorInvalidType, status.code);
+  ASSERT_EQ(offset, status.position);
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
 
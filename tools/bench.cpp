@@ -24,43 +24,1103 @@
 /// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <new>
 #include <string>
-#include <vector>
-#include <fstream>
-#include <chrono>
 #include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "velocypack/vpack.h"
 
+#ifdef VELOCYPACK_BENCH_RAPIDJSON
 #include "rapidjson/document.h"
-#include "rapidjson/writer.h"
-#include "rapidjson/stringbuffer.h"
+#endif
 
 using namespace arangodb::velocypack;
 
-static void usage(char* argv[]) {
-  std::cout << "Usage: " << argv[0]
-            << " FILENAME.json RUNTIME_IN_SECONDS COPIES TYPE" << std::endl;
-  std::cout << "This program reads the file into a string, makes COPIES copies"
-            << std::endl;
-  std::cout << "and then parses the copies in a round-robin fashion to VPack."
-            << std::endl;
-  std::cout << "1 copy means its running in cache, more copies make it run"
-            << std::endl;
-  std::cout << "out of cache. The target areas are also in a different memory"
-            << std::endl;
-  std::cout << "area for each copy." << std::endl;
-  std::cout << "TYPE must be either 'vpack' or 'rapidjson'." << std::endl;
+// allocation counting
+// -------------------
+// all heap allocations made by a thread are counted in a thread-local
+// counter, so that each benchmark case can report allocations per operation.
+// with glibc, malloc & friends are interposed, which also catches the
+// allocations made by velocypack's Buffer (which uses malloc directly).
+// elsewhere only the global operator new is replaced.
+
+namespace {
+thread_local uint64_t allocationCounter = 0;
+}  // namespace
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+
+extern "C" {
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) {
+  ++allocationCounter;
+  return __libc_malloc(size);
 }
 
-static std::string tryReadFile(std::string const& filename) {
-  std::string s;
+void* calloc(size_t count, size_t size) {
+  ++allocationCounter;
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  ++allocationCounter;
+  return __libc_realloc(ptr, size);
+}
+}
+
+#else
+
+void* operator new(std::size_t size) {
+  ++allocationCounter;
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete[](void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+#endif
+
+namespace {
+
+// hardware performance counters
+// -----------------------------
+// uses perf_event_open on Linux. if the counters are not available (other
+// OS, missing permissions, running inside a VM without PMU access), the
+// counters are simply not reported.
+
+struct CounterValues {
+  uint64_t values[4] = {0, 0, 0, 0};
+  bool valid = false;
+};
+
+char const* const counterNames[] = {"cycles", "instructions", "cacheMisses",
+                                    "branchMisses"};
+
+class PerfCounters {
+ public:
+  explicit PerfCounters(bool enabled) {
+    for (auto& fd : _fds) {
+      fd = -1;
+    }
+#ifdef __linux__
+    if (!enabled) {
+      return;
+    }
+    uint64_t const configs[] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (size_t i = 0; i < 4; ++i) {
+      struct perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      // counts the calling thread only, on any CPU
+      _fds[i] = static_cast<int>(
+          ::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+      if (_fds[i] == -1) {
+        close();
+        return;
+      }
+    }
+#else
+    (void)enabled;
+#endif
+  }
+
+  ~PerfCounters() { close(); }
+
+  PerfCounters(PerfCounters const&) = delete;
+  PerfCounters& operator=(PerfCounters const&) = delete;
+
+  bool available() const { return _fds[0] != -1; }
+
+  void start() {
+#ifdef __linux__
+    if (available()) {
+      for (auto fd : _fds) {
+        ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  CounterValues stop() {
+    CounterValues result;
+#ifdef __linux__
+    if (available()) {
+      result.valid = true;
+      for (size_t i = 0; i < 4; ++i) {
+        ::ioctl(_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value = 0;
+        if (::read(_fds[i], &value, sizeof(value)) != sizeof(value)) {
+          result.valid = false;
+        }
+        result.values[i] = value;
+      }
+    }
+#endif
+    return result;
+  }
+
+ private:
+  void close() {
+#ifdef __linux__
+    for (auto& fd : _fds) {
+      if (fd != -1) {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+#endif
+  }
+
+  int _fds[4];
+};
+
+// configuration
+// -------------
+
+struct Config {
+  double runTime = 1.0;
+  size_t threads = 1;
+  // 0 means: derive from the cache modes
+  size_t copies = 0;
+  // size of the out-of-cache working set per thread
+  size_t workingSetSize = 256 * 1024 * 1024;
+  bool inCache = true;
+  bool outOfCache = true;
+  bool counters = true;
+  bool json = false;
+  std::vector<std::string> filters;
+  std::vector<std::string> files;
+};
+
+// a single input document, in all the representations the cases need
+struct Input {
+  std::string name;
+  std::string json;
+  Builder vpack;
+  Builder compact;
+  // offsets (relative to the start of the document) of all objects, plus
+  // the keys contained in them. used by the "get" and "keys" cases
+  std::vector<std::pair<ValueLength, std::vector<std::string>>> objects;
+  // offsets of all top-level members. used by the "hash-many" case
+  std::vector<ValueLength> members;
+  // the document with all recurring object shapes encoded as shaped
+  // objects, plus the offsets and keys of all objects in it. used by the
+  // "get-shaped" case
+  std::shared_ptr<ShapeRegistry> shapes;
+  Builder shaped;
+  std::vector<std::pair<ValueLength, std::vector<std::string>>> shapedObjects;
+  // the top-level members in a compressed container. used by the
+  // "decompress" case
+  std::string compressed;
+  // the document as MessagePack and CBOR. used by the "from-msgpack" and
+  // "from-cbor" cases
+  std::string messagePack;
+  std::string cbor;
+  // the first top-level member, if the document is an Object. used by the
+  // "parse-projection" case
+  JsonProjection projection;
+};
+
+// per-thread copies of an input, so that working sets larger than the
+// caches can be simulated and threads do not share any data
+struct Workspace {
+  explicit Workspace(Input const& input, size_t copies)
+      : input(input), parser(&parserOptions) {
+    for (size_t i = 0; i < copies; ++i) {
+      // explicit copies in distinct memory areas
+      json.emplace_back(input.json.data(), input.json.size());
+      Slice s = input.vpack.slice();
+      vpack.emplace_back(s.start(), s.start() + s.byteSize());
+      s = input.compact.slice();
+      compact.emplace_back(s.start(), s.start() + s.byteSize());
+      s = input.shaped.slice();
+      shaped.emplace_back(s.start(), s.start() + s.byteSize());
+      compressed.emplace_back(input.compressed);
+      messagePack.emplace_back(input.messagePack);
+      cbor.emplace_back(input.cbor);
+    }
+    slices.resize(input.members.size());
+    hashes.resize(input.members.size());
+  }
+
+  Slice slice(size_t i) const { return Slice(vpack[i].data()); }
+  Slice compactSlice(size_t i) const { return Slice(compact[i].data()); }
+  Slice shapedSlice(size_t i) const { return Slice(shaped[i].data()); }
+
+  Input const& input;
+  std::vector<std::string> json;
+  std::vector<std::vector<uint8_t>> vpack;
+  std::vector<std::vector<uint8_t>> compact;
+  std::vector<std::vector<uint8_t>> shaped;
+  std::vector<std::string> compressed;
+  std::vector<std::string> messagePack;
+  std::vector<std::string> cbor;
+
+  Options parserOptions;
+  Parser parser;
+  Builder builder;
+  std::string output;
+  std::vector<Slice> slices;
+  std::vector<uint64_t> hashes;
+  // results of all operations are folded into this value, so the compiler
+  // cannot optimize them away
+  uint64_t sink = 0;
+};
+
+// the sinks of all runs are stored here. the store to a volatile cannot
+// be removed, so neither can the operations that computed the sinks
+volatile uint64_t resultSink = 0;
+
+enum class BytesBase { Json, VPack };
+
+struct Case {
+  char const* name;
+  BytesBase bytesBase;
+  std::function<void(Workspace&, size_t)> run;
+};
+
+void rebuild(Builder& b, Slice s) {
+  if (s.isObject()) {
+    b.openObject();
+    for (auto it : ObjectIterator(s, true)) {
+      b.add(ValuePair(it.key.stringRef(), ValueType::String));
+      rebuild(b, it.value);
+    }
+    b.close();
+  } else if (s.isArray()) {
+    b.openArray();
+    for (auto it : ArrayIterator(s)) {
+      rebuild(b, it);
+    }
+    b.close();
+  } else if (s.isString()) {
+    b.add(ValuePair(s.stringRef(), ValueType::String));
+  } else if (s.isDouble()) {
+    b.add(Value(s.getDouble()));
+  } else if (s.isInt() || s.isSmallInt()) {
+    b.add(Value(s.getInt()));
+  } else if (s.isUInt()) {
+    b.add(Value(s.getUInt()));
+  } else if (s.isBool()) {
+    b.add(Value(s.getBool()));
+  } else {
+    b.add(s);
+  }
+}
+
+uint64_t iterate(Slice s) {
+  uint64_t count = 1;
+  if (s.isObject()) {
+    for (auto it : ObjectIterator(s, true)) {
+      count += it.key.head() + iterate(it.value);
+    }
+  } else if (s.isArray()) {
+    for (auto it : ArrayIterator(s)) {
+      count += iterate(it);
+    }
+  }
+  return count;
+}
+
+uint64_t accessByIndex(Slice s) {
+  uint64_t count = 1;
+  if (s.isObject()) {
+    ValueLength const n = s.length();
+    for (ValueLength i = 0; i < n; ++i) {
+      count += s.keyAt(i, false).head() + accessByIndex(s.valueAt(i));
+    }
+  } else if (s.isArray()) {
+    ValueLength const n = s.length();
+    for (ValueLength i = 0; i < n; ++i) {
+      count += accessByIndex(s.at(i));
+    }
+  }
+  return count;
+}
+
+// same as accessByIndex(), but using a CompactIndex for each compound value
+uint64_t accessByCompactIndex(Slice s) {
+  uint64_t count = 1;
+  if (s.isObject()) {
+    CompactIndex index(s);
+    ValueLength const n = index.length();
+    for (ValueLength i = 0; i < n; ++i) {
+      count += index.keyAt(i, false).head() +
+               accessByCompactIndex(index.valueAt(i));
+    }
+  } else if (s.isArray()) {
+    CompactIndex index(s);
+    ValueLength const n = index.length();
+    for (ValueLength i = 0; i < n; ++i) {
+      count += accessByCompactIndex(index.at(i));
+    }
+  }
+  return count;
+}
+
+// same as iterate(), but without any checks
+uint64_t iterateTrusted(TrustedSlice s) {
+  uint64_t count = 1;
+  if (s.isObject()) {
+    for (auto it : TrustedObjectIterator(s, true)) {
+      count += it.key.head() + iterateTrusted(TrustedSlice(it.value));
+    }
+  } else if (s.isArray()) {
+    for (auto it : TrustedArrayIterator(s)) {
+      count += iterateTrusted(TrustedSlice(it));
+    }
+  }
+  return count;
+}
+
+// same as accessByIndex(), but without any checks
+uint64_t accessByIndexTrusted(TrustedSlice s) {
+  uint64_t count = 1;
+  if (s.isObject()) {
+    ValueLength const n = s.length();
+    for (ValueLength i = 0; i < n; ++i) {
+      count += s.keyAt(i, false).head() + accessByIndexTrusted(s.valueAt(i));
+    }
+  } else if (s.isArray()) {
+    ValueLength const n = s.length();
+    for (ValueLength i = 0; i < n; ++i) {
+      count += accessByIndexTrusted(s.at(i));
+    }
+  }
+  return count;
+}
+
+// calls cb for the top-level Array, or for all Arrays on the top level of
+// an Object
+template<typename F>
+void forEachTopLevelArray(Slice s, F const& cb) {
+  if (s.isArray()) {
+    cb(s);
+  } else if (s.isObject()) {
+    for (auto it : ObjectIterator(s, true)) {
+      if (it.value.isArray()) {
+        cb(it.value);
+      }
+    }
+  }
+}
+
+void collectObjects(Input& input, Slice s) {
+  if (s.isObject()) {
+    std::vector<std::string> keys;
+    for (auto it : ObjectIterator(s, true)) {
+      keys.emplace_back(it.key.copyString());
+      collectObjects(input, it.value);
+    }
+    input.objects.emplace_back(s.start() - input.vpack.slice().start(),
+                               std::move(keys));
+  } else if (s.isArray()) {
+    for (auto it : ArrayIterator(s)) {
+      collectObjects(input, it);
+    }
+  }
+}
+
+void collectShapedObjects(Input& input, Slice s) {
+  if (s.isShapedObject()) {
+    ArrayIterator it(s.value());
+    auto const* shape = input.shapes->shape((*it).getUInt());
+    std::vector<std::string> keys;
+    for (auto key : ArrayIterator(shape->keys())) {
+      keys.emplace_back(key.copyString());
+    }
+    for (it.next(); it.valid(); it.next()) {
+      collectShapedObjects(input, *it);
+    }
+    input.shapedObjects.emplace_back(s.start() - input.shaped.slice().start(),
+                                     std::move(keys));
+  } else if (s.isObject()) {
+    std::vector<std::string> keys;
+    for (auto it : ObjectIterator(s, true)) {
+      keys.emplace_back(it.key.copyString());
+      collectShapedObjects(input, it.value);
+    }
+    input.shapedObjects.emplace_back(s.start() - input.shaped.slice().start(),
+                                     std::move(keys));
+  } else if (s.isArray()) {
+    for (auto it : ArrayIterator(s)) {
+      collectShapedObjects(input, it);
+    }
+  }
+}
+
+// a dictionary of 1000 attribute names, used by the "translate-1k" cases
+// independent of the input. the keys to look up contain each name once,
+// plus one miss per ten names
+struct Dictionary {
+  Dictionary() {
+    for (uint64_t i = 0; i < 1000; ++i) {
+      std::string key("attribute-" + std::to_string(i * 7919));
+      translator.add(key, i + 1);
+      keys.push_back(key);
+      if (i % 10 == 0) {
+        keys.push_back(key + "-missing");
+      }
+    }
+    translator.seal();
+    for (uint64_t i = 0; i < 1000; ++i) {
+      map.emplace(Slice(translator.translate(i + 1)).stringRef(), i + 1);
+    }
+  }
+
+  AttributeTranslator translator;
+  std::unordered_map<StringRef, uint64_t> map;
+  std::vector<std::string> keys;
+};
+
+Dictionary const& dictionary() {
+  static Dictionary const instance;
+  return instance;
+}
+
+// counts the values reported by the Parser, used by the "parse-sax" cases.
+// with skipNested set, it skips all Arrays and Objects below the top level
+struct CountingHandler final : public JsonHandler {
+  explicit CountingHandler(bool skipNested) : skipNested(skipNested) {}
+
+  void nullValue() override { ++count; }
+  void boolValue(bool) override { ++count; }
+  void intValue(int64_t) override { ++count; }
+  void uintValue(uint64_t) override { ++count; }
+  void doubleValue(double) override { ++count; }
+  void stringValue(StringRef) override { ++count; }
+  bool startArray() override { return open(); }
+  void endArray() override { --depth; }
+  bool startObject() override { return open(); }
+  void endObject() override { --depth; }
+
+  bool open() {
+    ++count;
+    if (skipNested && depth > 0) {
+      return false;
+    }
+    ++depth;
+    return true;
+  }
+
+  bool const skipNested;
+  size_t depth = 0;
+  size_t count = 0;
+};
+
+// the "reject" cases process the document cut into pieces of this size,
+// almost all of which are invalid, so that the cost of rejecting them
+// dominates
+constexpr size_t rejectPieceSize = 256;
+
+std::vector<Case> buildCases() {
+  std::vector<Case> cases;
+
+  cases.push_back({"parse", BytesBase::Json, [](Workspace& w, size_t i) {
+                     w.parser.clear();
+                     w.parser.parse(w.json[i]);
+                     w.sink += w.parser.builder().size();
+                   }});
+
+  cases.push_back({"parse-reject", BytesBase::Json,
+                   [](Workspace& w, size_t i) {
+                     std::string const& json = w.json[i];
+                     for (size_t pos = 0; pos < json.size();
+                          pos += rejectPieceSize) {
+                       try {
+                         w.parser.parse(json.data() + pos,
+                                        std::min(rejectPieceSize,
+                                                 json.size() - pos));
+                       } catch (Exception const&) {
+                         ++w.sink;
+                       }
+                     }
+                   }});
+
+  cases.push_back({"parse-try-reject", BytesBase::Json,
+                   [](Workspace& w, size_t i) {
+                     std::string const& json = w.json[i];
+                     for (size_t pos = 0; pos < json.size();
+                          pos += rejectPieceSize) {
+                       w.sink += !w.parser
+                                      .tryParse(json.data() + pos,
+                                                std::min(rejectPieceSize,
+                                                         json.size() - pos))
+                                      .ok();
+                     }
+                   }});
+
+  cases.push_back({"parse-projection", BytesBase::Json,
+                   [](Workspace& w, size_t i) {
+                     w.parser.clear();
+                     w.parser.parse(w.json[i], w.input.projection);
+                     w.sink += w.parser.builder().size();
+                   }});
+
+  cases.push_back({"parse-sax", BytesBase::Json, [](Workspace& w, size_t i) {
+                     CountingHandler handler(false);
+                     w.parser.parse(w.json[i], handler);
+                     w.sink += handler.count;
+                   }});
+
+  cases.push_back({"parse-sax-skip", BytesBase::Json,
+                   [](Workspace& w, size_t i) {
+                     CountingHandler handler(true);
+                     w.parser.parse(w.json[i], handler);
+                     w.sink += handler.count;
+                   }});
+
+#ifdef VELOCYPACK_BENCH_RAPIDJSON
+  cases.push_back({"parse-rapidjson", BytesBase::Json,
+                   [](Workspace& w, size_t i) {
+                     rapidjson::Document d;
+                     d.Parse(w.json[i].c_str());
+                     w.sink += d.IsObject() ? 1 : 0;
+                   }});
+#endif
+
+  cases.push_back({"dump", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     w.output.clear();
+                     StringSink sink(&w.output);
+                     Dumper dumper(&sink);
+                     dumper.dump(w.slice(i));
+                     w.sink += w.output.size();
+                   }});
+
+  // dumps into a fresh string, which grows as the output is appended
+  cases.push_back({"dump-unsized", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     std::string output;
+                     StringSink sink(&output);
+                     Dumper dumper(&sink);
+                     dumper.dump(w.slice(i));
+                     w.sink += output.size();
+                   }});
+
+  // dumps into a fresh string, allocated once with the precomputed size
+  cases.push_back({"dump-presized", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     std::string output;
+                     output.reserve(Dumper::maxOutputSize(w.slice(i)));
+                     StringSink sink(&output);
+                     Dumper dumper(&sink);
+                     dumper.dump(w.slice(i));
+                     w.sink += output.size();
+                   }});
+
+  cases.push_back({"dump-parallel", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     // hardware_concurrency() is too slow to call per
+                     // operation
+                     static std::size_t const numThreads =
+                         std::max(1U, std::thread::hardware_concurrency());
+                     w.output.clear();
+                     StringSink sink(&w.output);
+                     Dumper dumper(&sink);
+                     dumper.dumpParallel(w.slice(i), numThreads);
+                     w.sink += w.output.size();
+                   }});
+
+  cases.push_back({"dump-streaming", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     StreamingDumper dumper(w.slice(i));
+                     char buffer[16384];
+                     while (!dumper.done()) {
+                       w.sink += dumper.produce(&buffer[0], sizeof(buffer));
+                     }
+                   }});
+
+  cases.push_back({"build", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     w.builder.clear();
+                     rebuild(w.builder, w.slice(i));
+                     w.sink += w.builder.size();
+                   }});
+
+  cases.push_back({"get", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     uint8_t const* base = w.slice(i).start();
+                     for (auto const& it : w.input.objects) {
+                       Slice obj(base + it.first);
+                       for (auto const& key : it.second) {
+                         w.sink += obj.get(key).head();
+                       }
+                     }
+                   }});
+
+  cases.push_back({"get-trusted", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     uint8_t const* base = w.slice(i).start();
+                     for (auto const& it : w.input.objects) {
+                       TrustedSlice obj(base + it.first);
+                       for (auto const& key : it.second) {
+                         w.sink += obj.get(key).head();
+                       }
+                     }
+                   }});
+
+  // like "get", but on the document with recurring object shapes
+  // encoded as shaped objects. resolves attributes through the shape
+  // registry directly, which is what Slice::get() does for shaped objects
+  cases.push_back({"get-shaped", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     ShapeRegistry const& shapes = *w.input.shapes;
+                     uint8_t const* base = w.shapedSlice(i).start();
+                     for (auto const& it : w.input.shapedObjects) {
+                       Slice obj(base + it.first);
+                       if (obj.isShapedObject()) {
+                         for (auto const& key : it.second) {
+                           w.sink += shapes.get(obj, StringRef(key)).head();
+                         }
+                       } else {
+                         for (auto const& key : it.second) {
+                           w.sink += obj.get(key).head();
+                         }
+                       }
+                     }
+                   }});
+
+  cases.push_back({"at", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     w.sink += accessByIndex(w.slice(i));
+                   }});
+
+  cases.push_back({"at-trusted", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     w.sink += accessByIndexTrusted(TrustedSlice(w.slice(i)));
+                   }});
+
+  cases.push_back({"at-compact", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     w.sink += accessByIndex(w.compactSlice(i));
+                   }});
+
+  cases.push_back({"at-compact-index", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     w.sink += accessByCompactIndex(w.compactSlice(i));
+                   }});
+
+  cases.push_back({"iterate", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     w.sink += iterate(w.slice(i));
+                   }});
+
+  cases.push_back({"iterate-trusted", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     w.sink += iterateTrusted(TrustedSlice(w.slice(i)));
+                   }});
+
+  cases.push_back({"validate", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     Validator validator;
+                     w.sink += validator.validate(w.vpack[i].data(),
+                                                  w.vpack[i].size());
+                   }});
+
+  cases.push_back({"validate-parallel", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     // hardware_concurrency() is too slow to call per
+                     // operation
+                     static std::size_t const numThreads =
+                         std::max(1U, std::thread::hardware_concurrency());
+                     Validator validator;
+                     w.sink += validator.validateParallel(
+                         w.vpack[i].data(), w.vpack[i].size(), numThreads);
+                   }});
+
+  cases.push_back({"validate-reject", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     Validator validator;
+                     std::vector<uint8_t> const& vpack = w.vpack[i];
+                     for (size_t pos = 0; pos < vpack.size();
+                          pos += rejectPieceSize) {
+                       try {
+                         validator.validate(vpack.data() + pos,
+                                            std::min(rejectPieceSize,
+                                                     vpack.size() - pos));
+                       } catch (Exception const&) {
+                         ++w.sink;
+                       }
+                     }
+                   }});
+
+  cases.push_back({"validate-try-reject", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     Validator validator;
+                     std::vector<uint8_t> const& vpack = w.vpack[i];
+                     for (size_t pos = 0; pos < vpack.size();
+                          pos += rejectPieceSize) {
+                       w.sink += !validator
+                                      .tryValidate(vpack.data() + pos,
+                                                   std::min(rejectPieceSize,
+                                                            vpack.size() - pos))
+                                      .ok();
+                     }
+                   }});
+
+  cases.push_back({"compress", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     w.output.clear();
+                     StringSink sink(&w.output);
+                     CompressedWriter writer(&sink);
+                     Slice s = w.slice(i);
+                     for (auto offset : w.input.members) {
+                       writer.add(Slice(s.start() + offset));
+                     }
+                     writer.finish();
+                     w.sink += w.output.size();
+                   }});
+
+  cases.push_back({"decompress", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     CompressedReader reader(w.compressed[i].data(),
+                                             w.compressed[i].size());
+                     for (auto const& block : reader.decompress()) {
+                       w.sink += block.size();
+                     }
+                   }});
+
+  cases.push_back({"to-msgpack", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     w.output.clear();
+                     StringSink sink(&w.output);
+                     MessagePackDumper dumper(&sink);
+                     dumper.dump(w.slice(i));
+                     w.sink += w.output.size();
+                   }});
+
+  cases.push_back({"from-msgpack", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     MessagePackParser parser(w.builder);
+                     parser.parse(w.messagePack[i]);
+                     w.sink += w.builder.size();
+                   }});
+
+  cases.push_back({"to-cbor", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     w.output.clear();
+                     StringSink sink(&w.output);
+                     CborDumper dumper(&sink);
+                     dumper.dump(w.slice(i));
+                     w.sink += w.output.size();
+                   }});
+
+  cases.push_back({"from-cbor", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     CborParser parser(w.builder);
+                     parser.parse(w.cbor[i]);
+                     w.sink += w.builder.size();
+                   }});
+
+  cases.push_back({"collection-visit", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     uint64_t count = 0;
+                     Collection::visitRecursive(
+                         w.slice(i), Collection::PreOrder,
+                         [&count](Slice const&, Slice const&) {
+                           ++count;
+                           return true;
+                         });
+                     w.sink += count;
+                   }});
+
+  cases.push_back({"collection-keys", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     uint8_t const* base = w.slice(i).start();
+                     for (auto const& it : w.input.objects) {
+                       w.sink += Collection::keys(Slice(base + it.first)).size();
+                     }
+                   }});
+
+  // aggregates the top-level Array, or all Arrays on the top level of an
+  // Object. most useful for inputs such as doubles.json
+  cases.push_back({"aggregate-numbers", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     forEachTopLevelArray(w.slice(i), [&w](Slice array) {
+                       w.sink += Collection::aggregateNumbers(array).count;
+                     });
+                   }});
+
+  // scans the same Arrays as "aggregate-numbers" for a member that does
+  // not exist, passing the predicate as a lambda and as a std::function
+  cases.push_back({"collection-any", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     forEachTopLevelArray(w.slice(i), [&w](Slice array) {
+                       w.sink += Collection::any(
+                           array, [](Slice const& current, ValueLength) {
+                             return current.isNone();
+                           });
+                     });
+                   }});
+
+  cases.push_back({"collection-any-function", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     Collection::Predicate predicate =
+                         [](Slice const& current, ValueLength) {
+                           return current.isNone();
+                         };
+                     forEachTopLevelArray(w.slice(i), [&](Slice array) {
+                       w.sink += Collection::any(array, predicate);
+                     });
+                   }});
+
+  // filters the same Arrays as "aggregate-numbers" by the hash of their
+  // members, on one thread and on one thread per core
+  cases.push_back({"collection-filter", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     forEachTopLevelArray(w.slice(i), [&w](Slice array) {
+                       w.sink += Collection::filter(
+                           array, [](Slice const& current, ValueLength) {
+                             return (current.hash() & 1) == 0;
+                           }).size();
+                     });
+                   }});
+
+  cases.push_back({"collection-filter-parallel", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     // hardware_concurrency() is too slow to call per
+                     // operation
+                     static std::size_t const numThreads =
+                         std::max(1U, std::thread::hardware_concurrency());
+                     forEachTopLevelArray(w.slice(i), [&](Slice array) {
+                       w.sink += Collection::filterParallel(
+                           array, numThreads,
+                           [](Slice const& current, ValueLength) {
+                             return (current.hash() & 1) == 0;
+                           }).size();
+                     });
+                   }});
+
+  cases.push_back({"hash", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     w.sink += w.slice(i).hash();
+                   }});
+
+  cases.push_back({"hash-many", BytesBase::VPack, [](Workspace& w, size_t i) {
+                     uint8_t const* base = w.slice(i).start();
+                     for (size_t j = 0; j < w.input.members.size(); ++j) {
+                       w.slices[j] = Slice(base + w.input.members[j]);
+                     }
+                     Slice::hashMany(w.slices.data(), w.slices.size(),
+                                     w.hashes.data());
+                     for (auto h : w.hashes) {
+                       w.sink += h;
+                     }
+                   }});
+
+  cases.push_back({"normalized-hash", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     w.sink += w.slice(i).normalizedHash();
+                   }});
+
+  // compares against the compact representation of the same value, so
+  // that the byte-wise fast path does not apply
+  cases.push_back({"compare-equals", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     w.sink += NormalizedCompare::equals(w.slice(i),
+                                                         w.compactSlice(i));
+                   }});
+
+  cases.push_back({"compare-order", BytesBase::VPack,
+                   [](Workspace& w, size_t i) {
+                     w.sink += NormalizedCompare::compare(w.slice(i),
+                                                          w.compactSlice(i));
+                   }});
+
+  cases.push_back({"translate-1k", BytesBase::VPack,
+                   [](Workspace& w, size_t) {
+                     AttributeTranslator const& translator =
+                         dictionary().translator;
+                     for (auto const& key : dictionary().keys) {
+                       uint8_t const* id = translator.translate(key);
+                       if (id != nullptr) {
+                         w.sink += *translator.translate(Slice(id).getUInt());
+                       }
+                     }
+                   }});
+
+  // the same lookups via std::unordered_map, for comparison
+  cases.push_back({"translate-1k-map", BytesBase::VPack,
+                   [](Workspace& w, size_t) {
+                     auto const& map = dictionary().map;
+                     for (auto const& key : dictionary().keys) {
+                       auto it = map.find(StringRef(key));
+                       if (it != map.end()) {
+                         w.sink += (*it).second;
+                       }
+                     }
+                   }});
+
+  return cases;
+}
+
+// running
+// -------
+
+struct ThreadResult {
+  uint64_t ops = 0;
+  uint64_t allocations = 0;
+  double seconds = 0.0;
+  CounterValues counters;
+  uint64_t sink = 0;
+};
+
+struct Result {
+  std::string file;
+  std::string name;
+  char const* cache;
+  size_t copies;
+  size_t threads;
+  uint64_t ops;
+  double seconds;
+  double nsPerOp;
+  double bytesPerSecond;
+  double allocsPerOp;
+  CounterValues counters;
+};
+
+size_t copiesFor(Config const& config, Input const& input, bool inCache) {
+  if (config.copies != 0) {
+    return config.copies;
+  }
+  if (inCache) {
+    return 1;
+  }
+  size_t const perCopy = input.json.size() + 2 * input.vpack.size();
+  return std::min<size_t>(100000,
+                          std::max<size_t>(2, config.workingSetSize / perCopy));
+}
+
+void runThread(Config const& config, Case const& c, Workspace& w,
+               ThreadResult& result) {
+  PerfCounters counters(config.counters);
+  size_t const copies = w.json.size();
+
+  // warm up and make sure all copies have been touched once
+  for (size_t i = 0; i < copies; ++i) {
+    c.run(w, i);
+  }
+
+  auto const runTime = std::chrono::duration<double>(config.runTime);
+  uint64_t const allocationsBefore = allocationCounter;
+  uint64_t ops = 0;
+  size_t i = 0;
+
+  counters.start();
+  auto const start = std::chrono::steady_clock::now();
+  auto now = start;
+  do {
+    c.run(w, i);
+    if (++i == copies) {
+      i = 0;
+    }
+    ++ops;
+    now = std::chrono::steady_clock::now();
+  } while (now - start < runTime);
+  result.counters = counters.stop();
+
+  result.ops = ops;
+  result.allocations = allocationCounter - allocationsBefore;
+  result.seconds = std::chrono::duration<double>(now - start).count();
+  result.sink = w.sink;
+}
+
+Result run(Config const& config, Input const& input, Case const& c,
+           bool inCache) {
+  size_t const copies = copiesFor(config, input, inCache);
+
+  std::vector<std::unique_ptr<Workspace>> workspaces;
+  for (size_t i = 0; i < config.threads; ++i) {
+    workspaces.emplace_back(new Workspace(input, copies));
+  }
+  std::vector<ThreadResult> results(config.threads);
+
+  if (config.threads == 1) {
+    runThread(config, c, *workspaces[0], results[0]);
+  } else {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < config.threads; ++i) {
+      threads.emplace_back([&config, &c, &workspaces, &results, i]() {
+        runThread(config, c, *workspaces[i], results[i]);
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
+
+  Result r;
+  r.file = input.name;
+  r.name = c.name;
+  r.cache = inCache ? "in" : "out";
+  r.copies = copies;
+  r.threads = config.threads;
+  r.ops = 0;
+  r.seconds = 0.0;
+  r.counters.valid = true;
+
+  uint64_t allocations = 0;
+  double threadSeconds = 0.0;
+  uint64_t sink = 0;
+  for (auto const& it : results) {
+    r.ops += it.ops;
+    r.seconds = std::max(r.seconds, it.seconds);
+    threadSeconds += it.seconds;
+    allocations += it.allocations;
+    sink += it.sink;
+    r.counters.valid &= it.counters.valid;
+    for (size_t i = 0; i < 4; ++i) {
+      r.counters.values[i] += it.counters.values[i];
+    }
+  }
+
+  size_t const bytes = (c.bytesBase == BytesBase::Json)
+                           ? input.json.size()
+                           : input.vpack.slice().byteSize();
+  r.nsPerOp = threadSeconds * 1.0e9 / static_cast<double>(r.ops);
+  r.bytesPerSecond = static_cast<double>(bytes) * r.ops / r.seconds;
+  r.allocsPerOp = static_cast<double>(allocations) / r.ops;
+
+  resultSink = sink;
+  return r;
+}
+
+// input handling
+// --------------
+
+bool tryReadFile(std::string const& filename, std::string& s) {
   std::ifstream ifs(filename.c_str(), std::ifstream::in);
 
   if (!ifs.is_open()) {
-    std::cerr << "Cannot open input file '" << filename << "'" << std::endl;
-    ::exit(EXIT_FAILURE);
+    return false;
   }
 
   char buffer[4096];
@@ -70,157 +1130,304 @@ static std::string tryReadFile(std::string const& filename) {
   }
   ifs.close();
 
-  return s;
+  return true;
 }
 
-static std::string readFile(std::string filename) {
+std::string readFile(std::string const& filename) {
 #ifdef _WIN32
   std::string const separator("\\");
 #else
   std::string const separator("/");
 #endif
-  filename = "tests" + separator + "jsonSample" + separator + filename;
+  std::string s;
+  if (tryReadFile(filename, s)) {
+    return s;
+  }
 
-  for (size_t i = 0; i < 3; ++i) {
-    try {
-      return tryReadFile(filename);
-    } catch (...) {
-      filename = ".." + separator + filename;
+  // search the sample directory
+  std::string name = "tests" + separator + "jsonSample" + separator + filename;
+  for (size_t i = 0; i < 4; ++i) {
+    if (tryReadFile(name, s)) {
+      return s;
     }
+    name = ".." + separator + name;
   }
-  throw "cannot open input file";
+  throw std::runtime_error("cannot open input file '" + filename + "'");
 }
 
-static void run(std::string& data, int runTime, size_t copies, bool useVPack,
-                bool fullOutput) {
-  Options options;
+void loadInput(Input& input, std::string const& filename) {
+  input.name = filename;
+  input.json = readFile(filename);
 
-  std::vector<std::string> inputs;
-  std::vector<Parser*> outputs;
-  inputs.push_back(data);
-  outputs.push_back(new Parser(&options));
+  Parser parser;
+  parser.parse(input.json);
+  input.vpack = *parser.steal();
 
-  for (size_t i = 1; i < copies; i++) {
-    // Make an explicit copy:
-    data.clear();
-    data.insert(data.begin(), inputs[0].begin(), inputs[0].end());
-    inputs.push_back(data);
-    outputs.push_back(new Parser(&options));
-  }
+  Options compactOptions;
+  compactOptions.buildUnindexedArrays = true;
+  compactOptions.buildUnindexedObjects = true;
+  Parser compactParser(&compactOptions);
+  compactParser.parse(input.json);
+  input.compact = *compactParser.steal();
 
-  size_t count = 0;
-  size_t total = 0;
-  auto start = std::chrono::high_resolution_clock::now();
-  decltype(start) now;
+  Slice s = input.vpack.slice();
+  input.shapes = std::make_shared<ShapeRegistry>();
+  input.shapes->observe(s);
+  input.shapes->infer(2);
+  input.shapes->encode(s, input.shaped);
+  collectShapedObjects(input, input.shaped.slice());
 
-  try {
-    do {
-      for (int i = 0; i < 2; i++) {
-        if (useVPack) {
-          outputs[count]->clear();
-          outputs[count]->parse(inputs[count]);
-        } else {
-          rapidjson::Document d;
-          d.Parse(inputs[count].c_str());
-        }
-        count++;
-        if (count >= copies) {
-          count = 0;
-        }
-        total++;
-      }
-      now = std::chrono::high_resolution_clock::now();
-    } while (std::chrono::duration_cast<std::chrono::duration<int>>(now - start)
-                 .count() < runTime);
-
-    std::chrono::duration<double> totalTime =
-        std::chrono::duration_cast<std::chrono::duration<double>>(now - start);
-
-    if (fullOutput) {
-      std::cout << "Total runtime: " << totalTime.count() << " s" << std::endl;
-      std::cout << "Have parsed " << total << " times with "
-                << (useVPack ? "vpack" : "rapidjson") << " using " << copies
-                << " copies of JSON data, each of size " << inputs[0].size()
-                << "." << std::endl;
-      std::cout << "Parsed " << inputs[0].size() * total << " bytes in total."
-                << std::endl;
-    }
-    std::cout << "This is "
-              << static_cast<double>(inputs[0].size() * total) /
-                     totalTime.count() << " bytes/s"
-              << " or " << total / totalTime.count() << " JSON docs per second."
-              << std::endl;
-  } catch (Exception const& ex) {
-    std::cerr << "An exception occurred while running bench: " << ex.what()
-              << std::endl;
-    ::exit(EXIT_FAILURE);
-  } catch (std::exception const& ex) {
-    std::cerr << "An exception occurred while running bench: " << ex.what()
-              << std::endl;
-    ::exit(EXIT_FAILURE);
-  } catch (...) {
-    std::cerr << "An unknown exception occurred while running bench"
-              << std::endl;
-    ::exit(EXIT_FAILURE);
+  collectObjects(input, s);
+  if (s.isObject()) {
+    for (auto it : ObjectIterator(s, true)) {
+      input.members.push_back(it.value.start() - s.start());
+    }
+    if (s.length() > 0) {
+      input.projection.add({ObjectIterator(s, true).key().copyString()});
+    }
+  } else if (s.isArray()) {
+    for (auto it : ArrayIterator(s)) {
+      input.members.push_back(it.start() - s.start());
+    }
+  } else {
+    input.members.push_back(0);
   }
 
-  for (auto& it : outputs) {
-    delete it;
+  StringSink sink(&input.compressed);
+  CompressedWriter writer(&sink);
+  for (auto offset : input.members) {
+    writer.add(Slice(s.start() + offset));
   }
+  writer.finish();
+
+  input.messagePack = MessagePackDumper::toString(s);
+  input.cbor = CborDumper::toString(s);
+}
+
+// output
+// ------
+
+void printHeader(bool countersAvailable) {
+  std::cout << std::left << std::setw(24) << "file" << std::setw(28) << "case"
+            << std::setw(6) << "cache" << std::right << std::setw(8)
+            << "copies" << std::setw(14) << "ns/op" << std::setw(12) << "MB/s"
+            << std::setw(12) << "allocs/op";
+  if (countersAvailable) {
+    std::cout << std::setw(14) << "cycles/op" << std::setw(8) << "IPC"
+              << std::setw(14) << "cmiss/op" << std::setw(14) << "bmiss/op";
+  }
+  std::cout << std::endl;
 }
 
-static void runDefaultBench() {
-  auto runComparison = [](std::string const& filename) {
-    std::string data = std::move(readFile(filename));
+void printResult(Result const& r) {
+  std::cout << std::left << std::setw(24) << r.file << std::setw(28) << r.name
+            << std::setw(6) << r.cache << std::right << std::setw(8)
+            << r.copies << std::fixed << std::setprecision(1) << std::setw(14)
+            << r.nsPerOp << std::setw(12) << r.bytesPerSecond / 1.0e6
+            << std::setprecision(2) << std::setw(12) << r.allocsPerOp;
+  if (r.counters.valid) {
+    double const ops = static_cast<double>(r.ops);
+    std::cout << std::setprecision(1) << std::setw(14)
+              << r.counters.values[0] / ops << std::setprecision(2)
+              << std::setw(8)
+              << (r.counters.values[0] == 0
+                      ? 0.0
+                      : static_cast<double>(r.counters.values[1]) /
+                            r.counters.values[0])
+              << std::setprecision(1) << std::setw(14)
+              << r.counters.values[2] / ops << std::setw(14)
+              << r.counters.values[3] / ops;
+  }
+  std::cout << std::endl;
+}
 
-    std::cout << std::endl;
-    std::cout << "# " << filename << " ";
-    for (size_t i = 0; i < 30 - filename.size(); ++i) {
-      std::cout << "#";
+void printJson(Config const& config, std::vector<Result> const& results) {
+  Builder b;
+  b.openObject();
+  b.add("config", Value(ValueType::Object));
+  b.add("runTime", Value(config.runTime));
+  b.add("threads", Value(config.threads));
+  b.add("workingSetSize", Value(config.workingSetSize));
+  b.add("hardwareConcurrency", Value(static_cast<uint32_t>(std::thread::hardware_concurrency())));
+  b.close();
+  b.add("results", Value(ValueType::Array));
+  for (auto const& r : results) {
+    b.openObject();
+    b.add("file", Value(r.file));
+    b.add("case", Value(r.name));
+    b.add("cache", Value(r.cache));
+    b.add("copies", Value(r.copies));
+    b.add("threads", Value(r.threads));
+    b.add("ops", Value(r.ops));
+    b.add("seconds", Value(r.seconds));
+    b.add("nsPerOp", Value(r.nsPerOp));
+    b.add("bytesPerSecond", Value(r.bytesPerSecond));
+    b.add("allocsPerOp", Value(r.allocsPerOp));
+    if (r.counters.valid) {
+      b.add("counters", Value(ValueType::Object));
+      for (size_t i = 0; i < 4; ++i) {
+        b.add(counterNames[i], Value(r.counters.values[i] /
+                                     static_cast<double>(r.ops)));
+      }
+      b.close();
     }
-    std::cout << std::endl;
+    b.close();
+  }
+  b.close();
+  b.close();
 
-    std::cout << "vpack:        ";
-    run(data, 10, 1, true, false);
+  Options options;
+  options.prettyPrint = true;
+  std::cout << b.slice().toJson(&options) << std::endl;
+}
 
-    std::cout << "rapidjson:    ";
-    run(data, 10, 1, false, false);
-  };
+void usage(char* argv[]) {
+  std::cout << "Usage: " << argv[0] << " [OPTIONS] [FILENAME.json ...]"
+            << std::endl;
+  std::cout << "Runs the VelocyPack benchmark suite on the given JSON files."
+            << std::endl;
+  std::cout << "File names are also looked up in tests/jsonSample. Without any"
+            << std::endl;
+  std::cout << "file names, a default set of sample files is used."
+            << std::endl;
+  std::cout << std::endl;
+  std::cout << "Available options are:" << std::endl;
+  std::cout << " --time <seconds>        run time per case (default: 1)"
+            << std::endl;
+  std::cout << " --threads <n>           run each case in n threads, each"
+            << std::endl;
+  std::cout << "                         with its own copies of the data"
+            << std::endl;
+  std::cout << " --cache <mode>          'in', 'out' or 'both' (default)"
+            << std::endl;
+  std::cout << " --working-set <MB>      per-thread working set size for"
+            << std::endl;
+  std::cout << "                         out-of-cache runs (default: 256)"
+            << std::endl;
+  std::cout << " --copies <n>            use exactly n copies of the data"
+            << std::endl;
+  std::cout << " --filter <name>         only run cases whose name contains"
+            << std::endl;
+  std::cout << "                         <name>. can be repeated" << std::endl;
+  std::cout << " --no-counters           do not use hardware counters"
+            << std::endl;
+  std::cout << " --json                  print results as JSON" << std::endl;
+  std::cout << " --list                  list all cases and exit" << std::endl;
+}
 
-  runComparison("small.json");
-  runComparison("sample.json");
-  runComparison("sampleNoWhite.json");
-  runComparison("commits.json");
+bool matches(Config const& config, char const* name) {
+  if (config.filters.empty()) {
+    return true;
+  }
+  for (auto const& it : config.filters) {
+    if (std::strstr(name, it.c_str()) != nullptr) {
+      return true;
+    }
+  }
+  return false;
 }
 
+}  // namespace
+
 int main(int argc, char* argv[]) {
-  if (argc == 1) {
-    runDefaultBench();
-    return EXIT_FAILURE;
-  }
+  Config config;
+  std::vector<Case> const cases = buildCases();
 
-  if (argc != 5) {
-    usage(argv);
-    return EXIT_FAILURE;
+  int i = 1;
+  while (i < argc) {
+    std::string const arg(argv[i]);
+    bool const hasValue = (i + 1 < argc);
+
+    if (arg == "--help" || arg == "-h") {
+      usage(argv);
+      return EXIT_SUCCESS;
+    } else if (arg == "--list") {
+      for (auto const& c : cases) {
+        std::cout << c.name << std::endl;
+      }
+      return EXIT_SUCCESS;
+    } else if (arg == "--time" && hasValue) {
+      config.runTime = std::stod(argv[++i]);
+    } else if (arg == "--threads" && hasValue) {
+      config.threads = std::max<size_t>(1, std::stoul(argv[++i]));
+    } else if (arg == "--copies" && hasValue) {
+      config.copies = std::stoul(argv[++i]);
+    } else if (arg == "--working-set" && hasValue) {
+      config.workingSetSize = std::stoul(argv[++i]) * 1024 * 1024;
+    } else if (arg == "--cache" && hasValue) {
+      std::string const mode(argv[++i]);
+      config.inCache = (mode == "in" || mode == "both");
+      config.outOfCache = (mode == "out" || mode == "both");
+      if (!config.inCache && !config.outOfCache) {
+        usage(argv);
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--filter" && hasValue) {
+      config.filters.emplace_back(argv[++i]);
+    } else if (arg == "--no-counters") {
+      config.counters = false;
+    } else if (arg == "--json") {
+      config.json = true;
+    } else if (!arg.empty() && arg[0] == '-') {
+      usage(argv);
+      return EXIT_FAILURE;
+    } else {
+      config.files.emplace_back(arg);
+    }
+    ++i;
   }
 
-  bool useVPack;
-  if (::strcmp(argv[4], "vpack") == 0) {
-    useVPack = true;
-  } else if (::strcmp(argv[4], "rapidjson") == 0) {
-    useVPack = false;
-  } else {
-    usage(argv);
-    return EXIT_FAILURE;
+  if (config.files.empty()) {
+    config.files = {"small.json", "sample.json", "sampleNoWhite.json",
+                    "commits.json"};
+  }
+  if (config.copies != 0) {
+    // an explicit number of copies makes the cache modes meaningless
+    config.outOfCache = false;
+    config.inCache = true;
+  }
+  if (config.counters) {
+    config.counters = PerfCounters(true).available();
   }
 
-  size_t copies = std::stoul(argv[3]);
-  int runTime = std::stoi(argv[2]);
+  std::vector<Result> results;
+  try {
+    if (!config.json) {
+      printHeader(config.counters);
+    }
+    for (auto const& filename : config.files) {
+      Input input;
+      loadInput(input, filename);
 
-  // read input file
-  std::string s = std::move(readFile(argv[1]));
+      for (auto const& c : cases) {
+        if (!matches(config, c.name)) {
+          continue;
+        }
+        for (int mode = 0; mode < 2; ++mode) {
+          bool const inCache = (mode == 0);
+          if ((inCache && !config.inCache) || (!inCache && !config.outOfCache)) {
+            continue;
+          }
+          results.emplace_back(run(config, input, c, inCache));
+          if (!config.json) {
+            printResult(results.back());
+          }
+        }
+      }
+    }
+  } catch (Exception const& ex) {
+    std::cerr << "An exception occurred while running bench: " << ex.what()
+              << std::endl;
+    return EXIT_FAILURE;
+  } catch (std::exception const& ex) {
+    std::cerr << "An exception occurred while running bench: " << ex.what()
+              << std::endl;
+    return EXIT_FAILURE;
+  }
 
-  run(s, runTime, copies, useVPack, true);
+  if (config.json) {
+    printJson(config, results);
+  }
 
   return EXIT_SUCCESS;
 }
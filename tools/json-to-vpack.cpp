@@ -24,17 +24,23 @@
 /// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <fstream>
+#include <memory>
 
 #include "velocypack/vpack.h"
 #include "velocypack/velocypack-exception-macros.h"
 
+#include "lines-pipeline.h"
+
 using namespace arangodb::velocypack;
-    
-static std::unique_ptr<AttributeTranslator> translator(new AttributeTranslator);
 
 static void usage(char* argv[]) {
 #ifdef __linux__
@@ -60,39 +66,231 @@ static void usage(char* argv[]) {
       << std::endl;
   std::cout << " --no-compact    store Array and Object types with index tables"
             << std::endl;
-  std::cout << " --compress      compress Object keys" << std::endl;
+  std::cout << " --compress      compress Object keys, using a key dictionary learned"
+            << std::endl;
+  std::cout << "                 from the input" << std::endl;
   std::cout << " --no-compress   don't compress Object keys" << std::endl;
+  std::cout << " --dictionary FILE" << std::endl;
+  std::cout << "                 compress Object keys using the key dictionary in FILE."
+            << std::endl;
+  std::cout << "                 with --compress, the dictionary is extended with the keys"
+            << std::endl;
+  std::cout << "                 learned from the input, and written back to FILE"
+            << std::endl;
+  std::cout << " --sample N      learn keys from the first N members of the input's"
+            << std::endl;
+  std::cout << "                 top-level Array only (default: 1000)" << std::endl;
   std::cout << " --hex           print a hex dump of the generated VPack value"
             << std::endl;
   std::cout << " --stringify     print a char array containing the generated VPack value"
             << std::endl;
+  std::cout << " --lines         read JSON Lines, i.e. one JSON value per line, and"
+            << std::endl;
+  std::cout << "                 write one VPack value per line, back to back. the input"
+            << std::endl;
+  std::cout << "                 is processed in parallel, and may be of any size"
+            << std::endl;
+  std::cout << " --array         with --lines, write a single Array holding the values"
+            << std::endl;
+  std::cout << "                 instead. the Array is built in memory" << std::endl;
+  std::cout << " --threads N     with --lines, the number of parser threads"
+            << std::endl;
+  std::cout << "                 (default: number of cores)" << std::endl;
 }
 
 static inline bool isOption(char const* arg, char const* expected) {
   return (strcmp(arg, expected) == 0);
 }
 
-static bool buildCompressedKeys(
-    std::string const& s, std::unordered_map<std::string, size_t>& keysFound) {
-  Options options;
-  Parser parser(&options);
-  try {
-    parser.parse(s);
-    std::shared_ptr<Builder> builder = parser.steal();
+static bool readFile(std::string const& filename, std::string& s) {
+  std::ifstream ifs(filename, std::ifstream::in | std::ifstream::binary);
+
+  if (!ifs.is_open()) {
+    return false;
+  }
+
+  char buffer[32768];
+  s.reserve(sizeof(buffer));
+
+  while (ifs.good()) {
+    ifs.read(&buffer[0], sizeof(buffer));
+    s.append(buffer, checkOverflow(ifs.gcount()));
+  }
+  ifs.close();
+  return true;
+}
+
+// the amount of input handed to a parser thread at once in --lines mode
+static std::size_t const linesBatchSize = 1024 * 1024;
+
+// reads the next lines of the input into the batch, at least
+// linesBatchSize bytes unless the input ends. the partial line at the end
+// is kept in carry for the next batch
+static bool readLines(std::istream& in, std::string& carry,
+                      LinesBatch& batch) {
+  batch.input.swap(carry);
+  carry.clear();
+
+  char buffer[65536];
+  while (in.good()) {
+    if (batch.input.size() >= linesBatchSize) {
+      std::size_t eol = batch.input.rfind('\n');
+      if (eol != std::string::npos) {
+        carry.assign(batch.input, eol + 1, std::string::npos);
+        batch.input.resize(eol + 1);
+        return true;
+      }
+    }
+    in.read(&buffer[0], sizeof(buffer));
+    batch.input.append(buffer, checkOverflow(in.gcount()));
+  }
+  return !batch.input.empty();
+}
+
+// parses all lines of the batch, and appends their VPack values to its
+// output. blank lines are skipped
+static void parseLines(Parser& parser, LinesBatch& batch) {
+  char const* p = batch.input.data();
+  char const* end = p + batch.input.size();
+  while (p < end) {
+    char const* eol = static_cast<char const*>(memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    ++batch.items;
+    while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r')) {
+      ++p;
+    }
+    if (p < eol) {
+      try {
+        parser.parse(p, eol - p);
+      } catch (Exception const& ex) {
+        batch.error = std::string(ex.what()) + ", at position " +
+                      std::to_string(parser.errorPos());
+        return;
+      }
+      Builder const& builder = parser.builder();
+      batch.output.append(reinterpret_cast<char const*>(builder.data()),
+                          builder.size());
+    }
+    p = eol + 1;
+  }
+}
+
+// converts JSON Lines in the --lines mode. returns the number of lines.
+// throws on the first invalid line
+static uint64_t convertLines(std::istream& in, std::ostream& out,
+                             Options const& options, bool toArray,
+                             std::size_t threads, uint64_t& outputSize) {
+  // each thread reuses its Parser, and thus the Parser's Builder
+  std::vector<std::unique_ptr<Parser>> parsers;
+  for (std::size_t i = 0; i < threads; ++i) {
+    parsers.emplace_back(new Parser(&options));
+  }
+
+  Builder array(&options);
+  if (toArray) {
+    array.openArray();
+  }
 
-    Collection::visitRecursive(
-        builder->slice(), Collection::PreOrder,
-        [&keysFound](Slice const& key, Slice const&) -> bool {
-          if (key.isString()) {
-            keysFound[key.copyString()]++;
+  std::string carry;
+  uint64_t lines = 0;
+  outputSize = 0;
+  LinesPipeline pipeline(
+      threads,
+      [&in, &carry](LinesBatch& batch) { return readLines(in, carry, batch); },
+      [&parsers](std::size_t worker, LinesBatch& batch) {
+        parseLines(*parsers[worker], batch);
+      },
+      [&](LinesBatch& batch) {
+        if (!batch.error.empty()) {
+          throw std::runtime_error("line " + std::to_string(lines + batch.items) +
+                                   ": " + batch.error);
+        }
+        lines += batch.items;
+        if (toArray) {
+          uint8_t const* p =
+              reinterpret_cast<uint8_t const*>(batch.output.data());
+          uint8_t const* end = p + batch.output.size();
+          while (p < end) {
+            Slice value(p);
+            array.add(value);
+            p += value.byteSize();
           }
-          return true;
-        });
+        } else {
+          out.write(batch.output.data(), batch.output.size());
+          outputSize += batch.output.size();
+        }
+        return true;
+      });
+  pipeline.run();
+
+  if (toArray) {
+    array.close();
+    out.write(reinterpret_cast<char const*>(array.data()), array.size());
+    outputSize = array.size();
+  }
+  return lines;
+}
 
-    return true;
-  } catch (...) {
-    // simply don't use compressed keys
-    return false;
+// learns the Object keys from a sample of the value: the first members
+// of a top-level Array, or the entire value otherwise
+static void learnKeys(Slice value, uint64_t sampleSize,
+                      AttributeDictionaryTrainer& trainer) {
+  if (value.isArray()) {
+    uint64_t n = 0;
+    for (auto it : ArrayIterator(value)) {
+      if (n++ == sampleSize) {
+        break;
+      }
+      trainer.observe(it);
+    }
+  } else {
+    trainer.observe(value);
+  }
+}
+
+static void translateKeys(Slice value, Builder& builder);
+
+static void translateMembers(Slice value, Builder& builder) {
+  if (value.isObject()) {
+    ObjectIterator it(value, true);
+    while (it.valid()) {
+      StringRef key(it.key(true));
+      Slice member = it.value();
+      if (member.isObject()) {
+        builder.add(key, Value(ValueType::Object));
+        translateMembers(member, builder);
+        builder.close();
+      } else if (member.isArray()) {
+        builder.add(key, Value(ValueType::Array));
+        translateMembers(member, builder);
+        builder.close();
+      } else {
+        builder.add(key, member);
+      }
+      it.next();
+    }
+  } else {
+    for (auto it : ArrayIterator(value)) {
+      translateKeys(it, builder);
+    }
+  }
+}
+
+// copies the value into the Builder. the Builder translates all Object
+// keys it has a translation for
+static void translateKeys(Slice value, Builder& builder) {
+  if (value.isObject()) {
+    builder.openObject();
+    translateMembers(value, builder);
+    builder.close();
+  } else if (value.isArray()) {
+    builder.openArray();
+    translateMembers(value, builder);
+    builder.close();
+  } else {
+    builder.add(value);
   }
 }
 
@@ -106,6 +304,11 @@ int main(int argc, char* argv[]) {
   bool compress = false;
   bool hexDump = false;
   bool stringify = false;
+  bool lines = false;
+  bool toArray = false;
+  std::size_t threads = std::max(1U, std::thread::hardware_concurrency());
+  char const* dictionaryName = nullptr;
+  uint64_t sampleSize = 1000;
 
   int i = 1;
   while (i < argc) {
@@ -121,10 +324,32 @@ int main(int argc, char* argv[]) {
       compress = true;
     } else if (allowFlags && isOption(p, "--no-compress")) {
       compress = false;
+    } else if (allowFlags && isOption(p, "--dictionary")) {
+      if (++i >= argc) {
+        usage(argv);
+        return EXIT_FAILURE;
+      }
+      dictionaryName = argv[i];
+    } else if (allowFlags && isOption(p, "--sample")) {
+      if (++i >= argc) {
+        usage(argv);
+        return EXIT_FAILURE;
+      }
+      sampleSize = std::strtoull(argv[i], nullptr, 10);
     } else if (allowFlags && isOption(p, "--hex")) {
       hexDump = true;
     } else if (allowFlags && isOption(p, "--stringify")) {
       stringify = true;
+    } else if (allowFlags && isOption(p, "--lines")) {
+      lines = true;
+    } else if (allowFlags && isOption(p, "--array")) {
+      toArray = true;
+    } else if (allowFlags && isOption(p, "--threads")) {
+      if (++i >= argc) {
+        usage(argv);
+        return EXIT_FAILURE;
+      }
+      threads = std::max(1ULL, std::strtoull(argv[i], nullptr, 10));
     } else if (allowFlags && isOption(p, "--")) {
       allowFlags = false;
     } else if (infileName == nullptr) {
@@ -149,6 +374,12 @@ int main(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
+  if (lines && (compress || hexDump || stringify)) {
+    std::cerr << "--lines cannot be combined with --compress, --hex or --stringify"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
 #ifdef __linux__
   // treat missing outfile as stdout
   bool toStdOut = false;
@@ -172,68 +403,72 @@ int main(int argc, char* argv[]) {
   }
 #endif
 
-  std::string s;
-  std::ifstream ifs(infile, std::ifstream::in);
-
-  if (!ifs.is_open()) {
-    std::cerr << "Cannot read infile '" << infile << "'" << std::endl;
-    return EXIT_FAILURE;
-  }
-
-  char buffer[32768];
-  s.reserve(sizeof(buffer));
-
-  while (ifs.good()) {
-    ifs.read(&buffer[0], sizeof(buffer));
-    s.append(buffer, checkOverflow(ifs.gcount()));
-  }
-  ifs.close();
-
   Options options;
   options.buildUnindexedArrays = compact;
   options.buildUnindexedObjects = compact;
 
-  // compress object keys?
-  if (compress) {
-    size_t compressedOccurrences = 0;
-    std::unordered_map<std::string, size_t> keysFound;
-    buildCompressedKeys(s, keysFound);
-
-    std::vector<std::tuple<uint64_t, std::string, size_t>> stats;
-    size_t requiredLength = 2;
-    uint64_t nextId = 0;
-    for (auto const& it : keysFound) {
-      if (it.second > 1 && it.first.size() >= requiredLength) {
-        translator->add(it.first, ++nextId);
-        stats.emplace_back(std::make_tuple(nextId, it.first, it.second));
-
-        if (translator->count() == 255) {
-          requiredLength = 3;
-        }
-        compressedOccurrences += it.second;
+  // load an existing key dictionary
+  std::unique_ptr<AttributeTranslator> translator;
+  if (dictionaryName != nullptr) {
+    std::string dictionary;
+    if (readFile(dictionaryName, dictionary)) {
+      try {
+        Validator validator;
+        validator.validate(dictionary.data(), dictionary.size());
+        translator = AttributeDictionary::load(
+            Slice(reinterpret_cast<uint8_t const*>(dictionary.data())));
+      } catch (Exception const& ex) {
+        std::cerr << "Cannot load dictionary '" << dictionaryName
+                  << "': " << ex.what() << std::endl;
+        return EXIT_FAILURE;
       }
+    } else if (!compress) {
+      std::cerr << "Cannot read dictionary '" << dictionaryName << "'"
+                << std::endl;
+      return EXIT_FAILURE;
     }
-    translator->seal();
+  }
 
+  if (translator != nullptr && !compress) {
     options.attributeTranslator = translator.get();
+  }
 
-    // print statistics
-    if (!toStdOut && compressedOccurrences > 0) {
-      std::cout << compressedOccurrences
-                << " occurrences of Object keys will be stored compressed:"
-                << std::endl;
+  if (lines) {
+    std::ifstream ifs(infile, std::ifstream::in | std::ifstream::binary);
+    if (!ifs.is_open()) {
+      std::cerr << "Cannot read infile '" << infile << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::ofstream ofs(outfileName, std::ofstream::out | std::ofstream::binary);
+    if (!ofs.is_open()) {
+      std::cerr << "Cannot write outfile '" << outfileName << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
 
-      size_t printed = 0;
-      for (auto const& it : stats) {
-        if (++printed > 20) {
-          std::cout << " - ... " << (stats.size() - printed + 1)
-                    << " Object key(s) follow ..." << std::endl;
-          break;
-        }
-        std::cout << " - #" << std::get<0>(it) << ": " << std::get<1>(it)
-                  << " (" << std::get<2>(it) << " occurrences)" << std::endl;
-      }
+    uint64_t count;
+    uint64_t outputSize;
+    try {
+      count = convertLines(ifs, ofs, options, toArray, threads, outputSize);
+    } catch (std::exception const& ex) {
+      std::cerr << "An exception occurred while parsing infile '" << infile
+                << "': " << ex.what() << std::endl;
+      return EXIT_FAILURE;
     }
+    ofs.close();
+
+    if (!toStdOut) {
+      std::cout << "Successfully converted JSON Lines infile '" << infile << "'"
+                << std::endl;
+      std::cout << "Lines:               " << count << std::endl;
+      std::cout << "VPack Outfile size:  " << outputSize << std::endl;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  std::string s;
+  if (!readFile(infile, s)) {
+    std::cerr << "Cannot read infile '" << infile << "'" << std::endl;
+    return EXIT_FAILURE;
   }
 
   Parser parser(&options);
@@ -250,6 +485,57 @@ int main(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
+  std::shared_ptr<Builder> builder = parser.steal();
+
+  // compress object keys?
+  if (compress) {
+    // the keys are learned from the already parsed value, which is then
+    // copied with translated keys. this avoids parsing the JSON twice
+    AttributeDictionaryTrainer trainer;
+    learnKeys(builder->slice(), sampleSize, trainer);
+    std::unique_ptr<AttributeTranslator> learned =
+        trainer.train(trainer.capacity(), 2, 2, translator.get());
+    std::size_t const previous = (translator == nullptr ? 0 : translator->count());
+    translator = std::move(learned);
+
+    options.attributeTranslator = translator.get();
+    std::shared_ptr<Builder> translated = std::make_shared<Builder>(&options);
+    translateKeys(builder->slice(), *translated);
+    builder = translated;
+
+    // print statistics
+    if (!toStdOut && translator->count() > previous) {
+      std::cout << (translator->count() - previous)
+                << " Object key(s) will be stored compressed:" << std::endl;
+
+      size_t printed = 0;
+      for (auto const& it : trainer.top(trainer.size())) {
+        uint8_t const* id = translator->translate(it.first);
+        if (id == nullptr) {
+          continue;
+        }
+        if (++printed > 20) {
+          std::cout << " - ... more Object key(s) follow ..." << std::endl;
+          break;
+        }
+        std::cout << " - #" << Slice(id).getUInt() << ": " << it.first
+                  << " (" << it.second << " occurrences in sample)" << std::endl;
+      }
+    }
+
+    if (dictionaryName != nullptr) {
+      Builder dictionary = AttributeDictionary::save(*translator);
+      std::ofstream dfs(dictionaryName, std::ofstream::out | std::ofstream::binary);
+      if (!dfs.is_open()) {
+        std::cerr << "Cannot write dictionary '" << dictionaryName << "'"
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+      dfs.write(reinterpret_cast<char const*>(dictionary.data()),
+                dictionary.size());
+    }
+  }
+
   std::ofstream ofs(outfileName, std::ofstream::out);
 
   if (!ofs.is_open()) {
@@ -263,7 +549,6 @@ int main(int argc, char* argv[]) {
   }
 
   // write into stream
-  std::shared_ptr<Builder> builder = parser.steal();
   if (hexDump) {
     ofs << HexDump(builder->slice()) << std::endl;
   } else if (stringify) {
@@ -281,11 +566,10 @@ int main(int argc, char* argv[]) {
     std::cout << "JSON Infile size:    " << s.size() << std::endl;
     std::cout << "VPack Outfile size:  " << builder->size() << std::endl;
 
-    if (compress) {
-      if (translator.get()->count() > 0) {
+    if (translator != nullptr) {
+      if (translator->count() > 0) {
         std::cout << "Key dictionary size: "
-                  << Slice(translator.get()->builder()->data())
-                        .byteSize() << std::endl;
+                  << AttributeDictionary::save(*translator).size() << std::endl;
       } else {
         std::cout << "Key dictionary size: 0 (no benefit from compression)"
                   << std::endl;
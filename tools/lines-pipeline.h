@@ -0,0 +1,222 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2014-2020 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Max Neunhoeffer
+/// @author Jan Steemann
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VELOCYPACK_TOOLS_LINES_PIPELINE_H
+#define VELOCYPACK_TOOLS_LINES_PIPELINE_H 1
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// a chunk of the input, holding a number of complete items such as JSON
+// lines or VPack values, and the result of its conversion
+struct LinesBatch {
+  std::string input;
+  std::string output;
+  // the number of items converted. if the conversion failed, the number of
+  // the failing item, and the error message
+  uint64_t items = 0;
+  std::string error;
+};
+
+// runs the --lines mode of the tools: the reader fills batches in a thread
+// of its own, the workers convert them in parallel, and the writer receives
+// the converted batches in input order on the calling thread. at most four
+// batches per worker are in flight, so that the memory usage does not depend
+// on the size of the input
+class LinesPipeline {
+ public:
+  // fills the input of the batch. returns false when the input is exhausted
+  typedef std::function<bool(LinesBatch&)> Reader;
+  // converts the batch, on the worker with the given number
+  typedef std::function<void(std::size_t, LinesBatch&)> Converter;
+  // consumes a converted batch. returns false to stop the pipeline
+  typedef std::function<bool(LinesBatch&)> Writer;
+
+  LinesPipeline(std::size_t threads, Reader reader, Converter converter,
+                Writer writer)
+      : _threads(threads == 0 ? 1 : threads),
+        _reader(std::move(reader)),
+        _converter(std::move(converter)),
+        _writer(std::move(writer)),
+        _read(0),
+        _inFlight(0),
+        _eof(false),
+        _stopped(false) {}
+
+  LinesPipeline(LinesPipeline const&) = delete;
+  LinesPipeline& operator=(LinesPipeline const&) = delete;
+
+  // returns false if the writer stopped the pipeline. rethrows the first
+  // exception thrown by the reader, a worker or the writer
+  bool run() {
+    std::vector<std::thread> threads;
+    threads.emplace_back([this]() { read(); });
+    for (std::size_t i = 0; i < _threads; ++i) {
+      threads.emplace_back([this, i]() { work(i); });
+    }
+
+    bool result = false;
+    try {
+      result = write();
+    } catch (...) {
+      fail();
+    }
+    stop();
+    for (auto& it : threads) {
+      it.join();
+    }
+
+    if (_exception) {
+      std::rethrow_exception(_exception);
+    }
+    return result;
+  }
+
+ private:
+  void read() {
+    try {
+      while (true) {
+        LinesBatch batch;
+        if (!_reader(batch)) {
+          break;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock,
+                      [this]() { return _stopped || _inFlight < 4 * _threads; });
+        if (_stopped) {
+          return;
+        }
+        _pending.emplace_back(_read++, std::move(batch));
+        ++_inFlight;
+        _changed.notify_all();
+      }
+    } catch (...) {
+      fail();
+      return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _eof = true;
+    _changed.notify_all();
+  }
+
+  void work(std::size_t worker) {
+    while (true) {
+      std::pair<uint64_t, LinesBatch> batch;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock, [this]() {
+          return _stopped || _eof || !_pending.empty();
+        });
+        if (_stopped || _pending.empty()) {
+          return;
+        }
+        batch = std::move(_pending.front());
+        _pending.pop_front();
+      }
+      try {
+        _converter(worker, batch.second);
+      } catch (...) {
+        fail();
+        return;
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      _done.emplace(batch.first, std::move(batch.second));
+      _changed.notify_all();
+    }
+  }
+
+  bool write() {
+    uint64_t next = 0;
+    while (true) {
+      LinesBatch batch;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock, [this, next]() {
+          return _stopped || _done.find(next) != _done.end() ||
+                 (_eof && next == _read);
+        });
+        if (_stopped) {
+          return false;
+        }
+        auto it = _done.find(next);
+        if (it == _done.end()) {
+          // all batches written
+          return true;
+        }
+        batch = std::move(it->second);
+        _done.erase(it);
+      }
+      ++next;
+      if (!_writer(batch)) {
+        return false;
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      --_inFlight;
+      _changed.notify_all();
+    }
+  }
+
+  void fail() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_exception) {
+      _exception = std::current_exception();
+    }
+    _stopped = true;
+    _changed.notify_all();
+  }
+
+  void stop() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopped = true;
+    _changed.notify_all();
+  }
+
+  std::size_t const _threads;
+  Reader const _reader;
+  Converter const _converter;
+  Writer const _writer;
+
+  std::mutex _mutex;
+  std::condition_variable _changed;
+  // batches read but not yet converted, and converted but not yet
+  // written, by their position in the input
+  std::deque<std::pair<uint64_t, LinesBatch>> _pending;
+  std::map<uint64_t, LinesBatch> _done;
+  uint64_t _read;
+  std::size_t _inFlight;
+  bool _eof;
+  bool _stopped;
+  std::exception_ptr _exception;
+};
+
+#endif
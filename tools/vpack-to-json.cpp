@@ -24,13 +24,21 @@
 /// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <fstream>
+#include <memory>
 
 #include "velocypack/vpack.h"
 #include "velocypack/velocypack-exception-macros.h"
 
+#include "lines-pipeline.h"
+
 using namespace arangodb::velocypack;
 
 static void usage(char* argv[]) {
@@ -58,6 +66,16 @@ static void usage(char* argv[]) {
   std::cout << " --hex                     try to turn hex-encoded input into binary vpack" << std::endl;
   std::cout << " --validate                validate input VelocyPack data" << std::endl;
   std::cout << " --no-validate             don't validate input VelocyPack data" << std::endl;
+  std::cout << " --dictionary FILE         resolve compressed Object keys using the key" << std::endl;
+  std::cout << "                           dictionary in FILE" << std::endl;
+  std::cout << " --lines                   read VPack values stored back to back, and" << std::endl;
+  std::cout << "                           write JSON Lines, i.e. one JSON value per line." << std::endl;
+  std::cout << "                           the input is processed in parallel, and may be" << std::endl;
+  std::cout << "                           of any size. implies --no-pretty" << std::endl;
+  std::cout << " --array                   with --lines, read a single Array and write one" << std::endl;
+  std::cout << "                           line per member instead" << std::endl;
+  std::cout << " --threads N               with --lines, the number of dumper threads" << std::endl;
+  std::cout << "                           (default: number of cores)" << std::endl;
 }
 
 static std::string convertFromHex(std::string const& value) {
@@ -94,10 +112,261 @@ static std::string convertFromHex(std::string const& value) {
   return result;
 }
 
+static bool readFile(std::string const& filename, std::string& s) {
+  std::ifstream ifs(filename, std::ifstream::in | std::ifstream::binary);
+
+  if (!ifs.is_open()) {
+    return false;
+  }
+
+  char buffer[32768];
+  s.reserve(sizeof(buffer));
+
+  while (ifs.good()) {
+    ifs.read(&buffer[0], sizeof(buffer));
+    s.append(buffer, checkOverflow(ifs.gcount()));
+  }
+  ifs.close();
+  return true;
+}
+
 static inline bool isOption(char const* arg, char const* expected) {
   return (strcmp(arg, expected) == 0);
 }
 
+// the amount of input handed to a dumper thread at once in --lines mode
+static std::size_t const linesBatchSize = 1024 * 1024;
+
+// returns the size of the VPack value at p if it is complete within the
+// available bytes, or 0. at the end of the input, the head of the value
+// may be shorter than the longest possible head
+static ValueLength completeValueSize(uint8_t const* p, std::size_t available,
+                                     bool eof) {
+  // skip over the tags, which Slice::byteSize() would read anyway
+  std::size_t offset = 0;
+  while (offset < available && (p[offset] == 0xee || p[offset] == 0xef)) {
+    offset += (p[offset] == 0xee ? 2 : 9);
+  }
+  // no head has more than 16 bytes
+  uint8_t head[16];
+  uint8_t const* start = p + offset;
+  if (offset >= available) {
+    return 0;
+  } else if (available - offset < sizeof(head)) {
+    if (!eof) {
+      return 0;
+    }
+    memset(&head[0], 0, sizeof(head));
+    memcpy(&head[0], start, available - offset);
+    start = &head[0];
+  }
+  ValueLength size = offset + Slice(start).byteSize();
+  return size <= available ? size : 0;
+}
+
+// reads the next values of the input into the batch, at least
+// linesBatchSize bytes unless the input ends. the partial value at the end
+// is kept in carry for the next batch
+static bool readValues(std::istream& in, std::string& carry,
+                       LinesBatch& batch) {
+  batch.input.swap(carry);
+  carry.clear();
+
+  char buffer[65536];
+  std::size_t complete = 0;
+  while (true) {
+    bool const eof = !in.good();
+    uint8_t const* p = reinterpret_cast<uint8_t const*>(batch.input.data());
+    while (complete < batch.input.size()) {
+      ValueLength size = completeValueSize(
+          p + complete, batch.input.size() - complete, eof);
+      if (size == 0) {
+        break;
+      }
+      complete += size;
+    }
+    if (complete >= linesBatchSize || eof) {
+      break;
+    }
+    in.read(&buffer[0], sizeof(buffer));
+    batch.input.append(buffer, checkOverflow(in.gcount()));
+  }
+
+  if (complete < batch.input.size()) {
+    if (!in.good()) {
+      throw std::runtime_error("truncated VPack value at the end of the input");
+    }
+    carry.assign(batch.input, complete, std::string::npos);
+    batch.input.resize(complete);
+  }
+  return !batch.input.empty();
+}
+
+// dumps all values of the batch as JSON Lines into its output
+static void dumpLines(Options const& options, AttributeTranslator const* translator,
+                      bool validate, LinesBatch& batch) {
+  // the Dumper resolves compressed keys via the thread's translator
+  AttributeTranslatorThreadScope translatorScope(translator);
+  Validator validator;
+  StringSink sink(&batch.output);
+  Dumper dumper(&sink, &options);
+
+  uint8_t const* p = reinterpret_cast<uint8_t const*>(batch.input.data());
+  uint8_t const* end = p + batch.input.size();
+  while (p < end) {
+    ++batch.items;
+    try {
+      Slice value(p);
+      ValueLength size = value.byteSize();
+      if (validate) {
+        validator.validate(p, checkOverflow(size));
+      }
+      dumper.dump(value);
+      sink.push_back('\n');
+      p += size;
+    } catch (Exception const& ex) {
+      batch.error = ex.what();
+      return;
+    }
+  }
+}
+
+// converts VPack values to JSON Lines in the --lines mode. the values are
+// read from the input, or are the members of the Array in arrayInput.
+// returns the number of lines. throws on the first invalid value
+static uint64_t convertLines(std::istream& in, Slice const* arrayInput,
+                             std::ostream& out, Options const& options,
+                             AttributeTranslator const* translator,
+                             bool validate, std::size_t threads,
+                             uint64_t& outputSize) {
+  std::string carry;
+  std::unique_ptr<ArrayIterator> members;
+  if (arrayInput != nullptr) {
+    members.reset(new ArrayIterator(*arrayInput));
+  }
+
+  LinesPipeline::Reader reader;
+  if (members != nullptr) {
+    reader = [&members](LinesBatch& batch) {
+      while (members->valid() && batch.input.size() < linesBatchSize) {
+        Slice member = members->value();
+        batch.input.append(reinterpret_cast<char const*>(member.start()),
+                           checkOverflow(member.byteSize()));
+        members->next();
+      }
+      return !batch.input.empty();
+    };
+  } else {
+    reader = [&in, &carry](LinesBatch& batch) {
+      return readValues(in, carry, batch);
+    };
+  }
+
+  uint64_t lines = 0;
+  outputSize = 0;
+  LinesPipeline pipeline(
+      threads, reader,
+      [&](std::size_t, LinesBatch& batch) {
+        dumpLines(options, translator, validate, batch);
+      },
+      [&](LinesBatch& batch) {
+        if (!batch.error.empty()) {
+          throw std::runtime_error("value " + std::to_string(lines + batch.items) +
+                                   ": " + batch.error);
+        }
+        lines += batch.items;
+        out.write(batch.output.data(), batch.output.size());
+        outputSize += batch.output.size();
+        return true;
+      });
+  pipeline.run();
+  return lines;
+}
+
+// the JSON is written to a temporary file next to the outfile, which
+// replaces the outfile only once the conversion has succeeded. so a
+// failed conversion does not leave a truncated outfile behind. output
+// to stdout is written directly
+static std::string temporaryOutfileName(char const* outfileName, bool toStdOut) {
+  if (toStdOut) {
+    return outfileName;
+  }
+  return std::string(outfileName) + ".tmp";
+}
+
+// makes the temporary file the outfile. returns false on failure, in
+// which case the temporary file is removed
+static bool commitOutfile(std::string const& tempName, char const* outfileName, 
+                          bool toStdOut) {
+  if (toStdOut) {
+    return true;
+  }
+  if (std::rename(tempName.c_str(), outfileName) != 0) {
+    std::cerr << "Cannot write outfile '" << outfileName << "'" << std::endl;
+    std::remove(tempName.c_str());
+    return false;
+  }
+  return true;
+}
+
+// removes the temporary file after a failed conversion
+static void discardOutfile(std::ofstream& ofs, std::string const& tempName, bool toStdOut) {
+  ofs.close();
+  if (!toStdOut) {
+    std::remove(tempName.c_str());
+  }
+}
+
+// runs convertLines() with the output going to the file, and reports the
+// outcome. returns the exit code
+static int convertLinesToFile(std::istream& in, Slice const* arrayInput,
+                              std::string const& infile,
+                              char const* outfileName, bool toStdOut,
+                              AttributeTranslator const* translator,
+                              bool printUnsupported, bool validate,
+                              std::size_t threads) {
+  Options options;
+  options.prettyPrint = false;
+  options.unsupportedTypeBehavior =
+    (printUnsupported ? Options::ConvertUnsupportedType : Options::FailOnUnsupportedType);
+
+  std::string const tempName = temporaryOutfileName(outfileName, toStdOut);
+  std::ofstream ofs(tempName, std::ofstream::out);
+  if (!ofs.is_open()) {
+    std::cerr << "Cannot write outfile '" << outfileName << "'" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  uint64_t count;
+  uint64_t outputSize;
+  try {
+    count = convertLines(in, arrayInput, ofs, options, translator, validate,
+                         threads, outputSize);
+  } catch (std::exception const& ex) {
+    std::cerr << "An exception occurred while processing infile '" << infile
+              << "': " << ex.what() << std::endl;
+    discardOutfile(ofs, tempName, toStdOut);
+    return EXIT_FAILURE;
+  }
+  ofs.close();
+  if (!ofs) {
+    std::cerr << "Cannot write outfile '" << outfileName << "'" << std::endl;
+    discardOutfile(ofs, tempName, toStdOut);
+    return EXIT_FAILURE;
+  }
+  if (!commitOutfile(tempName, outfileName, toStdOut)) {
+    return EXIT_FAILURE;
+  }
+
+  if (!toStdOut) {
+    std::cout << "Successfully converted VPack infile '" << infile << "'"
+              << std::endl;
+    std::cout << "Lines:             " << count << std::endl;
+    std::cout << "JSON Outfile size: " << outputSize << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
   VELOCYPACK_GLOBAL_EXCEPTION_TRY
 
@@ -108,6 +377,10 @@ int main(int argc, char* argv[]) {
   bool printUnsupported = true;
   bool hex = false;
   bool validate = true;
+  bool lines = false;
+  bool arrayInput = false;
+  std::size_t threads = std::max(1U, std::thread::hardware_concurrency());
+  char const* dictionaryName = nullptr;
 
   int i = 1;
   while (i < argc) {
@@ -123,12 +396,28 @@ int main(int argc, char* argv[]) {
       printUnsupported = true;
     } else if (allowFlags && isOption(p, "--no-print-unsupported")) {
       printUnsupported = false;
+    } else if (allowFlags && isOption(p, "--dictionary")) {
+      if (++i >= argc) {
+        usage(argv);
+        return EXIT_FAILURE;
+      }
+      dictionaryName = argv[i];
     } else if (allowFlags && isOption(p, "--hex")) {
       hex = true;
     } else if (allowFlags && isOption(p, "--validate")) {
       validate = true;
     } else if (allowFlags && isOption(p, "--no-validate")) {
       validate = false;
+    } else if (allowFlags && isOption(p, "--lines")) {
+      lines = true;
+    } else if (allowFlags && isOption(p, "--array")) {
+      arrayInput = true;
+    } else if (allowFlags && isOption(p, "--threads")) {
+      if (++i >= argc) {
+        usage(argv);
+        return EXIT_FAILURE;
+      }
+      threads = std::max(1ULL, std::strtoull(argv[i], nullptr, 10));
     } else if (allowFlags && isOption(p, "--")) {
       allowFlags = false;
     } else if (infileName == nullptr) {
@@ -153,6 +442,11 @@ int main(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
+  if (lines && hex) {
+    std::cerr << "--lines cannot be combined with --hex" << std::endl;
+    return EXIT_FAILURE;
+  }
+
 #ifdef __linux__
   // treat missing outfile as stdout
   bool toStdOut = false;
@@ -176,25 +470,47 @@ int main(int argc, char* argv[]) {
   }
 #endif
 
-  std::string s;
-  std::ifstream ifs(infile, std::ifstream::in);
+  // load the key dictionary the input was compressed with
+  std::unique_ptr<AttributeTranslator> translator;
+  if (dictionaryName != nullptr) {
+    std::string dictionary;
+    if (!readFile(dictionaryName, dictionary)) {
+      std::cerr << "Cannot read dictionary '" << dictionaryName << "'"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    try {
+      Validator validator;
+      validator.validate(dictionary.data(), dictionary.size());
+      translator = AttributeDictionary::load(
+          Slice(reinterpret_cast<uint8_t const*>(dictionary.data())));
+    } catch (Exception const& ex) {
+      std::cerr << "Cannot load dictionary '" << dictionaryName
+                << "': " << ex.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  // the Dumper resolves compressed keys via the thread's translator
+  AttributeTranslatorThreadScope translatorScope(translator.get());
+
+  if (lines && !arrayInput) {
+    // the input is streamed
+    std::ifstream ifs(infile, std::ifstream::in | std::ifstream::binary);
+    if (!ifs.is_open()) {
+      std::cerr << "Cannot read infile '" << infile << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
+    return convertLinesToFile(ifs, nullptr, infile, outfileName, toStdOut,
+                              translator.get(), printUnsupported, validate,
+                              threads);
+  }
 
-  if (!ifs.is_open()) {
+  std::string s;
+  if (!readFile(infile, s)) {
     std::cerr << "Cannot read infile '" << infile << "'" << std::endl;
     return EXIT_FAILURE;
   }
 
-  {
-    char buffer[32768];
-    s.reserve(sizeof(buffer));
-
-    while (ifs.good()) {
-      ifs.read(&buffer[0], sizeof(buffer));
-      s.append(buffer, checkOverflow(ifs.gcount()));
-    }
-  }
-  ifs.close();
-
   if (hex) {
     s = convertFromHex(s);
   }
@@ -206,50 +522,75 @@ int main(int argc, char* argv[]) {
 
   Slice const slice(reinterpret_cast<uint8_t const*>(s.data()));
 
+  if (lines) {
+    if (!slice.isArray()) {
+      std::cerr << "Expecting an Array in infile '" << infile << "'"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::ifstream unused;
+    // the input was validated as a whole already
+    return convertLinesToFile(unused, &slice, infile, outfileName, toStdOut,
+                              translator.get(), printUnsupported, false,
+                              threads);
+  }
+
   Options options;
   options.prettyPrint = pretty;
   options.unsupportedTypeBehavior = 
     (printUnsupported ? Options::ConvertUnsupportedType : Options::FailOnUnsupportedType);
 
-  Buffer<char> buffer(4096);
-  CharBufferSink sink(&buffer);
-  Dumper dumper(&sink, &options);
+  std::string const tempName = temporaryOutfileName(outfileName, toStdOut);
+  std::ofstream ofs(tempName, std::ofstream::out);
 
+  if (!ofs.is_open()) {
+    std::cerr << "Cannot write outfile '" << outfileName << "'" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // reset stream
+  if (!toStdOut) {
+    ofs.seekp(0);
+  }
+
+  // write into stream piece by piece, so the JSON is never held in
+  // memory in its entirety
+  uint64_t outputSize = 0;
   try {
-    dumper.dump(slice);
+    StreamingDumper dumper(slice, &options);
+    char buffer[65536];
+    while (!dumper.done()) {
+      std::size_t n = dumper.produce(&buffer[0], sizeof(buffer));
+      ofs.write(&buffer[0], n);
+      outputSize += n;
+    }
   } catch (Exception const& ex) {
     std::cerr << "An exception occurred while processing infile '" << infile
               << "': " << ex.what() << std::endl;
+    discardOutfile(ofs, tempName, toStdOut);
     return EXIT_FAILURE;
   } catch (...) {
     std::cerr << "An unknown exception occurred while processing infile '"
               << infile << "'" << std::endl;
+    discardOutfile(ofs, tempName, toStdOut);
     return EXIT_FAILURE;
   }
 
-  std::ofstream ofs(outfileName, std::ofstream::out);
-
-  if (!ofs.is_open()) {
+  ofs.close();
+  if (!ofs) {
     std::cerr << "Cannot write outfile '" << outfileName << "'" << std::endl;
+    discardOutfile(ofs, tempName, toStdOut);
     return EXIT_FAILURE;
   }
-
-  // reset stream
-  if (!toStdOut) {
-    ofs.seekp(0);
+  if (!commitOutfile(tempName, outfileName, toStdOut)) {
+    return EXIT_FAILURE;
   }
 
-  // write into stream
-  char const* start = buffer.data();
-  ofs.write(start, buffer.size());
-
-  ofs.close();
-
   if (!toStdOut) {
     std::cout << "Successfully converted JSON infile '" << infile << "'"
               << std::endl;
     std::cout << "VPack Infile size: " << s.size() << std::endl;
-    std::cout << "JSON Outfile size: " << buffer.size() << std::endl;
+    std::cout << "JSON Outfile size: " << outputSize << std::endl;
   }
   
   VELOCYPACK_GLOBAL_EXCEPTION_CATCH
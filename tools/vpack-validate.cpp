@@ -24,6 +24,7 @@
 /// @author Copyright 2015, ArangoDB GmbH, Cologne, Germany
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <fstream>
@@ -42,6 +43,9 @@ static void usage(char* argv[]) {
             << std::endl;
   std::cout << "Available options are:" << std::endl;
   std::cout << " --hex                     try to turn hex-encoded input into binary vpack" << std::endl;
+  std::cout << " --threads <n>             validate members of large values with <n> threads" << std::endl;
+  std::cout << " --stream                  validate a sequence of values piece by piece," << std::endl;
+  std::cout << "                           without reading the whole input into memory" << std::endl;
 }
 
 static std::string convertFromHex(std::string const& value) {
@@ -88,6 +92,8 @@ int main(int argc, char* argv[]) {
   char const* infileName = nullptr;
   bool allowFlags = true;
   bool hex = false;
+  bool stream = false;
+  std::size_t threads = 1;
 
   int i = 1;
   while (i < argc) {
@@ -97,6 +103,14 @@ int main(int argc, char* argv[]) {
       return EXIT_SUCCESS;
     } else if (allowFlags && isOption(p, "--hex")) {
       hex = true;
+    } else if (allowFlags && isOption(p, "--stream")) {
+      stream = true;
+    } else if (allowFlags && isOption(p, "--threads")) {
+      if (++i >= argc) {
+        usage(argv);
+        return EXIT_FAILURE;
+      }
+      threads = static_cast<std::size_t>(std::strtoul(argv[i], nullptr, 10));
     } else if (allowFlags && isOption(p, "--")) {
       allowFlags = false;
     } else if (infileName == nullptr) {
@@ -127,14 +141,38 @@ int main(int argc, char* argv[]) {
   }
 #endif
 
+  if (stream && hex) {
+    std::cerr << "Options --stream and --hex cannot be combined" << std::endl;
+    return EXIT_FAILURE;
+  }
+
   std::string s;
-  std::ifstream ifs(infile, std::ifstream::in);
+  std::ifstream ifs(infile, std::ifstream::in | std::ifstream::binary);
 
   if (!ifs.is_open()) {
     std::cerr << "Cannot read infile '" << infile << "'" << std::endl;
     return EXIT_FAILURE;
   }
 
+  if (stream) {
+    try {
+      StreamValidator validator(&Options::Defaults, threads);
+      char buffer[32768];
+      while (ifs.good()) {
+        ifs.read(&buffer[0], sizeof(buffer));
+        validator.feed(&buffer[0], checkOverflow(ifs.gcount()));
+      }
+      validator.finish();
+      std::cout << "The " << validator.values() << " velocypack value(s) in infile '" 
+                << infile << "' are valid" << std::endl;
+    } catch (Exception const& ex) {
+      std::cerr << "An exception occurred while processing infile '" << infile
+                << "': " << ex.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
   {
     char buffer[32768];
     s.reserve(sizeof(buffer));
@@ -152,7 +190,7 @@ int main(int argc, char* argv[]) {
 
   try {
     Validator validator;
-    validator.validate(reinterpret_cast<uint8_t const*>(s.data()), s.size(), false);
+    validator.validateParallel(reinterpret_cast<uint8_t const*>(s.data()), s.size(), threads, false);
     std::cout << "The velocypack in infile '" << infile << "' is valid" << std::endl;
   } catch (Exception const& ex) {
     std::cerr << "An exception occurred while processing infile '" << infile